@@ -12,10 +12,15 @@
 
 #include <map>
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <boost/shared_ptr.hpp>
 
 #include "gadgetbase_export.h"
 #include "GadgetContainerMessage.h"
+#include "GadgetMessageQueue.h"
+#include "GadgetWorkerPool.h"
 #include "GadgetronExport.h"
 #include "gadgetron_config.h"
 #include "log.h"
@@ -94,6 +99,8 @@ namespace Gadgetron{
   class GadgetStreamInterface;
 
   class EXPORTGADGETBASE Gadget : public ACE_Task<ACE_MT_SYNCH>
+    , protected GadgetWorkerTask
+    , protected GadgetMessageQueueListener
   {
 
   public:
@@ -105,11 +112,14 @@ namespace Gadgetron{
     };
 
     Gadget()
-    : inherited()
+    : inherited(0, new GadgetMessageQueue())
     , desired_threads_(1)
     , pass_on_undesired_data_(false)
     , controller_(0)
     , parameter_mutex_("GadgetParameterMutex")
+    , pooled_(false)
+    , pool_scheduled_(false)
+    , pool_done_(false)
     {
 
       gadgetron_version_ = std::string(GADGETRON_VERSION_STRING) + std::string(" (") +
@@ -122,6 +132,7 @@ namespace Gadgetron{
       if (this->module()) {
         GDEBUG("Shutting down Gadget (%s)\n", this->module()->name());
       }
+      delete this->queue();
     }
 
 
@@ -130,11 +141,25 @@ namespace Gadgetron{
       return 0;
     }
 
+    /**
+       Starts the threads of this Gadget. Single threaded Gadgets run on the GadgetWorkerPool
+       instead if the pool has been started.
+     */
     virtual int open(void* = 0)
     {
+      if (this->desired_threads() == 1 && GadgetWorkerPool::instance()->running()) {
+        pooled_ = true;
+        this->queue()->set_listener(this);
+        return GADGET_OK;
+      }
       return this->activate( THR_NEW_LWP | THR_JOINABLE, this->desired_threads() );
     }
 
+    bool runs_on_worker_pool() const
+    {
+      return pooled_;
+    }
+
     int put(ACE_Message_Block *m, ACE_Time_Value* timeout = 0)
     {
       return this->putq(m, timeout);
@@ -150,6 +175,32 @@ namespace Gadgetron{
       desired_threads_ = t;
     }
 
+    GadgetMessageQueue* queue()
+    {
+      return static_cast<GadgetMessageQueue*>(this->msg_queue());
+    }
+
+    /**
+       Bounds the input queue of this gadget, see GadgetMessageQueue. Zero removes the bound.
+     */
+    void set_queue_watermarks(size_t high_watermark, size_t low_watermark)
+    {
+      this->queue()->set_watermarks(high_watermark, low_watermark);
+    }
+
+    GadgetQueueStatistics queue_statistics()
+    {
+      return this->queue()->statistics();
+    }
+
+    /**
+       Records the messages flowing through this Gadget with GadgetTrace.
+     */
+    void set_trace_tag(const GadgetTraceTag& tag)
+    {
+      this->queue()->set_trace_tag(tag);
+    }
+
     virtual bool pass_on_undesired_data()
     {
       return pass_on_undesired_data_;
@@ -182,7 +233,12 @@ namespace Gadgetron{
           return GADGET_FAIL;
         }
         GDEBUG("Gadget (%s) waiting for thread to finish\n", this->module()->name());
-        rval = this->wait();
+        if (pooled_) {
+          std::unique_lock<std::mutex> lock(pool_mutex_);
+          pool_cond_.wait(lock, [this]{ return pool_done_; });
+        } else {
+          rval = this->wait();
+        }
         GDEBUG("Gadget (%s) thread finished\n", this->module()->name());
         controller_ = 0;
       }
@@ -211,55 +267,9 @@ namespace Gadgetron{
           break;
         }
 
-
-        //Is this config info, if so call appropriate process function
-        if (m->flags() & GADGET_MESSAGE_CONFIG) {
-
-          int success;
-          try{ success = this->process_config(m); }
-          catch (std::runtime_error& err){
-            GEXCEPTION(err,"Gadget::process_config() failed\n");
-            success = -1;
-          }
-
-          if (success == -1) {
-            m->release();
-            this->flush();
-            GDEBUG("Gadget (%s) process config failed\n", this->module()->name());
-            return GADGET_FAIL;
-
-          }
-
-          //Push this onto next gadgets queue, other gadgets may need this configuration information
-          if (this->next()) {
-            if (this->next()->putq(m) == -1) {
-              m->release();
-              GDEBUG("Gadget (%s) process config failed to put config on dowstream gadget\n", this->module()->name());
-              return GADGET_FAIL;
-            }
-          }
-          continue;
-        }
-
-
-        int success;
-#ifdef NDEBUG //We actually want a full stack trace in debug mode, so only catch in release.
-        try{ success = this->process(m); }
-        catch (std::runtime_error& err){
-          GEXCEPTION(err,"Gadget::process() failed\n");
-          success = -1;
-        }
-#else
-        success = this->process(m);
-#endif
-        if (success == -1){
-          m->release();
-          this->flush();
-          GERROR("Gadget (%s) process failed\n", this->module()->name());
+        if (this->dispatch_message(m) == GADGET_FAIL) {
           return GADGET_FAIL;
         }
-
-
       }
       return 0;
     }
@@ -368,11 +378,127 @@ namespace Gadgetron{
       return 0;
     }
 
+    /**
+       Calls process_config or process for a message taken from the queue.
+     */
+    int dispatch_message(ACE_Message_Block* m)
+    {
+      //Taken once, so the begin and end events of a message carry the same tag
+      GadgetTraceTag tag = this->queue()->trace_tag();
+
+      //Is this config info, if so call appropriate process function
+      if (m->flags() & GADGET_MESSAGE_CONFIG) {
+
+        int success;
+        GadgetTrace::record(tag, GADGET_TRACE_PROCESS_BEGIN, m);
+        try{ success = this->process_config(m); }
+        catch (std::runtime_error& err){
+          GEXCEPTION(err,"Gadget::process_config() failed\n");
+          success = -1;
+        }
+        GadgetTrace::record(tag, GADGET_TRACE_PROCESS_END, m);
+
+        if (success == -1) {
+          m->release();
+          this->flush();
+          GDEBUG("Gadget (%s) process config failed\n", this->module()->name());
+          return GADGET_FAIL;
+
+        }
+
+        //Push this onto next gadgets queue, other gadgets may need this configuration information
+        if (this->next()) {
+          if (this->next()->putq(m) == -1) {
+            m->release();
+            GDEBUG("Gadget (%s) process config failed to put config on dowstream gadget\n", this->module()->name());
+            return GADGET_FAIL;
+          }
+        }
+        return GADGET_OK;
+      }
+
+
+      int success;
+      GadgetTrace::record(tag, GADGET_TRACE_PROCESS_BEGIN, m);
+#ifdef NDEBUG //We actually want a full stack trace in debug mode, so only catch in release.
+      try{ success = this->process(m); }
+      catch (std::runtime_error& err){
+        GEXCEPTION(err,"Gadget::process() failed\n");
+        success = -1;
+      }
+#else
+      success = this->process(m);
+#endif
+      GadgetTrace::record(tag, GADGET_TRACE_PROCESS_END, m);
+      if (success == -1){
+        m->release();
+        this->flush();
+        GERROR("Gadget (%s) process failed\n", this->module()->name());
+        return GADGET_FAIL;
+      }
+      return GADGET_OK;
+    }
+
+    //Called by the queue when a message arrives, schedules this Gadget on the pool unless it already is
+    virtual void message_enqueued()
+    {
+      if (!pool_scheduled_.exchange(true)) {
+        GadgetWorkerPool::instance()->schedule(this);
+      }
+    }
+
+    //Drains a batch of messages on a pool worker, the equivalent of svc for pooled Gadgets
+    virtual void run_on_worker()
+    {
+      for (size_t n = 0; n < pool_batch_size && !this->msg_queue()->is_empty(); n++) {
+        ACE_Message_Block* m = 0;
+        if (this->getq(m) == -1) {
+          GDEBUG("Gadget (%s) failed to get message from queue\n", this->module()->name());
+          this->pool_finish();
+          return;
+        }
+
+        if (m->msg_type() == ACE_Message_Block::MB_HANGUP) {
+          m->release();
+          this->pool_finish();
+          return;
+        }
+
+        if (this->dispatch_message(m) == GADGET_FAIL) {
+          this->pool_finish();
+          return;
+        }
+      }
+
+      //Messages arriving from here on schedule the Gadget again
+      pool_scheduled_ = false;
+      if (!this->msg_queue()->is_empty()) {
+        this->message_enqueued();
+      }
+    }
+
+    //pool_scheduled_ stays set, so the Gadget is never scheduled again
+    void pool_finish()
+    {
+      std::lock_guard<std::mutex> lock(pool_mutex_);
+      pool_done_ = true;
+      pool_cond_.notify_all();
+    }
+
+    //Messages processed per scheduling, so Gadgets with a deep queue do not monopolize a worker
+    static const size_t pool_batch_size = 16;
+
     unsigned int desired_threads_;
     unsigned int threads_;
     bool pass_on_undesired_data_;
     GadgetStreamInterface* controller_;
     ACE_Thread_Mutex parameter_mutex_;
+
+    bool pooled_;
+    std::atomic<bool> pool_scheduled_;
+    bool pool_done_;
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cond_;
   private:
     std::map<std::string, std::string> parameters_;
     std::string gadgetron_version_;
@@ -643,10 +769,20 @@ namespace Gadgetron{
 
         virtual ~BasicPropertyGadget() {}
 
+        virtual int open(void* a = 0)
+        {
+          if (queue_high_watermark.value() > 0) {
+            this->set_queue_watermarks(queue_high_watermark.value(), queue_low_watermark.value());
+          }
+          return Gadget::open(a);
+        }
+
       protected:
         GADGET_PROPERTY(using_cloudbus,bool,"Indicates whether the cloudbus is in use and available", false);
         GADGET_PROPERTY(pass_on_undesired_data,bool, "If true, data not matching the process function will be passed to next Gadget", true);
         GADGET_PROPERTY(threads,int, "Number of threads to run in this Gadget", 1);
+        GADGET_PROPERTY(queue_high_watermark, int, "Maximum number of messages waiting for this Gadget before upstream Gadgets block, 0 for unbounded", 0);
+        GADGET_PROPERTY(queue_low_watermark, int, "Number of waiting messages at which blocked upstream Gadgets resume, 0 for half the high watermark", 0);
         #ifdef _WIN32
         GADGET_PROPERTY(workingDirectory, std::string, "Where to store temporary files", "c:\\temp\\gadgetron\\");
         #else
@@ -0,0 +1,257 @@
+#include "GadgetChainPool.h"
+#include "GadgetComponentCache.h"
+#include "Gadget.h"
+#include "gadgetron_config.h"
+#include "gadgetron_home.h"
+#include "log.h"
+
+#include <algorithm>
+
+namespace Gadgetron
+{
+  GadgetChain::~GadgetChain()
+  {
+    for (size_t i = 0; i < readers.size(); i++) delete readers[i].second;
+    for (size_t i = 0; i < writers.size(); i++) delete writers[i].second;
+    for (size_t i = 0; i < gadgets.size(); i++) delete gadgets[i];
+  }
+
+  const std::chrono::seconds GadgetChainPool::max_backoff(300);
+
+  GadgetChainPool* GadgetChainPool::instance()
+  {
+    static GadgetChainPool pool;
+    return &pool;
+  }
+
+  GadgetChainPool::GadgetChainPool()
+    : stop_(false)
+  {
+  }
+
+  GadgetChainPool::~GadgetChainPool()
+  {
+    this->stop();
+  }
+
+  void GadgetChainPool::start(const std::vector< std::pair<std::string, size_t> >& configurations)
+  {
+    if (thread_.joinable()) {
+      GWARN("Gadget chain pool is already running\n");
+      return;
+    }
+
+    boost::filesystem::path config_path = get_gadgetron_home() / GADGETRON_CONFIG_PATH;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = false;
+      for (size_t i = 0; i < configurations.size(); i++) {
+        Entry& e = entries_[configurations[i].first];
+        e.path = config_path / configurations[i].first;
+        e.chains = configurations[i].second;
+        e.modified = 0;
+        e.failed_modified = 0;
+        e.backoff = std::chrono::seconds(0);
+        e.retry = std::chrono::steady_clock::time_point();
+      }
+    }
+
+    //The first connections should not have to wait for the thread
+    for (size_t i = 0; i < configurations.size(); i++) {
+      size_t n = 0;
+      while (n < configurations[i].second && this->refill(configurations[i].first)) n++;
+      GINFO("Prepared %d Gadget chains of %s\n", (int)n, configurations[i].first.c_str());
+    }
+
+    thread_ = std::thread(&GadgetChainPool::refill_loop, this);
+  }
+
+  void GadgetChainPool::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+
+    if (thread_.joinable()) thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+  }
+
+  std::unique_ptr<GadgetChain> GadgetChainPool::take(const std::string& filename)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::map<std::string, Entry>::iterator it = entries_.find(filename);
+    if (it == entries_.end()) {
+      return std::unique_ptr<GadgetChain>();
+    }
+
+    boost::system::error_code ec;
+
+    if (it->second.ready.empty()) {
+      //A configuration which failed to build is tried again at once when its file has been modified since
+      if (it->second.backoff.count() > 0) {
+        std::time_t modified = boost::filesystem::last_write_time(it->second.path, ec);
+        if (!ec && modified != it->second.failed_modified) {
+          it->second.retry = std::chrono::steady_clock::now();
+          cond_.notify_one();
+        }
+      }
+      return std::unique_ptr<GadgetChain>();
+    }
+
+    std::time_t modified = boost::filesystem::last_write_time(it->second.path, ec);
+    if (ec || modified != it->second.modified) {
+      GDEBUG("Configuration %s has been modified, dropping its prepared Gadget chains\n", filename.c_str());
+      it->second.ready.clear();
+      cond_.notify_one();
+      return std::unique_ptr<GadgetChain>();
+    }
+
+    std::unique_ptr<GadgetChain> chain = std::move(it->second.ready.front());
+    it->second.ready.pop_front();
+    cond_.notify_one();
+
+    return chain;
+  }
+
+  std::unique_ptr<GadgetChain> GadgetChainPool::build(const GadgetronXML::GadgetStreamConfiguration& cfg)
+  {
+    std::unique_ptr<GadgetChain> chain(new GadgetChain());
+    chain->configuration = cfg;
+
+    GadgetComponentCache* cache = GadgetComponentCache::instance();
+
+    for (std::vector<GadgetronXML::Reader>::const_iterator i = cfg.reader.begin(); i != cfg.reader.end(); ++i) {
+      GadgetMessageReader* r = cache->create_component<GadgetMessageReader>(i->dll.c_str(), i->classname.c_str());
+      if (!r) {
+        GERROR("Failed to load GadgetMessageReader %s from DLL %s\n", i->classname.c_str(), i->dll.c_str());
+        return std::unique_ptr<GadgetChain>();
+      }
+      chain->readers.push_back(std::make_pair(i->slot, r));
+    }
+
+    for (std::vector<GadgetronXML::Writer>::const_iterator i = cfg.writer.begin(); i != cfg.writer.end(); ++i) {
+      GadgetMessageWriter* w = cache->create_component<GadgetMessageWriter>(i->dll.c_str(), i->classname.c_str());
+      if (!w) {
+        GERROR("Failed to load GadgetMessageWriter %s from DLL %s\n", i->classname.c_str(), i->dll.c_str());
+        return std::unique_ptr<GadgetChain>();
+      }
+      chain->writers.push_back(std::make_pair(i->slot, w));
+    }
+
+    for (std::vector<GadgetronXML::Gadget>::const_iterator i = cfg.gadget.begin(); i != cfg.gadget.end(); ++i) {
+      Gadget* g = cache->create_component<Gadget>(i->dll.c_str(), i->classname.c_str());
+      if (!g) {
+        GERROR("Failed to create Gadget %s from %s:%s\n", i->name.c_str(), i->classname.c_str(), i->dll.c_str());
+        return std::unique_ptr<GadgetChain>();
+      }
+      chain->gadgets.push_back(g);
+
+      for (std::vector<GadgetronXML::GadgetronParameter>::const_iterator p = i->property.begin(); p != i->property.end(); ++p) {
+        g->set_parameter(p->name.c_str(), p->value.c_str(), false);
+      }
+    }
+
+    return chain;
+  }
+
+  bool GadgetChainPool::refill(const std::string& filename)
+  {
+    boost::filesystem::path path;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      path = entries_[filename].path;
+    }
+
+    GadgetronXML::GadgetStreamConfiguration cfg;
+    std::time_t modified = 0;
+    std::unique_ptr<GadgetChain> chain;
+    try {
+      modified = boost::filesystem::last_write_time(path);
+      GadgetComponentCache::instance()->stream_configuration(path, cfg);
+      chain = build(cfg);
+    } catch (const std::exception& e) {
+      GERROR("Failed to parse Gadget Stream Configuration %s: %s\n", path.string().c_str(), e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& e = entries_[filename];
+
+    if (!chain) {
+      e.backoff = std::min(std::max(2*e.backoff, std::chrono::seconds(1)), max_backoff);
+      e.retry = std::chrono::steady_clock::now() + e.backoff;
+      e.failed_modified = modified;
+      e.ready.clear();
+      GERROR("Unable to prepare Gadget chains of %s, connections using it will build their own. Trying again in %d s\n",
+             filename.c_str(), (int)e.backoff.count());
+      return false;
+    }
+
+    e.backoff = std::chrono::seconds(0);
+
+    if (e.modified != modified) {
+      e.ready.clear();
+      e.modified = modified;
+    }
+    if (e.ready.size() < e.chains) {
+      e.ready.push_back(std::move(chain));
+    }
+
+    return true;
+  }
+
+  void GadgetChainPool::refill_loop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      std::chrono::steady_clock::time_point wake = std::chrono::steady_clock::time_point::max();
+      std::string next;
+      for (std::map<std::string, Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second.ready.size() >= it->second.chains) continue;
+
+        if (it->second.retry > now) {
+          wake = std::min(wake, it->second.retry);
+          continue;
+        }
+
+        next = it->first;
+        break;
+      }
+
+      if (next.empty()) {
+        if (wake == std::chrono::steady_clock::time_point::max()) {
+          cond_.wait(lock);
+        } else {
+          cond_.wait_until(lock, wake);
+        }
+        continue;
+      }
+
+      lock.unlock();
+      this->refill(next);
+      lock.lock();
+    }
+  }
+
+  void GadgetChainPool::report_setup_time(double seconds, bool warm)
+  {
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    statistics_.connections++;
+    if (warm) statistics_.warm_connections++;
+    statistics_.total_time += seconds;
+    statistics_.max_time = std::max(statistics_.max_time, seconds);
+    statistics_.last_time = seconds;
+  }
+
+  ConnectionSetupStatistics GadgetChainPool::setup_statistics()
+  {
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    return statistics_;
+  }
+}
@@ -0,0 +1,133 @@
+#ifndef GADGETCHAINPOOL_H
+#define GADGETCHAINPOOL_H
+
+#include "gadgetbase_export.h"
+#include "gadgetron_xml.h"
+#include "GadgetMessageInterface.h"
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Gadgetron{
+
+  class Gadget;
+
+  /**
+     The readers, writers and Gadgets of a stream configuration, created and given the properties of the
+     configuration, but not yet part of a stream. The chain deletes the components which have not been taken out.
+   */
+  struct EXPORTGADGETBASE GadgetChain
+  {
+    GadgetronXML::GadgetStreamConfiguration configuration;
+    std::vector< std::pair<unsigned short, GadgetMessageReader*> > readers;
+    std::vector< std::pair<unsigned short, GadgetMessageWriter*> > writers;
+    std::vector<Gadget*> gadgets; //In the order of the configuration
+
+    ~GadgetChain();
+  };
+
+  struct ConnectionSetupStatistics
+  {
+    size_t connections;
+    size_t warm_connections; //Connections which got a prepared chain
+    double total_time;       //Seconds
+    double max_time;
+    double last_time;
+
+    ConnectionSetupStatistics()
+      : connections(0), warm_connections(0), total_time(0), max_time(0), last_time(0)
+    {
+    }
+
+    double mean_time() const
+    {
+      return connections ? total_time / connections : 0;
+    }
+  };
+
+  /**
+     Process-wide pool of Gadget chains built ahead of the connections which use them.
+
+     For every stream configuration file listed in the Gadgetron configuration, the pool keeps a number of chains
+     ready. A connection asking for one of these files takes a chain, so it only has to put the Gadgets on its
+     stream, and a thread of the pool builds a new chain in the background. Chains are never reused, so the Gadgets
+     need no reset; they all start in their freshly constructed state. When a configuration file is modified, the
+     chains built from the old file are dropped. A configuration whose chain cannot be built is tried again after
+     a delay which doubles with every failure, or as soon as a connection finds its file modified.
+
+     The pool also collects the time from accepting a connection until its stream is configured.
+   */
+  class EXPORTGADGETBASE GadgetChainPool
+  {
+  public:
+    static GadgetChainPool* instance();
+
+    /**
+       Builds the chains of the configurations, given as file name, relative to the configuration directory, and
+       number of chains to keep ready, and starts the thread which replaces the chains taken by connections.
+     */
+    void start(const std::vector< std::pair<std::string, size_t> >& configurations);
+
+    /**
+       Stops the thread and deletes the chains.
+     */
+    void stop();
+
+    /**
+       A chain of the configuration file, or an empty pointer if none is ready.
+     */
+    std::unique_ptr<GadgetChain> take(const std::string& filename);
+
+    /**
+       Creates the components of a configuration. Returns an empty pointer if any of them cannot be created.
+     */
+    static std::unique_ptr<GadgetChain> build(const GadgetronXML::GadgetStreamConfiguration& cfg);
+
+    void report_setup_time(double seconds, bool warm);
+
+    ConnectionSetupStatistics setup_statistics();
+
+  protected:
+    GadgetChainPool();
+    ~GadgetChainPool();
+
+    struct Entry
+    {
+      boost::filesystem::path path;
+      size_t chains;
+      std::time_t modified; //Of the file the ready chains were built from
+      std::deque< std::unique_ptr<GadgetChain> > ready;
+      std::time_t failed_modified; //Of the file the last failed chain was built from
+      std::chrono::seconds backoff; //Zero unless building the last chain failed
+      std::chrono::steady_clock::time_point retry; //No chain is built before
+    };
+
+    void refill_loop();
+
+    //Builds one chain of the entry. Returns false, and delays the next attempt, if the chain cannot be built.
+    bool refill(const std::string& filename);
+
+    static const std::chrono::seconds max_backoff;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::map<std::string, Entry> entries_;
+    std::thread thread_;
+    bool stop_;
+
+    std::mutex statistics_mutex_;
+    ConnectionSetupStatistics statistics_;
+  };
+}
+#endif //GADGETCHAINPOOL_H
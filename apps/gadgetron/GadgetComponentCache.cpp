@@ -0,0 +1,143 @@
+#include "ace/DLL.h"
+#include "ace/DLL_Manager.h"
+#include "ace/OS_NS_stdio.h"
+
+#include "GadgetComponentCache.h"
+
+#include <fstream>
+#include <sstream>
+
+//Scripts are usually generated by the client, so the cache is emptied when it reaches this size
+#define MAX_CACHED_SCRIPTS 64
+
+namespace Gadgetron
+{
+  GadgetComponentCache* GadgetComponentCache::instance()
+  {
+    static GadgetComponentCache cache;
+    return &cache;
+  }
+
+  GadgetComponentCache::GadgetComponentCache()
+  {
+  }
+
+  void* GadgetComponentCache::find_factory(const char* DLL, const char* component_name)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::pair<std::string, std::string> key(DLL, component_name);
+    std::map< std::pair<std::string, std::string>, void* >::iterator it = factories_.find(key);
+    if (it != factories_.end()) {
+      return it->second;
+    }
+
+    ACE_DLL_Manager* dllmgr = ACE_DLL_Manager::instance();
+
+    ACE_DLL_Handle* dll = 0;
+    ACE_SHLIB_HANDLE dll_handle = 0;
+
+    ACE_TCHAR dllname[1024];
+#if defined(WIN32) && defined(_DEBUG)
+    ACE_OS::sprintf(dllname, "%s%sd",ACE_DLL_PREFIX, DLL);
+#else
+    ACE_OS::sprintf(dllname, "%s%s",ACE_DLL_PREFIX, DLL);
+#endif
+
+    ACE_TCHAR factoryname[1024];
+    ACE_OS::sprintf(factoryname, "make_%s", component_name);
+
+    //The handle is never closed, the DLL stays loaded
+    dll = dllmgr->open_dll (dllname, ACE_DEFAULT_SHLIB_MODE, dll_handle );
+
+    if (!dll) {
+      GERROR("Failed to load DLL, Possible reasons: \n");
+      GERROR("   * Name of DLL is wrong in XML file \n");
+      GERROR("   * Path of DLL is not in your DLL search path (LD_LIBRARY_PATH on Unix)\n");
+      GERROR("   * Path of other DLLs that this DLL depends on is not in the search path\n");
+      return 0;
+    }
+
+    void* factory = dll->symbol (factoryname);
+
+    if (factory == 0) {
+      GERROR("Failed to load factory (%s) from DLL (%s)\n", factoryname, dllname);
+      return 0;
+    }
+
+    factories_[key] = factory;
+    return factory;
+  }
+
+  void GadgetComponentCache::stream_configuration(const boost::filesystem::path& filename, GadgetronXML::GadgetStreamConfiguration& cfg)
+  {
+    boost::system::error_code ec;
+    std::time_t modified = boost::filesystem::last_write_time(filename, ec);
+    if (ec) {
+      throw std::runtime_error("Unable to open configuration file: " + filename.string());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::map< std::string, std::pair<std::time_t, GadgetronXML::GadgetStreamConfiguration> >::iterator it = files_.find(filename.string());
+      if (it != files_.end() && it->second.first == modified) {
+        cfg = it->second.second;
+        return;
+      }
+    }
+
+    std::ifstream config_file_stream (filename.c_str(), std::ios::in);
+    if (!config_file_stream.is_open()) {
+      throw std::runtime_error("Unable to open configuration file: " + filename.string());
+    }
+
+    GadgetronXML::GadgetStreamConfiguration parsed;
+    deserialize(config_file_stream, parsed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_[filename.string()] = std::make_pair(modified, parsed);
+    cfg = parsed;
+  }
+
+  void GadgetComponentCache::stream_configuration(const std::string& xml, GadgetronXML::GadgetStreamConfiguration& cfg)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::map< std::string, GadgetronXML::GadgetStreamConfiguration >::iterator it = scripts_.find(xml);
+      if (it != scripts_.end()) {
+        cfg = it->second;
+        return;
+      }
+    }
+
+    std::stringstream stream(xml, std::ios::in);
+    GadgetronXML::GadgetStreamConfiguration parsed;
+    deserialize(stream, parsed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (scripts_.size() >= MAX_CACHED_SCRIPTS) {
+      scripts_.clear();
+    }
+    scripts_[xml] = parsed;
+    cfg = parsed;
+  }
+
+  bool GadgetComponentCache::preload(const GadgetronXML::GadgetStreamConfiguration& cfg)
+  {
+    bool found = true;
+
+    for (size_t i = 0; i < cfg.reader.size(); i++) {
+      if (!this->find_factory(cfg.reader[i].dll.c_str(), cfg.reader[i].classname.c_str())) found = false;
+    }
+
+    for (size_t i = 0; i < cfg.writer.size(); i++) {
+      if (!this->find_factory(cfg.writer[i].dll.c_str(), cfg.writer[i].classname.c_str())) found = false;
+    }
+
+    for (size_t i = 0; i < cfg.gadget.size(); i++) {
+      if (!this->find_factory(cfg.gadget[i].dll.c_str(), cfg.gadget[i].classname.c_str())) found = false;
+    }
+
+    return found;
+  }
+}
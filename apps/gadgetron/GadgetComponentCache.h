@@ -0,0 +1,94 @@
+#ifndef GADGETCOMPONENTCACHE_H
+#define GADGETCOMPONENTCACHE_H
+
+#include "gadgetbase_export.h"
+#include "gadgetron_xml.h"
+#include "log.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace Gadgetron{
+
+  /**
+     Process-wide cache of the parts of setting up a stream which do not depend on the connection: the parsed
+     stream configurations, and the component factories resolved from the Gadget DLLs.
+
+     A DLL is opened the first time one of its components is created and stays loaded for the life of the
+     process, so connections do not pay for loading and unloading the DLLs and their dependencies.
+   */
+  class EXPORTGADGETBASE GadgetComponentCache
+  {
+  public:
+    static GadgetComponentCache* instance();
+
+    /**
+       Creates a component with the factory make_<component_name> of the DLL. Returns 0 on failure.
+     */
+    template <class T> T* create_component(const char* DLL, const char* component_name)
+    {
+      //Function pointer
+      typedef T* (*ComponentCreator) (void);
+
+      void* void_ptr = this->find_factory(DLL, component_name);
+      ptrdiff_t tmp = reinterpret_cast<ptrdiff_t> (void_ptr);
+      ComponentCreator cc = reinterpret_cast<ComponentCreator> (tmp);
+
+      if (cc == 0) {
+        return 0;
+      }
+
+      T* c = cc();
+
+      if (!c) {
+        GERROR("Failed to create component using factory\n");
+        return 0;
+      }
+
+      return c;
+    }
+
+    /**
+       The factory make_<component_name> of the DLL, opening the DLL if needed. Returns 0 on failure.
+     */
+    void* find_factory(const char* DLL, const char* component_name);
+
+    /**
+       Parses a stream configuration file, or copies the cached configuration if the file has not been modified
+       since it was parsed. Throws std::runtime_error if the file cannot be read or parsed.
+     */
+    void stream_configuration(const boost::filesystem::path& filename, GadgetronXML::GadgetStreamConfiguration& cfg);
+
+    /**
+       Parses a stream configuration sent as a script, or copies the cached configuration of the same script.
+     */
+    void stream_configuration(const std::string& xml, GadgetronXML::GadgetStreamConfiguration& cfg);
+
+    /**
+       Resolves the factories of all readers, writers and Gadgets of a configuration.
+       Returns false if any of them cannot be found.
+     */
+    bool preload(const GadgetronXML::GadgetStreamConfiguration& cfg);
+
+  protected:
+    GadgetComponentCache();
+
+    std::mutex mutex_;
+
+    //Keyed by DLL and factory name
+    std::map< std::pair<std::string, std::string>, void* > factories_;
+
+    //Keyed by file name, with the modification time of the file when it was parsed
+    std::map< std::string, std::pair<std::time_t, GadgetronXML::GadgetStreamConfiguration> > files_;
+
+    //Keyed by the script
+    std::map< std::string, GadgetronXML::GadgetStreamConfiguration > scripts_;
+  };
+}
+#endif //GADGETCOMPONENTCACHE_H
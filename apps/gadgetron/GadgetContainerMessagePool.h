@@ -0,0 +1,272 @@
+#ifndef GADGETCONTAINERMESSAGEPOOL_H
+#define GADGETCONTAINERMESSAGEPOOL_H
+#pragma once
+
+#include "GadgetContainerMessage.h"
+
+#include <ace/Thread_Mutex.h>
+#include <ace/Guard_T.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <vector>
+#include <new>
+
+namespace Gadgetron{
+
+  template <typename T> class hoNDArray;
+
+  /**
+     Describes how much memory a pooled object holds and whether it can be handed out again.
+     The default is suitable for plain structs such as the ISMRMRD headers.
+   */
+  template <class T> struct GadgetContainerMessagePoolTraits
+  {
+    static size_t payload_bytes(const T&) { return 0; }
+    static bool reusable(const T&) { return true; }
+  };
+
+  /**
+     Arrays are only recycled when they still own their storage. A downstream gadget may have moved the
+     data out or pointed the array at external memory, in which case the array is rebuilt before reuse.
+   */
+  template <class T> struct GadgetContainerMessagePoolTraits< hoNDArray<T> >
+  {
+    static size_t payload_bytes(const hoNDArray<T>& a) { return a.get_number_of_elements()*sizeof(T); }
+    static bool reusable(const hoNDArray<T>& a) { return a.get_data_ptr() && a.delete_data_on_destruct(); }
+  };
+
+  struct GadgetContainerMessagePoolStatistics
+  {
+    size_t hits;
+    size_t misses;
+    size_t recycled;
+    size_t dropped;
+    size_t resident_bytes;
+    size_t peak_resident_bytes;
+
+    GadgetContainerMessagePoolStatistics()
+      : hits(0), misses(0), recycled(0), dropped(0), resident_bytes(0), peak_resident_bytes(0)
+    {
+    }
+
+    double hit_rate() const
+    {
+      size_t total = hits + misses;
+      return total ? double(hits) / double(total) : 0.0;
+    }
+  };
+
+  template <class T> class GadgetContainerMessagePool;
+
+  /**
+     A GadgetContainerMessage that returns itself to its pool when the last reference is released,
+     instead of handing its memory back to the heap. The contained object is kept alive, so any
+     storage it owns (e.g. the samples of a hoNDArray) is reused by the next message.
+
+     The type magic number is that of GadgetContainerMessage<T>, so downstream gadgets see no difference.
+   */
+  template <class T> class PooledGadgetContainerMessage : public GadgetContainerMessage<T>
+  {
+    typedef GadgetContainerMessage<T> base;
+    friend class GadgetContainerMessagePool<T>;
+
+  public:
+    PooledGadgetContainerMessage(boost::weak_ptr< GadgetContainerMessagePool<T> > pool)
+      : base()
+      , pool_(pool)
+      , accounted_bytes_(0)
+    {
+    }
+
+    virtual ACE_Message_Block* release()
+    {
+      boost::shared_ptr< GadgetContainerMessagePool<T> > pool = pool_.lock();
+
+      //Shared data blocks (duplicates) and orphaned messages are released the usual way
+      if (!pool || this->reference_count() > 1) {
+        return this->discard();
+      }
+
+      if (this->cont_) {
+        this->cont_->release();
+        this->cont_ = 0;
+      }
+
+      pool->recycle(this);
+      return 0;
+    }
+
+  protected:
+    ACE_Message_Block* discard()
+    {
+      boost::shared_ptr< GadgetContainerMessagePool<T> > pool = pool_.lock();
+      pool_.reset();
+      if (pool) pool->forget(this);
+      return base::release();
+    }
+
+    void reset_content()
+    {
+      if (!GadgetContainerMessagePoolTraits<T>::reusable(*this->content_)) {
+        this->content_->~T();
+        this->content_ = new (this->content_) T();
+      }
+
+      this->msg_type(ACE_Message_Block::MB_DATA);
+      this->next(0);
+      this->prev(0);
+    }
+
+    boost::weak_ptr< GadgetContainerMessagePool<T> > pool_;
+    size_t accounted_bytes_;
+  };
+
+  /**
+     Free list of container messages of a single type.
+
+     Must be held by a boost::shared_ptr. Intended to be owned by a message reader, i.e. one pool
+     per connection. Messages keep a weak reference to the pool, so the reader may be destroyed
+     while messages are still in flight; those are then freed normally when released downstream.
+   */
+  template <class T> class GadgetContainerMessagePool
+    : public boost::enable_shared_from_this< GadgetContainerMessagePool<T> >
+  {
+  public:
+    /**
+       @param max_free_bytes Upper limit on memory parked in the free list. Messages released once
+       the limit is reached are returned to the heap.
+     */
+    GadgetContainerMessagePool(size_t max_free_bytes = 256*1024*1024)
+      : max_free_bytes_(max_free_bytes)
+      , free_bytes_(0)
+    {
+    }
+
+    virtual ~GadgetContainerMessagePool()
+    {
+      clear();
+    }
+
+    /**
+       Returns a message from the free list, or a freshly allocated one if the list is empty.
+       The content of a recycled message is left as the previous user left it.
+     */
+    PooledGadgetContainerMessage<T>* acquire()
+    {
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        if (!free_.empty()) {
+          PooledGadgetContainerMessage<T>* m = free_.back();
+          free_.pop_back();
+          free_bytes_ -= m->accounted_bytes_;
+          stats_.hits++;
+          m->reset_content();
+          return m;
+        }
+        stats_.misses++;
+      }
+
+      return new PooledGadgetContainerMessage<T>(this->shared_from_this());
+    }
+
+    /**
+       Puts count new messages on the free list, with their content prepared by init(T&), e.g. arrays created
+       with the size of the expected messages. Stops once the free list limit is reached.
+     */
+    template <class F> void reserve(size_t count, F init)
+    {
+      for (size_t i = 0; i < count; i++) {
+        PooledGadgetContainerMessage<T>* m = new PooledGadgetContainerMessage<T>(this->shared_from_this());
+        init(*m->getObjectPtr());
+
+        {
+          ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+          account_locked(m);
+          if (free_bytes_ + m->accounted_bytes_ <= max_free_bytes_) {
+            free_.push_back(m);
+            free_bytes_ += m->accounted_bytes_;
+            continue;
+          }
+        }
+
+        m->discard();
+        return;
+      }
+    }
+
+    /**
+       Updates the resident memory counters after the content of m has been (re)sized.
+     */
+    void account(PooledGadgetContainerMessage<T>* m)
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      account_locked(m);
+    }
+
+    GadgetContainerMessagePoolStatistics statistics()
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      return stats_;
+    }
+
+    void clear()
+    {
+      std::vector< PooledGadgetContainerMessage<T>* > to_free;
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        to_free.swap(free_);
+        free_bytes_ = 0;
+      }
+
+      for (size_t i = 0; i < to_free.size(); i++) {
+        to_free[i]->discard();
+      }
+    }
+
+  protected:
+    friend class PooledGadgetContainerMessage<T>;
+
+    void recycle(PooledGadgetContainerMessage<T>* m)
+    {
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        account_locked(m);
+        if (free_bytes_ + m->accounted_bytes_ <= max_free_bytes_) {
+          free_.push_back(m);
+          free_bytes_ += m->accounted_bytes_;
+          stats_.recycled++;
+          return;
+        }
+        stats_.dropped++;
+      }
+
+      m->discard();
+    }
+
+    void forget(PooledGadgetContainerMessage<T>* m)
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      stats_.resident_bytes -= m->accounted_bytes_;
+      m->accounted_bytes_ = 0;
+    }
+
+    void account_locked(PooledGadgetContainerMessage<T>* m)
+    {
+      size_t bytes = sizeof(T) + GadgetContainerMessagePoolTraits<T>::payload_bytes(*m->getObjectPtr());
+      stats_.resident_bytes += bytes;
+      stats_.resident_bytes -= m->accounted_bytes_;
+      m->accounted_bytes_ = bytes;
+      if (stats_.resident_bytes > stats_.peak_resident_bytes) {
+        stats_.peak_resident_bytes = stats_.resident_bytes;
+      }
+    }
+
+    size_t max_free_bytes_;
+    size_t free_bytes_;
+    std::vector< PooledGadgetContainerMessage<T>* > free_;
+    GadgetContainerMessagePoolStatistics stats_;
+    ACE_Thread_Mutex mutex_;
+  };
+}
+#endif //GADGETCONTAINERMESSAGEPOOL_H
@@ -0,0 +1,113 @@
+#include "GadgetInputStream.h"
+
+#include <ace/os_include/sys/os_uio.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Gadgetron
+{
+  GadgetInputStream::GadgetInputStream(ACE_SOCK_Stream* socket, size_t capacity)
+    : socket_(socket)
+    , buffer_(capacity)
+    , begin_(0)
+    , end_(0)
+    , read_ahead_(false)
+    , syscalls_(0)
+    , bytes_received_(0)
+  {
+  }
+
+  ssize_t GadgetInputStream::recv_n(void* buf, size_t len)
+  {
+    char* dst = reinterpret_cast<char*>(buf);
+
+    size_t n = std::min(len, this->buffered());
+    if (n) {
+      memcpy(dst, &buffer_[begin_], n);
+      begin_ += n;
+    }
+
+    if (begin_ == end_) {
+      begin_ = end_ = 0;
+    }
+
+    size_t remaining = len - n;
+    if (!remaining) {
+      return len;
+    }
+
+    if (!read_ahead_) {
+      ssize_t r = socket_->recv_n(dst + n, remaining);
+      syscalls_++;
+      if (r <= 0) return r;
+      bytes_received_ += r;
+      return len;
+    }
+
+    if (remaining < buffer_.size() / 2) {
+      ssize_t r = this->fill(remaining);
+      if (r <= 0) return r;
+      memcpy(dst + n, &buffer_[begin_], remaining);
+      begin_ += remaining;
+      return len;
+    }
+
+    //Large payload, the buffer is empty at this point
+    while (remaining) {
+      iovec iov[2];
+      iov[0].iov_base = dst + n;
+      iov[0].iov_len = remaining;
+      iov[1].iov_base = &buffer_[end_];
+      iov[1].iov_len = buffer_.size() - end_;
+
+      ssize_t r = socket_->recvv(iov, 2);
+      syscalls_++;
+      if (r <= 0) return r;
+      bytes_received_ += r;
+
+      if (size_t(r) <= remaining) {
+        n += r;
+        remaining -= r;
+      } else {
+        end_ += r - remaining;
+        remaining = 0;
+      }
+    }
+
+    return len;
+  }
+
+  ssize_t GadgetInputStream::fill(size_t len)
+  {
+    if (this->buffered() >= len) {
+      return 1;
+    }
+
+    if (len > buffer_.size()) {
+      buffer_.resize(len);
+    }
+
+    //Move the unconsumed bytes to the front if the request does not fit behind them
+    if (begin_ + len > buffer_.size()) {
+      memmove(&buffer_[0], &buffer_[begin_], this->buffered());
+      end_ -= begin_;
+      begin_ = 0;
+    }
+
+    while (this->buffered() < len) {
+      ssize_t r;
+      if (read_ahead_) {
+        r = socket_->recv(&buffer_[end_], buffer_.size() - end_);
+      } else {
+        r = socket_->recv_n(&buffer_[end_], len - this->buffered());
+      }
+      syscalls_++;
+
+      if (r <= 0) return r;
+      bytes_received_ += r;
+      end_ += r;
+    }
+
+    return 1;
+  }
+}
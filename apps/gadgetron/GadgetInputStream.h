@@ -0,0 +1,78 @@
+#ifndef GADGETINPUTSTREAM_H
+#define GADGETINPUTSTREAM_H
+
+#include "gadgetbase_export.h"
+
+#include <ace/SOCK_Stream.h>
+#include <vector>
+
+namespace Gadgetron{
+
+  /**
+     Buffered input layer on top of the connection socket.
+
+     Bytes are received into an internal buffer with large recv calls and handed to the message
+     readers from there, so a readout costs a fraction of a system call instead of one call per
+     field. Payloads larger than half the buffer are received with a single readv that fills the
+     destination directly and reads ahead into the buffer in the same call.
+
+     Read-ahead is off by default. While it is off, only the requested number of bytes is taken
+     from the socket, which keeps the socket positioned at message boundaries for readers that
+     read from the ACE_SOCK_Stream directly.
+   */
+  class EXPORTGADGETBASE GadgetInputStream
+  {
+  public:
+    GadgetInputStream(ACE_SOCK_Stream* socket, size_t capacity = 1024*1024);
+
+    ACE_SOCK_Stream* socket()
+    {
+      return socket_;
+    }
+
+    void read_ahead(bool enable)
+    {
+      read_ahead_ = enable;
+    }
+
+    bool read_ahead() const
+    {
+      return read_ahead_;
+    }
+
+    /**
+       Number of bytes received from the socket but not yet consumed.
+     */
+    size_t buffered() const
+    {
+      return end_ - begin_;
+    }
+
+    /**
+       Same semantics as ACE_SOCK_Stream::recv_n: returns len on success, 0 on end of file and -1 on error.
+     */
+    ssize_t recv_n(void* buf, size_t len);
+
+    size_t number_of_syscalls() const
+    {
+      return syscalls_;
+    }
+
+    size_t bytes_received() const
+    {
+      return bytes_received_;
+    }
+
+  protected:
+    ssize_t fill(size_t len);
+
+    ACE_SOCK_Stream* socket_;
+    std::vector<char> buffer_;
+    size_t begin_;
+    size_t end_;
+    bool read_ahead_;
+    size_t syscalls_;
+    size_t bytes_received_;
+  };
+}
+#endif //GADGETINPUTSTREAM_H
@@ -2,12 +2,15 @@
 #define GADGETMESSAGEINTERFACE_H
 
 #include "GadgetContainerMessage.h"
+#include "GadgetInputStream.h"
+#include "GadgetOutputStream.h"
 #include "GadgetronExport.h"
 #include "Gadget.h"
 
 #include <ace/SOCK_Stream.h>
 #include <ace/Basic_Types.h>
 #include <map>
+#include <string>
 
 namespace Gadgetron
 {
@@ -53,6 +56,33 @@ class GadgetMessageReader
    */
   virtual ACE_Message_Block* read(ACE_SOCK_Stream* stream) = 0;
 
+  /**
+     Reads a message from the buffered connection input. Readers overriding this function must also
+     return true from supports_read_ahead(). The default implementation reads straight from the socket,
+     which is only valid while read-ahead is disabled on the input stream.
+   */
+  virtual ACE_Message_Block* read_buffered(GadgetInputStream* stream)
+  {
+    if (stream->buffered()) {
+      GERROR("GadgetMessageReader, reader does not support buffered input but %d bytes are buffered\n", stream->buffered());
+      return 0;
+    }
+    return this->read(stream->socket());
+  }
+
+  virtual bool supports_read_ahead()
+  {
+    return false;
+  }
+
+  /**
+     Called with the ISMRMRD parameters (XML header) of the connection when they are received, before the
+     data messages, e.g. to prepare buffers of the expected size.
+   */
+  virtual void set_parameters(const std::string& xml)
+  {
+  }
+
 };
 
 /**
@@ -68,6 +98,20 @@ class GadgetMessageWriter
      Function must be implemented to write a specific message.
    */
   virtual int write(ACE_SOCK_Stream* stream, ACE_Message_Block* mb) = 0;
+
+  /**
+     Appends a message to the gather list of the output stream. The message block is kept alive until
+     the stream has been flushed, so writers may reference its storage instead of copying it.
+     The default implementation sends anything pending and then writes straight to the socket.
+   */
+  virtual int write_gather(GadgetOutputStream* stream, ACE_Message_Block* mb)
+  {
+    if (stream->pending_bytes() && stream->flush() < 0) {
+      GERROR("GadgetMessageWriter, failed to flush output stream\n");
+      return -1;
+    }
+    return this->write(stream->socket(), mb);
+  }
 };
 
 class GadgetMessageWriterContainer
@@ -159,6 +203,29 @@ class GadgetMessageReaderContainer
     map_.clear();
     return 0;
   }
+
+  /**
+     True if every registered reader can take its input from the read-ahead buffer.
+   */
+  bool supports_read_ahead()
+  {
+    std::map< ACE_UINT16, GadgetMessageReader* >::iterator it;
+
+    for (it = map_.begin(); it != map_.end(); it++) {
+      if (!it->second->supports_read_ahead()) return false;
+    }
+    return true;
+  }
+
+  void set_parameters(const std::string& xml)
+  {
+    std::map< ACE_UINT16, GadgetMessageReader* >::iterator it;
+
+    for (it = map_.begin(); it != map_.end(); it++) {
+      it->second->set_parameters(xml);
+    }
+  }
+
  protected:
   std::map<ACE_UINT16, GadgetMessageReader*> map_;
 };
@@ -167,6 +234,19 @@ class GadgetMessageConfigFileReader : public GadgetMessageReader
 {
  public:
   virtual ACE_Message_Block* read(ACE_SOCK_STREAM* stream) {
+    return read_impl(stream);
+  }
+
+  virtual ACE_Message_Block* read_buffered(GadgetInputStream* stream) {
+    return read_impl(stream);
+  }
+
+  virtual bool supports_read_ahead() {
+    return true;
+  }
+
+ protected:
+  template <class S> ACE_Message_Block* read_impl(S* stream) {
 
     GadgetContainerMessage<GadgetMessageConfigurationFile>* mb1 =
       new GadgetContainerMessage<GadgetMessageConfigurationFile>();
@@ -192,6 +272,19 @@ class GadgetMessageScriptReader : public GadgetMessageReader
 {
  public:
   virtual ACE_Message_Block* read(ACE_SOCK_STREAM* stream) {
+    return read_impl(stream);
+  }
+
+  virtual ACE_Message_Block* read_buffered(GadgetInputStream* stream) {
+    return read_impl(stream);
+  }
+
+  virtual bool supports_read_ahead() {
+    return true;
+  }
+
+ protected:
+  template <class S> ACE_Message_Block* read_impl(S* stream) {
 
     GadgetMessageScript ms;
 
@@ -0,0 +1,208 @@
+#ifndef GADGETMESSAGEQUEUE_H
+#define GADGETMESSAGEQUEUE_H
+#pragma once
+
+#include <ace/Message_Queue_T.h>
+#include <ace/Synch_Traits.h>
+#include <ace/Thread_Mutex.h>
+#include <ace/Guard_T.h>
+#include <ace/OS_NS_sys_time.h>
+#include <atomic>
+#include <limits>
+
+#include "GadgetWorkerPool.h"
+#include "GadgetTrace.h"
+
+namespace Gadgetron{
+
+  struct GadgetQueueStatistics
+  {
+    size_t message_count;       //Messages on the queue right now
+    size_t max_message_count;   //Largest queue depth seen
+    size_t enqueued;
+    size_t dequeued;
+    double elapsed;             //Seconds since the queue was created
+    double total_wait;          //Seconds producers spent blocked on a full queue
+    double max_wait;            //Longest single enqueue, in seconds
+
+    GadgetQueueStatistics()
+      : message_count(0), max_message_count(0), enqueued(0), dequeued(0), elapsed(0), total_wait(0), max_wait(0)
+    {
+    }
+
+    double enqueue_rate() const { return elapsed > 0 ? enqueued / elapsed : 0.0; }
+    double dequeue_rate() const { return elapsed > 0 ? dequeued / elapsed : 0.0; }
+  };
+
+  /**
+     Notified after a message has been put on a GadgetMessageQueue.
+   */
+  class GadgetMessageQueueListener
+  {
+  public:
+    virtual ~GadgetMessageQueueListener() {}
+    virtual void message_enqueued() = 0;
+  };
+
+  /**
+     Input queue of a Gadget.
+
+     Without watermarks it behaves like the default ACE message queue. With watermarks set, the
+     queue is bounded by the number of messages: once high_watermark messages are queued, putq blocks
+     until the consumer has brought the queue down to low_watermark. Since gadgets hand messages
+     downstream with putq, a slow gadget stalls its upstream neighbours and ultimately the socket
+     reader of the stream controller, instead of letting memory grow.
+
+     Message counts are used rather than bytes, because the ACE byte count only covers the container
+     objects and not the arrays they own.
+
+     Workers of the GadgetWorkerPool are never blocked by a full queue, since a blocked worker could
+     be the one needed to drain it. With the pool, backpressure is applied where messages enter the
+     stream from other threads, i.e. at the socket reader.
+   */
+  class GadgetMessageQueue : public ACE_Message_Queue<ACE_MT_SYNCH>
+  {
+    typedef ACE_Message_Queue<ACE_MT_SYNCH> inherited;
+
+  public:
+    GadgetMessageQueue()
+      : inherited()
+      , high_watermark_(0)
+      , low_watermark_(0)
+      , full_(false)
+      , listener_(0)
+      , trace_tag_(0)
+      , created_(ACE_OS::gettimeofday())
+    {
+    }
+
+    /**
+       Bounds the queue to high_watermark messages, zero removes the bound. The low watermark is set to
+       half the high watermark if it is zero or not below the high watermark.
+     */
+    void set_watermarks(size_t high_watermark, size_t low_watermark)
+    {
+      if (high_watermark && high_watermark < 2) high_watermark = 2;
+      if (low_watermark == 0 || low_watermark >= high_watermark) low_watermark = high_watermark / 2;
+
+      if (high_watermark) {
+        //Flow control is done on the message count, let every dequeue wake blocked producers
+        this->high_water_mark(std::numeric_limits<size_t>::max());
+        this->low_water_mark(std::numeric_limits<size_t>::max());
+      }
+
+      ACE_GUARD(ACE_MT_SYNCH::MUTEX, guard, this->lock_);
+      high_watermark_ = high_watermark;
+      low_watermark_ = low_watermark;
+      full_ = false;
+    }
+
+    size_t high_watermark() const { return high_watermark_; }
+    size_t low_watermark() const { return low_watermark_; }
+
+    /**
+       Sets the object notified on every successful enqueue_tail, 0 for none. Must be set before
+       messages arrive.
+     */
+    void set_listener(GadgetMessageQueueListener* listener)
+    {
+      listener_ = listener;
+    }
+
+    /**
+       Enqueues and dequeues are recorded with GadgetTrace under this tag. The tag is set while the Gadget
+       threads are running, so it is published as one atomic word.
+     */
+    void set_trace_tag(const GadgetTraceTag& tag)
+    {
+      trace_tag_.store((uint64_t(tag.stream) << 32) | tag.gadget, std::memory_order_release);
+    }
+
+    GadgetTraceTag trace_tag() const
+    {
+      uint64_t t = trace_tag_.load(std::memory_order_acquire);
+      GadgetTraceTag tag;
+      tag.stream = uint32_t(t >> 32);
+      tag.gadget = uint32_t(t);
+      return tag;
+    }
+
+    virtual int enqueue_tail(ACE_Message_Block* new_item, ACE_Time_Value* timeout = 0)
+    {
+      GadgetTrace::record(this->trace_tag(), GADGET_TRACE_ENQUEUE, new_item);
+
+      ACE_Time_Value start = ACE_OS::gettimeofday();
+      int res = inherited::enqueue_tail(new_item, timeout);
+      ACE_Time_Value waited = ACE_OS::gettimeofday() - start;
+
+      if (res >= 0) {
+        ACE_Guard<ACE_Thread_Mutex> guard(stats_mutex_);
+        stats_.enqueued++;
+        double w = waited.sec() + waited.usec()*1e-6;
+        stats_.total_wait += w;
+        if (w > stats_.max_wait) stats_.max_wait = w;
+        if (size_t(res) > stats_.max_message_count) stats_.max_message_count = res;
+      }
+
+      if (res >= 0 && listener_) {
+        listener_->message_enqueued();
+      }
+      return res;
+    }
+
+    virtual int dequeue_head(ACE_Message_Block*& first_item, ACE_Time_Value* timeout = 0)
+    {
+      int res = inherited::dequeue_head(first_item, timeout);
+      if (res >= 0) {
+        GadgetTrace::record(this->trace_tag(), GADGET_TRACE_DEQUEUE, first_item);
+        ACE_Guard<ACE_Thread_Mutex> guard(stats_mutex_);
+        stats_.dequeued++;
+      }
+      return res;
+    }
+
+    GadgetQueueStatistics statistics()
+    {
+      GadgetQueueStatistics s;
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(stats_mutex_);
+        s = stats_;
+      }
+      s.message_count = this->message_count();
+      ACE_Time_Value elapsed = ACE_OS::gettimeofday() - created_;
+      s.elapsed = elapsed.sec() + elapsed.usec()*1e-6;
+      return s;
+    }
+
+  protected:
+    //Called with the queue lock held
+    virtual bool is_full_i(void)
+    {
+      if (!high_watermark_) {
+        return inherited::is_full_i();
+      }
+
+      if (GadgetWorkerPool::is_worker_thread()) {
+        return false;
+      }
+
+      if (this->cur_count_ >= high_watermark_) {
+        full_ = true;
+      } else if (this->cur_count_ <= low_watermark_) {
+        full_ = false;
+      }
+      return full_;
+    }
+
+    size_t high_watermark_;
+    size_t low_watermark_;
+    bool full_;
+    GadgetMessageQueueListener* listener_;
+    std::atomic<uint64_t> trace_tag_; //Stream in the upper, gadget in the lower 32 bits
+
+    ACE_Time_Value created_;
+    ACE_Thread_Mutex stats_mutex_;
+    GadgetQueueStatistics stats_;
+  };
+}
+#endif //GADGETMESSAGEQUEUE_H
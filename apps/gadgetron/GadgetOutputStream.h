@@ -0,0 +1,131 @@
+#ifndef GADGETOUTPUTSTREAM_H
+#define GADGETOUTPUTSTREAM_H
+
+#include <ace/SOCK_Stream.h>
+#include <ace/os_include/sys/os_uio.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace Gadgetron{
+
+  /**
+     Gather list of outgoing bytes for the connection socket.
+
+     Writers append the pieces of a message (identifier, header, attributes, data) and the whole list
+     is sent with writev when flush() is called, instead of one send per piece. Large buffers such as
+     the storage of a hoNDArray are referenced in place and must stay valid until the next flush;
+     small or temporary pieces are copied into an internal staging buffer.
+   */
+  class GadgetOutputStream
+  {
+  public:
+    GadgetOutputStream(ACE_SOCK_Stream* socket)
+      : socket_(socket)
+      , pending_bytes_(0)
+    {
+    }
+
+    ACE_SOCK_Stream* socket()
+    {
+      return socket_;
+    }
+
+    /**
+       Appends len bytes that remain valid until the next flush.
+     */
+    void append(const void* buf, size_t len)
+    {
+      if (len < copy_threshold) {
+        this->append_copy(buf, len);
+        return;
+      }
+
+      Segment s;
+      s.ptr = reinterpret_cast<const char*>(buf);
+      s.offset = 0;
+      s.len = len;
+      segments_.push_back(s);
+      pending_bytes_ += len;
+    }
+
+    /**
+       Appends a copy of len bytes, e.g. from a stack variable.
+     */
+    void append_copy(const void* buf, size_t len)
+    {
+      if (!len) return;
+
+      //Consecutive copies share one segment
+      if (!segments_.empty() && !segments_.back().ptr && segments_.back().offset + segments_.back().len == staging_.size()) {
+        segments_.back().len += len;
+      } else {
+        Segment s;
+        s.ptr = 0;
+        s.offset = staging_.size();
+        s.len = len;
+        segments_.push_back(s);
+      }
+
+      const char* src = reinterpret_cast<const char*>(buf);
+      staging_.insert(staging_.end(), src, src + len);
+      pending_bytes_ += len;
+    }
+
+    size_t pending_bytes() const
+    {
+      return pending_bytes_;
+    }
+
+    /**
+       Sends all pending bytes. Returns the number of bytes sent or -1 on error.
+     */
+    ssize_t flush()
+    {
+      ssize_t sent = 0;
+      std::vector<iovec> iov(segments_.size());
+
+      for (size_t i = 0; i < segments_.size(); i++) {
+        const char* base = segments_[i].ptr ? segments_[i].ptr : &staging_[segments_[i].offset];
+        iov[i].iov_base = const_cast<char*>(base);
+        iov[i].iov_len = segments_[i].len;
+      }
+
+      for (size_t i = 0; i < iov.size(); i += ACE_IOV_MAX) {
+        int n = static_cast<int>(std::min(iov.size() - i, size_t(ACE_IOV_MAX)));
+        ssize_t r = socket_->sendv_n(&iov[i], n);
+        if (r < 0) {
+          this->clear();
+          return -1;
+        }
+        sent += r;
+      }
+
+      this->clear();
+      return sent;
+    }
+
+    void clear()
+    {
+      segments_.clear();
+      staging_.clear();
+      pending_bytes_ = 0;
+    }
+
+    static const size_t copy_threshold = 4096;
+
+  protected:
+    struct Segment
+    {
+      const char* ptr;
+      size_t offset;
+      size_t len;
+    };
+
+    ACE_SOCK_Stream* socket_;
+    std::vector<Segment> segments_;
+    std::vector<char> staging_;
+    size_t pending_bytes_;
+  };
+}
+#endif //GADGETOUTPUTSTREAM_H
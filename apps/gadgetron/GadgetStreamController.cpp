@@ -17,6 +17,7 @@
 
 #include <complex>
 #include <fstream>
+#include <iterator>
 #include <boost/filesystem.hpp>
 
 using namespace Gadgetron;
@@ -25,6 +26,8 @@ GadgetStreamController::GadgetStreamController()
   : GadgetStreamInterface()
   , notifier_ (0, this, ACE_Event_Handler::WRITE_MASK)
   , writer_task_(&this->peer())
+  , input_(&this->peer())
+  , prepared_chain_(false)
 {
   CloudBus::instance()->report_recon_start();    
 }
@@ -36,6 +39,7 @@ GadgetStreamController::~GadgetStreamController()
 
 int GadgetStreamController::open (void)
 {
+  connection_time_ = std::chrono::steady_clock::now();
 
   //We will set up the controllers message queue such that when a packet is enqueued write will be triggered.
   this->notifier_.reactor (this->reactor ());
@@ -70,7 +74,7 @@ int GadgetStreamController::svc(void)
   while (true) {
     GadgetMessageIdentifier id;
     ssize_t recv_cnt = 0;
-    if ((recv_cnt = peer().recv_n (&id, sizeof(GadgetMessageIdentifier))) <= 0) {
+    if ((recv_cnt = input_.recv_n (&id, sizeof(GadgetMessageIdentifier))) <= 0) {
       GERROR("GadgetStreamController, unable to read message identifier\n");
       return -1;
     }
@@ -91,7 +95,7 @@ int GadgetStreamController::svc(void)
       return GADGET_FAIL;
     }
 
-    ACE_Message_Block* mb = r->read(&peer());
+    ACE_Message_Block* mb = r->read_buffered(&input_);
 
     if (!mb) {
       GERROR("GadgetMessageReader returned null pointer\n");
@@ -114,6 +118,9 @@ int GadgetStreamController::svc(void)
 	  return GADGET_FAIL;
 	} else {
 	  mb->release();
+	  this->enable_read_ahead();
+	  this->start_trace();
+	  this->report_setup_time();
 	  continue;
 	}
       }
@@ -126,13 +133,20 @@ int GadgetStreamController::svc(void)
 	return GADGET_FAIL;
       } else {
 	mb->release();
+	this->enable_read_ahead();
+	this->start_trace();
+	this->report_setup_time();
 	continue;
       }
     }
 
-    ACE_Time_Value wait = ACE_OS::gettimeofday() + ACE_Time_Value(0,10000); //10ms from now
+    if (id.id == GADGET_MESSAGE_PARAMETER_SCRIPT) {
+      readers_.set_parameters(std::string(mb->rd_ptr(), mb->length()));
+    }
+
+    //Blocks while the first Gadget's queue is above its high watermark, which stops reading from the socket
     if (stream_.put(mb) == -1) {
-      GERROR("Failed to put stuff on stream, too long wait, %d\n",  ACE_OS::last_error () ==  EWOULDBLOCK);
+      GERROR("Failed to put stuff on stream, %d\n",  ACE_OS::last_error ());
       mb->release();
       return GADGET_FAIL;
     }
@@ -140,6 +154,21 @@ int GadgetStreamController::svc(void)
   return GADGET_OK;
 }
 
+void GadgetStreamController::enable_read_ahead()
+{
+  //Readers that read from the socket directly need the socket to be positioned at message boundaries
+  bool read_ahead = readers_.supports_read_ahead();
+  input_.read_ahead(read_ahead);
+  GDEBUG("Input read-ahead %s\n", read_ahead ? "enabled" : "disabled, not supported by all readers");
+}
+
+void GadgetStreamController::report_setup_time()
+{
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - connection_time_).count();
+  GINFO("Connection set up in %.1f ms%s\n", seconds * 1000, prepared_chain_ ? ", using a prepared Gadget chain" : "");
+  GadgetChainPool::instance()->report_setup_time(seconds, prepared_chain_);
+}
+
 int GadgetStreamController::handle_input (ACE_HANDLE)
 {
   return 0;
@@ -163,7 +192,10 @@ int GadgetStreamController::handle_close (ACE_HANDLE, ACE_Reactor_Mask mask)
 
   GINFO("Shutting down stream and closing up shop...\n");
   
+  this->print_queue_statistics();
+
   this->stream_.close();
+  this->finish_trace();
 
   //Empty output queue in case there is something on it.
   int messages_dropped = this->msg_queue ()->flush();
@@ -173,20 +205,12 @@ int GadgetStreamController::handle_close (ACE_HANDLE, ACE_Reactor_Mask mask)
     this->reactor ()->handle_events(); //Flush any remaining events before we delete this Stream Controller
   }
 
+  GDEBUG("Received %d bytes in %d socket reads\n", input_.bytes_received(), input_.number_of_syscalls());
+
   // Remove all readers and writers
   //writers_.clear();
   readers_.clear();
   
-  //Clear DLL handles (to make DLLs unload if needed)
-  for (unsigned int i = 0; i < dll_handles_.size(); i++) {
-#if defined WIN32
-    dll_handles_[i]->close(0); //On windows we will not unload the DLLs even when there are no more refs
-#else 
-    dll_handles_[i]->close(0); //On Unix/Mac it seems to be OK to do this
-#endif
-  }
-  dll_handles_.clear();
-  
   GINFO("Stream is closed\n");
 
   delete this;
@@ -201,26 +225,46 @@ int GadgetStreamController::configure_from_file(std::string filename)
 
   GINFO("Running configuration: %s\n", full_path.c_str());
 
-  std::ifstream config_file_stream (full_path.c_str(), std::ios::in);
+  std::unique_ptr<GadgetChain> chain = GadgetChainPool::instance()->take(filename);
+  if (chain) {
+    prepared_chain_ = true;
+    return configure(std::move(chain));
+  }
 
-  if (!config_file_stream.is_open()) {
-    GERROR("Unable to open configuation file: %s\n", full_path.c_str());
+  GadgetronXML::GadgetStreamConfiguration cfg;
+  try {
+    GadgetComponentCache::instance()->stream_configuration(full_path, cfg);
+  }  catch (const std::exception& e) {
+    GERROR("Failed to parse Gadget Stream Configuration: %s\n", e.what());
     return GADGET_FAIL;
   }
 
-  return configure(config_file_stream);
+  return configure(GadgetChainPool::build(cfg));
 }
 
 int GadgetStreamController::configure(std::istream& config_file_stream)
 {
+  std::string xml((std::istreambuf_iterator<char>(config_file_stream)), std::istreambuf_iterator<char>());
+
   GadgetronXML::GadgetStreamConfiguration cfg;
   try {
-    deserialize(config_file_stream, cfg);
-  }  catch (const std::runtime_error& e) {
+    GadgetComponentCache::instance()->stream_configuration(xml, cfg);
+  }  catch (const std::exception& e) {
     GERROR("Failed to parse Gadget Stream Configuration: %s\n", e.what());
     return GADGET_FAIL;
   }
 
+  return configure(GadgetChainPool::build(cfg));
+}
+
+int GadgetStreamController::configure(std::unique_ptr<GadgetChain> chain)
+{
+  if (!chain) {
+    GERROR("Failed to create the components of the Gadget Stream Configuration\n");
+    return GADGET_FAIL;
+  }
+
+  const GadgetronXML::GadgetStreamConfiguration& cfg = chain->configuration;
   stream_configuration_ = cfg;
 
   GINFO("Found %d readers\n", cfg.reader.size());
@@ -228,113 +272,56 @@ int GadgetStreamController::configure(std::istream& config_file_stream)
   GINFO("Found %d gadgets\n", cfg.gadget.size());
   
   //Configuration of readers
-  for (std::vector<GadgetronXML::Reader>::iterator i = cfg.reader.begin();
-       i != cfg.reader.end();
-       ++i) 
+  for (size_t i = 0; i < cfg.reader.size(); i++) 
     {
-
-      long slot = 0;
-      std::string dllname("");
-      std::string classname("");
-
-      slot = i->slot;
-      dllname = i->dll;
-      classname = i->classname;
-
       GINFO("--Found reader declaration\n");
-      GINFO("  Reader dll: %s\n", dllname.c_str());
-      GINFO("  Reader class: %s\n", classname.c_str());
-      GINFO("  Reader slot: %d\n", slot);
+      GINFO("  Reader dll: %s\n", cfg.reader[i].dll.c_str());
+      GINFO("  Reader class: %s\n", cfg.reader[i].classname.c_str());
+      GINFO("  Reader slot: %d\n", cfg.reader[i].slot);
 
-      GadgetMessageReader* r =
-	load_dll_component<GadgetMessageReader>(dllname.c_str(),
-						classname.c_str());
-      
-      if (!r) {
-	GERROR("Failed to load GadgetMessageReader from DLL\n");
-	return GADGET_FAIL;
-      }
-      
-      readers_.insert(slot, r);
-      
+      readers_.insert(chain->readers[i].first, chain->readers[i].second);
+      chain->readers[i].second = 0;
     }	
   //Configuration of readers end
 
 
   //Configuration of writers
-  for (std::vector<GadgetronXML::Writer>::iterator i = cfg.writer.begin();
-       i != cfg.writer.end();
-       ++i) 
+  for (size_t i = 0; i < cfg.writer.size(); i++) 
     {
-      long slot = 0;
-      std::string dllname("");
-      std::string classname("");
-      
-      slot = i->slot;
-      dllname = i->dll;
-      classname = i->classname;
-
       GINFO("--Found writer declaration\n");
-      GINFO("  Writer dll: %s\n", dllname.c_str());
-      GINFO("  Writer class: %s\n", classname.c_str());
-      GINFO("  Writer slot: %d\n", slot);
-      
-      GadgetMessageWriter* w =
-	load_dll_component<GadgetMessageWriter>(dllname.c_str(),
-						classname.c_str());
-      
-      if (!w) {
-	GERROR("Failed to load GadgetMessageWriter from DLL\n");
-	return GADGET_FAIL;
-      }
+      GINFO("  Writer dll: %s\n", cfg.writer[i].dll.c_str());
+      GINFO("  Writer class: %s\n", cfg.writer[i].classname.c_str());
+      GINFO("  Writer slot: %d\n", cfg.writer[i].slot);
       
-      writer_task_.register_writer(slot, w);
+      writer_task_.register_writer(chain->writers[i].first, chain->writers[i].second);
+      chain->writers[i].second = 0;
     }
   //Configuration of writers end
 
+  if (cfg.outputCoalescing) {
+    GINFO("Output coalescing: %d bytes, %d us\n", cfg.outputCoalescing->maxBytes, cfg.outputCoalescing->maxLatency);
+    writer_task_.set_coalescing(cfg.outputCoalescing->maxBytes, cfg.outputCoalescing->maxLatency);
+  }
+
   //Let's configure the stream
   GDEBUG("Processing %d gadgets in reverse order\n",cfg.gadget.size());
 
-  for (std::vector<GadgetronXML::Gadget>::reverse_iterator i = cfg.gadget.rbegin();
-       i != cfg.gadget.rend();
-       ++i) 
+  for (size_t n = cfg.gadget.size(); n-- > 0; ) 
     {
-      std::string gadgetname("");
-      std::string dllname("");
-      std::string classname("");
-
-      gadgetname = i->name;
-      dllname = i->dll;
-      classname = i->classname;
+      const GadgetronXML::Gadget& gadget = cfg.gadget[n];
 
       GINFO("--Found gadget declaration\n");
-      GINFO("  Gadget Name: %s\n", gadgetname.c_str());
-      GINFO("  Gadget dll: %s\n", dllname.c_str());
-      GINFO("  Gadget class: %s\n", classname.c_str());
+      GINFO("  Gadget Name: %s\n", gadget.name.c_str());
+      GINFO("  Gadget dll: %s\n", gadget.dll.c_str());
+      GINFO("  Gadget class: %s\n", gadget.classname.c_str());
+      GINFO("  Gadget parameters: %d\n", gadget.property.size());
 
-      GadgetModule* m = create_gadget_module(dllname.c_str(),
-					     classname.c_str(),
-					     gadgetname.c_str());
-      
-      if (!m) {
-	GERROR("Failed to create GadgetModule from %s:%s\n",
-	       classname.c_str(),
-	       dllname.c_str());
-	return GADGET_FAIL;
-      }
-      
-      Gadget* g = dynamic_cast<Gadget*>(m->writer());//Get the gadget out of the module
-      
-      GINFO("  Gadget parameters: %d\n", i->property.size());
-      for (std::vector<GadgetronXML::GadgetronParameter>::iterator p = i->property.begin();
-	   p != i->property.end();
-	   ++p)
-	{
-	  std::string pname(p->name);
-	  std::string pval(p->value);
-	  GINFO("Setting parameter %s = %s\n", pname.c_str(),pval.c_str());
-	  g->set_parameter(pname.c_str(),pval.c_str(),false);
-	}
+      Gadget* g = chain->gadgets[n];
+      g->set_controller(this);
+
+      GadgetModule* m = 0;
+      ACE_NEW_RETURN (m, GadgetModule (gadget.name.c_str(), g), GADGET_FAIL);
+      chain->gadgets[n] = 0; //The module deletes the Gadget
       
       // set the global gadget parameters for every gadget
       std::map<std::string, std::string>::const_iterator iter;
@@ -346,7 +333,7 @@ int GadgetStreamController::configure(std::istream& config_file_stream)
         }
 
       if (stream_.push(m) < 0) {
-	GERROR("Failed to push Gadget %s onto stream\n", gadgetname.c_str());
+	GERROR("Failed to push Gadget %s onto stream\n", gadget.name.c_str());
 	delete m;
 	return GADGET_FAIL;
       }
@@ -358,5 +345,3 @@ int GadgetStreamController::configure(std::istream& config_file_stream)
 
   return GADGET_OK;
 }
-
-
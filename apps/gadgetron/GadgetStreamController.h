@@ -8,12 +8,16 @@
 #include "ace/Svc_Handler.h"
 #include "ace/Reactor_Notification_Strategy.h"
 
+#include <chrono>
 #include <complex>
+#include <memory>
 #include <vector>
 
 #include "gadgetbase_export.h"
 #include "GadgetronConnector.h"
+#include "GadgetInputStream.h"
 #include "GadgetStreamInterface.h"
+#include "GadgetChainPool.h"
 
 
 namespace Gadgetron{
@@ -41,8 +45,14 @@ private:
   WriterTask writer_task_;
   ACE_Reactor_Notification_Strategy notifier_;
   GadgetMessageReaderContainer readers_;
+  GadgetInputStream input_;
+  std::chrono::steady_clock::time_point connection_time_;
+  bool prepared_chain_;
+  void enable_read_ahead();
+  void report_setup_time();
   virtual int configure(std::istream &config_file_stream);
   virtual int configure_from_file(std::string filename);
+  int configure(std::unique_ptr<GadgetChain> chain);
 };
 
 }
@@ -16,6 +16,7 @@ namespace Gadgetron {
     GadgetStreamInterface::GadgetStreamInterface()
             : stream_configured_(false)
             , stream_(nullptr, nullptr, default_end_module())
+            , trace_stream_(0)
     {
         gadgetron_home_ = get_gadgetron_home();
     }
@@ -45,6 +46,63 @@ namespace Gadgetron {
     }
 
 
+    std::vector< std::pair<std::string, GadgetQueueStatistics> > GadgetStreamInterface::get_queue_statistics()
+    {
+        std::vector< std::pair<std::string, GadgetQueueStatistics> > stats;
+
+        ACE_Stream_Iterator<ACE_MT_SYNCH> it(stream_);
+        const GadgetModule* gm = 0;
+        while (it.next(gm)) {
+            Gadget* g = dynamic_cast<Gadget*>(const_cast<GadgetModule*>(gm)->writer());
+            if (g) {
+                stats.push_back(std::make_pair(std::string(gm->name()), g->queue_statistics()));
+            }
+            it.advance();
+        }
+
+        return stats;
+    }
+
+    void GadgetStreamInterface::print_queue_statistics()
+    {
+        std::vector< std::pair<std::string, GadgetQueueStatistics> > stats = this->get_queue_statistics();
+        for (size_t i = 0; i < stats.size(); i++) {
+            const GadgetQueueStatistics& s = stats[i].second;
+            GDEBUG("Queue %s: depth %d (max %d), %d in (%.1f/s), %d out (%.1f/s), max wait %.3f s, total wait %.3f s\n",
+                   stats[i].first.c_str(), (int)s.message_count, (int)s.max_message_count,
+                   (int)s.enqueued, s.enqueue_rate(), (int)s.dequeued, s.dequeue_rate(), s.max_wait, s.total_wait);
+        }
+    }
+
+    void GadgetStreamInterface::start_trace()
+    {
+        if (!GadgetTrace::instance()->enabled() || trace_stream_) return;
+
+        trace_stream_ = GadgetTrace::instance()->open_stream();
+        trace_gadget_names_.clear();
+
+        ACE_Stream_Iterator<ACE_MT_SYNCH> it(stream_);
+        const GadgetModule* gm = 0;
+        while (it.next(gm)) {
+            Gadget* g = dynamic_cast<Gadget*>(const_cast<GadgetModule*>(gm)->writer());
+            if (g) {
+                GadgetTraceTag tag;
+                tag.stream = trace_stream_;
+                tag.gadget = static_cast<uint32_t>(trace_gadget_names_.size());
+                g->set_trace_tag(tag);
+                trace_gadget_names_.push_back(std::string(gm->name()));
+            }
+            it.advance();
+        }
+    }
+
+    void GadgetStreamInterface::finish_trace()
+    {
+        if (!trace_stream_) return;
+        GadgetTrace::instance()->close_stream(trace_stream_, trace_gadget_names_);
+        trace_stream_ = 0;
+    }
+
     GadgetModule *GadgetStreamInterface::create_gadget_module(const char* DLL, const char* gadget, const char* gadget_module_name)
     {
 
@@ -0,0 +1,260 @@
+#include "GadgetTrace.h"
+#include "log.h"
+
+#include <ace/OS_NS_unistd.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace Gadgetron
+{
+  namespace
+  {
+    bool earlier(const GadgetTraceEvent& a, const GadgetTraceEvent& b)
+    {
+      return a.time < b.time;
+    }
+
+    std::string json_escape(const std::string& s)
+    {
+      std::string r;
+      for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') r += '\\';
+        r += s[i];
+      }
+      return r;
+    }
+
+    std::string gadget_name(const std::vector<std::string>& names, uint32_t gadget)
+    {
+      if (gadget < names.size()) return json_escape(names[gadget]);
+      std::stringstream ss;
+      ss << "gadget " << gadget;
+      return ss.str();
+    }
+  }
+
+  GadgetTrace* GadgetTrace::instance()
+  {
+    static GadgetTrace trace;
+    return &trace;
+  }
+
+  GadgetTrace::GadgetTrace()
+    : enabled_(false)
+    , format_(CHROME_JSON)
+    , ring_capacity_(32768)
+    , next_stream_(1)
+    , next_thread_(0)
+  {
+  }
+
+  void GadgetTrace::enable(const std::string& directory, Format format, size_t ring_capacity)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (enabled_) {
+      GWARN("Gadget tracing is already enabled\n");
+      return;
+    }
+
+    size_t capacity = 1;
+    while (capacity < ring_capacity) capacity <<= 1;
+
+    directory_ = directory;
+    format_ = format;
+    ring_capacity_ = capacity;
+    enabled_ = true;
+
+    GINFO("Gadget tracing enabled, writing %s traces to %s\n", format == BINARY ? "binary" : "JSON", directory.c_str());
+  }
+
+  uint32_t GadgetTrace::open_stream()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t stream = next_stream_++;
+    if (!next_stream_) next_stream_ = 1;
+    open_streams_.insert(stream);
+    return stream;
+  }
+
+  void GadgetTrace::record_event(const GadgetTraceTag& tag, GadgetTraceEventType type, const void* message)
+  {
+    static thread_local std::shared_ptr<Ring> thread_ring;
+    if (!thread_ring) {
+      thread_ring = this->register_thread();
+    }
+    Ring* ring = thread_ring.get();
+
+    uint64_t h = ring->head.load(std::memory_order_relaxed);
+    GadgetTraceEvent& e = ring->events[h & (ring->events.size() - 1)];
+    e.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    e.message = reinterpret_cast<uint64_t>(message);
+    e.stream = tag.stream;
+    e.gadget = tag.gadget;
+    e.thread = ring->thread;
+    e.type = type;
+    ring->head.store(h + 1, std::memory_order_release);
+  }
+
+  std::shared_ptr<GadgetTrace::Ring> GadgetTrace::register_thread()
+  {
+    std::shared_ptr<Ring> ring(new Ring());
+    ring->head = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring->events.resize(ring_capacity_);
+    ring->thread = next_thread_++;
+    rings_.push_back(ring);
+    return ring;
+  }
+
+  std::vector<GadgetTraceEvent> GadgetTrace::collect(uint32_t stream)
+  {
+    std::vector<GadgetTraceEvent> events;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t r = 0; r < rings_.size(); r++) {
+      const Ring& ring = *rings_[r];
+      const uint64_t capacity = ring.events.size();
+
+      uint64_t head = ring.head.load(std::memory_order_acquire);
+      uint64_t begin = head > capacity ? head - capacity : 0;
+      size_t first = events.size();
+      std::vector<uint64_t> index;
+      for (uint64_t i = begin; i < head; i++) {
+        const GadgetTraceEvent& e = ring.events[i & (capacity - 1)];
+        if (e.stream == stream) {
+          events.push_back(e);
+          index.push_back(i);
+        }
+      }
+
+      //Drop the events the owning thread may have overwritten while we were copying. The slot of event
+      //head_after - capacity is the one being written next, so it may be torn as well.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint64_t head_after = ring.head.load(std::memory_order_relaxed);
+      uint64_t valid = head_after >= capacity ? head_after - capacity + 1 : 0;
+      size_t kept = first;
+      for (size_t k = 0; k < index.size(); k++) {
+        if (index[k] >= valid) events[kept++] = events[first + k];
+      }
+      events.resize(kept);
+    }
+
+    std::stable_sort(events.begin(), events.end(), earlier);
+    return events;
+  }
+
+  bool GadgetTrace::close_stream(uint32_t stream, const std::vector<std::string>& gadget_names)
+  {
+    std::vector<GadgetTraceEvent> events = this->collect(stream);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      open_streams_.erase(stream);
+      this->prune_rings();
+    }
+
+    std::stringstream name;
+    name << "gadgetron_trace_" << ACE_OS::getpid() << "_" << stream << (format_ == BINARY ? ".bin" : ".json");
+    boost::filesystem::path filename = boost::filesystem::path(directory_) / name.str();
+
+    std::ofstream f(filename.string().c_str(), std::ios::out | std::ios::binary);
+    if (!f.is_open()) {
+      GERROR("Unable to open trace file %s\n", filename.string().c_str());
+      return false;
+    }
+
+    if (format_ == BINARY) {
+      write_binary(f, events, gadget_names);
+    } else {
+      write_chrome_json(f, events, gadget_names);
+    }
+
+    GDEBUG("Wrote %d trace events to %s\n", (int)events.size(), filename.string().c_str());
+    return f.good();
+  }
+
+  //Called with mutex_ held. Rings of exited threads are dropped once no open stream has events in them.
+  void GadgetTrace::prune_rings()
+  {
+    std::vector< std::shared_ptr<Ring> > keep;
+    for (size_t r = 0; r < rings_.size(); r++) {
+      const Ring& ring = *rings_[r];
+      bool needed = rings_[r].use_count() > 1;
+
+      uint64_t head = ring.head.load(std::memory_order_acquire);
+      uint64_t begin = head > ring.events.size() ? head - ring.events.size() : 0;
+      for (uint64_t i = begin; !needed && i < head; i++) {
+        needed = open_streams_.count(ring.events[i & (ring.events.size() - 1)].stream) > 0;
+      }
+
+      if (needed) keep.push_back(rings_[r]);
+    }
+    rings_.swap(keep);
+  }
+
+  void GadgetTrace::write_chrome_json(std::ostream& os, const std::vector<GadgetTraceEvent>& events, const std::vector<std::string>& gadget_names)
+  {
+    uint64_t t0 = events.empty() ? 0 : events.front().time;
+    std::set<uint32_t> threads;
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    os << std::fixed << std::setprecision(3);
+
+    for (size_t i = 0; i < events.size(); i++) {
+      const GadgetTraceEvent& e = events[i];
+      threads.insert(e.thread);
+
+      os << "{\"name\":\"" << gadget_name(gadget_names, e.gadget) << "\",";
+      switch (e.type) {
+      case GADGET_TRACE_ENQUEUE:
+        os << "\"cat\":\"queue\",\"ph\":\"b\",\"id\":\"0x" << std::hex << e.message << std::dec << "\",";
+        break;
+      case GADGET_TRACE_DEQUEUE:
+        os << "\"cat\":\"queue\",\"ph\":\"e\",\"id\":\"0x" << std::hex << e.message << std::dec << "\",";
+        break;
+      case GADGET_TRACE_PROCESS_BEGIN:
+        os << "\"cat\":\"process\",\"ph\":\"B\",\"args\":{\"message\":\"0x" << std::hex << e.message << std::dec << "\"},";
+        break;
+      default:
+        os << "\"cat\":\"process\",\"ph\":\"E\",";
+        break;
+      }
+      os << "\"pid\":" << e.stream << ",\"tid\":" << e.thread << ",\"ts\":" << (e.time - t0) * 1e-3 << "},\n";
+    }
+
+    for (std::set<uint32_t>::iterator it = threads.begin(); it != threads.end(); ++it) {
+      os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << (events.empty() ? 0 : events.front().stream)
+         << ",\"tid\":" << *it << ",\"args\":{\"name\":\"thread " << *it << "\"}},\n";
+    }
+
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << (events.empty() ? 0 : events.front().stream)
+       << ",\"args\":{\"name\":\"Gadgetron stream\"}}\n]}\n";
+  }
+
+  void GadgetTrace::write_binary(std::ostream& os, const std::vector<GadgetTraceEvent>& events, const std::vector<std::string>& gadget_names)
+  {
+    const char magic[4] = { 'G', 'T', 'R', 'C' };
+    uint32_t version = 1;
+    uint32_t num_gadgets = static_cast<uint32_t>(gadget_names.size());
+    uint64_t num_events = events.size();
+
+    os.write(magic, 4);
+    os.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(&num_gadgets), sizeof(uint32_t));
+    for (size_t i = 0; i < gadget_names.size(); i++) {
+      uint32_t len = static_cast<uint32_t>(gadget_names[i].size());
+      os.write(reinterpret_cast<const char*>(&len), sizeof(uint32_t));
+      os.write(gadget_names[i].c_str(), len);
+    }
+    os.write(reinterpret_cast<const char*>(&num_events), sizeof(uint64_t));
+    if (num_events) {
+      os.write(reinterpret_cast<const char*>(&events[0]), num_events*sizeof(GadgetTraceEvent));
+    }
+  }
+}
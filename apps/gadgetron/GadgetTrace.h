@@ -0,0 +1,137 @@
+#ifndef GADGETTRACE_H
+#define GADGETTRACE_H
+
+#include "gadgetbase_export.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Gadgetron{
+
+  enum GadgetTraceEventType
+  {
+    GADGET_TRACE_ENQUEUE = 0,
+    GADGET_TRACE_DEQUEUE = 1,
+    GADGET_TRACE_PROCESS_BEGIN = 2,
+    GADGET_TRACE_PROCESS_END = 3
+  };
+
+  /**
+     Identifies the Gadget an event belongs to. Stream 0 means the Gadget is not traced.
+   */
+  struct GadgetTraceTag
+  {
+    uint32_t stream;
+    uint32_t gadget;
+
+    GadgetTraceTag()
+      : stream(0), gadget(0)
+    {
+    }
+  };
+
+  struct GadgetTraceEvent
+  {
+    uint64_t time;      //Nanoseconds, steady clock
+    uint64_t message;   //Address of the message block, pairs enqueue with dequeue
+    uint32_t stream;
+    uint32_t gadget;
+    uint32_t thread;    //Index of the recording thread, in order of first use
+    uint32_t type;      //GadgetTraceEventType
+  };
+
+  /**
+     Low overhead recording of message flow through the Gadgets of a stream.
+
+     Each thread records into its own ring of fixed size, so recording takes no lock; only the
+     thread that owns a ring writes to it. When the ring is full the oldest events are overwritten.
+     When a connection closes, the events of its stream are collected from all rings and written
+     to one file per connection, either as Chrome trace event JSON (load in chrome://tracing or
+     Perfetto) or in the compact binary layout below.
+
+     Binary layout, little endian: "GTRC", uint32 version, uint32 number of gadgets, for each gadget
+     a uint32 length followed by the name, uint64 number of events, then the GadgetTraceEvent records.
+
+     Tracing is off unless enabled in gadgetron.xml. Gadgets that are not traced only test their tag.
+   */
+  class EXPORTGADGETBASE GadgetTrace
+  {
+  public:
+    enum Format
+    {
+      CHROME_JSON,
+      BINARY
+    };
+
+    static GadgetTrace* instance();
+
+    /**
+       @param directory Where trace files are written.
+       @param ring_capacity Events per thread, rounded up to a power of two.
+     */
+    void enable(const std::string& directory, Format format = CHROME_JSON, size_t ring_capacity = 32768);
+
+    bool enabled() const
+    {
+      return enabled_;
+    }
+
+    /**
+       Returns the id for a new stream to be traced.
+     */
+    uint32_t open_stream();
+
+    static void record(const GadgetTraceTag& tag, GadgetTraceEventType type, const void* message)
+    {
+      if (tag.stream) {
+        instance()->record_event(tag, type, message);
+      }
+    }
+
+    /**
+       Events of a stream recorded so far, ordered by time.
+     */
+    std::vector<GadgetTraceEvent> collect(uint32_t stream);
+
+    /**
+       Writes the events of the stream to a file in the trace directory and forgets the stream.
+       gadget_names is indexed by the gadget number of the tags.
+     */
+    bool close_stream(uint32_t stream, const std::vector<std::string>& gadget_names);
+
+    static void write_chrome_json(std::ostream& os, const std::vector<GadgetTraceEvent>& events, const std::vector<std::string>& gadget_names);
+    static void write_binary(std::ostream& os, const std::vector<GadgetTraceEvent>& events, const std::vector<std::string>& gadget_names);
+
+  protected:
+    GadgetTrace();
+
+    struct Ring
+    {
+      std::vector<GadgetTraceEvent> events;
+      std::atomic<uint64_t> head;
+      uint32_t thread;
+    };
+
+    void record_event(const GadgetTraceTag& tag, GadgetTraceEventType type, const void* message);
+    std::shared_ptr<Ring> register_thread();
+    void prune_rings();
+
+    std::atomic<bool> enabled_;
+    std::string directory_;
+    Format format_;
+    size_t ring_capacity_;
+
+    std::mutex mutex_;
+    std::vector< std::shared_ptr<Ring> > rings_;
+    std::set<uint32_t> open_streams_;
+    uint32_t next_stream_;
+    uint32_t next_thread_;
+  };
+}
+#endif //GADGETTRACE_H
@@ -0,0 +1,190 @@
+#include "GadgetWorkerPool.h"
+#include "log.h"
+
+#include <algorithm>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+namespace Gadgetron
+{
+  namespace
+  {
+    //Index of the pool worker running on this thread, -1 for other threads
+    thread_local int current_worker = -1;
+  }
+
+  GadgetWorkerPool* GadgetWorkerPool::instance()
+  {
+    static GadgetWorkerPool pool;
+    return &pool;
+  }
+
+  GadgetWorkerPool::GadgetWorkerPool()
+    : pending_(0)
+    , busy_(0)
+    , tasks_run_(0)
+    , tasks_stolen_(0)
+    , running_(false)
+    , stop_(false)
+    , omp_threads_(1)
+  {
+  }
+
+  GadgetWorkerPool::~GadgetWorkerPool()
+  {
+    this->stop();
+  }
+
+  void GadgetWorkerPool::start(size_t threads, size_t omp_threads)
+  {
+    if (running_) {
+      GWARN("Gadget worker pool is already running\n");
+      return;
+    }
+
+    size_t hw = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    if (!threads) threads = hw;
+    omp_threads_ = omp_threads ? omp_threads : hw;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = false;
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+      workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (size_t i = 0; i < threads; i++) {
+      workers_[i]->thread = std::thread(&GadgetWorkerPool::worker_loop, this, i);
+    }
+
+    running_ = true;
+    GINFO("Gadget worker pool started with %d threads and an OpenMP budget of %d threads\n", (int)threads, (int)omp_threads_);
+  }
+
+  void GadgetWorkerPool::stop()
+  {
+    if (!running_) return;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+
+    for (size_t i = 0; i < workers_.size(); i++) {
+      if (workers_[i]->thread.joinable()) workers_[i]->thread.join();
+    }
+
+    workers_.clear();
+    shared_.clear();
+    pending_ = 0;
+    running_ = false;
+  }
+
+  void GadgetWorkerPool::schedule(GadgetWorkerTask* task)
+  {
+    if (current_worker >= 0 && size_t(current_worker) < workers_.size()) {
+      Worker& w = *workers_[current_worker];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.tasks.push_back(task);
+      pending_++;
+    } else {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shared_.push_back(task);
+      pending_++;
+    }
+
+    //Waiting workers check pending_ with the mutex held, taking it here avoids a lost wakeup
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+    }
+    cond_.notify_one();
+  }
+
+  GadgetWorkerPoolStatistics GadgetWorkerPool::statistics() const
+  {
+    GadgetWorkerPoolStatistics s;
+    s.tasks_run = tasks_run_;
+    s.tasks_stolen = tasks_stolen_;
+    return s;
+  }
+
+  bool GadgetWorkerPool::is_worker_thread()
+  {
+    return current_worker >= 0;
+  }
+
+  void GadgetWorkerPool::worker_loop(size_t index)
+  {
+    current_worker = static_cast<int>(index);
+
+    for (;;) {
+      GadgetWorkerTask* task = this->next_task(index);
+
+      if (!task) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]{ return stop_ || pending_ > 0; });
+        if (stop_) break;
+        continue;
+      }
+
+      busy_++;
+      this->limit_omp_threads();
+      task->run_on_worker();
+      busy_--;
+      tasks_run_++;
+    }
+
+    current_worker = -1;
+  }
+
+  GadgetWorkerTask* GadgetWorkerPool::next_task(size_t index)
+  {
+    GadgetWorkerTask* task = 0;
+
+    {
+      Worker& w = *workers_[index];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      if (!w.tasks.empty()) {
+        task = w.tasks.front();
+        w.tasks.pop_front();
+      }
+    }
+
+    if (!task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!shared_.empty()) {
+        task = shared_.front();
+        shared_.pop_front();
+      }
+    }
+
+    //Steal from the back, the owner takes from the front
+    for (size_t k = 1; !task && k < workers_.size(); k++) {
+      Worker& w = *workers_[(index + k) % workers_.size()];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      if (!w.tasks.empty()) {
+        task = w.tasks.back();
+        w.tasks.pop_back();
+        tasks_stolen_++;
+      }
+    }
+
+    if (task) pending_--;
+    return task;
+  }
+
+  void GadgetWorkerPool::limit_omp_threads()
+  {
+#ifdef USE_OMP
+    size_t busy = std::max<size_t>(busy_, 1);
+    int n = static_cast<int>(std::max<size_t>(omp_threads_ / busy, 1));
+    if (omp_get_max_threads() != n) {
+      omp_set_num_threads(n);
+    }
+#endif // USE_OMP
+  }
+}
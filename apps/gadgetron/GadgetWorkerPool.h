@@ -0,0 +1,119 @@
+#ifndef GADGETWORKERPOOL_H
+#define GADGETWORKERPOOL_H
+
+#include "gadgetbase_export.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Gadgetron{
+
+  /**
+     Unit of work for the GadgetWorkerPool. The pool does not take ownership.
+   */
+  class EXPORTGADGETBASE GadgetWorkerTask
+  {
+  public:
+    virtual ~GadgetWorkerTask() {}
+    virtual void run_on_worker() = 0;
+  };
+
+  struct GadgetWorkerPoolStatistics
+  {
+    size_t tasks_run;
+    size_t tasks_stolen;
+
+    GadgetWorkerPoolStatistics()
+      : tasks_run(0), tasks_stolen(0)
+    {
+    }
+  };
+
+  /**
+     Process-wide pool of worker threads shared by the Gadgets of all connections.
+
+     When the pool is running, single threaded Gadgets do not start a thread of their own in open().
+     Instead they schedule themselves on the pool whenever a message is put on their queue, and a
+     worker drains the queue. A Gadget is scheduled at most once at a time, so its messages are
+     processed in order and never concurrently.
+
+     Each worker has a local deque. Tasks scheduled from a worker, typically the downstream Gadget of
+     the message that was just produced, go to the local deque and are run by the same worker while
+     the data is still in cache. Tasks scheduled from other threads (e.g. the socket reader) go to a
+     shared queue. Idle workers steal from the other workers.
+
+     With OpenMP, the workers share an OpenMP thread budget: before running a task a worker limits
+     its parallel regions to the budget divided by the number of busy workers, so that concurrent
+     reconstructions do not oversubscribe the machine.
+   */
+  class EXPORTGADGETBASE GadgetWorkerPool
+  {
+  public:
+    static GadgetWorkerPool* instance();
+
+    /**
+       @param threads Number of workers, 0 for the number of hardware threads.
+       @param omp_threads OpenMP threads shared by all workers, 0 for the number of hardware threads.
+     */
+    void start(size_t threads = 0, size_t omp_threads = 0);
+
+    /**
+       Stops and joins the workers. Tasks still queued are not run.
+     */
+    void stop();
+
+    bool running() const
+    {
+      return running_;
+    }
+
+    size_t number_of_threads() const
+    {
+      return workers_.size();
+    }
+
+    void schedule(GadgetWorkerTask* task);
+
+    GadgetWorkerPoolStatistics statistics() const;
+
+    /**
+       True if the calling thread is a worker of the pool.
+     */
+    static bool is_worker_thread();
+
+  protected:
+    GadgetWorkerPool();
+    ~GadgetWorkerPool();
+
+    struct Worker
+    {
+      std::mutex mutex;
+      std::deque<GadgetWorkerTask*> tasks;
+      std::thread thread;
+    };
+
+    void worker_loop(size_t index);
+    GadgetWorkerTask* next_task(size_t index);
+    void limit_omp_threads();
+
+    std::vector< std::unique_ptr<Worker> > workers_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<GadgetWorkerTask*> shared_;
+
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> busy_;
+    std::atomic<size_t> tasks_run_;
+    std::atomic<size_t> tasks_stolen_;
+    std::atomic<bool> running_;
+    bool stop_;
+    size_t omp_threads_;
+  };
+}
+#endif //GADGETWORKERPOOL_H
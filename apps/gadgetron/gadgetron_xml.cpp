@@ -3,10 +3,46 @@
 #include "pugixml.hpp"
 #include <stdexcept>
 #include <cstdlib>
+#include <limits>
+#include <sstream>
 #include <iostream>
 
 namespace GadgetronXML
 {
+  //Every ready chain holds the memory of its Gadgets, so a larger warm pool is almost certainly a typo
+  static const unsigned int max_warm_pool_chains = 64;
+
+  static unsigned int parse_warm_pool_chains(const std::string& name, const std::string& value)
+  {
+    int chains;
+    size_t end = 0;
+    try {
+      chains = std::stoi(value, &end);
+    } catch (const std::out_of_range&) {
+      chains = value.find('-') == std::string::npos ? std::numeric_limits<int>::max() : -1;
+      end = value.size();
+    } catch (const std::invalid_argument&) {
+      end = 0;
+    }
+
+    if (end == 0 || value.find_first_not_of(" \t\r\n", end) != std::string::npos) {
+      GERROR("Invalid number of warm pool chains for %s: '%s'\n", name.c_str(), value.c_str());
+      throw std::runtime_error("Invalid warm pool configuration, chains is not a number.");
+    }
+
+    if (chains < 0) {
+      GERROR("Invalid number of warm pool chains for %s: %s\n", name.c_str(), value.c_str());
+      throw std::runtime_error("Invalid warm pool configuration, chains is negative.");
+    }
+
+    if (chains > static_cast<int>(max_warm_pool_chains)) {
+      GERROR("%s warm pool chains requested for %s, keeping %u ready\n", value.c_str(), name.c_str(), max_warm_pool_chains);
+      return max_warm_pool_chains;
+    }
+
+    return static_cast<unsigned int>(chains);
+  }
+
   void deserialize(std::istream& stream, GadgetronConfiguration& h)
   {
     pugi::xml_document doc;
@@ -58,6 +94,68 @@ namespace GadgetronXML
       }
       h.rest = re;
     }
+
+    pugi::xml_node w = root.child("workerPool");
+    if (w) {
+      WorkerPool wp;
+      wp.threads = static_cast<unsigned int>(std::atoi(w.child_value("threads")));
+      wp.ompThreads = static_cast<unsigned int>(std::atoi(w.child_value("ompThreads")));
+      h.workerPool = wp;
+    }
+
+    pugi::xml_node t = root.child("trace");
+    if (t) {
+      Trace tr;
+      if (t.child("directory")) {
+        tr.directory = std::string(t.child_value("directory"));
+      }
+      tr.format = t.child("format") ? t.child_value("format") : "json";
+      if (tr.format != "json" && tr.format != "binary") {
+        throw std::runtime_error("Invalid trace format, must be json or binary.");
+      }
+      h.trace = tr;
+    }
+
+    pugi::xml_node f = root.child("fftw");
+    if (f) {
+      FFTW fw;
+      if (f.child("wisdomDirectory")) {
+        fw.wisdomDirectory = std::string(f.child_value("wisdomDirectory"));
+      }
+
+      pugi::xml_node pw = f.child("prewarm");
+      while (pw) {
+        FFTWPrewarm p;
+        std::stringstream ss(pw.child_value("size"));
+        unsigned int n;
+        while (ss >> n) p.size.push_back(n);
+        if (p.size.empty() || p.size.size() > 3) {
+          throw std::runtime_error("Invalid FFTW prewarm size, 1 to 3 dimensions are supported.");
+        }
+        p.batch = pw.child("batch") ? static_cast<unsigned int>(std::atoi(pw.child_value("batch"))) : 1;
+        if (p.batch == 0) p.batch = 1;
+        fw.prewarm.push_back(p);
+        pw = pw.next_sibling("prewarm");
+      }
+      h.fftw = fw;
+    }
+
+    pugi::xml_node wp = root.child("warmPool");
+    if (wp) {
+      WarmPool pool;
+      pugi::xml_node c = wp.child("configuration");
+      while (c) {
+        WarmPoolConfiguration pc;
+        pc.name = c.child_value("name");
+        if (pc.name.empty()) {
+          throw std::runtime_error("Invalid warm pool configuration, name is missing.");
+        }
+        pc.chains = c.child("chains") ? parse_warm_pool_chains(pc.name, c.child_value("chains")) : 1;
+        pool.configuration.push_back(pc);
+        c = c.next_sibling("configuration");
+      }
+      h.warmPool = pool;
+    }
   }
 
   void deserialize(std::istream& stream, GadgetStreamConfiguration& cfg)
@@ -116,6 +214,14 @@ namespace GadgetronXML
       cfg.gadget.push_back(g);
       gadget = gadget.next_sibling("gadget");
     }
+
+    pugi::xml_node coalescing = root.child("outputCoalescing");
+    if (coalescing) {
+      OutputCoalescing oc;
+      oc.maxBytes = static_cast<unsigned long>(std::atol(coalescing.child_value("maxBytes")));
+      oc.maxLatency = static_cast<unsigned long>(std::atol(coalescing.child_value("maxLatency")));
+      cfg.outputCoalescing = oc;
+    }
   }
 
 
@@ -132,6 +238,13 @@ namespace GadgetronXML
     return std::string(buffer);
   }
 
+  std::string to_string_val(const unsigned long& v)
+  {
+    char buffer[256];
+    sprintf(buffer,"%lu",v);
+    return std::string(buffer);
+  }
+
   void serialize(const GadgetStreamConfiguration& cfg, std::ostream& o)
   {
     pugi::xml_document doc;
@@ -209,6 +322,12 @@ namespace GadgetronXML
       }
     }
 
+    if (cfg.outputCoalescing) {
+      n1 = root.append_child("outputCoalescing");
+      append_node(n1, "maxBytes", to_string_val(cfg.outputCoalescing->maxBytes));
+      append_node(n1, "maxLatency", to_string_val(cfg.outputCoalescing->maxLatency));
+    }
+
     doc.save(o);
 
   }
@@ -86,6 +86,41 @@ namespace GadgetronXML
   {
     unsigned int port;
   };
+
+  struct WorkerPool
+  {
+    unsigned int threads;     //0 for the number of hardware threads
+    unsigned int ompThreads;  //0 for the number of hardware threads
+  };
+
+  struct FFTWPrewarm
+  {
+    std::vector<unsigned int> size;  //Transformed dimensions, fastest varying first
+    unsigned int batch;              //Number of transforms per call, 1 if not given
+  };
+
+  struct FFTW
+  {
+    Optional<std::string> wisdomDirectory;  //Defaults to share/gadgetron/fftw under the Gadgetron home
+    std::vector<FFTWPrewarm> prewarm;
+  };
+
+  struct WarmPoolConfiguration
+  {
+    std::string name;    //Stream configuration file
+    unsigned int chains; //Number of chains kept ready, 1 if not given, at most 64
+  };
+
+  struct WarmPool
+  {
+    std::vector<WarmPoolConfiguration> configuration;
+  };
+
+  struct Trace
+  {
+    Optional<std::string> directory; //Defaults to the working directory
+    std::string format;              //"json" or "binary"
+  };
   
   struct GadgetronConfiguration
   {
@@ -93,6 +128,10 @@ namespace GadgetronXML
     std::vector<GadgetronParameter> globalGadgetParameter;
     Optional<CloudBus> cloudBus;
     Optional<ReST> rest;
+    Optional<WorkerPool> workerPool;
+    Optional<Trace> trace;
+    Optional<FFTW> fftw;
+    Optional<WarmPool> warmPool;
   };
 
   void EXPORTGADGETBASE deserialize(std::istream& stream, GadgetronConfiguration& h);
@@ -114,11 +153,18 @@ namespace GadgetronXML
     std::vector<GadgetronParameter> property;
   };
 
+  struct OutputCoalescing
+  {
+    unsigned long maxBytes;
+    unsigned long maxLatency; //microseconds
+  };
+
   struct GadgetStreamConfiguration
   {
     std::vector<Reader> reader;
     std::vector<Writer> writer;
     std::vector<Gadget> gadget;
+    Optional<OutputCoalescing> outputCoalescing;
   };
 
   void EXPORTGADGETBASE deserialize(std::istream& stream, GadgetStreamConfiguration& cfg);
@@ -7,6 +7,10 @@
 #include "gadgetron_config.h"
 #include "gadgetron_home.h"
 #include "CloudBus.h"
+#include "GadgetWorkerPool.h"
+#include "GadgetTrace.h"
+#include "GadgetChainPool.h"
+#include "hoNDFFT.h"
 
 #include "gadgetron_system_info.h"
 
@@ -84,6 +88,34 @@ namespace Gadgetron {
 
 }
 
+namespace {
+  boost::filesystem::path fftw_wisdom_file(const boost::filesystem::path& dir, const char* precision)
+  {
+    return dir / (std::string("wisdom_") + precision + ".fftw");
+  }
+
+  void load_fftw_wisdom(const boost::filesystem::path& dir)
+  {
+    if (Gadgetron::hoNDFFT<float>::instance()->import_wisdom(fftw_wisdom_file(dir, "float").string())) {
+      GINFO("Loaded FFTW wisdom (float) from %s\n", dir.string().c_str());
+    }
+    if (Gadgetron::hoNDFFT<double>::instance()->import_wisdom(fftw_wisdom_file(dir, "double").string())) {
+      GINFO("Loaded FFTW wisdom (double) from %s\n", dir.string().c_str());
+    }
+  }
+
+  void save_fftw_wisdom(const boost::filesystem::path& dir)
+  {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(dir, ec);
+
+    if (!Gadgetron::hoNDFFT<float>::instance()->export_wisdom(fftw_wisdom_file(dir, "float").string()) ||
+        !Gadgetron::hoNDFFT<double>::instance()->export_wisdom(fftw_wisdom_file(dir, "double").string())) {
+      GWARN("Unable to save FFTW wisdom to %s\n", dir.string().c_str());
+    }
+  }
+}
+
 void print_usage()
 {
   GINFO("Usage: \n");
@@ -197,6 +229,17 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[])
       std::string content = ss.str();
       return content;
     });
+    Gadgetron::ReST::instance()->server().route_dynamic("/info/connection_setup")([]()
+    {
+      Gadgetron::ConnectionSetupStatistics s = Gadgetron::GadgetChainPool::instance()->setup_statistics();
+      std::stringstream ss;
+      ss << "connections " << s.connections << "\n"
+         << "prepared_chain_connections " << s.warm_connections << "\n"
+         << "mean_ms " << s.mean_time() * 1000 << "\n"
+         << "max_ms " << s.max_time * 1000 << "\n"
+         << "last_ms " << s.last_time * 1000 << "\n";
+      return ss.str();
+    });
   }
 
   if (relay_port > 0) {
@@ -248,6 +291,43 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[])
       return -1;
     }
 
+  if (c.workerPool) {
+    Gadgetron::GadgetWorkerPool::instance()->start(c.workerPool->threads, c.workerPool->ompThreads);
+  }
+
+  boost::filesystem::path fftwWisdomDirectory;
+  if (c.fftw) {
+    fftwWisdomDirectory = c.fftw->wisdomDirectory ? boost::filesystem::path(*c.fftw->wisdomDirectory)
+                                                  : gadgetron_home / "share" / "gadgetron" / "fftw";
+    load_fftw_wisdom(fftwWisdomDirectory);
+
+    //The reconstructions run in single precision
+    for (size_t i = 0; i < c.fftw->prewarm.size(); i++) {
+      const GadgetronXML::FFTWPrewarm& p = c.fftw->prewarm[i];
+      std::vector<size_t> dims(p.size.begin(), p.size.end());
+      GINFO("Planning FFTs of size %d x %d x %d, batch %d\n", (int)dims[0], dims.size() > 1 ? (int)dims[1] : 1, dims.size() > 2 ? (int)dims[2] : 1, (int)p.batch);
+      Gadgetron::hoNDFFT<float>::instance()->prewarm(dims, p.batch);
+    }
+
+    if (!c.fftw->prewarm.empty()) {
+      save_fftw_wisdom(fftwWisdomDirectory);
+    }
+  }
+
+  if (c.trace) {
+    std::string traceDirectory = c.trace->directory ? *c.trace->directory : workingDirectory;
+    Gadgetron::GadgetTrace::instance()->enable(traceDirectory,
+      c.trace->format == "binary" ? Gadgetron::GadgetTrace::BINARY : Gadgetron::GadgetTrace::CHROME_JSON);
+  }
+
+  if (c.warmPool) {
+    std::vector< std::pair<std::string, size_t> > configurations;
+    for (size_t i = 0; i < c.warmPool->configuration.size(); i++) {
+      configurations.push_back(std::make_pair(c.warmPool->configuration[i].name, (size_t)c.warmPool->configuration[i].chains));
+    }
+    Gadgetron::GadgetChainPool::instance()->start(configurations);
+  }
+
   GINFO("Configuring services, Running on port %s\n", port_no);
 
   auto reactor = ACE_Reactor::instance();
@@ -259,5 +339,12 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[])
   
   reactor->run_reactor_event_loop ();
 
+  Gadgetron::GadgetChainPool::instance()->stop();
+  Gadgetron::GadgetWorkerPool::instance()->stop();
+
+  if (c.fftw) {
+    save_fftw_wisdom(fftwWisdomDirectory);
+  }
+
   return 0;
 }
@@ -114,6 +114,7 @@ namespace Gadgetron {
 
             t1_sr.max_iter_ = max_iter.value();
             t1_sr.thres_fun_ = thres_func.value();
+            t1_sr.batched_fitting_ = batched_fitting.value();
             t1_sr.max_map_value_ = max_T1.value();
 
             t1_sr.verbose_ = verbose.value();
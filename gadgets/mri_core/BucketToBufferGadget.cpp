@@ -7,11 +7,17 @@ namespace Gadgetron {
 
     BucketToBufferGadget::BucketToBufferGadget()
     {
+        trigger_ = NONE;
+        has_prev_acqhdr_ = false;
     }
 
     BucketToBufferGadget::~BucketToBufferGadget()
     {
         //The buckets array should be empty but just in case, let's make sure all the stuff is released.
+        for (std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* >::iterator it = direct_buffers_.begin(); it != direct_buffers_.end(); it++)
+        {
+            if (it->second) it->second->release();
+        }
     }
 
     int BucketToBufferGadget
@@ -85,6 +91,67 @@ namespace Gadgetron {
         ignore_segment_ = ignore_segment.value();
         GDEBUG("IGNORE SEGMENT IS: %d\n", ignore_segment_);
 
+        if (trigger_dimension.value().size() == 0) {
+            trigger_ = NONE;
+        }
+        else if (trigger_dimension.value().compare("kspace_encode_step_1") == 0) {
+            trigger_ = KSPACE_ENCODE_STEP_1;
+        }
+        else if (trigger_dimension.value().compare("kspace_encode_step_2") == 0) {
+            trigger_ = KSPACE_ENCODE_STEP_2;
+        }
+        else if (trigger_dimension.value().compare("average") == 0) {
+            trigger_ = AVERAGE;
+        }
+        else if (trigger_dimension.value().compare("slice") == 0) {
+            trigger_ = SLICE;
+        }
+        else if (trigger_dimension.value().compare("contrast") == 0) {
+            trigger_ = CONTRAST;
+        }
+        else if (trigger_dimension.value().compare("phase") == 0) {
+            trigger_ = PHASE;
+        }
+        else if (trigger_dimension.value().compare("repetition") == 0) {
+            trigger_ = REPETITION;
+        }
+        else if (trigger_dimension.value().compare("set") == 0) {
+            trigger_ = SET;
+        }
+        else if (trigger_dimension.value().compare("segment") == 0) {
+            trigger_ = SEGMENT;
+        }
+        else if (trigger_dimension.value().compare("user_0") == 0) {
+            trigger_ = USER_0;
+        }
+        else if (trigger_dimension.value().compare("user_1") == 0) {
+            trigger_ = USER_1;
+        }
+        else if (trigger_dimension.value().compare("user_2") == 0) {
+            trigger_ = USER_2;
+        }
+        else if (trigger_dimension.value().compare("user_3") == 0) {
+            trigger_ = USER_3;
+        }
+        else if (trigger_dimension.value().compare("user_4") == 0) {
+            trigger_ = USER_4;
+        }
+        else if (trigger_dimension.value().compare("user_5") == 0) {
+            trigger_ = USER_5;
+        }
+        else if (trigger_dimension.value().compare("user_6") == 0) {
+            trigger_ = USER_6;
+        }
+        else if (trigger_dimension.value().compare("user_7") == 0) {
+            trigger_ = USER_7;
+        }
+        else {
+            GDEBUG("WARNING: Unknown trigger dimension (%s), trigger condition set to NONE (end of scan)\n", trigger_dimension.value().c_str());
+            trigger_ = NONE;
+        }
+
+        GDEBUG("TRIGGER DIMENSION IS: %s (%d)\n", trigger_dimension.value().c_str(), trigger_);
+
         // keep a copy of the deserialized ismrmrd xml header for runtime
         ISMRMRD::deserialize(mb->rd_ptr(), hdr_);
 
@@ -95,7 +162,6 @@ namespace Gadgetron {
         ::process(GadgetContainerMessage<IsmrmrdAcquisitionBucket>* m1)
     {
 
-        size_t key;
         std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > recon_data_buffers;
 
         //GDEBUG("BucketToBufferGadget::process\n");
@@ -119,67 +185,162 @@ namespace Gadgetron {
         //}
 
         //Iterate over the reference data of the bucket
-        IsmrmrdDataBuffered* pCurrDataBuffer = NULL;
-        for (std::vector<IsmrmrdAcquisitionData>::iterator it = m1->getObjectPtr()->ref_.begin();
-            it != m1->getObjectPtr()->ref_.end(); ++it)
+        stuffBucket(m1->getObjectPtr()->ref_, m1->getObjectPtr()->refstats_, recon_data_buffers, true);
+
+        //Iterate over the imaging data of the bucket
+        stuffBucket(m1->getObjectPtr()->data_, m1->getObjectPtr()->datastats_, recon_data_buffers, false);
+
+        //Send all the ReconData messages
+        GDEBUG("End of bucket reached, sending out %d ReconData buffers\n", recon_data_buffers.size());
+        sendBuffers(recon_data_buffers, m1->getObjectPtr()->waveform_);
+
+        //Clear the recondata buffer map
+        recon_data_buffers.clear();  // is this necessary?
+
+        //We can release the incoming bucket now. This will release all of the data it contains.
+        m1->release();
+
+        return GADGET_OK;
+    }
+
+    int BucketToBufferGadget::process(ACE_Message_Block* mb)
+    {
+        //The waveforms are only buffered once readouts have been received directly, they are sent with the direct buffers
+        //Behind the AcquisitionAccumulateTriggerGadget they are in the buckets, anything else is handled as by Gadget1Of2
+        if (has_prev_acqhdr_)
         {
-            //Get a reference to the header for this acquisition
-            ISMRMRD::AcquisitionHeader & acqhdr = *it->head_->getObjectPtr();
+            GadgetContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>* mw = AsContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>(mb);
+            if (mw)
+            {
+                return this->process(mw);
+            }
+        }
 
-            //Generate the key to the corresponding ReconData buffer
-            key = getKey(acqhdr.idx);
+        return BaseClass::process(mb);
+    }
 
-            //The storage is based on the encoding space
-            uint16_t espace = acqhdr.encoding_space_ref;
+    int BucketToBufferGadget
+        ::process(GadgetContainerMessage<ISMRMRD::AcquisitionHeader>* m1)
+    {
+        //Ignore noise scans
+        if (m1->getObjectPtr()->isFlagSet(ISMRMRD::ISMRMRD_ACQ_IS_NOISE_MEASUREMENT)) {
+            m1->release();
+            return GADGET_OK;
+        }
 
-            //GDEBUG_STREAM("espace: " << acqhdr.encoding_space_ref << std::endl);
-            //GDEBUG_STREAM("slice: " << acqhdr.idx.slice << std::endl);
-            //GDEBUG_STREAM("rep: " << acqhdr.idx.repetition << std::endl);
-            //GDEBUG_STREAM("k1: " << acqhdr.idx.kspace_encode_step_1 << std::endl);
-            //GDEBUG_STREAM("k2: " << acqhdr.idx.kspace_encode_step_2 << std::endl);
-            //GDEBUG_STREAM("seg: " << acqhdr.idx.segment << std::endl);
-            //GDEBUG_STREAM("key: " << key << std::endl);
+        GadgetContainerMessage< hoNDArray< std::complex<float> > >* m2 = AsContainerMessage< hoNDArray< std::complex<float> > >(m1->cont());
+        if (!m2)
+        {
+            GDEBUG("Error casting acquisition data package");
+            return GADGET_FAIL;
+        }
 
-            //Get some references to simplify the notation
-            //the reconstruction bit corresponding to this ReconDataBuffer and encoding space
-            IsmrmrdReconBit & rbit = getRBit(recon_data_buffers, key, espace);
-            //and the corresponding data buffer for the reference data
-            if (!rbit.ref_)
-                rbit.ref_ = IsmrmrdDataBuffered();
-            IsmrmrdDataBuffered & dataBuffer = *rbit.ref_;
-            //this encoding space's xml header info
+        ISMRMRD::AcquisitionHeader & acqhdr = *m1->getObjectPtr();
+
+        //Send the buffers of the previous readouts if a trigger condition has occurred
+        if (has_prev_acqhdr_ && (trigger_ != NONE) && (getTriggerIndex(prev_acqhdr_.idx) != getTriggerIndex(acqhdr.idx)))
+        {
+            triggerDirectBuffers();
+        }
+
+        prev_acqhdr_ = acqhdr;
+        has_prev_acqhdr_ = true;
+
+        IsmrmrdAcquisitionData d(m1, m2, AsContainerMessage< hoNDArray<float> >(m2->cont()));
+
+        uint16_t espace = acqhdr.encoding_space_ref;
+
+        if (!(
+            ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(acqhdr.flags) ||
+            ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PHASECORR_DATA).isSet(acqhdr.flags)
+            ))
+        {
+            IsmrmrdReconBit & rbit = getRBit(direct_buffers_, getKey(acqhdr.idx), espace);
+            IsmrmrdDataBuffered & dataBuffer = rbit.data_;
             ISMRMRD::Encoding & encoding = hdr_.encoding[espace];
-            //this bucket's reference stats
-            IsmrmrdAcquisitionBucketStats & stats = m1->getObjectPtr()->refstats_[espace];
 
-            //Fill the sampling description for this data buffer, only need to fill the sampling_ once per recon bit
-            if (&dataBuffer != pCurrDataBuffer)
+            //The stats are only used to allocate the buffer, the imaging data is stuffed without them
+            IsmrmrdAcquisitionBucketStats stats;
+            if (dataBuffer.data_.get_number_of_elements() == 0)
             {
-                fillSamplingDescription(dataBuffer.sampling_, encoding, stats, acqhdr, true);
-                pCurrDataBuffer = &dataBuffer;
+                fillStatsFromEncodingLimits(stats, encoding, acqhdr);
+                fillSamplingDescription(dataBuffer.sampling_, encoding, stats, acqhdr, false);
+                allocateDataArrays(dataBuffer, acqhdr, encoding, stats, false);
             }
 
-            //Make sure that the data storage for this data buffer has been allocated
-            //TODO should this check the limits, or should that be done in the stuff function?
-            allocateDataArrays(dataBuffer, acqhdr, encoding, stats, true);
+            stuff(d, dataBuffer, encoding, stats, false);
+        }
 
-            // Stuff the data, header and trajectory into this data buffer
-            stuff(it, dataBuffer, encoding, stats, true);
+        if (ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(acqhdr.flags) ||
+            ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION_AND_IMAGING).isSet(acqhdr.flags))
+        {
+            direct_ref_.ref_.push_back(d);
+            if (direct_ref_.refstats_.size() < (espace + 1)) {
+                direct_ref_.refstats_.resize(espace + 1);
+            }
+            direct_ref_.refstats_[espace].kspace_encode_step_1.insert(acqhdr.idx.kspace_encode_step_1);
+            direct_ref_.refstats_[espace].kspace_encode_step_2.insert(acqhdr.idx.kspace_encode_step_2);
+            direct_ref_.refstats_[espace].slice.insert(acqhdr.idx.slice);
+            direct_ref_.refstats_[espace].phase.insert(acqhdr.idx.phase);
+            direct_ref_.refstats_[espace].contrast.insert(acqhdr.idx.contrast);
+            direct_ref_.refstats_[espace].set.insert(acqhdr.idx.set);
+            direct_ref_.refstats_[espace].segment.insert(acqhdr.idx.segment);
+            direct_ref_.refstats_[espace].average.insert(acqhdr.idx.average);
+            direct_ref_.refstats_[espace].repetition.insert(acqhdr.idx.repetition);
+        }
+
+        //The imaging readout has been copied into its buffer and is deleted when d goes out of scope
+        m1->release();
+
+        return GADGET_OK;
+    }
+
+    int BucketToBufferGadget::process(GadgetContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>* m1)
+    {
+        GadgetContainerMessage< hoNDArray< uint32_t > >* m2 = AsContainerMessage< hoNDArray< uint32_t > >(m1->cont());
+        if (!m2)
+        {
+            GDEBUG("Error casting waveform data package");
+            return GADGET_FAIL;
         }
 
+        ISMRMRD::Waveform ismrmrd_wav;
+        ismrmrd_wav.head = *m1->getObjectPtr();
+        ismrmrd_wav.data = m2->getObjectPtr()->begin();
 
-        //Iterate over the imaging data of the bucket
-        // this is exactly the same code as for the reference data except for
-        // the chunk of the data buffer.
-        pCurrDataBuffer = NULL;
-        for (std::vector<IsmrmrdAcquisitionData>::iterator it = m1->getObjectPtr()->data_.begin();
-            it != m1->getObjectPtr()->data_.end(); ++it)
+        // buffer the waveform data
+        wav_buf_.push_back(ismrmrd_wav);
+
+        ismrmrd_wav.data = NULL;
+        m1->release();
+
+        return GADGET_OK;
+    }
+
+    void BucketToBufferGadget::triggerDirectBuffers()
+    {
+        //The reference data is stuffed first, as for a bucket
+        stuffBucket(direct_ref_.ref_, direct_ref_.refstats_, direct_buffers_, true);
+
+        GDEBUG("Trigger occurred, sending out %d ReconData buffers\n", direct_buffers_.size());
+        sendBuffers(direct_buffers_, wav_buf_);
+
+        direct_buffers_.clear();
+        direct_ref_.ref_.clear();
+        direct_ref_.refstats_.clear();
+        wav_buf_.clear();
+    }
+
+    void BucketToBufferGadget::stuffBucket(std::vector<IsmrmrdAcquisitionData>& acqs, std::vector<IsmrmrdAcquisitionBucketStats>& stats_espace, std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > & recon_data_buffers, bool forref)
+    {
+        IsmrmrdDataBuffered* pCurrDataBuffer = NULL;
+        for (std::vector<IsmrmrdAcquisitionData>::iterator it = acqs.begin(); it != acqs.end(); ++it)
         {
             //Get a reference to the header for this acquisition
             ISMRMRD::AcquisitionHeader & acqhdr = *it->head_->getObjectPtr();
 
             //Generate the key to the corresponding ReconData buffer
-            key = getKey(acqhdr.idx);
+            size_t key = getKey(acqhdr.idx);
 
             //The storage is based on the encoding space
             uint16_t espace = acqhdr.encoding_space_ref;
@@ -195,31 +356,33 @@ namespace Gadgetron {
             //Get some references to simplify the notation
             //the reconstruction bit corresponding to this ReconDataBuffer and encoding space
             IsmrmrdReconBit & rbit = getRBit(recon_data_buffers, key, espace);
-            //and the corresponding data buffer for the imaging data
-            IsmrmrdDataBuffered & dataBuffer = rbit.data_;
+            //and the corresponding data buffer for the reference or imaging data
+            if (forref && !rbit.ref_)
+                rbit.ref_ = IsmrmrdDataBuffered();
+            IsmrmrdDataBuffered & dataBuffer = forref ? *rbit.ref_ : rbit.data_;
             //this encoding space's xml header info
             ISMRMRD::Encoding & encoding = hdr_.encoding[espace];
-            //this bucket's imaging data stats
-            IsmrmrdAcquisitionBucketStats & stats = m1->getObjectPtr()->datastats_[espace];
+            //this bucket's reference or imaging data stats
+            IsmrmrdAcquisitionBucketStats & stats = stats_espace[espace];
 
-            //Fill the sampling description for this data buffer, only need to fill sampling_ once per recon bit
+            //Fill the sampling description for this data buffer, only need to fill the sampling_ once per recon bit
             if (&dataBuffer != pCurrDataBuffer)
             {
-                fillSamplingDescription(dataBuffer.sampling_, encoding, stats, acqhdr, false);
+                fillSamplingDescription(dataBuffer.sampling_, encoding, stats, acqhdr, forref);
                 pCurrDataBuffer = &dataBuffer;
             }
 
             //Make sure that the data storage for this data buffer has been allocated
             //TODO should this check the limits, or should that be done in the stuff function?
-            allocateDataArrays(dataBuffer, acqhdr, encoding, stats, false);
+            allocateDataArrays(dataBuffer, acqhdr, encoding, stats, forref);
 
             // Stuff the data, header and trajectory into this data buffer
-            stuff(it, dataBuffer, encoding, stats, false);
+            stuff(it, dataBuffer, encoding, stats, forref);
         }
+    }
 
-
-        //Send all the ReconData messages
-        GDEBUG("End of bucket reached, sending out %d ReconData buffers\n", recon_data_buffers.size());
+    void BucketToBufferGadget::sendBuffers(std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > & recon_data_buffers, std::vector<ISMRMRD::Waveform>& wav)
+    {
         for (std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* >::iterator it = recon_data_buffers.begin(); it != recon_data_buffers.end(); it++)
         {
             //GDEBUG_STREAM("Sending: " << it->first << std::endl);
@@ -235,7 +398,6 @@ namespace Gadgetron {
 
                 if (total_data > 0)
                 {
-                    std::vector<ISMRMRD::Waveform>& wav = m1->getObjectPtr()->waveform_;
                     if (!wav.empty())
                     {
                         GadgetContainerMessage< std::vector<ISMRMRD::Waveform> >* m3 = new GadgetContainerMessage< std::vector<ISMRMRD::Waveform> >();
@@ -257,16 +419,12 @@ namespace Gadgetron {
                         throw std::runtime_error("Failed to pass bucket down the chain\n");
                     }
                 }
+                else
+                {
+                    it->second->release();
+                }
             }
         }
-
-        //Clear the recondata buffer map
-        recon_data_buffers.clear();  // is this necessary?
-
-        //We can release the incoming bucket now. This will release all of the data it contains.
-        m1->release();
-
-        return GADGET_OK;
     }
 
     int BucketToBufferGadget::close(unsigned long flags)
@@ -275,6 +433,10 @@ namespace Gadgetron {
         int ret = Gadget::close(flags);
         GDEBUG("BucketToBufferGadget::close\n");
 
+        if (flags != 0 && (!direct_buffers_.empty() || !direct_ref_.ref_.empty())) {
+            triggerDirectBuffers();
+        }
+
         return ret;
     }
 
@@ -418,6 +580,115 @@ namespace Gadgetron {
         return key;
     }
 
+    uint16_t BucketToBufferGadget::getTriggerIndex(ISMRMRD::ISMRMRD_EncodingCounters idx)
+    {
+        switch (trigger_) {
+        case KSPACE_ENCODE_STEP_1:
+            return idx.kspace_encode_step_1;
+        case KSPACE_ENCODE_STEP_2:
+            return idx.kspace_encode_step_2;
+        case AVERAGE:
+            return idx.average;
+        case SLICE:
+            return idx.slice;
+        case CONTRAST:
+            return idx.contrast;
+        case PHASE:
+            return idx.phase;
+        case REPETITION:
+            return idx.repetition;
+        case SET:
+            return idx.set;
+        case SEGMENT:
+            return idx.segment;
+        case USER_0:
+            return idx.user[0];
+        case USER_1:
+            return idx.user[1];
+        case USER_2:
+            return idx.user[2];
+        case USER_3:
+            return idx.user[3];
+        case USER_4:
+            return idx.user[4];
+        case USER_5:
+            return idx.user[5];
+        case USER_6:
+            return idx.user[6];
+        case USER_7:
+            return idx.user[7];
+        default:
+            return 0;
+        }
+    }
+
+    void BucketToBufferGadget::fillStatsFromEncodingLimits(IsmrmrdAcquisitionBucketStats & stats, ISMRMRD::Encoding & encoding, ISMRMRD::AcquisitionHeader & acqhdr)
+    {
+        ISMRMRD::EncodingLimits & limits = encoding.encodingLimits;
+
+        //Without a limit, the whole encoded matrix or only the first index is used
+        stats.kspace_encode_step_1.insert(limits.kspace_encoding_step_1.is_present() ? limits.kspace_encoding_step_1->minimum : 0);
+        stats.kspace_encode_step_1.insert(limits.kspace_encoding_step_1.is_present() ? limits.kspace_encoding_step_1->maximum : encoding.encodedSpace.matrixSize.y - 1);
+        stats.kspace_encode_step_2.insert(limits.kspace_encoding_step_2.is_present() ? limits.kspace_encoding_step_2->minimum : 0);
+        stats.kspace_encode_step_2.insert(limits.kspace_encoding_step_2.is_present() ? limits.kspace_encoding_step_2->maximum : encoding.encodedSpace.matrixSize.z - 1);
+        stats.average.insert(limits.average.is_present() ? limits.average->minimum : 0);
+        stats.average.insert(limits.average.is_present() ? limits.average->maximum : 0);
+        stats.slice.insert(limits.slice.is_present() ? limits.slice->minimum : 0);
+        stats.slice.insert(limits.slice.is_present() ? limits.slice->maximum : 0);
+        stats.contrast.insert(limits.contrast.is_present() ? limits.contrast->minimum : 0);
+        stats.contrast.insert(limits.contrast.is_present() ? limits.contrast->maximum : 0);
+        stats.phase.insert(limits.phase.is_present() ? limits.phase->minimum : 0);
+        stats.phase.insert(limits.phase.is_present() ? limits.phase->maximum : 0);
+        stats.repetition.insert(limits.repetition.is_present() ? limits.repetition->minimum : 0);
+        stats.repetition.insert(limits.repetition.is_present() ? limits.repetition->maximum : 0);
+        stats.set.insert(limits.set.is_present() ? limits.set->minimum : 0);
+        stats.set.insert(limits.set.is_present() ? limits.set->maximum : 0);
+        stats.segment.insert(limits.segment.is_present() ? limits.segment->minimum : 0);
+        stats.segment.insert(limits.segment.is_present() ? limits.segment->maximum : 0);
+
+        //The buffer is sent when the trigger dimension changes, so it only holds the current index
+        switch (trigger_) {
+        case KSPACE_ENCODE_STEP_1:
+            stats.kspace_encode_step_1.clear();
+            stats.kspace_encode_step_1.insert(acqhdr.idx.kspace_encode_step_1);
+            break;
+        case KSPACE_ENCODE_STEP_2:
+            stats.kspace_encode_step_2.clear();
+            stats.kspace_encode_step_2.insert(acqhdr.idx.kspace_encode_step_2);
+            break;
+        case AVERAGE:
+            stats.average.clear();
+            stats.average.insert(acqhdr.idx.average);
+            break;
+        case SLICE:
+            stats.slice.clear();
+            stats.slice.insert(acqhdr.idx.slice);
+            break;
+        case CONTRAST:
+            stats.contrast.clear();
+            stats.contrast.insert(acqhdr.idx.contrast);
+            break;
+        case PHASE:
+            stats.phase.clear();
+            stats.phase.insert(acqhdr.idx.phase);
+            break;
+        case REPETITION:
+            stats.repetition.clear();
+            stats.repetition.insert(acqhdr.idx.repetition);
+            break;
+        case SET:
+            stats.set.clear();
+            stats.set.insert(acqhdr.idx.set);
+            break;
+        case SEGMENT:
+            stats.segment.clear();
+            stats.segment.insert(acqhdr.idx.segment);
+            break;
+        default:
+            break;
+        }
+    }
+
     IsmrmrdReconBit & BucketToBufferGadget::getRBit(std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > & recon_data_buffers, size_t key, uint16_t espace)
     {
         //Look up the corresponding ReconData buffer
@@ -742,11 +1013,16 @@ namespace Gadgetron {
     }
 
     void BucketToBufferGadget::stuff(std::vector<IsmrmrdAcquisitionData>::iterator it, IsmrmrdDataBuffered & dataBuffer, ISMRMRD::Encoding encoding, IsmrmrdAcquisitionBucketStats & stats, bool forref)
+    {
+        stuff(*it, dataBuffer, encoding, stats, forref);
+    }
+
+    void BucketToBufferGadget::stuff(IsmrmrdAcquisitionData & acq, IsmrmrdDataBuffered & dataBuffer, ISMRMRD::Encoding & encoding, IsmrmrdAcquisitionBucketStats & stats, bool forref)
     {
 
         // The acquisition header and data
-        ISMRMRD::AcquisitionHeader & acqhdr = *it->head_->getObjectPtr();
-        hoNDArray< std::complex<float> > & acqdata = *it->data_->getObjectPtr();
+        ISMRMRD::AcquisitionHeader & acqhdr = *acq.head_->getObjectPtr();
+        hoNDArray< std::complex<float> > & acqdata = *acq.data_->getObjectPtr();
         // we make one for the trajectory down below if we need it
 
         uint16_t NE0 = (uint16_t)dataBuffer.data_.get_size(0);
@@ -886,7 +1162,7 @@ namespace Gadgetron {
         if (acqhdr.trajectory_dimensions > 0)
         {
 
-            hoNDArray< float > & acqtraj = *it->traj_->getObjectPtr();  // TODO do we need to check this?
+            hoNDArray< float > & acqtraj = *acq.traj_->getObjectPtr();  // TODO do we need to check this?
 
             float * trajptr;
 
@@ -24,12 +24,22 @@ namespace Gadgetron{
     // Since the order of data can be changed from its acquried time order, there is no easy way to resort waveform data
     // Therefore, the waveform data was copied and passed with every buffer
 
+    // The gadget also accepts the readouts directly, e.g. straight from the reader, without the AcquisitionAccumulateTriggerGadget.
+    // In that case, the buffers are sized from the encoding limits when the first readout of a buffer arrives and every readout
+    // is copied into its place and released at once, so the readouts of a whole bucket are never held at the same time.
+    // The buffers are sent when the trigger_dimension changes and at the end of the scan.
+    // The reference readouts are still collected until the trigger, because the size of the separate or external
+    // reference buffers is given by the lines which were acquired.
+    // Waveforms are attached to these buffers once the first readout has arrived, before that they are passed on.
+
   class EXPORTGADGETSMRICORE BucketToBufferGadget : 
-  public Gadget1<IsmrmrdAcquisitionBucket>
+  public Gadget1Of2<IsmrmrdAcquisitionBucket, ISMRMRD::AcquisitionHeader>
     {
     public:
       GADGET_DECLARE(BucketToBufferGadget);
 
+      typedef Gadget1Of2<IsmrmrdAcquisitionBucket, ISMRMRD::AcquisitionHeader> BaseClass;
+
       BucketToBufferGadget();
       virtual ~BucketToBufferGadget();
 
@@ -58,6 +68,27 @@ namespace Gadgetron{
                  "slice",
                  "");
 
+      GADGET_PROPERTY_LIMITS(trigger_dimension, std::string, "Dimension to trigger on, when the readouts are received directly", "",
+                 GadgetPropertyLimitsEnumeration,
+                 "kspace_encode_step_1",
+                 "kspace_encode_step_2",
+                 "average",
+                 "slice",
+                 "contrast",
+                 "phase",
+                 "repetition",
+                 "set",
+                 "segment",
+                 "user_0",
+                 "user_1",
+                 "user_2",
+                 "user_3",
+                 "user_4",
+                 "user_5",
+                 "user_6",
+                 "user_7",
+                 "");
+
       GADGET_PROPERTY(split_slices, bool, "Split slices", false);
       GADGET_PROPERTY(ignore_segment, bool, "Ignore segment", false);
       GADGET_PROPERTY(verbose, bool, "Whether to print more information", false);
@@ -67,9 +98,33 @@ namespace Gadgetron{
       bool split_slices_;
       bool ignore_segment_;
       ISMRMRD::IsmrmrdHeader hdr_;
-      
+
+      // for the readouts received directly
+      IsmrmrdCONDITION trigger_;
+      std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > direct_buffers_;
+      IsmrmrdAcquisitionBucket direct_ref_;
+      ISMRMRD::AcquisitionHeader prev_acqhdr_;
+      bool has_prev_acqhdr_;
+      std::vector<ISMRMRD::Waveform> wav_buf_;
+
       virtual int process_config(ACE_Message_Block* mb);
+      virtual int process(ACE_Message_Block* mb);
       virtual int process(GadgetContainerMessage<IsmrmrdAcquisitionBucket>* m1);
+      virtual int process(GadgetContainerMessage<ISMRMRD::AcquisitionHeader>* m1);
+      virtual int process(GadgetContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>* m1);
+
+      // fill the buffers with the readouts of a bucket
+      void stuffBucket(std::vector<IsmrmrdAcquisitionData>& acqs, std::vector<IsmrmrdAcquisitionBucketStats>& stats, std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > & recon_data_buffers, bool forref);
+      // send the buffers holding any data down the chain, with the waveforms attached
+      void sendBuffers(std::map<size_t, GadgetContainerMessage<IsmrmrdReconData>* > & recon_data_buffers, std::vector<ISMRMRD::Waveform>& wav);
+      // send the buffers of the readouts received directly
+      void triggerDirectBuffers();
+
+      // the stats a buffer of the readouts received directly is allocated for, given by the encoding limits
+      // the trigger dimension only has the value of the current readout
+      void fillStatsFromEncodingLimits(IsmrmrdAcquisitionBucketStats & stats, ISMRMRD::Encoding & encoding, ISMRMRD::AcquisitionHeader & acqhdr);
+      uint16_t getTriggerIndex(ISMRMRD::ISMRMRD_EncodingCounters idx);
+
       size_t getKey(ISMRMRD::ISMRMRD_EncodingCounters idx);
       size_t getSlice(ISMRMRD::ISMRMRD_EncodingCounters idx);
       size_t getN(ISMRMRD::ISMRMRD_EncodingCounters idx);
@@ -79,6 +134,7 @@ namespace Gadgetron{
       virtual void allocateDataArrays(IsmrmrdDataBuffered &  dataBuffer, ISMRMRD::AcquisitionHeader & acqhdr, ISMRMRD::Encoding encoding, IsmrmrdAcquisitionBucketStats & stats, bool forref);
       virtual void fillSamplingDescription(SamplingDescription & sampling, ISMRMRD::Encoding & encoding, IsmrmrdAcquisitionBucketStats & stats, ISMRMRD::AcquisitionHeader & acqhdr, bool forref);
       virtual void stuff(std::vector<IsmrmrdAcquisitionData>::iterator it, IsmrmrdDataBuffered & dataBuffer, ISMRMRD::Encoding encoding, IsmrmrdAcquisitionBucketStats & stats, bool forref);
+      virtual void stuff(IsmrmrdAcquisitionData & acq, IsmrmrdDataBuffered & dataBuffer, ISMRMRD::Encoding & encoding, IsmrmrdAcquisitionBucketStats & stats, bool forref);
     };
 }
 #endif //BUCKETTOBUFFER_H
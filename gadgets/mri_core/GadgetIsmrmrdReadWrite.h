@@ -3,12 +3,14 @@
 
 #include "GadgetMRIHeaders.h"
 #include "GadgetContainerMessage.h"
+#include "GadgetContainerMessagePool.h"
 #include "GadgetMessageInterface.h"
 #include "hoNDArray.h"
 #include "url_encode.h"
 #include "gadgetron_mricore_export.h"
 #include <ismrmrd/ismrmrd.h>
 #include <ismrmrd/waveform.h>
+#include <ismrmrd/xml.h>
 #include <ace/SOCK_Stream.h>
 #include <ace/Task.h>
 #include <complex>
@@ -26,6 +28,20 @@ namespace Gadgetron{
 
     public:
         virtual int write(ACE_SOCK_Stream* sock, ACE_Message_Block* mb)
+        {
+	  GadgetOutputStream out(sock);
+	  if (this->write_gather(&out, mb) < 0) {
+	    return -1;
+	  }
+
+	  if (out.flush() < 0) {
+	    GERROR("Unable to send acquisition\n");
+	    return -1;
+	  }
+	  return 0;
+        }
+
+        virtual int write_gather(GadgetOutputStream* out, ACE_Message_Block* mb)
         {
 	  auto h = AsContainerMessage<ISMRMRD::AcquisitionHeader>(mb);
 
@@ -34,21 +50,12 @@ namespace Gadgetron{
 	    return -1;
 	  }
 
-	  ssize_t send_cnt = 0;
-	  
 	  GadgetMessageIdentifier id;
 	  id.id = GADGET_MESSAGE_ISMRMRD_ACQUISITION;
-
-	  if ((send_cnt = sock->send_n (&id, sizeof(GadgetMessageIdentifier))) <= 0) {
-	    GERROR("Unable to send acquisition message identifier\n");
-	    return -1;
-	  }
+	  out->append_copy(&id, sizeof(GadgetMessageIdentifier));
 
 	  ISMRMRD::AcquisitionHeader* acqHead = h->getObjectPtr();
-	  if ((send_cnt = sock->send_n (acqHead, sizeof(ISMRMRD::AcquisitionHeader))) <= 0) {
-	    GERROR("Unable to send acquisition header\n");
-	    return -1;
-	  }
+	  out->append(acqHead, sizeof(ISMRMRD::AcquisitionHeader));
 
 	  unsigned long trajectory_elements = acqHead->trajectory_dimensions*acqHead->number_of_samples;
 	  unsigned long data_elements = acqHead->active_channels*acqHead->number_of_samples;
@@ -56,18 +63,12 @@ namespace Gadgetron{
 	  auto d = AsContainerMessage< hoNDArray<std::complex<float> > >(h->cont());
 	  
 	  if (trajectory_elements) {
-	    auto t = AsContainerMessage< hoNDArray<float> >(h->cont());
-	    if ((send_cnt = sock->send_n (t->getObjectPtr()->get_data_ptr(), sizeof(float)*trajectory_elements)) <= 0) {
-	      GERROR("Unable to send acquisition trajectory elements\n");
-	      return -1;
-	    }
+	    auto t = AsContainerMessage< hoNDArray<float> >(d->cont());
+	    out->append(t->getObjectPtr()->get_data_ptr(), sizeof(float)*trajectory_elements);
 	  }
 
 	  if (data_elements) {
-	    if ((send_cnt = sock->send_n (d->getObjectPtr()->get_data_ptr(), 2*sizeof(float)*data_elements)) <= 0) {
-	      GERROR("Unable to send acquisition data elements\n");
-	      return -1;
-	    }
+	    out->append(d->getObjectPtr()->get_data_ptr(), 2*sizeof(float)*data_elements);
 	  }
 	  
 	  return 0;
@@ -76,6 +77,16 @@ namespace Gadgetron{
 
     /**
     Default implementation of GadgetMessageReader for IsmrmrdAcquisition messages
+
+    A reader instance is created per connection. Headers, sample arrays and trajectory arrays are taken
+    from per-reader pools and returned there when the downstream gadgets release them, so for a
+    steady stream of equally sized readouts no heap allocation takes place after the first few readouts.
+
+    When the ISMRMRD header of the connection is received, the pools are filled with one message per
+    phase encoding line of the first encoding space, with arrays of the encoded matrix size times the
+    number of receiver channels. The trajectory pool is filled the same way when the first readout with a
+    trajectory arrives, with the trajectory dimensions of its header. Readouts of a different size resize
+    the array of the message they get.
     */
     class EXPORTGADGETSMRICORE GadgetIsmrmrdAcquisitionMessageReader : public GadgetMessageReader
     {
@@ -83,14 +94,84 @@ namespace Gadgetron{
     public:
         GADGETRON_READER_DECLARE(GadgetIsmrmrdAcquisitionMessageReader);
 
+        GadgetIsmrmrdAcquisitionMessageReader()
+            : header_pool_(new GadgetContainerMessagePool<ISMRMRD::AcquisitionHeader>())
+            , data_pool_(new GadgetContainerMessagePool< hoNDArray< std::complex<float> > >())
+            , traj_pool_(new GadgetContainerMessagePool< hoNDArray< float > >())
+            , traj_reserve_(0)
+        {
+        }
+
+        virtual ~GadgetIsmrmrdAcquisitionMessageReader()
+        {
+            GadgetContainerMessagePoolStatistics h = header_pool_->statistics();
+            GadgetContainerMessagePoolStatistics d = data_pool_->statistics();
+            GadgetContainerMessagePoolStatistics t = traj_pool_->statistics();
+
+            if (h.hits + h.misses) {
+                GDEBUG("GadgetIsmrmrdAcquisitionMessageReader, pool hit rate : header %f, data %f, trajectory %f\n", h.hit_rate(), d.hit_rate(), t.hit_rate());
+                GDEBUG("GadgetIsmrmrdAcquisitionMessageReader, pool peak resident bytes : header %zu, data %zu, trajectory %zu\n", h.peak_resident_bytes, d.peak_resident_bytes, t.peak_resident_bytes);
+            }
+        }
+
+        GadgetContainerMessagePoolStatistics header_pool_statistics() { return header_pool_->statistics(); }
+        GadgetContainerMessagePoolStatistics data_pool_statistics() { return data_pool_->statistics(); }
+        GadgetContainerMessagePoolStatistics trajectory_pool_statistics() { return traj_pool_->statistics(); }
+
         virtual ACE_Message_Block* read(ACE_SOCK_Stream* stream)
         {
+            return read_impl(stream);
+        }
+
+        virtual ACE_Message_Block* read_buffered(GadgetInputStream* stream)
+        {
+            return read_impl(stream);
+        }
+
+        virtual bool supports_read_ahead()
+        {
+            return true;
+        }
+
+        virtual void set_parameters(const std::string& xml)
+        {
+            ISMRMRD::IsmrmrdHeader h;
+            try {
+                ISMRMRD::deserialize(xml.c_str(), h);
+            }
+            catch (...) {
+                GWARN("GadgetIsmrmrdAcquisitionMessageReader, unable to parse the ISMRMRD header, the pools grow on demand\n");
+                return;
+            }
+
+            if (h.encoding.empty() || !h.acquisitionSystemInformation || !h.acquisitionSystemInformation->receiverChannels) {
+                return;
+            }
+
+            const ISMRMRD::Encoding& e = h.encoding[0];
+            size_t samples = e.encodedSpace.matrixSize.x;
+            size_t channels = h.acquisitionSystemInformation->receiverChannels.get();
+            size_t lines = e.encodedSpace.matrixSize.y;
 
-            GadgetContainerMessage<ISMRMRD::AcquisitionHeader>* m1 =
-                new GadgetContainerMessage<ISMRMRD::AcquisitionHeader>();
+            if (!samples || !lines) return;
 
-            GadgetContainerMessage<hoNDArray< std::complex<float> > >* m2 =
-                new GadgetContainerMessage< hoNDArray< std::complex<float> > >();
+            header_pool_->reserve(lines, [](ISMRMRD::AcquisitionHeader&) {});
+            data_pool_->reserve(lines, [=](hoNDArray< std::complex<float> >& a) { a.create(samples, channels); });
+
+            //The number of trajectory dimensions (2D or 3D k-space, plus density weights for some trajectories) is only
+            //known from the acquisition headers, so the trajectory pool is filled with the first readout carrying one
+            traj_reserve_ = lines;
+
+            GDEBUG("GadgetIsmrmrdAcquisitionMessageReader, pools filled with %zu readouts of %zu samples x %zu channels\n", lines, samples, channels);
+        }
+
+    protected:
+        template <class S> ACE_Message_Block* read_impl(S* stream)
+        {
+
+            PooledGadgetContainerMessage<ISMRMRD::AcquisitionHeader>* m1 = header_pool_->acquire();
+
+            PooledGadgetContainerMessage<hoNDArray< std::complex<float> > >* m2 = data_pool_->acquire();
 
             m1->cont(m2);
 
@@ -102,8 +183,14 @@ namespace Gadgetron{
             }
 
             if (m1->getObjectPtr()->trajectory_dimensions) {
-                GadgetContainerMessage<hoNDArray< float > >* m3 =
-                    new GadgetContainerMessage< hoNDArray< float > >();
+                if (traj_reserve_) {
+                    size_t dims = m1->getObjectPtr()->trajectory_dimensions;
+                    size_t samples = m1->getObjectPtr()->number_of_samples;
+                    traj_pool_->reserve(traj_reserve_, [=](hoNDArray< float >& a) { a.create(dims, samples); });
+                    traj_reserve_ = 0;
+                }
+
+                PooledGadgetContainerMessage<hoNDArray< float > >* m3 = traj_pool_->acquire();
 
                 m2->cont(m3);
 
@@ -118,6 +205,7 @@ namespace Gadgetron{
 
                     return 0;
                 }
+                traj_pool_->account(m3);
 
                 if ((recv_count =
 		     stream->recv_n
@@ -142,6 +230,7 @@ namespace Gadgetron{
 
                 return 0;
             }
+            data_pool_->account(m2);
 
 
             if (m1->getObjectPtr()->isFlagSet(ISMRMRD::ISMRMRD_ACQ_COMPRESSION1)) { //Is this ZFP compressed data
@@ -155,7 +244,8 @@ namespace Gadgetron{
                     return 0;
                 }
 
-                char* comp_buffer = new char[comp_size];
+                if (comp_buffer_.size() < comp_size) comp_buffer_.resize(comp_size);
+                char* comp_buffer = reinterpret_cast<char*>(comp_buffer_.data());
                 if ((recv_count = stream->recv_n(comp_buffer, comp_size)) <= 0) {
 	            GERROR("Unable to read compressed data\n");
                     m1->release();
@@ -178,7 +268,6 @@ namespace Gadgetron{
                     zfp_field_free(field);
                     zfp_stream_close(zfp);
                     stream_close(cstream);            
-                    delete [] comp_buffer;
                     m1->release();
                     return 0;
                 }
@@ -190,7 +279,6 @@ namespace Gadgetron{
                     zfp_field_free(field);
                     zfp_stream_close(zfp);
                     stream_close(cstream);            
-                    delete [] comp_buffer;
                     m1->release();
                     return 0;
                 }
@@ -205,7 +293,6 @@ namespace Gadgetron{
                     zfp_field_free(field);
                     zfp_stream_close(zfp);
                     stream_close(cstream);            
-                    delete [] comp_buffer;
                     m1->release();
                     return 0;                
                 }
@@ -216,7 +303,6 @@ namespace Gadgetron{
                     zfp_field_free(field);
                     zfp_stream_close(zfp);
                     stream_close(cstream);            
-                    delete [] comp_buffer;
                     m1->release();
                     return 0;                
                 }
@@ -224,7 +310,6 @@ namespace Gadgetron{
                 zfp_field_free(field);
                 zfp_stream_close(zfp);
                 stream_close(cstream);            
-                delete [] comp_buffer;
 
                 //At this point the data is no longer compressed and we should clear the flag
                 m1->getObjectPtr()->clearFlag(ISMRMRD::ISMRMRD_ACQ_COMPRESSION1);
@@ -247,15 +332,15 @@ namespace Gadgetron{
                     return 0;
                 }
 
-                std::vector<uint8_t> comp_buffer(comp_size,0);
-                if ((recv_count = stream->recv_n(&comp_buffer[0], comp_size)) <= 0) {
+                comp_buffer_.resize(comp_size);
+                if ((recv_count = stream->recv_n(comp_buffer_.data(), comp_size)) <= 0) {
 	            GERROR("Unable to read compressed data\n");
                     m1->release();
                     return 0;
                 }
 
                 CompressedBuffer<float> comp;
-                comp.deserialize(comp_buffer);
+                comp.deserialize(comp_buffer_);
 
                 if (comp.size() != m2->getObjectPtr()->get_number_of_elements()*2) { //*2 for complex
 	            GERROR("Mismatch between uncompressed data samples (%d) and expected number of samples (%d)\n", comp.size(), m2->getObjectPtr()->get_number_of_elements()*2);
@@ -287,6 +372,13 @@ namespace Gadgetron{
             return m1;
         }
 
+        boost::shared_ptr< GadgetContainerMessagePool<ISMRMRD::AcquisitionHeader> > header_pool_;
+        boost::shared_ptr< GadgetContainerMessagePool< hoNDArray< std::complex<float> > > > data_pool_;
+        boost::shared_ptr< GadgetContainerMessagePool< hoNDArray< float > > > traj_pool_;
+        size_t traj_reserve_; //Trajectory arrays still to be put in the pool, see set_parameters
+
+        // receive buffer for compressed readouts, reused across reads
+        std::vector<uint8_t> comp_buffer_;
     };
 
     // ------------------------------------------------------------------------------------------------------- //
@@ -297,6 +389,22 @@ namespace Gadgetron{
 
     public:
         virtual int write(ACE_SOCK_Stream* sock, ACE_Message_Block* mb)
+        {
+            GadgetOutputStream out(sock);
+            if (this->write_gather(&out, mb) < 0)
+            {
+                return -1;
+            }
+
+            if (out.flush() < 0)
+            {
+                GERROR("Unable to send waveform\n");
+                return -1;
+            }
+            return 0;
+        }
+
+        virtual int write_gather(GadgetOutputStream* out, ACE_Message_Block* mb)
         {
             auto h = AsContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>(mb);
 
@@ -306,23 +414,12 @@ namespace Gadgetron{
                 return -1;
             }
 
-            ssize_t send_cnt = 0;
-
             GadgetMessageIdentifier id;
             id.id = GADGET_MESSAGE_ISMRMRD_WAVEFORM;
-
-            if ((send_cnt = sock->send_n(&id, sizeof(GadgetMessageIdentifier))) <= 0)
-            {
-                GERROR("Unable to send waveform message identifier\n");
-                return -1;
-            }
+            out->append_copy(&id, sizeof(GadgetMessageIdentifier));
 
             ISMRMRD::ISMRMRD_WaveformHeader* wavHead = h->getObjectPtr();
-            if ((send_cnt = sock->send_n(wavHead, sizeof(ISMRMRD::ISMRMRD_WaveformHeader))) <= 0)
-            {
-                GERROR("Unable to send waveform header\n");
-                return -1;
-            }
+            out->append(wavHead, sizeof(ISMRMRD::ISMRMRD_WaveformHeader));
 
             unsigned long data_elements = wavHead->channels*wavHead->number_of_samples;
 
@@ -330,11 +427,7 @@ namespace Gadgetron{
 
             if (data_elements)
             {
-                if ((send_cnt = sock->send_n(d->getObjectPtr()->get_data_ptr(), sizeof(uint32_t)*data_elements)) <= 0)
-                {
-                    GERROR("Unable to send waveform data elements\n");
-                    return -1;
-                }
+                out->append(d->getObjectPtr()->get_data_ptr(), sizeof(uint32_t)*data_elements);
             }
 
             return 0;
@@ -348,6 +441,22 @@ namespace Gadgetron{
         GADGETRON_READER_DECLARE(GadgetIsmrmrdWaveformMessageReader);
 
         virtual ACE_Message_Block* read(ACE_SOCK_Stream* stream)
+        {
+            return read_impl(stream);
+        }
+
+        virtual ACE_Message_Block* read_buffered(GadgetInputStream* stream)
+        {
+            return read_impl(stream);
+        }
+
+        virtual bool supports_read_ahead()
+        {
+            return true;
+        }
+
+    protected:
+        template <class S> ACE_Message_Block* read_impl(S* stream)
         {
             GadgetContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>* m1 = new GadgetContainerMessage<ISMRMRD::ISMRMRD_WaveformHeader>();
             GadgetContainerMessage<hoNDArray< uint32_t > >* m2 = new GadgetContainerMessage< hoNDArray< uint32_t > >();
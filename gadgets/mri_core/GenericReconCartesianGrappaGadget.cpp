@@ -594,41 +594,34 @@ namespace Gadgetron {
         }
 
         // unwrapping
+        // frames from ref_N-1 on share the unmixing coefficients of the last reference frame and form one group,
+        // the groups of all S and SLC are unmixed in a single call, which balances the tiles of all frames over the threads
 
-        long long num = N * S * SLC;
+        size_t unmixCHA = (unmixingCoeff_CHA <= srcCHA) ? unmixingCoeff_CHA : srcCHA;
+        size_t numGroupN = (ref_N < N) ? ref_N : N;
 
-        long long ii;
-
-#pragma omp parallel default(none) private(ii) shared(num, N, S, RO, E1, E2, srcCHA, convkRO, convkE1, convkE2, ref_N, ref_S, recon_obj, dstCHA, unmixingCoeff_CHA, e) if(num>1)
-        {
-#pragma omp for
-            for (ii = 0; ii < num; ii++) {
-                size_t slc = ii / (N * S);
-                size_t s = (ii - slc * N * S) / N;
-                size_t n = ii - slc * N * S - s * N;
-
-                // combined channels
-                T *pIm = &(complex_im_recon_buf_(0, 0, 0, 0, n, s, slc));
-
-                size_t usedN = n;
-                if (n >= ref_N) usedN = ref_N - 1;
+        std::vector<const T*> pIm, pUnmix;
+        std::vector<T*> pRes;
+        std::vector<size_t> numFrames;
 
+        for (size_t slc = 0; slc < SLC; slc++) {
+            for (size_t s = 0; s < S; s++) {
                 size_t usedS = s;
                 if (s >= ref_S) usedS = ref_S - 1;
 
-                T *pUnmix = &(recon_obj.unmixing_coeff_(0, 0, 0, 0, usedN, usedS, slc));
-
-                T *pRes = &(recon_obj.recon_res_.data_(0, 0, 0, 0, n, s, slc));
-                hoNDArray<std::complex<float> > res(RO, E1, E2, 1, pRes);
-
-                hoNDArray<std::complex<float> > unmixing(RO, E1, E2, unmixingCoeff_CHA, pUnmix);
-                hoNDArray<std::complex<float> > aliasedIm(RO, E1, E2,
-                                                          ((unmixingCoeff_CHA <= srcCHA) ? unmixingCoeff_CHA : srcCHA),
-                                                          1, pIm);
-                Gadgetron::apply_unmix_coeff_aliased_image_3D(aliasedIm, unmixing, res);
+                for (size_t n = 0; n < numGroupN; n++) {
+                    // combined channels
+                    pIm.push_back(&(complex_im_recon_buf_(0, 0, 0, 0, n, s, slc)));
+                    pUnmix.push_back(&(recon_obj.unmixing_coeff_(0, 0, 0, 0, n, usedS, slc)));
+                    pRes.push_back(&(recon_obj.recon_res_.data_(0, 0, 0, 0, n, s, slc)));
+                    numFrames.push_back((n + 1 == numGroupN) ? N - n : 1);
+                }
             }
         }
 
+        Gadgetron::apply_unmix_coeff_multiple_groups(pIm, RO * E1 * E2 * dstCHA, pUnmix, RO * E1 * E2, unmixCHA,
+                                                     numFrames, pRes, RO * E1 * E2);
+
         if (!debug_folder_full_path_.empty()) {
             std::stringstream os;
             os << "encoding_" << e;
@@ -7,6 +7,7 @@
 #include "mri_core_grappa.h"
 #include "hoNDArray_reductions.h"
 #include "hoGdSolver.h"
+#include "hoFistaSolver.h"
 #include <boost/make_shared.hpp>
 
 namespace Gadgetron {
@@ -512,10 +513,17 @@ namespace Gadgetron {
                                     << " - using coil sen map : "                       << this->spirit_reg_use_coil_sen_map.value()
                                     << " - iter thres : "                               << this->spirit_nl_iter_thres.value()
                                     << " - wavelet name : "                             << this->spirit_reg_name.value()
+                                    << " - solver : "                                   << this->spirit_nl_solver.value()
                                     );
 
                     typedef hoGdSolver< hoNDArray< std::complex<float> >, hoWavelet2DTOperator< std::complex<float> > > SolverType;
-                    SolverType solver;
+                    typedef hoFistaSolver< hoNDArray< std::complex<float> >, hoWavelet2DTOperator< std::complex<float> > > FistaSolverType;
+                    boost::shared_ptr<SolverType> pSolver;
+                    if (this->spirit_nl_solver.value() == "fista")
+                        pSolver = boost::make_shared<FistaSolverType>();
+                    else
+                        pSolver = boost::make_shared<SolverType>();
+                    SolverType& solver = *pSolver;
                     solver.iterations_ = this->spirit_nl_iter_max.value();
                     solver.set_output_mode(this->spirit_print_iter.value() ? SolverType::OUTPUT_VERBOSE : SolverType::OUTPUT_SILENT);
                     solver.grad_thres_ = this->spirit_nl_iter_thres.value();
@@ -580,10 +588,17 @@ namespace Gadgetron {
                                     << " - using coil sen map : " << this->spirit_reg_use_coil_sen_map.value()
                                     << " - iter thres : " << this->spirit_nl_iter_thres.value()
                                     << " - wavelet name : " << this->spirit_reg_name.value()
+                                    << " - solver : " << this->spirit_nl_solver.value()
                                     );
 
                     typedef hoGdSolver< hoNDArray< std::complex<float> >, hoWavelet2DTOperator< std::complex<float> > > SolverType;
-                    SolverType solver;
+                    typedef hoFistaSolver< hoNDArray< std::complex<float> >, hoWavelet2DTOperator< std::complex<float> > > FistaSolverType;
+                    boost::shared_ptr<SolverType> pSolver;
+                    if (this->spirit_nl_solver.value() == "fista")
+                        pSolver = boost::make_shared<FistaSolverType>();
+                    else
+                        pSolver = boost::make_shared<SolverType>();
+                    SolverType& solver = *pSolver;
                     solver.iterations_ = this->spirit_nl_iter_max.value();
                     solver.set_output_mode(this->spirit_print_iter.value() ? SolverType::OUTPUT_VERBOSE : SolverType::OUTPUT_SILENT);
                     solver.grad_thres_ = this->spirit_nl_iter_thres.value();
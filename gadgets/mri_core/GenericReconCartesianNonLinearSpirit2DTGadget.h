@@ -35,6 +35,7 @@ namespace Gadgetron {
         /// parameters for non-linear iteration
         GADGET_PROPERTY(spirit_nl_iter_max                   , int,     "Spirit maximal number of iterations for nonlinear optimization", 0);
         GADGET_PROPERTY(spirit_nl_iter_thres                 , double,  "Spirit threshold to stop iteration for nonlinear optimization", 0);
+        GADGET_PROPERTY_LIMITS(spirit_nl_solver              , std::string, "Spirit solver for nonlinear optimization, gradient descent or FISTA with adaptive restart", "gd", GadgetPropertyLimitsEnumeration, "gd", "fista");
         /// parameters for image domain regularization, wavelet type regularizer is used here
         GADGET_PROPERTY_LIMITS(spirit_reg_name               , std::string, "Spirit image domain regularizer", "db1", GadgetPropertyLimitsEnumeration, "db1", "db2", "db3", "db4", "db5");
         GADGET_PROPERTY(spirit_reg_level                     , int,     "Spirit image domain regularizer, number of transformation levels", 1);
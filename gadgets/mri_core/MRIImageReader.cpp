@@ -121,6 +121,16 @@ public:
 namespace Gadgetron{
 
   ACE_Message_Block* MRIImageReader::read(ACE_SOCK_Stream* stream)
+  {
+    return this->read_impl(stream);
+  }
+
+  ACE_Message_Block* MRIImageReader::read_buffered(GadgetInputStream* stream)
+  {
+    return this->read_impl(stream);
+  }
+
+  template <class S> ACE_Message_Block* MRIImageReader::read_impl(S* stream)
   {
 
     auto h = new GadgetContainerMessage< ISMRMRD::ImageHeader >();
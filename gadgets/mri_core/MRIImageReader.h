@@ -24,6 +24,11 @@ namespace Gadgetron{
     public:
         GADGETRON_READER_DECLARE(MRIImageReader);
         virtual ACE_Message_Block* read(ACE_SOCK_Stream* stream);
+        virtual ACE_Message_Block* read_buffered(GadgetInputStream* stream);
+        virtual bool supports_read_ahead() { return true; }
+
+    protected:
+        template <class S> ACE_Message_Block* read_impl(S* stream);
     };
 
 }
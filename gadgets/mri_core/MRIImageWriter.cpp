@@ -8,6 +8,23 @@
 namespace Gadgetron{
 
     int MRIImageWriter::write(ACE_SOCK_Stream* sock, ACE_Message_Block* mb)
+    {
+        GadgetOutputStream out(sock);
+        if (this->write_gather(&out, mb) != 0)
+        {
+            return -1;
+        }
+
+        if (out.flush() < 0)
+        {
+            GERROR("MRIImageWriter::write, unable to send image\n");
+            return -1;
+        }
+
+        return 0;
+    }
+
+    int MRIImageWriter::write_gather(GadgetOutputStream* out, ACE_Message_Block* mb)
     {
         GadgetContainerMessage<ISMRMRD::ImageHeader>* imagemb =
             AsContainerMessage<ISMRMRD::ImageHeader>(mb);
@@ -29,7 +46,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for unsigned short ... \n");
                 return -1;
@@ -44,7 +61,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for short ... \n");
                 return -1;
@@ -59,7 +76,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for unsigned int ... \n");
                 return -1;
@@ -74,7 +91,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for int ... \n");
                 return -1;
@@ -89,7 +106,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for float ... \n");
                 return -1;
@@ -104,7 +121,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for double ... \n");
                 return -1;
@@ -119,7 +136,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for std::complex<float> ... \n");
                 return -1;
@@ -134,7 +151,7 @@ namespace Gadgetron{
                 return -1;
             }
 
-            if (this->write_data_attrib(sock, imagemb, datamb) != 0)
+            if (this->write_data_attrib(out, imagemb, datamb) != 0)
             {
                 GERROR("MRIImageWriter::write_data_attrib failed for std::complex<double> ... \n");
                 return -1;
@@ -20,9 +20,10 @@ namespace Gadgetron{
     {
     public:
         virtual int write(ACE_SOCK_Stream* sock, ACE_Message_Block* mb);
+        virtual int write_gather(GadgetOutputStream* out, ACE_Message_Block* mb);
 
         template <typename T>
-        int write_data_attrib(ACE_SOCK_Stream* sock, GadgetContainerMessage<ISMRMRD::ImageHeader>* header, GadgetContainerMessage< hoNDArray<T> >* data)
+        int write_data_attrib(GadgetOutputStream* out, GadgetContainerMessage<ISMRMRD::ImageHeader>* header, GadgetContainerMessage< hoNDArray<T> >* data)
         {
             typedef unsigned long long size_t_type;
 
@@ -45,19 +46,9 @@ namespace Gadgetron{
                 return -1;
             }
 
-            ssize_t send_cnt = 0;
-            GadgetMessageIdentifier id;
-            id.id = GADGET_MESSAGE_ISMRMRD_IMAGE;
-
-            if ((send_cnt = sock->send_n(&id, sizeof(GadgetMessageIdentifier))) <= 0)
-            {
-                GERROR("Unable to send image message identifier\n");
-                return -1;
-            }
-
             GadgetContainerMessage<ISMRMRD::MetaContainer>* attribmb = AsContainerMessage<ISMRMRD::MetaContainer>(data->cont());
 
-            char* buf = NULL;
+            std::string attribContent;
             size_t_type len(0);
 
             if (attribmb)
@@ -66,14 +57,8 @@ namespace Gadgetron{
                 {
                     std::stringstream str;
                     ISMRMRD::serialize(*attribmb->getObjectPtr(), str);
-                    std::string attribContent = str.str();
+                    attribContent = str.str();
                     len = attribContent.length() + 1;
-
-                    buf = new char[len];
-                    GADGET_CHECK_THROW(buf != NULL);
-
-                    memset(buf, '\0', sizeof(char)*len);
-                    memcpy(buf, attribContent.c_str(), len - 1);
                 }
                 catch (...)
                 {
@@ -84,36 +69,19 @@ namespace Gadgetron{
 
             header->getObjectPtr()->attribute_string_len = (uint32_t)len;
 
-            if ((send_cnt = sock->send_n(header->getObjectPtr(), sizeof(ISMRMRD::ImageHeader))) <= 0)
-            {
-                GERROR("Unable to send image header\n");
-                return -1;
-            }
-
-            if ((send_cnt = sock->send_n(&len, sizeof(size_t_type))) <= 0)
-            {
-                GERROR("Unable to send image meta attributes length\n");
-                if (buf != NULL) delete[] buf;
-                return -1;
-            }
+            GadgetMessageIdentifier id;
+            id.id = GADGET_MESSAGE_ISMRMRD_IMAGE;
+            out->append_copy(&id, sizeof(GadgetMessageIdentifier));
+            out->append(header->getObjectPtr(), sizeof(ISMRMRD::ImageHeader));
+            out->append_copy(&len, sizeof(size_t_type));
 
             if (len>0)
             {
-                if ((send_cnt = sock->send_n(buf, len)) <= 0)
-                {
-                    GERROR("Unable to send image meta attributes\n");
-                    if (buf != NULL) delete[] buf;
-                    return -1;
-                }
+                //Serialized attributes are sent with their terminating null character
+                out->append_copy(attribContent.c_str(), len);
             }
 
-            if (buf != NULL) delete[] buf;
-
-            if ((send_cnt = sock->send_n(data->getObjectPtr()->get_data_ptr(), sizeof(T)*data->getObjectPtr()->get_number_of_elements())) <= 0)
-            {
-                GERROR("Unable to send image data\n");
-                return -1;
-            }
+            out->append(data->getObjectPtr()->get_data_ptr(), sizeof(T)*data->getObjectPtr()->get_number_of_elements());
 
             return 0;
         }
@@ -4,17 +4,13 @@
 #include "hoMatrix.h"
 #include "hoNDArray_linalg.h"
 #include "hoNDArray_reductions.h"
+#include "NoisePrewhitenerStore.h"
 #include "log.h"
 
 #ifdef USE_OMP
 #include "omp.h"
 #endif // USE_OMP
 
-#ifndef _WIN32
-#include <sys/types.h>
-#include <sys/stat.h>
-#endif // _WIN32
-
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
 
@@ -28,6 +24,8 @@ namespace Gadgetron {
         , noise_dwell_time_us_(-1.0f)
         , noiseCovarianceLoaded_(false)
         , saved_(false)
+        , prewhitener_scaled_(false)
+        , coil_layout_hash_(0)
     {
         noise_dependency_prefix_ = "GadgetronNoiseCovarianceMatrix";
         measurement_id_.clear();
@@ -75,6 +73,34 @@ namespace Gadgetron {
             GDEBUG("receiver_noise_bandwidth_ is %f\n", receiver_noise_bandwidth_);
         }
 
+        //Let's figure out if some channels are "scale_only"
+        std::string uncomb_str = scale_only_channels_by_name.value();
+        std::vector<std::string> uncomb;
+        if (uncomb_str.size()) {
+            GDEBUG("SCALE ONLY: %s\n", uncomb_str.c_str());
+            boost::split(uncomb, uncomb_str, boost::is_any_of(","));
+            for (unsigned int i = 0; i < uncomb.size(); i++) {
+                std::string ch = boost::algorithm::trim_copy(uncomb[i]);
+                if (current_ismrmrd_header_.acquisitionSystemInformation) {
+                    for (size_t i = 0; i < current_ismrmrd_header_.acquisitionSystemInformation->coilLabel.size(); i++) {
+                        if (ch == current_ismrmrd_header_.acquisitionSystemInformation->coilLabel[i].coilName) {
+                            scale_only_channels_.push_back(i);//This assumes that the channels are sorted in the header
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (current_ismrmrd_header_.acquisitionSystemInformation) {
+            coil_layout_hash_ = NoisePrewhitenerStore::layout_hash(current_ismrmrd_header_.acquisitionSystemInformation->coilLabel, scale_only_channels_);
+        }
+        else {
+            coil_layout_hash_ = NoisePrewhitenerStore::layout_hash(std::vector<ISMRMRD::CoilLabel>(), scale_only_channels_);
+        }
+
+        NoisePrewhitenerStore::instance()->set_capacity(prewhitener_cache_entries.value());
+
         // find the measurementID of this scan
         if (current_ismrmrd_header_.measurementInformation)
         {
@@ -105,11 +131,15 @@ namespace Gadgetron {
                 if (!measurement_id_of_noise_dependency_.empty()) {
                     GDEBUG("Measurement ID of noise dependency is %s\n", measurement_id_of_noise_dependency_.c_str());
 
-                    full_name_stored_noise_dependency_ = this->generateNoiseDependencyFilename(generateMeasurementIdOfNoiseDependency(measurement_id_of_noise_dependency_));
+                    noise_dependency_id_ = generateMeasurementIdOfNoiseDependency(measurement_id_of_noise_dependency_);
+                    full_name_stored_noise_dependency_ = this->generateNoiseDependencyFilename(noise_dependency_id_);
                     GDEBUG("Stored noise dependency is %s\n", full_name_stored_noise_dependency_.c_str());
 
-                    // try to load the precomputed noise prewhitener
-                    if (!this->loadNoiseCovariance()) {
+                    // try the prewhitener computed by an earlier scan with the same coils, then the noise covariance
+                    if (this->loadStoredPrewhitener()) {
+                        GDEBUG("Stored noise prewhitener is found for %s, noise dwell time in us is %f\n", noise_dependency_id_.c_str(), noise_dwell_time_us_);
+                    }
+                    else if (!this->loadNoiseCovariance()) {
                         GDEBUG("Stored noise dependency is NOT found : %s\n", full_name_stored_noise_dependency_.c_str());
                         noiseCovarianceLoaded_ = false;
                         noise_dwell_time_us_ = -1;
@@ -196,26 +226,6 @@ namespace Gadgetron {
             }
         }
 
-
-        //Let's figure out if some channels are "scale_only"
-        std::string uncomb_str = scale_only_channels_by_name.value();
-        std::vector<std::string> uncomb;
-        if (uncomb_str.size()) {
-            GDEBUG("SCALE ONLY: %s\n", uncomb_str.c_str());
-            boost::split(uncomb, uncomb_str, boost::is_any_of(","));
-            for (unsigned int i = 0; i < uncomb.size(); i++) {
-                std::string ch = boost::algorithm::trim_copy(uncomb[i]);
-                if (current_ismrmrd_header_.acquisitionSystemInformation) {
-                    for (size_t i = 0; i < current_ismrmrd_header_.acquisitionSystemInformation->coilLabel.size(); i++) {
-                        if (ch == current_ismrmrd_header_.acquisitionSystemInformation->coilLabel[i].coilName) {
-                            scale_only_channels_.push_back(i);//This assumes that the channels are sorted in the header
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
 #ifdef USE_OMP
         omp_set_num_threads(1);
 #endif // USE_OMP
@@ -259,38 +269,53 @@ namespace Gadgetron {
 
     bool NoiseAdjustGadget::loadNoiseCovariance()
     {
-        std::ifstream infile;
-        infile.open(full_name_stored_noise_dependency_.c_str(), std::ios::in | std::ios::binary);
+        MappedDependencyFile infile(full_name_stored_noise_dependency_);
 
-        if (infile.good()) {
-            //Read the XML header of the noise scan
-            uint32_t xml_length;
-            infile.read(reinterpret_cast<char*>(&xml_length), 4);
-            std::string xml_str(xml_length, '\0');
-            infile.read(const_cast<char*>(xml_str.c_str()), xml_length);
-            ISMRMRD::deserialize(xml_str.c_str(), noise_ismrmrd_header_);
+        if (!infile.data()) {
+            GDEBUG("Noise prewhitener file is not found. Proceeding without stored noise\n");
+            return false;
+        }
 
-            infile.read(reinterpret_cast<char*>(&noise_dwell_time_us_), sizeof(float));
+        if (!infile.good()) {
+            GERROR("Noise dependency file %s is damaged, proceeding without stored noise\n", full_name_stored_noise_dependency_.c_str());
+            return false;
+        }
 
-            size_t len;
-            infile.read(reinterpret_cast<char*>(&len), sizeof(size_t));
+        const char* ptr = infile.data();
+        size_t remaining = infile.size();
 
-            char* buf = new char[len];
-            if (buf == NULL) return false;
+        //Read the XML header of the noise scan
+        uint32_t xml_length;
+        if (remaining < sizeof(uint32_t)) return false;
+        memcpy(&xml_length, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        remaining -= sizeof(uint32_t);
 
-            infile.read(buf, len);
+        if (remaining < xml_length + sizeof(float) + sizeof(size_t)) return false;
+        std::string xml_str(ptr, xml_length);
+        ISMRMRD::deserialize(xml_str.c_str(), noise_ismrmrd_header_);
+        ptr += xml_length;
 
-            if (!noise_covariance_matrixf_.deserialize(buf, len))
-            {
-                delete[] buf;
-                return false;
-            }
+        memcpy(&noise_dwell_time_us_, ptr, sizeof(float));
+        ptr += sizeof(float);
 
-            delete[] buf;
-            infile.close();
-        }
-        else {
-            GDEBUG("Noise prewhitener file is not found. Proceeding without stored noise\n");
+        size_t len;
+        memcpy(&len, ptr, sizeof(size_t));
+        ptr += sizeof(size_t);
+        remaining -= xml_length + sizeof(float) + sizeof(size_t);
+
+        //The serialized array starts with the number of dimensions and the dimensions
+        size_t NDim;
+        if (len > remaining || len < sizeof(size_t)) return false;
+        memcpy(&NDim, ptr, sizeof(size_t));
+        if (NDim != 2 || len < sizeof(size_t)*3) return false;
+
+        size_t dims[2];
+        memcpy(dims, ptr + sizeof(size_t), sizeof(size_t) * 2);
+        if (len != sizeof(size_t)*3 + sizeof(std::complex<float>)*dims[0] * dims[1]) return false;
+
+        if (!noise_covariance_matrixf_.deserialize(const_cast<char*>(ptr), len))
+        {
             return false;
         }
 
@@ -324,38 +349,51 @@ namespace Gadgetron {
         std::string xml_str = xml_ss.str();
         uint32_t xml_length = static_cast<uint32_t>(xml_str.size());
 
-        std::ofstream outfile;
-        std::string filename = this->generateNoiseDependencyFilename(measurement_id_);
-        outfile.open(filename.c_str(), std::ios::out | std::ios::binary);
+        std::string content;
+        content.append(reinterpret_cast<char*>(&xml_length), 4);
+        content.append(xml_str.c_str(), xml_length);
+        content.append(reinterpret_cast<char*>(&noise_dwell_time_us_), sizeof(float));
+        content.append(reinterpret_cast<char*>(&len), sizeof(size_t));
+        content.append(buf, len);
+        delete[] buf;
 
-        if (outfile.good())
-        {
-            GDEBUG("write out the noise dependency file : %s\n", filename.c_str());
-            outfile.write(reinterpret_cast<char*>(&xml_length), 4);
-            outfile.write(xml_str.c_str(), xml_length);
-            outfile.write(reinterpret_cast<char*>(&noise_dwell_time_us_), sizeof(float));
-            outfile.write(reinterpret_cast<char*>(&len), sizeof(size_t));
-            outfile.write(buf, len);
-            outfile.close();
-
-            // set the permission for the noise file to be rewritable
-#ifndef _WIN32
-            int res = chmod(filename.c_str(), S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IWOTH | S_IXOTH);
-            if (res != 0) {
-                GDEBUG("Changing noise prewhitener file permission failed ...\n");
-            }
-#endif // _WIN32
-        }
-        else {
-            delete[] buf;
+        // the file is replaced atomically and ends with a checksum; readers of the older layout ignore the trailer
+        std::string filename = this->generateNoiseDependencyFilename(measurement_id_);
+        GDEBUG("write out the noise dependency file : %s\n", filename.c_str());
+        if (!NoisePrewhitenerStore::write_file(filename, content)) {
             GERROR_STREAM("Noise prewhitener file is not good for writing");
             return false;
         }
 
-        delete[] buf;
         return true;
     }
 
+    bool NoiseAdjustGadget::loadStoredPrewhitener()
+    {
+        NoisePrewhitener stored;
+        if (!NoisePrewhitenerStore::instance()->find(noise_dependency_folder_, noise_dependency_id_, coil_layout_hash_, stored)) {
+            return false;
+        }
+
+        noise_prewhitener_matrixf_ = stored.prewhitener;
+        noise_dwell_time_us_ = stored.noise_dwell_time_us;
+        noise_decorrelation_calculated_ = true;
+        noiseCovarianceLoaded_ = true;
+        number_of_noise_samples_ = 1;
+        return true;
+    }
+
+    void NoiseAdjustGadget::storePrewhitener()
+    {
+        NoisePrewhitener p;
+        p.prewhitener = noise_prewhitener_matrixf_;
+        p.noise_dwell_time_us = noise_dwell_time_us_;
+
+        if (!NoisePrewhitenerStore::instance()->store(noise_dependency_folder_, noise_dependency_id_, coil_layout_hash_, p)) {
+            GWARN("Unable to store the noise prewhitener for %s\n", noise_dependency_id_.c_str());
+        }
+    }
+
     void NoiseAdjustGadget::computeNoisePrewhitener()
     {
         GDEBUG("Noise dwell time: %f\n", noise_dwell_time_us_);
@@ -536,6 +574,15 @@ namespace Gadgetron {
                 }
 
                 computeNoisePrewhitener();
+
+                // keep the prewhitener of a noise dependency for the next scans with the same coils
+                if (noiseCovarianceLoaded_ && noise_decorrelation_calculated_) {
+                    storePrewhitener();
+                }
+            }
+
+            if (noise_decorrelation_calculated_ && !prewhitener_scaled_)
+            {
                 acquisition_dwell_time_us_ = m1->getObjectPtr()->sample_time_us;
                 if ((noise_dwell_time_us_ == 0.0f) || (acquisition_dwell_time_us_ == 0.0f)) {
                     noise_bw_scale_factor_ = 1.0f;
@@ -545,6 +592,7 @@ namespace Gadgetron {
                 }
 
                 noise_prewhitener_matrixf_ *= std::complex<float>(noise_bw_scale_factor_, 0.0);
+                prewhitener_scaled_ = true;
 
                 GDEBUG("Noise dwell time: %f\n", noise_dwell_time_us_);
                 GDEBUG("Acquisition dwell time: %f\n", acquisition_dwell_time_us_);
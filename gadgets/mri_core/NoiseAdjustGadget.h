@@ -30,6 +30,7 @@ namespace Gadgetron {
       GADGET_PROPERTY(pass_nonconformant_data, bool, "Whether to pass data that does not conform", false);
       GADGET_PROPERTY(noise_dwell_time_us_preset, float, "Preset dwell time for noise measurement", 0.0);
       GADGET_PROPERTY(scale_only_channels_by_name, std::string, "List of named channels that should only be scaled", "");
+      GADGET_PROPERTY(prewhitener_cache_entries, size_t, "Number of noise prewhiteners kept in memory across connections", 16);
 
       bool noise_decorrelation_calculated_;
       hoNDArray< std::complex<float> > noise_covariance_matrixf_;
@@ -48,12 +49,15 @@ namespace Gadgetron {
       bool perform_noise_adjust_;
       bool pass_nonconformant_data_;
       bool saved_;
+      bool prewhitener_scaled_;
 
       std::string noise_dependency_folder_;
       std::string noise_dependency_prefix_;
       std::string measurement_id_;
       std::string measurement_id_of_noise_dependency_;
       std::string full_name_stored_noise_dependency_;
+      std::string noise_dependency_id_;
+      uint64_t coil_layout_hash_;
 
       virtual int process_config(ACE_Message_Block* mb);
       virtual int process(GadgetContainerMessage<ISMRMRD::AcquisitionHeader>* m1,
@@ -66,6 +70,10 @@ namespace Gadgetron {
       bool saveNoiseCovariance();
       void computeNoisePrewhitener();
 
+      // prewhitener computed earlier for the same noise dependency and coil layout
+      bool loadStoredPrewhitener();
+      void storePrewhitener();
+
       //We will store/load a copy of the noise scans XML header to enable us to check which coil layout, etc.
       ISMRMRD::IsmrmrdHeader current_ismrmrd_header_;
       ISMRMRD::IsmrmrdHeader noise_ismrmrd_header_;
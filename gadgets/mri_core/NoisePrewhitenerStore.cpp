@@ -0,0 +1,310 @@
+#include "NoisePrewhitenerStore.h"
+#include "log.h"
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace Gadgetron {
+
+  namespace
+  {
+    const char checksum_magic[4] = { 'G', 'C', 'R', 'C' };
+    const size_t checksum_trailer_size = sizeof(uint32_t) + sizeof(checksum_magic);
+
+    const char prewhitener_magic[4] = { 'G', 'P', 'W', 'H' };
+    const uint32_t prewhitener_version = 1;
+
+    uint64_t fnv1a(uint64_t h, const void* data, size_t len)
+    {
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+      for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+      }
+      return h;
+    }
+
+    template <typename T> bool read_value(const char*& ptr, const char* end, T& v)
+    {
+      if (size_t(end - ptr) < sizeof(T)) return false;
+      memcpy(&v, ptr, sizeof(T));
+      ptr += sizeof(T);
+      return true;
+    }
+  }
+
+  // ------------------------------------------------------------------------
+
+  MappedDependencyFile::MappedDependencyFile(const std::string& filename)
+    : data_(0)
+    , size_(0)
+    , mapped_size_(0)
+    , has_checksum_(false)
+    , checksum_ok_(false)
+  {
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        data_ = static_cast<const char*>(p);
+        size_ = st.st_size;
+        mapped_size_ = st.st_size;
+      }
+    }
+    ::close(fd);
+#else
+    std::ifstream infile(filename.c_str(), std::ios::in | std::ios::binary);
+    if (infile.good()) {
+      buffer_.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+      if (!buffer_.empty()) {
+        data_ = &buffer_[0];
+        size_ = buffer_.size();
+      }
+    }
+#endif // _WIN32
+
+    if (!data_) return;
+
+    checksum_ok_ = true;
+    if (size_ >= checksum_trailer_size && memcmp(data_ + size_ - sizeof(checksum_magic), checksum_magic, sizeof(checksum_magic)) == 0) {
+      has_checksum_ = true;
+      size_ -= checksum_trailer_size;
+
+      uint32_t stored;
+      memcpy(&stored, data_ + size_, sizeof(uint32_t));
+      checksum_ok_ = (stored == NoisePrewhitenerStore::checksum(data_, size_));
+      if (!checksum_ok_) {
+        GWARN("Checksum mismatch in noise dependency file %s\n", filename.c_str());
+      }
+    }
+  }
+
+  MappedDependencyFile::~MappedDependencyFile()
+  {
+#ifndef _WIN32
+    if (mapped_size_) munmap(const_cast<char*>(data_), mapped_size_);
+#endif // _WIN32
+  }
+
+  // ------------------------------------------------------------------------
+
+  NoisePrewhitenerStore* NoisePrewhitenerStore::instance()
+  {
+    static NoisePrewhitenerStore store;
+    return &store;
+  }
+
+  NoisePrewhitenerStore::NoisePrewhitenerStore()
+    : capacity_(16)
+  {
+  }
+
+  uint64_t NoisePrewhitenerStore::layout_hash(const std::vector<ISMRMRD::CoilLabel>& coils, const std::vector<unsigned int>& scale_only_channels)
+  {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t c = 0; c < coils.size(); c++) {
+      h = fnv1a(h, coils[c].coilName.c_str(), coils[c].coilName.size() + 1);
+    }
+
+    uint32_t n = static_cast<uint32_t>(scale_only_channels.size());
+    h = fnv1a(h, &n, sizeof(n));
+    for (size_t c = 0; c < scale_only_channels.size(); c++) {
+      h = fnv1a(h, &scale_only_channels[c], sizeof(unsigned int));
+    }
+    return h;
+  }
+
+  std::string NoisePrewhitenerStore::filename(const std::string& folder, const std::string& noise_measurement_id, uint64_t layout)
+  {
+    std::stringstream ss;
+    ss << "GadgetronNoisePrewhitener_" << noise_measurement_id << "_" << std::hex << layout;
+    return (boost::filesystem::path(folder) / ss.str()).string();
+  }
+
+  uint32_t NoisePrewhitenerStore::checksum(const char* data, size_t len)
+  {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, len);
+    return crc.checksum();
+  }
+
+  bool NoisePrewhitenerStore::write_file(const std::string& filename, const std::string& content)
+  {
+    boost::filesystem::path target(filename);
+    boost::filesystem::path tmp = target;
+    tmp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+
+    {
+      std::ofstream outfile(tmp.string().c_str(), std::ios::out | std::ios::binary);
+      if (!outfile.good()) {
+        GERROR("Unable to open %s for writing\n", tmp.string().c_str());
+        return false;
+      }
+
+      uint32_t crc = checksum(content.c_str(), content.size());
+      outfile.write(content.c_str(), content.size());
+      outfile.write(reinterpret_cast<const char*>(&crc), sizeof(uint32_t));
+      outfile.write(checksum_magic, sizeof(checksum_magic));
+      outfile.close();
+
+      if (!outfile) {
+        GERROR("Writing %s failed\n", tmp.string().c_str());
+        boost::system::error_code ec;
+        boost::filesystem::remove(tmp, ec);
+        return false;
+      }
+    }
+
+#ifndef _WIN32
+    // Replacing the file needs write permission on the folder only, the file itself need not be writable by others
+    if (chmod(tmp.string().c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0) {
+      GDEBUG("Changing permission of %s failed ...\n", tmp.string().c_str());
+    }
+#endif // _WIN32
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp, target, ec);
+    if (ec) {
+      GERROR("Unable to move %s into place : %s\n", filename.c_str(), ec.message().c_str());
+      boost::filesystem::remove(tmp, ec);
+      return false;
+    }
+
+    return true;
+  }
+
+  bool NoisePrewhitenerStore::find(const std::string& folder, const std::string& noise_measurement_id, uint64_t layout, NoisePrewhitener& p)
+  {
+    Key key(noise_measurement_id, layout);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::map<Key, List::iterator>::iterator it = index_.find(key);
+      if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        p = it->second->second;
+        return true;
+      }
+    }
+
+    if (!this->read(filename(folder, noise_measurement_id, layout), noise_measurement_id, layout, p)) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    this->insert(key, p);
+    return true;
+  }
+
+  bool NoisePrewhitenerStore::store(const std::string& folder, const std::string& noise_measurement_id, uint64_t layout, const NoisePrewhitener& p)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      this->insert(Key(noise_measurement_id, layout), p);
+    }
+
+    uint32_t CHA = static_cast<uint32_t>(p.prewhitener.get_size(0));
+    uint32_t id_length = static_cast<uint32_t>(noise_measurement_id.size());
+
+    std::string content;
+    content.append(prewhitener_magic, sizeof(prewhitener_magic));
+    content.append(reinterpret_cast<const char*>(&prewhitener_version), sizeof(uint32_t));
+    content.append(reinterpret_cast<const char*>(&layout), sizeof(uint64_t));
+    content.append(reinterpret_cast<const char*>(&id_length), sizeof(uint32_t));
+    content.append(noise_measurement_id);
+    content.append(reinterpret_cast<const char*>(&p.noise_dwell_time_us), sizeof(float));
+    content.append(reinterpret_cast<const char*>(&CHA), sizeof(uint32_t));
+    content.append(reinterpret_cast<const char*>(p.prewhitener.begin()), sizeof(std::complex<float>)*CHA*CHA);
+
+    return write_file(filename(folder, noise_measurement_id, layout), content);
+  }
+
+  bool NoisePrewhitenerStore::read(const std::string& filename, const std::string& noise_measurement_id, uint64_t layout, NoisePrewhitener& p)
+  {
+    MappedDependencyFile file(filename);
+    if (!file.good() || !file.has_checksum()) return false;
+
+    const char* ptr = file.data();
+    const char* end = file.data() + file.size();
+
+    char magic[4];
+    uint32_t version, id_length, CHA;
+    uint64_t stored_layout;
+    float dwell_time;
+
+    if (size_t(end - ptr) < sizeof(magic) || memcmp(ptr, prewhitener_magic, sizeof(magic)) != 0) return false;
+    ptr += sizeof(magic);
+
+    if (!read_value(ptr, end, version) || version != prewhitener_version) return false;
+    if (!read_value(ptr, end, stored_layout) || stored_layout != layout) return false;
+    if (!read_value(ptr, end, id_length) || size_t(end - ptr) < id_length) return false;
+    if (std::string(ptr, id_length) != noise_measurement_id) return false;
+    ptr += id_length;
+    if (!read_value(ptr, end, dwell_time) || !read_value(ptr, end, CHA)) return false;
+    if (size_t(end - ptr) != sizeof(std::complex<float>)*CHA*CHA) return false;
+
+    p.prewhitener.create(CHA, CHA);
+    memcpy(p.prewhitener.begin(), ptr, sizeof(std::complex<float>)*CHA*CHA);
+    p.noise_dwell_time_us = dwell_time;
+    return true;
+  }
+
+  //Called with mutex_ held
+  void NoisePrewhitenerStore::insert(const Key& key, const NoisePrewhitener& p)
+  {
+    std::map<Key, List::iterator>::iterator it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = p;
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return;
+    }
+
+    lru_.push_front(std::make_pair(key, p));
+    index_[key] = lru_.begin();
+
+    while (lru_.size() > capacity_) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+
+  void NoisePrewhitenerStore::set_capacity(size_t entries)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = entries;
+    while (lru_.size() > capacity_) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+
+  size_t NoisePrewhitenerStore::size()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+  }
+
+  void NoisePrewhitenerStore::clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "hoNDArray.h"
+#include "gadgetron_mricore_export.h"
+
+#include <ismrmrd/xml.h>
+#include <complex>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Gadgetron {
+
+  /**
+     Read-only memory mapping of a noise dependency file.
+
+     Files written by NoisePrewhitenerStore::write_file end with a CRC-32 trailer. If the trailer is
+     present it is verified and excluded from size(); files without it are accepted as they are, so
+     dependencies written by older versions can still be read.
+   */
+  class EXPORTGADGETSMRICORE MappedDependencyFile
+  {
+  public:
+    explicit MappedDependencyFile(const std::string& filename);
+    ~MappedDependencyFile();
+
+    /// The file could be mapped and, if it has a checksum, the checksum matches
+    bool good() const { return data_ != 0 && checksum_ok_; }
+
+    bool has_checksum() const { return has_checksum_; }
+    bool checksum_ok() const { return checksum_ok_; }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+  protected:
+    MappedDependencyFile(const MappedDependencyFile&);
+    MappedDependencyFile& operator=(const MappedDependencyFile&);
+
+    const char* data_;
+    size_t size_;
+    size_t mapped_size_;
+    bool has_checksum_;
+    bool checksum_ok_;
+    std::vector<char> buffer_; //Used where the file cannot be mapped
+  };
+
+  /**
+     Prewhitening matrix computed from a noise dependency, before the bandwidth scaling of the data.
+   */
+  struct NoisePrewhitener
+  {
+    hoNDArray< std::complex<float> > prewhitener;
+    float noise_dwell_time_us;
+
+    NoisePrewhitener()
+      : noise_dwell_time_us(0)
+    {
+    }
+  };
+
+  /**
+     Process-wide store of noise prewhitening matrices, shared by the connections of a study.
+
+     A prewhitener is keyed by the measurement id of the noise scan and a hash of the coil layout of
+     the data, since the channel order and the scale-only channels change the matrix. Recently used
+     prewhiteners are kept in memory in an LRU list, and every prewhitener is also written next to the
+     noise dependency, so that back-to-back scans skip loading the covariance and the Cholesky
+     decomposition, including after a restart.
+
+     Files are written to a temporary name and renamed into place, so a reader never maps a partial
+     file, and carry a CRC-32 trailer that is checked when they are mapped.
+   */
+  class EXPORTGADGETSMRICORE NoisePrewhitenerStore
+  {
+  public:
+    static NoisePrewhitenerStore* instance();
+
+    /// Hash of the coil names of the data and of the channels that are only scaled
+    static uint64_t layout_hash(const std::vector<ISMRMRD::CoilLabel>& coils, const std::vector<unsigned int>& scale_only_channels);
+
+    /// Looks for the prewhitener in memory, then in folder. Returns false if there is none or the stored file is damaged.
+    bool find(const std::string& folder, const std::string& noise_measurement_id, uint64_t layout, NoisePrewhitener& p);
+
+    /// Keeps the prewhitener in memory and writes it to folder
+    bool store(const std::string& folder, const std::string& noise_measurement_id, uint64_t layout, const NoisePrewhitener& p);
+
+    /// Number of prewhiteners kept in memory
+    void set_capacity(size_t entries);
+    size_t size();
+    void clear();
+
+    static std::string filename(const std::string& folder, const std::string& noise_measurement_id, uint64_t layout);
+
+    /// Writes content followed by its checksum trailer, readable by the owner and read-only for others
+    static bool write_file(const std::string& filename, const std::string& content);
+
+    static uint32_t checksum(const char* data, size_t len);
+
+  protected:
+    NoisePrewhitenerStore();
+
+    typedef std::pair<std::string, uint64_t> Key;
+    typedef std::list< std::pair<Key, NoisePrewhitener> > List;
+
+    void insert(const Key& key, const NoisePrewhitener& p);
+    bool read(const std::string& filename, const std::string& noise_measurement_id, uint64_t layout, NoisePrewhitener& p);
+
+    std::mutex mutex_;
+    List lru_; //Most recently used first
+    std::map<Key, List::iterator> index_;
+    size_t capacity_;
+  };
+}
@@ -43,6 +43,9 @@ namespace Gadgetron {
         ISMRMRD::IsmrmrdHeader h;
         ISMRMRD::deserialize(mb->rd_ptr(), h);
 
+        max_buffered_profiles_ = max_buffered_profiles.value();
+        GDEBUG("Maximal number of buffered profiles for PCA calculation is %d\n", max_buffered_profiles_);
+
         std::string uncomb_str = uncombined_channels_by_name.value();
         std::vector<std::string> uncomb;
         if (uncomb_str.size()) {
@@ -105,111 +108,72 @@ namespace Gadgetron {
             buffer_[location].push_back(m1);
             int profiles_available = buffer_[location].size();
 
+            //The covariance of the channels is accumulated as the profiles arrive
+            hoNDKLT< std::complex<float> >*& VT = pca_coefficients_[location];
+            if (!VT) {
+                VT = new hoNDKLT < std::complex<float> > ;
+            }
+
+            int samples_to_use = samples_per_profile > samples_to_use_ ? samples_to_use_ : samples_per_profile;
+
+            try {
+                this->accumulate_profile(*VT, *m1->getObjectPtr(), *m2->getObjectPtr(), samples_to_use);
+            }
+            catch (...) {
+                GERROR("Unable to accumulate the profile for PCA calculation\n");
+                return GADGET_FAIL;
+            }
+
             //Are we ready for calculating PCA
             if (is_last_scan_in_slice || (profiles_available >= max_buffered_profiles_))
             {
 
                 //GDEBUG("Calculating PCA coefficients with %d profiles for %d coils\n", profiles_available, channels);
-                int samples_to_use = samples_per_profile > samples_to_use_ ? samples_to_use_ : samples_per_profile;
-
-                //For some sequences there is so little data, we should just use it all.
-                if (profiles_available < 16) {
-                    samples_to_use = samples_per_profile;
-                }
 
-                int total_samples = samples_to_use*profiles_available;
+                try {
+                    //For some sequences there is so little data, we should just use it all.
+                    if (profiles_available < 16) {
+                        VT->reset_accumulation();
 
-                std::vector<size_t> dims(2);
-                dims[0] = total_samples; dims[1] = channels;
-
-                hoNDArray< std::complex<float> > A;
-                try{ A.create(&dims); }
-                catch (std::runtime_error & err){
-                    GDEBUG("Unable to create array for PCA calculation\n");
-                    return GADGET_FAIL;
-                }
+                        for (size_t p = 0; p < profiles_available; p++) {
+                            GadgetContainerMessage<ISMRMRD::AcquisitionHeader>* m_head =
+                                AsContainerMessage<ISMRMRD::AcquisitionHeader>(buffer_[location][p]);
 
-                std::complex<float>* A_ptr = A.get_data_ptr();
-                size_t sample_counter = 0;
+                            GadgetContainerMessage<hoNDArray<std::complex<float> > >* m_tmp =
+                                AsContainerMessage<hoNDArray< std::complex<float> > >(buffer_[location][p]->cont());
 
-                size_t data_offset = 0;
-                if (m1->getObjectPtr()->center_sample >= (samples_to_use >> 1)) {
-                    data_offset = m1->getObjectPtr()->center_sample - (samples_to_use >> 1);
-                }
-
-                //GDEBUG("Data offset = %d\n", data_offset);
-
-                hoNDArray<std::complex<float> > means;
-                std::vector<size_t> means_dims; means_dims.push_back(channels);
-
-                try{ means.create(&means_dims); }
-                catch (std::runtime_error& err){
-                    GDEBUG("Unable to create temporary stoorage for mean values\n");
-                    return GADGET_FAIL;
-                }
-
-                means.fill(std::complex<float>(0.0f, 0.0f));
-
-                std::complex<float>* means_ptr = means.get_data_ptr();
-
-                for (size_t p = 0; p < profiles_available; p++) {
-                    GadgetContainerMessage<hoNDArray<std::complex<float> > >* m_tmp =
-                        AsContainerMessage<hoNDArray< std::complex<float> > >(buffer_[location][p]->cont());
+                            if (!m_head || !m_tmp) {
+                                GDEBUG("Fatal error, unable to recover data from data buffer (%d,%d)\n", p, profiles_available);
+                                return GADGET_FAIL;
+                            }
 
-                    if (!m_tmp) {
-                        GDEBUG("Fatal error, unable to recover data from data buffer (%d,%d)\n", p, profiles_available);
-                        return GADGET_FAIL;
+                            this->accumulate_profile(*VT, *m_head->getObjectPtr(), *m_tmp->getObjectPtr(), samples_per_profile);
+                        }
                     }
 
-                    std::complex<float>* d = m_tmp->getObjectPtr()->get_data_ptr();
-
-                    for (unsigned s = 0; s < samples_to_use; s++) {
-                        for (size_t c = 0; c < channels; c++) {
-                            bool uncombined_channel = std::find(uncombined_channels_.begin(), uncombined_channels_.end(), c) != uncombined_channels_.end();
-                            if (uncombined_channel) {
-                                A_ptr[sample_counter + c *total_samples] = std::complex<float>(0.0, 0.0);
-                            }
-                            else {
-                                A_ptr[sample_counter + c *total_samples] = d[c*samples_per_profile + data_offset + s];
-                                means_ptr[c] += d[c*samples_per_profile + data_offset + s];
-                            }
+                    //Collected the covariance, now let's calculate the PCA coefficients
+                    //We will create a new matrix that explicitly preserves the uncombined channels
+                    if (uncombined_channels_.size())
+                    {
+                        std::vector<size_t> untransformed(uncombined_channels_.size());
+                        for (size_t un = 0; un < uncombined_channels_.size(); un++)
+                        {
+                            untransformed[un] = uncombined_channels_[un];
                         }
 
-                        sample_counter++;
-                        //GDEBUG("Sample counter = %d/%d\n", sample_counter, total_samples);
-                    }
-                }
-
-                //Subtract off mean
-                for (size_t c = 0; c < channels; c++) {
-                    for (size_t s = 0; s < total_samples; s++) {
-                        A_ptr[s + c *total_samples] -= means_ptr[c] / std::complex<float>(total_samples, 0);
+                        VT->prepare_accumulated(untransformed, (size_t)0);
                     }
-                }
-
-                //Collected data for temp matrix, now let's calculate SVD coefficients
-
-                std::vector<size_t> VT_dims;
-                VT_dims.push_back(channels);
-                VT_dims.push_back(channels);
-                pca_coefficients_[location] = new hoNDKLT < std::complex<float> > ;
-                hoNDKLT< std::complex<float> >* VT = pca_coefficients_[location];
-
-                //We will create a new matrix that explicitly preserves the uncombined channels
-                if (uncombined_channels_.size())
-                {
-                    std::vector<size_t> untransformed(uncombined_channels_.size());
-                    for (size_t un = 0; un < uncombined_channels_.size(); un++)
+                    else
                     {
-                        untransformed[un] = uncombined_channels_[un];
+                        VT->prepare_accumulated((size_t)0);
                     }
 
-                    VT->prepare(A, (size_t)1, untransformed, (size_t)0, false);
-
+                    //The covariance is not needed anymore
+                    VT->reset_accumulation();
                 }
-                else
-                {
-                    VT->prepare(A, (size_t)1, (size_t)0, false);
+                catch (...) {
+                    GERROR("Unable to calculate PCA coefficients\n");
+                    return GADGET_FAIL;
                 }
 
                 //Switch off buffering for this slice
@@ -260,5 +224,29 @@ namespace Gadgetron {
         return GADGET_OK;
     }
 
+    void PCACoilGadget::accumulate_profile(hoNDKLT< std::complex<float> >& klt, ISMRMRD::AcquisitionHeader& head, hoNDArray< std::complex<float> >& data, int samples_to_use)
+    {
+        int samples_per_profile = head.number_of_samples;
+        int channels = head.active_channels;
+
+        //Use the samples around the center of the profile
+        size_t data_offset = 0;
+        if (head.center_sample >= (samples_to_use >> 1)) {
+            data_offset = head.center_sample - (samples_to_use >> 1);
+        }
+        if (data_offset + samples_to_use > (size_t)samples_per_profile) {
+            data_offset = samples_per_profile - samples_to_use;
+        }
+
+        samples_.create(samples_to_use, channels);
+
+        std::complex<float>* d = data.get_data_ptr();
+        for (size_t c = 0; c < channels; c++) {
+            memcpy(samples_.begin() + c*samples_to_use, d + c*samples_per_profile + data_offset, sizeof(std::complex<float>)*samples_to_use);
+        }
+
+        klt.accumulate(samples_, 1, true);
+    }
+
     GADGET_FACTORY_DECLARE(PCACoilGadget)
 }
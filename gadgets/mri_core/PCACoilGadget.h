@@ -30,6 +30,7 @@ namespace Gadgetron {
   private:
     GADGET_PROPERTY(uncombined_channels_by_name, std::string, "List of comma separated channels by name", "");
     GADGET_PROPERTY(present_uncombined_channels, int, "Number of uncombined channels found", 0);
+    GADGET_PROPERTY(max_buffered_profiles, int, "Maximal number of profiles buffered before the PCA coefficients are calculated", 100);
 
     std::vector<unsigned int> uncombined_channels_;
     
@@ -44,6 +45,11 @@ namespace Gadgetron {
 
     int max_buffered_profiles_;
     int samples_to_use_;
+
+    //The samples of a profile added to the covariance
+    hoNDArray< std::complex<float> > samples_;
+
+    void accumulate_profile(hoNDKLT< std::complex<float> >& klt, ISMRMRD::AcquisitionHeader& head, hoNDArray< std::complex<float> >& data, int samples_to_use);
   };
 }
 
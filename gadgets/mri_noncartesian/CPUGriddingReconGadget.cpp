@@ -27,5 +27,11 @@ namespace Gadgetron{
 
     }
 
+    int CPUGriddingReconGadget::process_config(ACE_Message_Block* mb) {
+        // Repetitions and pseudo replicas sharing a trajectory reuse the matrices computed for the first one
+        NFFT_internal::NFFT_MatrixCache<float,2>::instance()->set_capacity(std::max(gridding_matrix_cache_entries.value(), 0));
+        return GriddingReconGadgetBase<hoNDArray>::process_config(mb);
+    }
+
     GADGET_FACTORY_DECLARE(CPUGriddingReconGadget);
 }
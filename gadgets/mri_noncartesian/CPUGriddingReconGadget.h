@@ -23,8 +23,11 @@ namespace Gadgetron{
 		CPUGriddingReconGadget();
 
 		~CPUGriddingReconGadget();
-	
 
+		GADGET_PROPERTY(gridding_matrix_cache_entries, int, "Number of trajectories whose gridding matrices are kept for later repetitions", 8);
+
+	protected:
+		virtual int process_config(ACE_Message_Block* mb) override;
 
 	};
 }
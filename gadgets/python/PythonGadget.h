@@ -245,7 +245,7 @@ namespace Gadgetron {
             GILLock lock;
             try {
                 boost::python::object process_fn = class_.attr("process");
-                auto pyrecon_data = boost::python::object(*recon_data->getObjectPtr());
+                auto pyrecon_data = to_python_views(recon_data);
                 int res = boost::python::extract<int>(process_fn(pyrecon_data));
                 if (res != GADGET_OK) {
                     GDEBUG("Gadget (%s) Returned from python call with error\n",
@@ -282,7 +282,7 @@ namespace Gadgetron {
             try
             {
                 boost::python::object process_fn = class_.attr("process");
-                auto pyrecon_data = boost::python::object(*recon_data->getObjectPtr());
+                auto pyrecon_data = to_python_views(recon_data);
                 int res = boost::python::extract<int>(process_fn(pyrecon_data));
                 if (res != GADGET_OK)
                 {
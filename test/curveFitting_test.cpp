@@ -13,6 +13,7 @@
 #include "twoParaExpDecayOperator.h"
 #include "twoParaExpRecoveryOperator.h"
 #include "curveFittingCostFunction.h"
+#include "batchedExpFittingSolver.h"
 #include "cmr_t1_mapping.h"
 #include <gtest/gtest.h>
 #include <boost/random.hpp>
@@ -231,3 +232,75 @@ TYPED_TEST(curveFitting_test, T1SRMapping)
     // test hole filling
     EXPECT_NEAR(t1_sr.map_(12, 23, 0, 0), 1122.36963, 1.0);
 }
+
+TYPED_TEST(curveFitting_test, batchedFitting)
+{
+    size_t num = 100;
+
+    // T2 decay of T2SE and T1 saturation recovery of T1SR, samples stored as [num N]
+    std::vector<TypeParam> x_t2 = { 10, 20, 30, 40, 60, 80, 120, 160 };
+    std::vector<TypeParam> y_t2 = { (TypeParam)606.248226950355, (TypeParam)598.40425531914, (TypeParam)589.368794326241, (TypeParam)580.815602836879,
+                                    (TypeParam)563.170212765957, (TypeParam)545.893617021277, (TypeParam)512.31914893617, (TypeParam)480.723404255319 };
+
+    std::vector<TypeParam> x_t1(11, 545);
+    x_t1[10] = 10000;
+    std::vector<TypeParam> y_t1 = { 178, 185, 182, 189, 178, 180, 187, 179, 177, 177, 471 };
+
+    std::vector<TypeParam> data_t2(num*x_t2.size()), data_t1(num*x_t1.size());
+    for (size_t n = 0; n < x_t2.size(); n++)
+        std::fill(data_t2.begin() + n*num, data_t2.begin() + (n + 1)*num, y_t2[n]);
+    for (size_t n = 0; n < x_t1.size(); n++)
+        std::fill(data_t1.begin() + n*num, data_t1.begin() + (n + 1)*num, y_t1[n]);
+
+    std::vector<TypeParam> mask(num, 1);
+    mask[3] = 0;
+    mask[77] = 0;
+
+    Gadgetron::batchedExpFittingSolver<TypeParam> solver(Gadgetron::EXP_DECAY_TWO_PARA, 150, 1e-6);
+    EXPECT_EQ(solver.get_num_of_paras(), (size_t)2);
+
+    std::vector<TypeParam> b(num * 2, -1);
+    solver.solve(&x_t2[0], x_t2.size(), &data_t2[0], num, num, &b[0], num, &mask[0]);
+
+    for (size_t p = 0; p < num; p++)
+    {
+        if (mask[p] > 0)
+        {
+            EXPECT_NEAR(b[p], 617.257, 0.01);
+            EXPECT_NEAR(b[p + num], 644.417, 0.1);
+        }
+        else
+        {
+            EXPECT_EQ(b[p], -1);
+            EXPECT_EQ(b[p + num], -1);
+        }
+    }
+
+    // the simplex solver stops about 0.007 from the minimum
+    solver.model_ = Gadgetron::EXP_RECOVERY_TWO_PARA;
+    solver.solve(&x_t1[0], x_t1.size(), &data_t1[0], num, num, &b[0], num);
+
+    for (size_t p = 0; p < num; p++)
+    {
+        EXPECT_NEAR(b[p], 471.062894, 0.001);
+        EXPECT_NEAR(b[p + num], 1122.36963, 0.01);
+    }
+
+    // noise free three parameter recovery
+    std::vector<TypeParam> x_t1_3(8), data_t1_3(num * 8);
+    for (size_t n = 0; n < x_t1_3.size(); n++)
+    {
+        x_t1_3[n] = (TypeParam)(100 + 400 * n);
+        std::fill(data_t1_3.begin() + n*num, data_t1_3.begin() + (n + 1)*num, (TypeParam)(500 - 900 * std::exp(-x_t1_3[n] / 1000.0)));
+    }
+
+    std::vector<TypeParam> b3(num * 3);
+    solver.model_ = Gadgetron::EXP_RECOVERY_THREE_PARA;
+    solver.solve(&x_t1_3[0], x_t1_3.size(), &data_t1_3[0], num, num, &b3[0], num);
+
+    EXPECT_NEAR(b3[0], 500, 0.1);
+    EXPECT_NEAR(b3[num], 900, 0.1);
+    EXPECT_NEAR(b3[2 * num], 1000, 0.5);
+    EXPECT_NEAR(b3[num - 1], 500, 0.1);
+    EXPECT_NEAR(b3[3 * num - 1], 1000, 0.5);
+}
@@ -0,0 +1,134 @@
+/** \file       gadget_message_queue_test.cpp
+    \brief      Test case for the bounded input queue of the Gadgets
+
+    \author     agent
+*/
+
+#include "GadgetMessageQueue.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace Gadgetron;
+
+namespace
+{
+    // counts the enqueued messages, so the test can wait for the producer instead of polling the queue
+    class EnqueueCounter : public GadgetMessageQueueListener
+    {
+    public:
+        EnqueueCounter() : count_(0) {}
+
+        virtual void message_enqueued()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            count_++;
+            cond_.notify_all();
+        }
+
+        // true once count messages have been enqueued, false if that takes unreasonably long
+        bool wait_for(size_t count)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            return cond_.wait_for(lock, std::chrono::seconds(30), [&]() { return count_ >= count; });
+        }
+
+        size_t count()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return count_;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        size_t count_;
+    };
+
+    // an enqueue from this thread with an expired timeout fails exactly when the producer is held back
+    bool is_blocking(GadgetMessageQueue& q)
+    {
+        ACE_Message_Block* mb = new ACE_Message_Block(1);
+        ACE_Time_Value expired = ACE_OS::gettimeofday();
+        if (q.enqueue_tail(mb, &expired) < 0)
+        {
+            mb->release();
+            return true;
+        }
+        return false;
+    }
+
+    void dequeue(GadgetMessageQueue& q, size_t num)
+    {
+        for (size_t n = 0; n < num; n++)
+        {
+            ACE_Message_Block* mb = 0;
+            ASSERT_GE(q.dequeue_head(mb), 0);
+            mb->release();
+        }
+    }
+}
+
+TEST(GadgetMessageQueue, defaultLowWatermark)
+{
+    GadgetMessageQueue q;
+
+    q.set_watermarks(8, 0);
+    EXPECT_EQ(q.high_watermark(), 8);
+    EXPECT_EQ(q.low_watermark(), 4);
+
+    q.set_watermarks(8, 6);
+    EXPECT_EQ(q.low_watermark(), 6);
+
+    q.set_watermarks(8, 8);
+    EXPECT_EQ(q.low_watermark(), 4);
+
+    q.set_watermarks(0, 0);
+    EXPECT_EQ(q.high_watermark(), 0);
+}
+
+TEST(GadgetMessageQueue, producerResumesAtHalfHighWatermark)
+{
+    GadgetMessageQueue q;
+    q.set_watermarks(8, 0);
+
+    EnqueueCounter produced;
+    q.set_listener(&produced);
+
+    const size_t total = 20;
+
+    std::thread producer([&]() {
+        for (size_t n = 0; n < total; n++)
+        {
+            q.enqueue_tail(new ACE_Message_Block(1));
+        }
+    });
+
+    // the producer blocks once the high watermark is reached
+    EXPECT_TRUE(produced.wait_for(8));
+    EXPECT_TRUE(is_blocking(q));
+    EXPECT_EQ(q.message_count(), 8);
+    EXPECT_EQ(produced.count(), 8);
+
+    // and stays blocked above the low watermark
+    dequeue(q, 3);
+    EXPECT_TRUE(is_blocking(q));
+    EXPECT_EQ(q.message_count(), 5);
+    EXPECT_EQ(produced.count(), 8);
+
+    // it resumes at half the high watermark and fills the queue up again
+    dequeue(q, 1);
+    EXPECT_TRUE(produced.wait_for(12));
+    EXPECT_TRUE(is_blocking(q));
+    EXPECT_EQ(q.message_count(), 8);
+    EXPECT_EQ(produced.count(), 12);
+
+    dequeue(q, total - 12);
+    producer.join();
+
+    dequeue(q, 8);
+    EXPECT_EQ(q.message_count(), 0);
+    q.set_listener(0);
+}
@@ -0,0 +1,170 @@
+#include "GridGraphCut.h"
+#include "ImageGraph.h"
+#include "graph_cut.h"
+#include <boost/graph/boykov_kolmogorov_max_flow.hpp>
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+
+using namespace Gadgetron;
+
+namespace {
+
+    // Random integer capacities on the forward neighbour edges and the terminal edges, as in the field map graph
+    template<unsigned int D>
+    void compare_with_boykov_kolmogorov(const vector_td<int, D> &dims, unsigned int seed) {
+        boost::random::mt19937 rng(seed);
+        boost::random::uniform_int_distribution<int> edge_capacity(0, 10);
+        boost::random::uniform_int_distribution<int> terminal_capacity(-20, 20);
+
+        ImageGraph<D> image_graph(dims);
+        GridGraphCut<D> grid_graph(dims);
+
+        size_t stride = 1;
+        for (unsigned int dim = 0; dim < D; dim++) {
+            for (size_t idx = 0; idx < image_graph.source_vertex; idx++) {
+                if ((idx / stride) % dims[dim] == size_t(dims[dim] - 1)) continue;
+                float capacity = edge_capacity(rng);
+                image_graph.edge_capacity_map[image_graph.edge(idx, idx + stride).first] += capacity;
+                grid_graph.add_edge(idx, dim, capacity);
+            }
+            stride *= dims[dim];
+        }
+
+        for (size_t idx = 0; idx < image_graph.source_vertex; idx++) {
+            float capacity = terminal_capacity(rng);
+            if (capacity > 0) {
+                image_graph.edge_capacity_map[image_graph.edge_from_source(idx)] += capacity;
+                grid_graph.add_terminal_capacity(idx, capacity, 0);
+            } else {
+                image_graph.edge_capacity_map[image_graph.edge_to_sink(idx)] -= capacity;
+                grid_graph.add_terminal_capacity(idx, 0, -capacity);
+            }
+        }
+
+        boost::boykov_kolmogorov_max_flow(image_graph, image_graph.source_vertex, image_graph.sink_vertex);
+        std::vector<char> source_side = grid_graph.solve();
+
+        for (size_t idx = 0; idx < image_graph.source_vertex; idx++)
+            EXPECT_EQ(image_graph.color_map[idx] == boost::default_color_type::black_color, bool(source_side[idx]));
+    }
+
+    // The field map graph as update_field_map used to build it, adding the edges in raster order to one boost graph
+    template<unsigned int D>
+    void add_regularization_edge(ImageGraph<D> &graph, const hoNDArray<uint16_t> &field_map,
+                                 const hoNDArray<uint16_t> &proposed_field_map, const hoNDArray<float> &second_deriv,
+                                 size_t idx, size_t idx2) {
+        int a = std::norm(int(field_map[idx]) - int(field_map[idx2]));
+        int b = std::norm(int(field_map[idx]) - int(proposed_field_map[idx2]));
+        int c = std::norm(int(proposed_field_map[idx]) - int(field_map[idx2]));
+        int d = std::norm(int(proposed_field_map[idx]) - int(proposed_field_map[idx2]));
+
+        float lambda = std::max(std::min(second_deriv[idx], second_deriv[idx2]), 0.0f);
+        float weight = b + c - a - d;
+        weight *= lambda;
+
+        auto &capacity_map = graph.edge_capacity_map;
+        capacity_map[graph.edge(idx, idx2).first] += weight;
+
+        float aq = lambda * (c - a);
+        if (aq > 0) capacity_map[graph.edge_from_source(idx)] += aq;
+        else capacity_map[graph.edge_to_sink(idx)] -= aq;
+
+        float aj = lambda * (d - c);
+        if (aj > 0) capacity_map[graph.edge_from_source(idx2)] += aj;
+        else capacity_map[graph.edge_to_sink(idx2)] -= aj;
+    }
+
+    template<unsigned int D>
+    hoNDArray<uint16_t> update_field_map_boykov_kolmogorov(const hoNDArray<uint16_t> &field_map,
+                                                            const hoNDArray<uint16_t> &proposed_field_map,
+                                                            const hoNDArray<float> &residuals_map,
+                                                            const hoNDArray<float> &lambda_map) {
+        const size_t X = field_map.get_size(0);
+        const size_t Y = field_map.get_size(1);
+        const size_t Z = field_map.get_size(2);
+
+        vector_td<int, D> dims;
+        const size_t sizes[3] = {X, Y, Z};
+        for (unsigned int dim = 0; dim < D; dim++) dims[dim] = sizes[dim];
+
+        ImageGraph<D> graph(dims);
+        for (size_t kz = 0; kz < Z; kz++) {
+            for (size_t ky = 0; ky < Y; ky++) {
+                for (size_t kx = 0; kx < X; kx++) {
+                    size_t idx = (kz * Y + ky) * X + kx;
+                    if (kx < X - 1) add_regularization_edge(graph, field_map, proposed_field_map, lambda_map, idx, idx + 1);
+                    if (ky < Y - 1) add_regularization_edge(graph, field_map, proposed_field_map, lambda_map, idx, idx + X);
+                    if (kz < Z - 1) add_regularization_edge(graph, field_map, proposed_field_map, lambda_map, idx, idx + X * Y);
+
+                    float residual_diff = residuals_map(field_map[idx], kx, ky, kz) -
+                                          residuals_map(proposed_field_map[idx], kx, ky, kz);
+                    if (residual_diff > 0) graph.edge_capacity_map[graph.edge_to_sink(idx)] += int(residual_diff);
+                    else graph.edge_capacity_map[graph.edge_from_source(idx)] -= int(residual_diff);
+                }
+            }
+        }
+
+        boost::boykov_kolmogorov_max_flow(graph, graph.source_vertex, graph.sink_vertex);
+
+        auto result = field_map;
+        for (size_t idx = 0; idx < result.get_number_of_elements(); idx++)
+            if (graph.color_map[idx] != boost::default_color_type::black_color) result[idx] = proposed_field_map[idx];
+        return result;
+    }
+
+    // Random field maps, each proposed a constant jump away as in the field map estimation, with real valued
+    // regularization weights so the capacities are not exact integers
+    template<unsigned int D>
+    void compare_field_map_with_boykov_kolmogorov(size_t X, size_t Y, size_t Z, unsigned int seed) {
+        boost::random::mt19937 rng(seed);
+        boost::random::uniform_int_distribution<int> field_value(0, 15);
+        boost::random::uniform_real_distribution<float> lambda(0.0f, 2.0f);
+        boost::random::uniform_real_distribution<float> residual(0.0f, 400.0f);
+
+        const int jump = 1 + seed;
+        const size_t num_field_values = 16 + jump;
+
+        hoNDArray<uint16_t> field_map(X, Y, Z);
+        hoNDArray<uint16_t> proposed_field_map(X, Y, Z);
+        hoNDArray<float> lambda_map(X, Y, Z);
+        hoNDArray<float> residuals_map(num_field_values, X, Y, Z);
+
+        for (size_t idx = 0; idx < field_map.get_number_of_elements(); idx++) {
+            field_map[idx] = field_value(rng);
+            proposed_field_map[idx] = field_map[idx] + jump;
+            lambda_map[idx] = lambda(rng);
+        }
+        for (size_t idx = 0; idx < residuals_map.get_number_of_elements(); idx++) residuals_map[idx] = residual(rng);
+
+        auto expected = update_field_map_boykov_kolmogorov<D>(field_map, proposed_field_map, residuals_map, lambda_map);
+        auto result = update_field_map(field_map, proposed_field_map, residuals_map, lambda_map);
+
+        ASSERT_EQ(expected.get_number_of_elements(), result.get_number_of_elements());
+        for (size_t idx = 0; idx < result.get_number_of_elements(); idx++)
+            EXPECT_EQ(expected[idx], result[idx]);
+    }
+}
+
+TEST(graph_cut_test, matches_boykov_kolmogorov_2d)
+{
+    for (unsigned int seed = 0; seed < 4; seed++)
+        compare_with_boykov_kolmogorov<2>(vector_td<int, 2>(37, 29), seed);
+}
+
+TEST(graph_cut_test, matches_boykov_kolmogorov_3d)
+{
+    for (unsigned int seed = 0; seed < 4; seed++)
+        compare_with_boykov_kolmogorov<3>(vector_td<int, 3>(17, 13, 9), seed);
+}
+
+TEST(graph_cut_test, field_map_matches_boykov_kolmogorov_2d)
+{
+    for (unsigned int seed = 0; seed < 4; seed++)
+        compare_field_map_with_boykov_kolmogorov<2>(37, 29, 1, seed);
+}
+
+TEST(graph_cut_test, field_map_matches_boykov_kolmogorov_3d)
+{
+    for (unsigned int seed = 0; seed < 4; seed++)
+        compare_field_map_with_boykov_kolmogorov<3>(17, 13, 9, seed);
+}
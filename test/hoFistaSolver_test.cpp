@@ -0,0 +1,185 @@
+/** \file       hoFistaSolver_test.cpp
+    \brief      Test case for the accelerated proximal gradient solver
+
+    \author     agent
+*/
+
+#include "hoNDArray_elemwise.h"
+#include "hoNDArray_reductions.h"
+#include "linearOperator.h"
+#include "hoFistaSolver.h"
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+
+using namespace Gadgetron;
+using testing::Types;
+
+namespace
+{
+    template <typename T> void set_value(T& v, float re, float im) { v = T(re); }
+    template <typename T> void set_value(std::complex<T>& v, float re, float im) { v = std::complex<T>(re, im); }
+
+    // y = d.*x, with a positive real diagonal, which is its own adjoint
+    template <typename T> class diagonalTestOperator : public linearOperator< hoNDArray<T> >
+    {
+    public:
+        hoNDArray<T> diagonal_;
+
+        virtual void mult_M(hoNDArray<T>* x, hoNDArray<T>* y, bool accumulate = false)
+        {
+            Gadgetron::multiply(diagonal_, *x, *y);
+        }
+
+        virtual void mult_MH(hoNDArray<T>* x, hoNDArray<T>* y, bool accumulate = false)
+        {
+            Gadgetron::multiply(diagonal_, *x, *y);
+        }
+    };
+
+    // identity transform, with soft thresholding as the proximity operation
+    template <typename T> class identityTestRegularizer
+    {
+    public:
+        typedef typename realType<T>::Type value_type;
+
+        void mult_M(hoNDArray<T>* x, hoNDArray<T>* y, bool accumulate = false) { *y = *x; }
+        void mult_MH(hoNDArray<T>* x, hoNDArray<T>* y, bool accumulate = false) { *y = *x; }
+        bool unitary() const { return true; }
+
+        void proximity(hoNDArray<T>& wavCoeff, value_type thres)
+        {
+            for (size_t n = 0; n < wavCoeff.get_number_of_elements(); n++)
+            {
+                value_type mag = std::abs(wavCoeff[n]);
+                wavCoeff[n] = (mag > thres) ? wavCoeff[n] * ((mag - thres) / mag) : T(0);
+            }
+        }
+    };
+}
+
+template<typename T> class hoFistaSolver_test : public ::testing::Test
+{
+protected:
+    typedef typename realType<T>::Type value_type;
+
+    virtual void SetUp()
+    {
+        size_t N = 4096;
+
+        boost::random::mt19937 rng(42);
+        boost::random::uniform_real_distribution<float> dist_b(-1.0f, 1.0f), dist_d(0.05f, 1.0f);
+
+        A_.diagonal_.create(N);
+        b_.create(N);
+        for (size_t n = 0; n < N; n++)
+        {
+            A_.diagonal_[n] = T(dist_d(rng));
+            set_value(b_[n], dist_b(rng), dist_b(rng));
+        }
+
+        lamda_ = 0.1f;
+
+        // argmin 0.5*||d.*x-b||2 + lamda*||x||1 = soft(d.*b, lamda)./d.^2
+        solution_.create(N);
+        for (size_t n = 0; n < N; n++)
+        {
+            T d = A_.diagonal_[n];
+            T db = d*b_[n];
+            value_type mag = std::abs(db);
+            solution_[n] = (mag > lamda_) ? db * ((mag - lamda_) / mag) / (d*d) : T(0);
+        }
+    }
+
+    template <typename SolverType> value_type solve(SolverType& solver, hoNDArray<T>& x)
+    {
+        solver.oper_system_ = &A_;
+        solver.oper_reg_ = &W_;
+        solver.iterations_ = 100;
+        solver.grad_thres_ = 0;
+        solver.thres_ = 0;
+        solver.scale_factor_ = 1;
+        solver.proximal_strength_ratio_ = lamda_;
+
+        boost::shared_ptr< hoNDArray<T> > x0(new hoNDArray<T>(b_.get_dimensions()));
+        Gadgetron::clear(*x0);
+        solver.set_x0(x0);
+
+        solver.solve(b_, x);
+
+        hoNDArray<T> diff;
+        Gadgetron::subtract(x, solution_, diff);
+        return Gadgetron::nrm2(diff) / Gadgetron::nrm2(solution_);
+    }
+
+    // 0.5*||d.*x-b||2 + lamda*||x||1, with the magnitude of the complex values in the l1 norm
+    value_type objective(const hoNDArray<T>& x)
+    {
+        value_type data_term = 0, reg_term = 0;
+        for (size_t n = 0; n < x.get_number_of_elements(); n++)
+        {
+            value_type res = std::abs(A_.diagonal_[n] * x[n] - b_[n]);
+            data_term += res*res;
+            reg_term += std::abs(x[n]);
+        }
+        return value_type(0.5)*data_term + lamda_*reg_term;
+    }
+
+    diagonalTestOperator<T> A_;
+    identityTestRegularizer<T> W_;
+    hoNDArray<T> b_, solution_;
+    value_type lamda_;
+};
+
+typedef Types<float, double, std::complex<float>, std::complex<double> > Implementations;
+TYPED_TEST_CASE(hoFistaSolver_test, Implementations);
+
+TYPED_TEST(hoFistaSolver_test, converge)
+{
+    hoFistaSolver< hoNDArray<TypeParam>, identityTestRegularizer<TypeParam> > solver;
+
+    typedef typename realType<TypeParam>::Type value_type;
+
+    hoNDArray<TypeParam> x;
+    value_type err = this->solve(solver, x);
+    EXPECT_LE(err, 0.02);
+
+    // the cost decreases, apart from the iterations where the momentum was restarted
+    EXPECT_GT(solver.func_value_.size(), 2);
+    EXPECT_LT(solver.func_value_.back(), solver.func_value_.front());
+}
+
+TYPED_TEST(hoFistaSolver_test, compareGd)
+{
+    hoGdSolver< hoNDArray<TypeParam>, identityTestRegularizer<TypeParam> > gd;
+    hoFistaSolver< hoNDArray<TypeParam>, identityTestRegularizer<TypeParam> > fista;
+
+    typedef typename realType<TypeParam>::Type value_type;
+
+    hoNDArray<TypeParam> x_gd, x_fista;
+    value_type err_gd = this->solve(gd, x_gd);
+    value_type err_fista = this->solve(fista, x_fista);
+
+    // the solvers record their cost differently for complex values, so both are evaluated here
+    EXPECT_LE(err_fista, err_gd);
+    EXPECT_LE(this->objective(x_fista), this->objective(x_gd));
+}
+
+TYPED_TEST(hoFistaSolver_test, reuse)
+{
+    typedef typename realType<TypeParam>::Type value_type;
+
+    // the workspace of the first solve is reused by the second
+    hoFistaSolver< hoNDArray<TypeParam>, identityTestRegularizer<TypeParam> > solver;
+
+    hoNDArray<TypeParam> x1, x2;
+    this->solve(solver, x1);
+    std::vector<value_type> cost1(solver.func_value_);
+
+    this->solve(solver, x2);
+
+    ASSERT_EQ(cost1.size(), solver.func_value_.size());
+    for (size_t n = 0; n < x1.get_number_of_elements(); n++)
+    {
+        EXPECT_EQ(x1[n], x2[n]);
+    }
+}
@@ -1,4 +1,5 @@
 #include "hoNDArray_elemwise.h"
+#include "hoNDArray_elemwise_simd.h"
 #include "complext.h"
 
 #include <gtest/gtest.h>
@@ -300,6 +301,50 @@ TYPED_TEST(hoNDArray_elemwise_TestCplx,conjTest){
   EXPECT_NEAR(-4.2,imag(conj(&this->Array)->at(45)), 0.000001);
 }
 
+TYPED_TEST(hoNDArray_elemwise_TestCplx,multiplyConjAccumulateTest){
+  TypeParam v1 = TypeParam(1.5,-2.25);
+  TypeParam v2 = TypeParam(0.5,3.0);
+  TypeParam v3 = TypeParam(-4.0,1.0);
+  fill(&this->Array,v1);
+  fill(&this->Array2,v2);
+  hoNDArray<TypeParam> res(&this->dims);
+  fill(&res,v3);
+  multiplyConjAccumulate(this->Array,this->Array2,res);
+  EXPECT_FLOAT_EQ(real(v3+v1*conj(v2)),real(res.get_data_ptr()[33425]));
+  EXPECT_FLOAT_EQ(imag(v3+v1*conj(v2)),imag(res.get_data_ptr()[33425]));
+}
+
+TYPED_TEST(hoNDArray_elemwise_TestCplx,axpyTest){
+  TypeParam a = TypeParam(0.75,-1.5);
+  TypeParam v1 = TypeParam(1.5,-2.25);
+  TypeParam v2 = TypeParam(0.5,3.0);
+  fill(&this->Array,v1);
+  fill(&this->Array2,v2);
+  hoNDArray<TypeParam> res;
+  axpy(a,this->Array,this->Array2,res);
+  EXPECT_FLOAT_EQ(real(a*v1+v2),real(res.get_data_ptr()[12345]));
+  EXPECT_FLOAT_EQ(imag(a*v1+v2),imag(res.get_data_ptr()[12345]));
+}
+
+TYPED_TEST(hoNDArray_elemwise_TestCplx,emptyTest){
+  // arrays without elements are valid input and give empty results
+  hoNDArray<TypeParam> x, y, res, acc;
+  hoNDArray<typename realType<TypeParam>::Type> res_abs;
+
+  multiply(x,y,res);
+  EXPECT_EQ(0u,res.get_number_of_elements());
+  multiplyConj(x,y,res);
+  EXPECT_EQ(0u,res.get_number_of_elements());
+  multiplyConjAccumulate(x,y,acc);
+  EXPECT_EQ(0u,acc.get_number_of_elements());
+  axpy(TypeParam(0.5,-2.0),x,y,res);
+  EXPECT_EQ(0u,res.get_number_of_elements());
+  conjugate(x,res);
+  EXPECT_EQ(0u,res.get_number_of_elements());
+  abs(x,res_abs);
+  EXPECT_EQ(0u,res_abs.get_number_of_elements());
+}
+
 TYPED_TEST(hoNDArray_elemwise_TestCplx,normalizeTest){
   fill(&this->Array,TypeParam(50,50));
   this->Array.get_data_ptr()[23]=TypeParam(-200,-200);
@@ -616,3 +661,49 @@ TYPED_TEST(hoNDArray_operators_TestCplx,equalsDivideTest3){
   EXPECT_FLOAT_EQ(real(v1/v2),real(this->Array.get_data_ptr()[idx]));
   EXPECT_FLOAT_EQ(imag(v1/v2),imag(this->Array.get_data_ptr()[idx]));
 }
+
+// Every instruction set the CPU supports has to give the results of the scalar kernels. The length is odd, so that the
+// vectorized kernels also run their scalar tails.
+TEST(hoNDArray_elemwise_simd,isaTest){
+  typedef std::complex<float> T;
+  const size_t N = 1031;
+  hoNDArray<T> x(N), y(N);
+  for (size_t i = 0; i < N; i++) {
+    x[i] = T(std::sin(0.1f*i), std::cos(0.37f*i));
+    y[i] = T(std::cos(0.23f*i), -std::sin(0.05f*i));
+  }
+
+  std::vector< hoNDArray<T> > ref;
+  hoNDArray<float> ref_abs;
+  for (int isa = 0; isa <= int(simd::supported_isa()); isa++) {
+    simd::set_isa(simd::ISA(isa));
+
+    std::vector< hoNDArray<T> > res(4);
+    multiply(x, y, res[0]);
+    multiplyConj(x, y, res[1]);
+    axpy(T(0.5f, -2.0f), x, y, res[2]);
+    conjugate(x, res[3]);
+    res.push_back(y);
+    multiplyConjAccumulate(x, y, res.back());
+
+    hoNDArray<float> res_abs;
+    abs(x, res_abs);
+
+    if (isa == 0) {
+      ref = res;
+      ref_abs = res_abs;
+      continue;
+    }
+
+    for (size_t k = 0; k < ref.size(); k++) {
+      for (size_t i = 0; i < N; i++) {
+        EXPECT_NEAR(0, std::abs(ref[k][i] - res[k][i]), 1e-5) << simd::isa_name(simd::ISA(isa)) << " function " << k << " element " << i;
+      }
+    }
+    for (size_t i = 0; i < N; i++) {
+      EXPECT_NEAR(ref_abs[i], res_abs[i], 1e-5) << simd::isa_name(simd::ISA(isa)) << " element " << i;
+    }
+  }
+
+  simd::set_isa(simd::supported_isa());
+}
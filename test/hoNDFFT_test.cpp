@@ -3,6 +3,12 @@
 #include "complext.h"
 #include <gtest/gtest.h>
 #include <boost/random.hpp>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <limits>
 
 using namespace Gadgetron;
 using testing::Types;
@@ -28,6 +34,19 @@ protected:
 	hoNDArray<complext<REAL> > Array2;
 
 };
+// exposes the protected plan lookup of the singleton
+template<typename REAL> struct hoNDFFT_plan_cache : public hoNDFFT<REAL>
+{
+	typedef typename hoNDFFT<REAL>::ComplexType ComplexType;
+	typedef typename fftw_types<REAL>::plan Plan;
+
+	static Plan* plan(ComplexType* in, ComplexType* out, int n, int howmany, int sign, bool& cached)
+	{
+		Plan* (hoNDFFT<REAL>::*get)(int, const int*, int, ComplexType*, int, int, ComplexType*, int, int, int, bool&, size_t) = &hoNDFFT_plan_cache::get_plan;
+		return (hoNDFFT<REAL>::instance()->*get)(1, &n, howmany, in, 1, n, out, 1, n, sign, cached, 0);
+	}
+};
+
 typedef Types<float, double> realImplementations;
 TYPED_TEST_CASE(hoNDFFT_test, realImplementations);
 
@@ -44,3 +63,196 @@ TYPED_TEST(hoNDFFT_test,ifftNrm2Test){
 	EXPECT_NEAR(nrm2(&this->Array2),nrm2(&this->Array),nrm2(&this->Array)*1e-2);
 
 }
+
+TYPED_TEST(hoNDFFT_test,planCacheTest){
+	typedef hoNDFFT_plan_cache<TypeParam> Cache;
+	typedef typename Cache::ComplexType ComplexType;
+	hoNDFFT<TypeParam>* fft = hoNDFFT<TypeParam>::instance();
+
+	fft->clear_plan_cache();
+	EXPECT_EQ(fft->plan_cache_size(), 0);
+
+	hoNDArray<ComplexType> a(64, 8);
+	bool cached = false;
+	typename Cache::Plan* p = Cache::plan(a.begin(), a.begin(), 64, 8, FFTW_FORWARD, cached);
+	ASSERT_TRUE(p != NULL);
+	EXPECT_TRUE(cached);
+	EXPECT_EQ(fft->plan_cache_size(), 1);
+
+	// the same problem hits the cache, in this thread and in others
+	cached = false;
+	EXPECT_EQ(Cache::plan(a.begin(), a.begin(), 64, 8, FFTW_FORWARD, cached), p);
+	EXPECT_TRUE(cached);
+
+	typename Cache::Plan* q = NULL;
+	bool cached_thread = false;
+	std::thread t([&]() { q = Cache::plan(a.begin(), a.begin(), 64, 8, FFTW_FORWARD, cached_thread); });
+	t.join();
+	EXPECT_EQ(q, p);
+	EXPECT_TRUE(cached_thread);
+	EXPECT_EQ(fft->plan_cache_size(), 1);
+
+	// a different direction is a different problem
+	EXPECT_NE(Cache::plan(a.begin(), a.begin(), 64, 8, FFTW_BACKWARD, cached), p);
+	EXPECT_EQ(fft->plan_cache_size(), 2);
+
+	// repeated transforms of the same size do not add plans
+	fft->clear_plan_cache();
+	fft->fft1c(a);
+	fft->ifft1c(a);
+	size_t num = fft->plan_cache_size();
+	EXPECT_GT(num, 0);
+	fft->fft1c(a);
+	fft->ifft1c(a);
+	EXPECT_EQ(fft->plan_cache_size(), num);
+}
+
+TYPED_TEST(hoNDFFT_test,wisdomRoundTripTest){
+	hoNDFFT<TypeParam>* fft = hoNDFFT<TypeParam>::instance();
+
+	std::stringstream name;
+	name << "hoNDFFT_test_wisdom_" << sizeof(TypeParam) << ".txt";
+	std::string filename = name.str();
+
+	std::vector<size_t> dims(2, 16);
+	fft->prewarm(dims, 4);
+	ASSERT_TRUE(fft->export_wisdom(filename));
+
+	// the wisdom is written to a temporary file and renamed
+	std::ifstream tmp((filename + ".tmp").c_str());
+	EXPECT_FALSE(tmp.good());
+
+	std::ifstream file(filename.c_str());
+	ASSERT_TRUE(file.good());
+	std::string wisdom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	EXPECT_EQ(wisdom.compare(0, 5, "(fftw"), 0);
+	EXPECT_NE(wisdom.find("wisdom"), std::string::npos);
+
+	EXPECT_TRUE(fft->import_wisdom(filename));
+	EXPECT_FALSE(fft->import_wisdom(filename + ".missing"));
+
+	std::remove(filename.c_str());
+}
+
+// the centered transforms against the explicit ifftshift, fft and fftshift
+template<typename REAL> class hoNDFFT_centered_test : public ::testing::Test {
+protected:
+	typedef std::complex<REAL> T;
+
+	void random(const std::vector<size_t>& dims, hoNDArray<T>& a){
+		boost::random::mt19937 rng(11);
+		boost::random::uniform_real_distribution<REAL> uni(-1,1);
+
+		a.create(dims);
+		for (size_t i = 0; i < a.get_number_of_elements(); i++)
+			a[i] = T(uni(rng),uni(rng));
+	}
+
+	void reference(const hoNDArray<T>& a, hoNDArray<T>& r, size_t rank, bool forward){
+		hoNDFFT<REAL>* fft = hoNDFFT<REAL>::instance();
+		r = a;
+
+		if (rank == 1){
+			fft->ifftshift1D(r);
+			if (forward) fft->fft1(r); else fft->ifft1(r);
+			fft->fftshift1D(r);
+		}
+		else if (rank == 2){
+			fft->ifftshift2D(r);
+			if (forward) fft->fft2(r); else fft->ifft2(r);
+			fft->fftshift2D(r);
+		}
+		else{
+			fft->ifftshift3D(r);
+			if (forward) fft->fft3(r); else fft->ifft3(r);
+			fft->fftshift3D(r);
+		}
+	}
+
+	void centered(hoNDArray<T>& a, size_t rank, bool forward){
+		hoNDFFT<REAL>* fft = hoNDFFT<REAL>::instance();
+		if (rank == 1){ if (forward) fft->fft1c(a); else fft->ifft1c(a); }
+		else if (rank == 2){ if (forward) fft->fft2c(a); else fft->ifft2c(a); }
+		else{ if (forward) fft->fft3c(a); else fft->ifft3c(a); }
+	}
+
+	void centered(const hoNDArray<T>& a, hoNDArray<T>& r, size_t rank, bool forward){
+		hoNDFFT<REAL>* fft = hoNDFFT<REAL>::instance();
+		if (rank == 1){ if (forward) fft->fft1c(a, r); else fft->ifft1c(a, r); }
+		else if (rank == 2){ if (forward) fft->fft2c(a, r); else fft->ifft2c(a, r); }
+		else{ if (forward) fft->fft3c(a, r); else fft->ifft3c(a, r); }
+	}
+
+	void centered(const hoNDArray<T>& a, hoNDArray<T>& r, hoNDArray<T>& buf, size_t rank, bool forward){
+		hoNDFFT<REAL>* fft = hoNDFFT<REAL>::instance();
+		if (rank == 1){ if (forward) fft->fft1c(a, r, buf); else fft->ifft1c(a, r, buf); }
+		else if (rank == 2){ if (forward) fft->fft2c(a, r, buf); else fft->ifft2c(a, r, buf); }
+		else{ if (forward) fft->fft3c(a, r, buf); else fft->ifft3c(a, r, buf); }
+	}
+
+	REAL max_diff(const hoNDArray<T>& a, const hoNDArray<T>& b){
+		EXPECT_TRUE(a.dimensions_equal(&b));
+		REAL diff = 0;
+		for (size_t i = 0; i < a.get_number_of_elements(); i++)
+			diff = std::max(diff, std::abs(a[i] - b[i]));
+		return diff;
+	}
+
+	// forward and inverse, in-place and out-of-place
+	void check(const std::vector<size_t>& dims, size_t rank){
+		hoNDArray<T> a, ref;
+		this->random(dims, a);
+
+		REAL tol = std::numeric_limits<REAL>::epsilon() * 100;
+
+		for (int forward = 0; forward < 2; forward++){
+			this->reference(a, ref, rank, forward != 0);
+
+			hoNDArray<T> r;
+			this->centered(a, r, rank, forward != 0);
+			EXPECT_LE(this->max_diff(r, ref), tol) << "out-of-place, rank " << rank << ", forward " << forward;
+
+			hoNDArray<T> b(a);
+			this->centered(b, rank, forward != 0);
+			EXPECT_LE(this->max_diff(b, ref), tol) << "in-place, rank " << rank << ", forward " << forward;
+
+			hoNDArray<T> c(dims), buf;
+			this->centered(a, c, buf, rank, forward != 0);
+			EXPECT_LE(this->max_diff(c, ref), tol) << "with buffer, rank " << rank << ", forward " << forward;
+		}
+	}
+};
+
+typedef Types<float, double> centeredImplementations;
+TYPED_TEST_CASE(hoNDFFT_centered_test, centeredImplementations);
+
+TYPED_TEST(hoNDFFT_centered_test,fft1cTest){
+	this->check({16}, 1);
+	this->check({15}, 1);
+	// [RO E1 CHA N]
+	this->check({16, 6, 4, 3}, 1);
+	this->check({14, 5, 3, 2}, 1);
+	this->check({15, 6, 4, 3}, 1);
+}
+
+TYPED_TEST(hoNDFFT_centered_test,fft2cTest){
+	this->check({12, 8}, 2);
+	this->check({6, 8}, 2);
+	this->check({9, 7}, 2);
+	// [RO E1 CHA N]
+	this->check({12, 8, 4, 3}, 2);
+	this->check({10, 6, 3, 5}, 2);
+	this->check({10, 8, 3, 2}, 2);
+	this->check({12, 7, 4, 3}, 2);
+	this->check({9, 8, 2, 2}, 2);
+}
+
+TYPED_TEST(hoNDFFT_centered_test,fft3cTest){
+	this->check({8, 6, 4}, 3);
+	this->check({7, 5, 3}, 3);
+	// [RO E1 E2 CHA N]
+	this->check({8, 6, 4, 3, 2}, 3);
+	this->check({6, 6, 2, 5}, 3);
+	this->check({8, 5, 4, 3, 2}, 3);
+}
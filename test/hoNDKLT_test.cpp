@@ -0,0 +1,148 @@
+/** \file       hoNDKLT_test.cpp
+    \brief      Test case for the KL transform computed from accumulated batches
+
+    \author     agent
+*/
+
+#include "hoNDKLT.h"
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+
+using namespace Gadgetron;
+using testing::Types;
+
+template<typename T> class hoNDKLT_test : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        // samples of correlated channels with a non-zero mean, [samples channels]
+        M_ = 480;
+        N_ = 12;
+
+        boost::random::mt19937 rng(42);
+        boost::random::normal_distribution<float> dist(0.0f, 1.0f);
+
+        hoNDArray<T> mixing(N_, N_);
+        for (size_t n = 0; n < mixing.get_number_of_elements(); n++)
+        {
+            mixing(n) = T(dist(rng));
+        }
+
+        data_.create(M_, N_);
+        for (size_t m = 0; m < M_; m++)
+        {
+            for (size_t c = 0; c < N_; c++)
+            {
+                T v = T(3.0f + c);
+                for (size_t k = 0; k < N_; k++)
+                {
+                    v += mixing(k, c) * T(dist(rng) / (k + 1));
+                }
+                data_(m, c) = v;
+            }
+        }
+    }
+
+    // accumulate the data in batches of the given number of samples
+    void accumulate(hoNDKLT<T>& klt, size_t batch, bool remove_mean)
+    {
+        for (size_t m = 0; m < M_; m += batch)
+        {
+            size_t len = std::min(batch, M_ - m);
+
+            hoNDArray<T> part(len, N_);
+            for (size_t c = 0; c < N_; c++)
+            {
+                memcpy(&part(0, c), &data_(m, c), sizeof(T)*len);
+            }
+
+            klt.accumulate(part, 1, remove_mean);
+        }
+    }
+
+    // the eigen values agree and the eigen vectors span the same directions
+    void compare(const hoNDKLT<T>& klt, const hoNDKLT<T>& ref, size_t num)
+    {
+        hoNDArray<T> E, E_ref, V, V_ref;
+        klt.eigen_value(E);
+        ref.eigen_value(E_ref);
+        klt.eigen_vector(V);
+        ref.eigen_vector(V_ref);
+
+        for (size_t n = 0; n < num; n++)
+        {
+            EXPECT_NEAR(std::abs(E(n)), std::abs(E_ref(n)), 1e-3*std::abs(E_ref(0)));
+
+            // |v'*v_ref| == 1 for the same direction
+            std::complex<double> inner = 0;
+            for (size_t c = 0; c < N_; c++)
+            {
+                inner += std::conj(std::complex<double>(V_ref(c, n))) * std::complex<double>(V(c, n));
+            }
+            EXPECT_NEAR(std::abs(inner), 1.0, 1e-3);
+        }
+    }
+
+    size_t M_, N_;
+    hoNDArray<T> data_;
+};
+
+typedef Types<float, double, std::complex<float>, std::complex<double> > kltImplementations;
+TYPED_TEST_CASE(hoNDKLT_test, kltImplementations);
+
+TYPED_TEST(hoNDKLT_test, accumulate)
+{
+    hoNDKLT<TypeParam> ref, klt;
+    ref.prepare(this->data_, (size_t)1, (size_t)0, true);
+
+    this->accumulate(klt, 17, true);
+    EXPECT_EQ(klt.accumulated_samples(), this->M_);
+
+    klt.prepare_accumulated();
+    EXPECT_EQ(klt.output_length(), this->N_);
+
+    this->compare(klt, ref, 4);
+}
+
+TYPED_TEST(hoNDKLT_test, accumulateNoMean)
+{
+    hoNDKLT<TypeParam> ref, klt;
+    ref.prepare(this->data_, (size_t)1, (size_t)0, false);
+
+    this->accumulate(klt, 1, false);
+    klt.prepare_accumulated((size_t)4);
+    EXPECT_EQ(klt.output_length(), 4);
+
+    this->compare(klt, ref, 4);
+}
+
+TYPED_TEST(hoNDKLT_test, untransformed)
+{
+    std::vector<size_t> untransformed(2);
+    untransformed[0] = 3;
+    untransformed[1] = 7;
+
+    hoNDKLT<TypeParam> ref, klt;
+    ref.prepare(this->data_, (size_t)1, untransformed, (size_t)6, true);
+
+    this->accumulate(klt, 64, true);
+    klt.prepare_accumulated(untransformed, (size_t)6);
+    EXPECT_EQ(klt.output_length(), 6);
+
+    // the untransformed slots are passed through
+    hoNDArray<TypeParam> V;
+    klt.eigen_vector(V);
+    EXPECT_EQ(V(3, 0), TypeParam(1));
+    EXPECT_EQ(V(7, 1), TypeParam(1));
+
+    this->compare(klt, ref, 5);
+
+    // more data can be added after the transform was computed
+    hoNDKLT<TypeParam> klt2(klt);
+    this->accumulate(klt2, 64, true);
+    EXPECT_EQ(klt2.accumulated_samples(), 2 * this->M_);
+
+    klt.reset_accumulation();
+    EXPECT_EQ(klt.accumulated_samples(), 0);
+}
@@ -3,6 +3,7 @@
 #include "hoNDArray_reductions.h"
 #include "hoNDArray_elemwise.h"
 #include "hoNFFT.h"
+#include "hoNFFTOperator.h"
 #include "vector_td_utilities.h"
 #include "ImageIOAnalyze.h"
 #include "GadgetronTimer.h"
@@ -136,3 +137,146 @@ TYPED_TEST(hoNFFT_2D_NC2C_BACKWARDS, randomTestOne)
 
     EXPECT_LE(v/norm_ref, 0.00001);
 }
+
+TEST(hoNFFT_sparseMatrix, columns)
+{
+    using namespace Gadgetron::NFFT_internal;
+
+    vector_td<size_t, 2> dims(48, 40);
+    vector_td<float, 2> beta(10.0f, 11.0f);
+    float W = 5.5f;
+
+    hoNDArray<vector_td<float, 2>> traj(1001);
+    for (size_t i = 0; i < traj.get_number_of_elements(); i++) {
+        traj[i][0] = float((i * 37) % 4800) / 100.0f;
+        traj[i][1] = float((i * 53) % 4000) / 100.0f;
+    }
+
+    auto matrix = make_NFFT_matrix(traj, dims, W, beta);
+
+    EXPECT_EQ(matrix.n_cols, traj.get_number_of_elements());
+    EXPECT_EQ(matrix.n_rows, prod(dims));
+
+    // Every sample is stored once, with its entries inside the grid
+    std::vector<int> seen(matrix.n_cols, 0);
+    for (size_t j = 0; j < matrix.n_cols; j++) {
+        seen[matrix.column(j)]++;
+        EXPECT_LT(matrix.column_offsets[j], matrix.column_offsets[j + 1]);
+        for (size_t n = matrix.column_offsets[j]; n < matrix.column_offsets[j + 1]; n++) {
+            EXPECT_LT(matrix.indices[n], matrix.n_rows);
+        }
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), (long)matrix.n_cols);
+}
+
+TEST(hoNFFT_sparseMatrix, cache)
+{
+    using namespace Gadgetron::NFFT_internal;
+
+    vector_td<size_t, 2> dims(32, 32);
+    vector_td<float, 2> beta(10.0f, 10.0f);
+
+    hoNDArray<vector_td<float, 2>> traj(200);
+    for (size_t i = 0; i < traj.get_number_of_elements(); i++) {
+        traj[i][0] = float(i % 32);
+        traj[i][1] = float(i / 32) + 0.5f;
+    }
+
+    auto cache = NFFT_MatrixCache<float, 2>::instance();
+    cache->clear();
+
+    auto first = cache->get(traj, dims, 5.5f, beta);
+    ASSERT_TRUE(first);
+
+    auto second = cache->get(traj, dims, 5.5f, beta);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(cache->size(), 1u);
+
+    traj[3][0] += 0.25f;
+    auto third = cache->get(traj, dims, 5.5f, beta);
+    EXPECT_NE(first, third);
+    EXPECT_EQ(cache->size(), 2u);
+
+    cache->clear();
+}
+
+TEST(hoNFFT_sparseMatrix, tiles)
+{
+    using namespace Gadgetron::NFFT_internal;
+
+    // 6 tiles along x and an odd number, 3, along y, with samples on the edges of the grid
+    vector_td<size_t, 2> dims(100, 56);
+    vector_td<float, 2> beta(10.0f, 10.0f);
+
+    hoNDArray<vector_td<float, 2>> traj(2000);
+    for (size_t i = 0; i < traj.get_number_of_elements(); i++) {
+        traj[i][0] = float((i * 37) % 1001) / 10.0f;
+        traj[i][1] = float((i * 53) % 561) / 10.0f;
+    }
+
+    auto matrix = make_NFFT_matrix(traj, dims, 5.5f, beta);
+
+    // The tiles cover every column once
+    size_t columns = 0;
+    for (auto &tiles : matrix.tiles)
+        for (auto &range : tiles) columns += range.second - range.first;
+    EXPECT_EQ(columns, matrix.n_cols);
+
+    // Tiles of one colour touch disjoint parts of the grid
+    for (auto &tiles : matrix.tiles) {
+        std::vector<int> owner(matrix.n_rows, -1);
+        for (size_t t = 0; t < tiles.size(); t++) {
+            for (size_t j = tiles[t].first; j < tiles[t].second; j++) {
+                for (size_t n = matrix.column_offsets[j]; n < matrix.column_offsets[j + 1]; n++) {
+                    int &o = owner[matrix.indices[n]];
+                    EXPECT_TRUE(o == -1 || o == int(t));
+                    o = int(t);
+                }
+            }
+        }
+    }
+}
+
+TEST(hoNFFTOperator, toeplitz)
+{
+    typedef complext<float> C;
+
+    size_t N = 16;
+    vector_td<size_t, 2> matrix_size(N, N);
+    vector_td<size_t, 2> matrix_size_os(2 * N, 2 * N);
+
+    // Two frames, and four images cycling through them
+    size_t samples = 300, frames = 2, images = 4;
+
+    hoNDArray<vector_td<float, 2>> traj(samples, frames);
+    auto dcw = boost::make_shared<hoNDArray<float>>(samples, frames);
+    for (size_t i = 0; i < traj.get_number_of_elements(); i++) {
+        traj[i][0] = float((i * 37) % 1000) / 1000.0f - 0.5f;
+        traj[i][1] = float((i * 59) % 1000) / 1000.0f - 0.5f;
+        (*dcw)[i] = 0.5f + float(i % 7) / 14.0f;
+    }
+
+    hoNDArray<C> x(N, N, images);
+    for (size_t i = 0; i < x.get_number_of_elements(); i++)
+        x[i] = C(float((i * 13) % 17) / 17.0f, float((i * 7) % 11) / 11.0f);
+
+    std::vector<size_t> domain_dims = {N, N, images};
+    std::vector<size_t> codomain_dims = {samples, frames, images / frames};
+
+    hoNFFTOperator<float, 2> E;
+    E.setup(matrix_size, matrix_size_os, 5.5f);
+    E.set_dcw(dcw);
+    E.set_domain_dimensions(&domain_dims);
+    E.set_codomain_dimensions(&codomain_dims);
+    E.preprocess(traj);
+
+    hoNDArray<C> k(codomain_dims), ref(domain_dims), res(domain_dims);
+    E.mult_M(&x, &k);
+    E.mult_MH(&k, &ref);
+
+    E.set_toeplitz(true);
+    E.mult_MH_M(&x, &res);
+
+    res -= ref;
+    EXPECT_LE(nrm2(&res) / nrm2(&ref), 1e-3f);
+}
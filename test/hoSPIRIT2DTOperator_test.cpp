@@ -0,0 +1,240 @@
+/** \file       hoSPIRIT2DTOperator_test.cpp
+    \brief      Test case for the kernel application of the 2D+T SPIRIT operator
+
+    \author     agent
+*/
+
+#include "hoSPIRIT2DTOperator.h"
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+#include <algorithm>
+#include <limits>
+
+using namespace Gadgetron;
+using testing::Types;
+
+namespace
+{
+    // exposes the kernels and their application
+    template <typename T> class hoSPIRIT2DTOperatorAccess : public hoSPIRIT2DTOperator<T>
+    {
+    public:
+        typedef hoSPIRIT2DTOperator<T> BaseClass;
+
+        hoSPIRIT2DTOperatorAccess(std::vector<size_t>* dims) : BaseClass(dims) {}
+
+        using BaseClass::apply_kernel;
+        using BaseClass::apply_forward_kernel;
+        using BaseClass::apply_adjoint_kernel;
+        using BaseClass::apply_adjoint_forward_kernel;
+        using BaseClass::res_after_apply_kernel_sum_over_;
+        using BaseClass::res_after_apply_kernel_sum_over_dst_;
+    };
+}
+
+template<typename T> class hoSPIRIT2DTOperator_test : public ::testing::Test
+{
+protected:
+    typedef typename realType<T>::Type value_type;
+
+    void random(hoNDArray<T>& a, unsigned int seed)
+    {
+        boost::random::mt19937 rng(seed);
+        boost::random::uniform_real_distribution<value_type> uni(-1, 1);
+
+        for (size_t n = 0; n < a.get_number_of_elements(); n++)
+        {
+            a[n] = T(uni(rng), uni(rng));
+        }
+    }
+
+    // y[RO E1 dstCHA N] = sum over src of kernel[RO E1 src dst min(n, kernelN-1)] * x[RO E1 src n]
+    void reference(const hoNDArray<T>& kernel, const hoNDArray<T>& x, hoNDArray<T>& y)
+    {
+        size_t RO = x.get_size(0), E1 = x.get_size(1), srcCHA = x.get_size(2), N = x.get_size(3);
+        size_t dstCHA = kernel.get_size(3), kernelN = kernel.get_size(4);
+
+        y.create(RO, E1, dstCHA, N);
+        for (size_t n = 0; n < N; n++)
+        {
+            size_t kn = std::min(n, kernelN - 1);
+            for (size_t dst = 0; dst < dstCHA; dst++)
+            {
+                for (size_t e1 = 0; e1 < E1; e1++)
+                {
+                    for (size_t ro = 0; ro < RO; ro++)
+                    {
+                        T sum = 0;
+                        for (size_t src = 0; src < srcCHA; src++)
+                        {
+                            sum += kernel(ro, e1, src, dst, kn) * x(ro, e1, src, n);
+                        }
+                        y(ro, e1, dst, n) = sum;
+                    }
+                }
+            }
+        }
+    }
+
+    // y[RO E1 srcCHA N] = sum over dst of conj(kernel[RO E1 src dst min(n, kernelN-1)]) * x[RO E1 dst n]
+    void reference_adjoint(const hoNDArray<T>& kernel, const hoNDArray<T>& x, hoNDArray<T>& y)
+    {
+        size_t RO = x.get_size(0), E1 = x.get_size(1), dstCHA = x.get_size(2), N = x.get_size(3);
+        size_t srcCHA = kernel.get_size(2), kernelN = kernel.get_size(4);
+
+        y.create(RO, E1, srcCHA, N);
+        for (size_t n = 0; n < N; n++)
+        {
+            size_t kn = std::min(n, kernelN - 1);
+            for (size_t src = 0; src < srcCHA; src++)
+            {
+                for (size_t e1 = 0; e1 < E1; e1++)
+                {
+                    for (size_t ro = 0; ro < RO; ro++)
+                    {
+                        T sum = 0;
+                        for (size_t dst = 0; dst < dstCHA; dst++)
+                        {
+                            sum += std::conj(kernel(ro, e1, src, dst, kn)) * x(ro, e1, dst, n);
+                        }
+                        y(ro, e1, src, n) = sum;
+                    }
+                }
+            }
+        }
+    }
+
+    // sum of conj(a).*b
+    T dotc(const hoNDArray<T>& a, const hoNDArray<T>& b)
+    {
+        T sum = 0;
+        for (size_t n = 0; n < a.get_number_of_elements(); n++)
+        {
+            sum += std::conj(a[n]) * b[n];
+        }
+        return sum;
+    }
+
+    value_type max_diff(const hoNDArray<T>& a, const hoNDArray<T>& b)
+    {
+        EXPECT_TRUE(a.dimensions_equal(&b));
+        value_type diff = 0;
+        for (size_t n = 0; n < a.get_number_of_elements(); n++)
+        {
+            diff = std::max(diff, (value_type)std::abs(a[n] - b[n]));
+        }
+        return diff;
+    }
+
+    value_type tolerance()
+    {
+        return std::numeric_limits<value_type>::epsilon() * 100;
+    }
+};
+
+typedef Types< std::complex<float>, std::complex<double> > cpfloatImplementations;
+TYPED_TEST_CASE(hoSPIRIT2DTOperator_test, cpfloatImplementations);
+
+TYPED_TEST(hoSPIRIT2DTOperator_test, applyKernel)
+{
+    // odd RO*E1, different numbers of src and dst channels
+    size_t RO = 13, E1 = 7, srcCHA = 3, dstCHA = 5;
+
+    std::vector<size_t> dims = { RO, E1, srcCHA, 4 };
+    hoSPIRIT2DTOperatorAccess<TypeParam> op(&dims);
+
+    // one kernel for all frames, one kernel per frame, and fewer kernels than frames, where the last one is reused
+    size_t kernelN[] = { 1, 4, 2 };
+
+    for (size_t k = 0; k < 3; k++)
+    {
+        hoNDArray<TypeParam> kernel(RO, E1, srcCHA, dstCHA, kernelN[k]), x(RO, E1, srcCHA, 4), y, ref;
+        this->random(kernel, 1);
+        this->random(x, 2);
+
+        op.apply_kernel(kernel, x, y);
+        this->reference(kernel, x, ref);
+
+        EXPECT_LE(this->max_diff(y, ref), this->tolerance()) << "kernelN " << kernelN[k];
+    }
+}
+
+TYPED_TEST(hoSPIRIT2DTOperator_test, forwardAndAdjointKernels)
+{
+    size_t RO = 11, E1 = 9, CHA = 4, N = 5, kernelN = 2;
+
+    std::vector<size_t> dims = { RO, E1, CHA, N };
+    hoSPIRIT2DTOperatorAccess<TypeParam> op(&dims);
+
+    hoNDArray<TypeParam> kernel(RO, E1, CHA, CHA, kernelN), x(RO, E1, CHA, N);
+    this->random(kernel, 3);
+    this->random(x, 4);
+
+    op.set_forward_kernel(kernel, true);
+
+    // forward
+    hoNDArray<TypeParam> ref;
+    op.apply_forward_kernel(x);
+    this->reference(kernel, x, ref);
+    EXPECT_LE(this->max_diff(op.res_after_apply_kernel_sum_over_, ref), this->tolerance());
+
+    // adjoint, the conjugate transpose of the forward kernel
+    op.apply_adjoint_kernel(x);
+    this->reference_adjoint(kernel, x, ref);
+    EXPECT_LE(this->max_diff(op.res_after_apply_kernel_sum_over_dst_, ref), this->tolerance());
+
+    // adjoint forward, the adjoint applied to the forward result, for every frame
+    hoNDArray<TypeParam> forward;
+    this->reference(kernel, x, forward);
+    this->reference_adjoint(kernel, forward, ref);
+
+    op.apply_adjoint_forward_kernel(x);
+    EXPECT_LE(this->max_diff(op.res_after_apply_kernel_sum_over_dst_, ref), this->tolerance() * 10);
+}
+
+TYPED_TEST(hoSPIRIT2DTOperator_test, adjointDotProduct)
+{
+    typedef typename realType<TypeParam>::Type value_type;
+
+    size_t RO = 12, E1 = 10, CHA = 3, N = 4, kernelN = 3;
+
+    std::vector<size_t> dims = { RO, E1, CHA, N };
+    hoSPIRIT2DTOperatorAccess<TypeParam> op(&dims);
+
+    hoNDArray<TypeParam> kernel(RO, E1, CHA, CHA, kernelN), x(RO, E1, CHA, N), y(RO, E1, CHA, N);
+    this->random(kernel, 5);
+    this->random(x, 6);
+    this->random(y, 7);
+
+    op.set_forward_kernel(kernel, true);
+
+    // <Gx, y> = <x, G'y> in the image domain
+    op.apply_forward_kernel(x);
+    hoNDArray<TypeParam> Gx(op.res_after_apply_kernel_sum_over_);
+    op.apply_adjoint_kernel(y);
+    hoNDArray<TypeParam> GHy(op.res_after_apply_kernel_sum_over_dst_);
+
+    TypeParam lhs = this->dotc(Gx, y);
+    TypeParam rhs = this->dotc(x, GHy);
+    EXPECT_LE(std::abs(lhs - rhs), std::abs(lhs) * this->tolerance());
+
+    // <Mx, y> = <x, M'y> for the operator with the null space constraint, M = (G-I)Dc'
+    hoNDArray<TypeParam> kspace(RO, E1, CHA, N);
+    this->random(kspace, 8);
+    for (size_t n = 0; n < kspace.get_number_of_elements(); n += 3)
+    {
+        kspace[n] = 0;
+    }
+
+    op.set_acquired_points(kspace);
+    op.no_null_space_ = false;
+
+    hoNDArray<TypeParam> Mx(RO, E1, CHA, N), MHy(RO, E1, CHA, N);
+    op.mult_M(&x, &Mx);
+    op.mult_MH(&y, &MHy);
+
+    lhs = this->dotc(Mx, y);
+    rhs = this->dotc(x, MHy);
+    EXPECT_GT(std::abs(lhs), value_type(0));
+    EXPECT_LE(std::abs(lhs - rhs), std::abs(lhs) * this->tolerance() * 10);
+}
@@ -0,0 +1,195 @@
+/** \file       mri_core_coil_map_test.cpp
+    \brief      Test case for the Inati coil map estimation
+
+    \author     agent
+*/
+
+#include "mri_core_coil_map_estimation.h"
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+
+using namespace Gadgetron;
+using testing::Types;
+
+template<typename T> class mri_core_coil_map_test : public ::testing::Test
+{
+protected:
+    typedef typename realType<T>::Type value_type;
+
+    // smooth coil sensitivities times an object with a sharp edge, plus noise; [RO E1 E2 CHA]
+    void simulate(size_t RO, size_t E1, size_t E2, size_t CHA, hoNDArray<T>& data)
+    {
+        boost::random::mt19937 rng(42);
+        boost::random::normal_distribution<value_type> dist(0, 1);
+
+        data.create(RO, E1, E2, CHA);
+        for (size_t cha = 0; cha < CHA; cha++)
+        {
+            for (size_t e2 = 0; e2 < E2; e2++)
+            {
+                for (size_t e1 = 0; e1 < E1; e1++)
+                {
+                    for (size_t ro = 0; ro < RO; ro++)
+                    {
+                        value_type x = (value_type)ro / RO - (value_type)(cha + 1) / (CHA + 1);
+                        value_type y = (value_type)e1 / E1 - (value_type)0.5;
+                        value_type z = (value_type)e2 / E2;
+
+                        value_type mag = std::exp(-2 * (x*x + y*y + z*z));
+                        value_type phase = (value_type)(0.7*cha + 2.0*x - 1.5*y + z);
+                        value_type obj = (ro > RO / 4 && ro < 3 * RO / 4) ? (value_type)10 : (value_type)1;
+
+                        data(ro, e1, e2, cha) = T(obj*mag*std::cos(phase) + (value_type)0.05*dist(rng), obj*mag*std::sin(phase) + (value_type)0.05*dist(rng));
+                    }
+                }
+            }
+        }
+    }
+
+    // the local covariance is computed for every pixel from its window
+    void reference(const hoNDArray<T>& data, size_t ks, size_t kz, size_t power, hoNDArray<T>& coilMap)
+    {
+        long long RO = data.get_size(0);
+        long long E1 = data.get_size(1);
+        long long E2 = data.get_size(2);
+        long long CHA = data.get_size(3);
+        long long halfKs = ks / 2, halfKz = kz / 2;
+
+        coilMap.create(RO, E1, E2, CHA);
+
+        std::vector<T> sum(CHA), V1(CHA), V(CHA), DH_D(CHA*CHA);
+
+        for (long long e2 = 0; e2 < E2; e2++)
+        {
+            for (long long e1 = 0; e1 < E1; e1++)
+            {
+                for (long long ro = 0; ro < RO; ro++)
+                {
+                    std::fill(sum.begin(), sum.end(), T(0));
+                    std::fill(DH_D.begin(), DH_D.end(), T(0));
+
+                    for (long long ke2 = -halfKz; ke2 <= halfKz; ke2++)
+                    {
+                        for (long long ke1 = -halfKs; ke1 <= halfKs; ke1++)
+                        {
+                            for (long long kro = -halfKs; kro <= halfKs; kro++)
+                            {
+                                long long de2 = (e2 + ke2 + E2) % E2;
+                                long long de1 = (e1 + ke1 + E1) % E1;
+                                long long dro = (ro + kro + RO) % RO;
+
+                                for (long long j = 0; j < CHA; j++)
+                                {
+                                    T x = data(dro, de1, de2, j);
+                                    sum[j] += x;
+                                    for (long long i = 0; i < CHA; i++)
+                                    {
+                                        DH_D[i + j*CHA] += std::conj(data(dro, de1, de2, i)) * x;
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    V1 = sum;
+                    for (size_t po = 0; po <= power; po++)
+                    {
+                        if (po > 0)
+                        {
+                            for (long long i = 0; i < CHA; i++)
+                            {
+                                V[i] = 0;
+                                for (long long j = 0; j < CHA; j++) V[i] += DH_D[i + j*CHA] * V1[j];
+                            }
+                            V1 = V;
+                        }
+
+                        value_type norm = 0;
+                        for (long long i = 0; i < CHA; i++) norm += std::norm(V1[i]);
+                        for (long long i = 0; i < CHA; i++) V1[i] /= std::sqrt(norm);
+                    }
+
+                    T phaseU1 = 0;
+                    for (long long i = 0; i < CHA; i++) phaseU1 += sum[i] * V1[i];
+                    phaseU1 /= std::abs(phaseU1);
+
+                    for (long long i = 0; i < CHA; i++)
+                    {
+                        coilMap(ro, e1, e2, i) = std::conj(V1[i]) * phaseU1;
+                    }
+                }
+            }
+        }
+    }
+
+    value_type max_diff(const hoNDArray<T>& a, const hoNDArray<T>& b)
+    {
+        value_type diff = 0;
+        for (size_t n = 0; n < a.get_number_of_elements(); n++)
+        {
+            diff = std::max(diff, (value_type)std::abs(a[n] - b[n]));
+        }
+        return diff;
+    }
+};
+
+typedef Types< std::complex<float>, std::complex<double> > cpfloatImplementations;
+TYPED_TEST_CASE(mri_core_coil_map_test, cpfloatImplementations);
+
+TYPED_TEST(mri_core_coil_map_test, Inati2D)
+{
+    hoNDArray<TypeParam> data, ref, coilMap;
+    this->simulate(37, 29, 1, 6, data);
+    this->reference(data, 7, 1, 3, ref);
+
+    data.squeeze();
+    coil_map_2d_Inati(data, coilMap, 7, 3);
+    ref.reshape(coilMap.get_dimensions());
+
+    EXPECT_LE(this->max_diff(coilMap, ref), 1e-4);
+}
+
+TYPED_TEST(mri_core_coil_map_test, Inati3D)
+{
+    hoNDArray<TypeParam> data, ref, coilMap;
+    this->simulate(24, 19, 11, 5, data);
+    this->reference(data, 5, 3, 3, ref);
+
+    coil_map_3d_Inati(data, coilMap, 5, 3, 3);
+
+    EXPECT_LE(this->max_diff(coilMap, ref), 1e-4);
+}
+
+TYPED_TEST(mri_core_coil_map_test, InatiSmallImage)
+{
+    // the window is larger than the image and wraps around more than once
+    hoNDArray<TypeParam> data, ref, coilMap;
+    this->simulate(5, 4, 3, 3, data);
+    this->reference(data, 7, 5, 2, ref);
+
+    coil_map_3d_Inati(data, coilMap, 7, 5, 2);
+
+    EXPECT_LE(this->max_diff(coilMap, ref), 1e-4);
+}
+
+TYPED_TEST(mri_core_coil_map_test, InatiN)
+{
+    // [RO E1 E2 CHA N], every N is estimated on its own
+    hoNDArray<TypeParam> data, ref, coilMap;
+    this->simulate(32, 26, 1, 4, data);
+    this->reference(data, 7, 1, 3, ref);
+
+    hoNDArray<TypeParam> dataN(32, 26, 1, 4, 3);
+    for (size_t n = 0; n < 3; n++)
+    {
+        memcpy(&dataN(0, 0, 0, 0, n), data.begin(), data.get_number_of_bytes());
+    }
+
+    coil_map_Inati(dataN, coilMap, 7, 5, 3);
+
+    for (size_t n = 0; n < 3; n++)
+    {
+        hoNDArray<TypeParam> cmap(32, 26, 1, 4, &coilMap(0, 0, 0, 0, n));
+        EXPECT_LE(this->max_diff(cmap, ref), 1e-4);
+    }
+}
@@ -0,0 +1,117 @@
+#include "mri_core_grappa.h"
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+#include <algorithm>
+
+using namespace Gadgetron;
+using testing::Types;
+
+template<typename REAL> class mri_core_grappa_test : public ::testing::Test {
+protected:
+    virtual void SetUp(){
+        boost::random::mt19937 rng;
+        boost::random::uniform_real_distribution<REAL> uni(-1,1);
+
+        // odd RO*E1 exercises the remainder of the vectorized loops, N exercises the image blocks
+        RO = 37;
+        E1 = 29;
+        CHA = 9;
+        N = 7;
+
+        aliasedIm.create(RO, E1, CHA, N);
+        unmixCoeff.create(RO, E1, CHA);
+
+        for (size_t i = 0; i < aliasedIm.get_number_of_elements(); i++)
+            aliasedIm[i] = std::complex<REAL>(uni(rng), uni(rng));
+        for (size_t i = 0; i < unmixCoeff.get_number_of_elements(); i++)
+            unmixCoeff[i] = std::complex<REAL>(uni(rng), uni(rng));
+    }
+
+    size_t RO, E1, CHA, N;
+    hoNDArray<std::complex<REAL> > aliasedIm;
+    hoNDArray<std::complex<REAL> > unmixCoeff;
+};
+
+typedef Types<float, double> realImplementations;
+TYPED_TEST_CASE(mri_core_grappa_test, realImplementations);
+
+TYPED_TEST(mri_core_grappa_test, apply_unmix_coeff_aliased_image){
+    hoNDArray<std::complex<TypeParam> > complexIm;
+    apply_unmix_coeff_aliased_image(this->aliasedIm, this->unmixCoeff, complexIm);
+
+    EXPECT_EQ(complexIm.get_size(0), this->RO);
+    EXPECT_EQ(complexIm.get_size(1), this->E1);
+    EXPECT_EQ(complexIm.get_size(2), 1u);
+    EXPECT_EQ(complexIm.get_size(3), this->N);
+
+    size_t pixels = this->RO*this->E1;
+    for (size_t n = 0; n < this->N; n++) {
+        for (size_t p = 0; p < pixels; p++) {
+            std::complex<TypeParam> v(0);
+            for (size_t cha = 0; cha < this->CHA; cha++)
+                v += this->aliasedIm[n*pixels*this->CHA + cha*pixels + p] * this->unmixCoeff[cha*pixels + p];
+
+            EXPECT_NEAR(v.real(), complexIm[n*pixels + p].real(), 1e-4);
+            EXPECT_NEAR(v.imag(), complexIm[n*pixels + p].imag(), 1e-4);
+        }
+    }
+}
+
+TYPED_TEST(mri_core_grappa_test, apply_unmix_coeff_multiple_images_channel_subset){
+    // images hold more channels than the coefficients use, as in GenericReconCartesianGrappaGadget
+    size_t pixels = this->RO*this->E1;
+    size_t usedCHA = this->CHA - 2;
+
+    hoNDArray<std::complex<TypeParam> > complexIm(this->RO, this->E1, this->N);
+    apply_unmix_coeff_multiple_images(this->aliasedIm.begin(), pixels*this->CHA, this->unmixCoeff.begin(), pixels, usedCHA, this->N, complexIm.begin(), pixels);
+
+    for (size_t n = 0; n < this->N; n++) {
+        for (size_t p = 0; p < pixels; p++) {
+            std::complex<TypeParam> v(0);
+            for (size_t cha = 0; cha < usedCHA; cha++)
+                v += this->aliasedIm[n*pixels*this->CHA + cha*pixels + p] * this->unmixCoeff[cha*pixels + p];
+
+            EXPECT_NEAR(v.real(), complexIm[n*pixels + p].real(), 1e-4);
+            EXPECT_NEAR(v.imag(), complexIm[n*pixels + p].imag(), 1e-4);
+        }
+    }
+}
+
+TYPED_TEST(mri_core_grappa_test, apply_unmix_coeff_multiple_groups){
+    // frames 0 and 1 have their own coefficients, the remaining frames share the last ones, as for ref_N < N
+    size_t pixels = this->RO*this->E1;
+    size_t numGroups = 3;
+
+    boost::random::mt19937 rng(7);
+    boost::random::uniform_real_distribution<TypeParam> uni(-1,1);
+
+    hoNDArray<std::complex<TypeParam> > coeff(this->RO, this->E1, this->CHA, numGroups);
+    for (size_t i = 0; i < coeff.get_number_of_elements(); i++)
+        coeff[i] = std::complex<TypeParam>(uni(rng), uni(rng));
+
+    std::vector<const std::complex<TypeParam>*> pIm, pCoeff;
+    std::vector<std::complex<TypeParam>*> pRes;
+    std::vector<size_t> num;
+
+    hoNDArray<std::complex<TypeParam> > complexIm(this->RO, this->E1, this->N);
+    for (size_t g = 0; g < numGroups; g++) {
+        pIm.push_back(this->aliasedIm.begin() + g*pixels*this->CHA);
+        pCoeff.push_back(coeff.begin() + g*pixels*this->CHA);
+        pRes.push_back(complexIm.begin() + g*pixels);
+        num.push_back((g + 1 == numGroups) ? this->N - g : 1);
+    }
+
+    apply_unmix_coeff_multiple_groups(pIm, pixels*this->CHA, pCoeff, pixels, this->CHA, num, pRes, pixels);
+
+    for (size_t n = 0; n < this->N; n++) {
+        size_t g = std::min(n, numGroups - 1);
+        for (size_t p = 0; p < pixels; p++) {
+            std::complex<TypeParam> v(0);
+            for (size_t cha = 0; cha < this->CHA; cha++)
+                v += this->aliasedIm[n*pixels*this->CHA + cha*pixels + p] * coeff[g*pixels*this->CHA + cha*pixels + p];
+
+            EXPECT_NEAR(v.real(), complexIm[n*pixels + p].real(), 1e-4);
+            EXPECT_NEAR(v.imag(), complexIm[n*pixels + p].imag(), 1e-4);
+        }
+    }
+}
@@ -185,3 +185,56 @@ TYPED_TEST(pattern_recognition_test, kmeans_test)
 
     EXPECT_LE( std::sqrt(sumD) / N, 2.0);
 }
+
+TYPED_TEST(pattern_recognition_test, kmeans_mini_batch_test)
+{
+    std::default_random_engine generator;
+    std::normal_distribution<float> distribution(0.0f, 1.0f);
+
+    size_t P = 3;
+    size_t N = 40000;
+    size_t K = 4;
+
+    hoNDArray<float> X;
+    X.create(P, N);
+
+    size_t n, p;
+    for (n = 0; n < N; n++)
+    {
+        for (p = 0; p < P; p++)
+        {
+            X(p, n) = distribution(generator) + ((p == (n % K) % P) ? 8.0f : 0.0f) + ((n % K) == 3 ? -8.0f : 0.0f);
+        }
+    }
+
+    Gadgetron::kmeans<float> km;
+    km.max_iter_ = 100;
+    km.replicates_ = 1;
+    km.random_seed_ = 7;
+
+    hoNDArray<float> C_for_initial;
+    km.get_initial_guess_kmeansplusplus(X, K, C_for_initial);
+
+    std::vector<size_t> IDX;
+    hoNDArray<float> C;
+    float sumD;
+    km.run(X, K, C_for_initial, IDX, C, sumD);
+
+    km.mini_batch_size_ = 500;
+
+    std::vector<size_t> IDX_mini_batch;
+    hoNDArray<float> C_mini_batch;
+    float sumD_mini_batch;
+    km.run(X, K, C_for_initial, IDX_mini_batch, C_mini_batch, sumD_mini_batch);
+
+    EXPECT_LE(sumD_mini_batch, 1.05f * sumD);
+
+    // the same seed gives the same clustering
+    std::vector<size_t> IDX_repeated;
+    hoNDArray<float> C_repeated;
+    float sumD_repeated;
+    km.run(X, K, C_for_initial, IDX_repeated, C_repeated, sumD_repeated);
+
+    EXPECT_EQ(sumD_mini_batch, sumD_repeated);
+    EXPECT_TRUE(IDX_mini_batch == IDX_repeated);
+}
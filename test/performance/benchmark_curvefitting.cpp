@@ -11,6 +11,7 @@
 #include "twoParaExpDecayOperator.h"
 #include "twoParaExpRecoveryOperator.h"
 #include "curveFittingCostFunction.h"
+#include "batchedExpFittingSolver.h"
 #include "cmr_t1_mapping.h"
 #include <gtest/gtest.h>
 #include <boost/random.hpp>
@@ -247,9 +248,42 @@ void time_gadgetron(){
     std::cout << "Fitting tookz " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << std::endl;
     std::cout << "Best cost " << best_cost << " " << b[0] << " " << b[1] <<  std::endl;
 }
+void time_batched(){
+
+    // the same curve for every pixel, samples stored as [ITERATIONS N]
+    std::vector<float> y = {178, 185, 182, 189, 178, 180, 187, 179, 177, 177, 471};
+    auto x = std::vector<float>(11, 545);
+    x[10] = 10000;
+
+    std::vector<float> data(ITERATIONS*y.size());
+    for (size_t n = 0; n < y.size(); n++)
+        std::fill(data.begin() + n*ITERATIONS, data.begin() + (n + 1)*ITERATIONS, y[n]);
+
+    std::vector<float> paras(ITERATIONS * 2);
+
+    Gadgetron::batchedExpFittingSolver<float> solver(Gadgetron::EXP_RECOVERY_TWO_PARA, 150, 1e-6);
+
+    auto start = std::chrono::system_clock::now();
+    solver.solve(x.data(), x.size(), data.data(), ITERATIONS, ITERATIONS, paras.data(), ITERATIONS);
+    auto end = std::chrono::system_clock::now();
+
+    typedef Gadgetron::twoParaExpRecoveryOperator<std::vector<float> > SignalType;
+    typedef Gadgetron::leastSquareErrorCostFunction<std::vector<float> > CostType;
+
+    SignalType t1_sr;
+    CostType lse;
+
+    std::vector<float> b = {paras[0], paras[ITERATIONS]};
+    std::vector<float> result;
+    t1_sr.magnitude(x, b, result);
+
+    std::cout << "Fitting tookz " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << std::endl;
+    std::cout << "Best cost " << lse.eval(y, result) << " " << b[0] << " " << b[1] <<  std::endl;
+}
 using namespace Gadgetron;
 int main(){
     time_gadgetron();
+    time_batched();
     time_dlib();
     time_ceres();
 }
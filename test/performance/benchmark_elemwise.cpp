@@ -0,0 +1,69 @@
+//
+// Memory bandwidth of the complex element-wise functions for every instruction set the CPU supports
+//
+
+#include "hoNDArray_elemwise.h"
+#include "hoNDArray_elemwise_simd.h"
+#include <boost/random.hpp>
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+#define ITERATIONS 20
+
+using namespace Gadgetron;
+
+typedef std::complex<float> T;
+
+static void fill_random(hoNDArray<T>& a)
+{
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (size_t i = 0; i < a.get_number_of_elements(); i++) a[i] = T(dist(rng), dist(rng));
+}
+
+// bytes is the memory traffic of one call
+static void time_op(const std::string& name, size_t bytes, std::function<void()> op)
+{
+    op();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) op();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1e6 / ITERATIONS;
+    std::cout << "    " << name << " : " << bytes / seconds / 1e9 << " GB/s" << std::endl;
+}
+
+static void time_elemwise(size_t N)
+{
+    hoNDArray<T> x(N), y(N), r(N);
+    hoNDArray<float> a(N);
+    fill_random(x);
+    fill_random(y);
+    fill_random(r);
+
+    const size_t c = N * sizeof(T);
+    const size_t f = N * sizeof(float);
+
+    for (int isa = 0; isa <= int(simd::supported_isa()); isa++) {
+        simd::set_isa(simd::ISA(isa));
+        std::cout << "N " << N << ", " << simd::isa_name(simd::get_isa()) << std::endl;
+
+        time_op("multiply              ", 3 * c, [&]() { Gadgetron::multiply(x, y, r); });
+        time_op("multiplyConj          ", 3 * c, [&]() { Gadgetron::multiplyConj(x, y, r); });
+        time_op("multiplyConjAccumulate", 4 * c, [&]() { Gadgetron::multiplyConjAccumulate(x, y, r); });
+        time_op("axpy                  ", 3 * c, [&]() { Gadgetron::axpy(T(0.5f, -0.25f), x, y, r); });
+        time_op("conjugate             ", 2 * c, [&]() { Gadgetron::conjugate(x, r); });
+        time_op("abs                   ", c + f, [&]() { Gadgetron::abs(x, a); });
+    }
+
+    simd::set_isa(simd::supported_isa());
+}
+
+int main()
+{
+    // in cache, and in memory
+    time_elemwise(16 * 1024);
+    time_elemwise(16 * 1024 * 1024);
+}
@@ -0,0 +1,124 @@
+//
+// Compares the tiled GRAPPA unmixing kernel with the multiply and sum_over_dimension path it replaced,
+// and the single call for all groups of frames with a parallel loop over the groups
+//
+
+#include "hoNDArray_elemwise.h"
+#include "hoNDArray_reductions.h"
+#include "mri_core_grappa.h"
+#include <boost/random.hpp>
+#include <chrono>
+#include <iostream>
+
+#define ITERATIONS 10
+
+using namespace Gadgetron;
+
+typedef std::complex<float> T;
+
+static void fill_random(hoNDArray<T>& a)
+{
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (size_t i = 0; i < a.get_number_of_elements(); i++) a[i] = T(dist(rng), dist(rng));
+}
+
+static void time_unmixing(size_t RO, size_t E1, size_t CHA, size_t N)
+{
+    hoNDArray<T> aliasedIm(RO, E1, CHA, N);
+    hoNDArray<T> unmixCoeff(RO, E1, CHA);
+    fill_random(aliasedIm);
+    fill_random(unmixCoeff);
+
+    hoNDArray<T> resOld(RO, E1, 1, N), resNew(RO, E1, 1, N);
+
+    // one frame at a time through the element-wise functions
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        hoNDArray<T> buffer(RO, E1, CHA);
+        for (size_t n = 0; n < N; n++) {
+            hoNDArray<T> im(RO, E1, CHA, aliasedIm.begin() + n*RO*E1*CHA);
+            hoNDArray<T> res(RO, E1, 1, resOld.begin() + n*RO*E1);
+            Gadgetron::multiply(im, unmixCoeff, buffer);
+            Gadgetron::sum_over_dimension(buffer, res, 2);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double old_ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / ITERATIONS;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        Gadgetron::apply_unmix_coeff_multiple_images(aliasedIm.begin(), RO*E1*CHA, unmixCoeff.begin(), RO*E1, CHA, N, resNew.begin(), RO*E1);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double new_ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / ITERATIONS;
+
+    double max_diff = 0;
+    for (size_t i = 0; i < resOld.get_number_of_elements(); i++) {
+        max_diff = std::max(max_diff, (double)std::abs(resOld[i] - resNew[i]));
+    }
+
+    std::cout << "RO " << RO << " E1 " << E1 << " CHA " << CHA << " N " << N
+              << " : multiply/sum " << old_ms << " ms, tiled " << new_ms << " ms, speedup " << old_ms / new_ms
+              << ", max difference " << max_diff << std::endl;
+}
+
+// SLC slices of N frames, every slice has its own coefficients, as in GenericReconCartesianGrappaGadget with ref_N == 1
+static void time_unmixing_groups(size_t RO, size_t E1, size_t CHA, size_t N, size_t SLC)
+{
+    hoNDArray<T> aliasedIm(RO, E1, CHA, N, SLC);
+    hoNDArray<T> unmixCoeff(RO, E1, CHA, SLC);
+    fill_random(aliasedIm);
+    fill_random(unmixCoeff);
+
+    hoNDArray<T> resOld(RO, E1, 1, N, SLC), resNew(RO, E1, 1, N, SLC);
+
+    // parallel over the slices, the tile loop of each call is nested and runs serially
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        long long slc;
+#pragma omp parallel for private(slc) shared(aliasedIm, unmixCoeff, resOld, RO, E1, CHA, N, SLC)
+        for (slc = 0; slc < (long long)SLC; slc++) {
+            Gadgetron::apply_unmix_coeff_multiple_images(aliasedIm.begin() + slc*RO*E1*CHA*N, RO*E1*CHA, unmixCoeff.begin() + slc*RO*E1*CHA, RO*E1, CHA, N, resOld.begin() + slc*RO*E1*N, RO*E1);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double old_ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / ITERATIONS;
+
+    std::vector<const T*> pIm, pCoeff;
+    std::vector<T*> pRes;
+    std::vector<size_t> num(SLC, N);
+    for (size_t slc = 0; slc < SLC; slc++) {
+        pIm.push_back(aliasedIm.begin() + slc*RO*E1*CHA*N);
+        pCoeff.push_back(unmixCoeff.begin() + slc*RO*E1*CHA);
+        pRes.push_back(resNew.begin() + slc*RO*E1*N);
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        Gadgetron::apply_unmix_coeff_multiple_groups(pIm, RO*E1*CHA, pCoeff, RO*E1, CHA, num, pRes, RO*E1);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double new_ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / ITERATIONS;
+
+    double max_diff = 0;
+    for (size_t i = 0; i < resOld.get_number_of_elements(); i++) {
+        max_diff = std::max(max_diff, (double)std::abs(resOld[i] - resNew[i]));
+    }
+
+    std::cout << "RO " << RO << " E1 " << E1 << " CHA " << CHA << " N " << N << " SLC " << SLC
+              << " : parallel over slices " << old_ms << " ms, single call " << new_ms << " ms, speedup " << old_ms / new_ms
+              << ", max difference " << max_diff << std::endl;
+}
+
+int main()
+{
+    time_unmixing(192, 144, 32, 1);
+    time_unmixing(192, 144, 32, 8);
+    time_unmixing(256, 256, 64, 1);
+    time_unmixing(256, 256, 64, 8);
+    time_unmixing(320, 256, 96, 16);
+
+    time_unmixing_groups(192, 144, 32, 30, 10);
+    time_unmixing_groups(256, 256, 64, 8, 3);
+}
@@ -4,6 +4,7 @@
 #include "ismrmrd/ismrmrd.h"
 #include "hoNDArray_utils.h"
 #include "hoNDArray_elemwise.h"
+#include "GadgetContainerMessage.h"
 
 using namespace Gadgetron;
 using testing::Types;
@@ -701,3 +702,53 @@ TEST_F(python_converter_test, ismrmrd_recon_data)
         EXPECT_EQ(array_data.rbit_[0].data_.headers_(2, 2, 0).version, 123);
     }
 }
+
+TEST_F(python_converter_test, numpy_view_of_message)
+{
+    GDEBUG_STREAM(" --------------------------------------------------------------------------------------------------");
+    GDEBUG_STREAM("Test the NumPy views of the data of a message");
+    initialize_python();
+    register_converter< hoNDArray<float> >();
+
+    GILLock gl;     // this is needed
+    boost::python::object main(boost::python::import("__main__"));
+    boost::python::object global(main.attr("__dict__"));
+    boost::python::exec("import numpy as np\n"
+        "def keep_view(a): \n"
+        "   global kept\n"
+        "   kept = a\n"
+        "   return a.ctypes.data\n"
+        "def view_item(i, j): \n"
+        "   return float(kept[i, j])\n"
+        "def sum_view(): \n"
+        "   return float(np.sum(kept))\n"
+        "def drop_view(): \n"
+        "   global kept\n"
+        "   del kept\n",
+        global, global);
+
+    GadgetContainerMessage< hoNDArray<float> >* m = new GadgetContainerMessage< hoNDArray<float> >();
+    m->getObjectPtr()->create(16, 8);
+    float* data = m->getObjectPtr()->get_data_ptr();
+    for (size_t n = 0; n < 128; n++) data[n] = float(n);
+
+    ACE_Data_Block* block = m->data_block();
+
+    {
+        // the view aliases the data of the message
+        boost::python::object view = to_python_views(m);
+        size_t address = boost::python::extract<size_t>(global["keep_view"](view));
+        EXPECT_EQ(address, size_t(data));
+        EXPECT_EQ(block->reference_count(), 2);
+    }
+
+    data[5 + 16*2] = 1000;
+    EXPECT_FLOAT_EQ(boost::python::extract<float>(global["view_item"](5, 2)), 1000);
+
+    // Python keeps the data alive after the message is released
+    m->release();
+    EXPECT_EQ(block->reference_count(), 1);
+    EXPECT_FLOAT_EQ(boost::python::extract<float>(global["sum_view"]()), 127*128/2 - 37 + 1000);
+
+    global["drop_view"]();
+}
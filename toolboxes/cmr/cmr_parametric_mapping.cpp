@@ -182,6 +182,8 @@ CmrParametricMapping<T>::CmrParametricMapping()
 
     compute_SD_maps_ = false;;
 
+    batched_fitting_ = false;
+
     max_iter_ = 50;
     max_fun_eval_ = 100;
     thres_fun_ = 1e-5;
@@ -255,6 +257,15 @@ void CmrParametricMapping<T>::perform_parametric_mapping()
             if (!debug_folder_.empty()) gt_exporter_.export_array(this->mask_for_mapping_, debug_folder_ + "CmrParametricMapping_mask_for_mapping");
         }
 
+        batchedExpFittingModel model = EXP_RECOVERY_TWO_PARA;
+        bool batched = this->batched_fitting_ && this->get_batched_fitting_model(model);
+
+        batchedExpFittingSolver<T> solver(model, max_iter_, thres_fun_);
+        if (batched)
+        {
+            GADGET_CHECK_THROW(solver.get_num_of_paras() == NUM);
+        }
+
         if (this->perform_timing_) { gt_timer_.start("perform pixel-wise mapping ... "); }
 
         long long ro, e1;
@@ -282,7 +293,13 @@ void CmrParametricMapping<T>::perform_parametric_mapping()
                     pMaskCurr = pMask + s*RO*E1 + slc*S*RO*E1;
                 }
 
-#pragma omp parallel private(e1, ro, n) shared(RO, E1, pMask, pMaskCurr, pData, pMap, pMapSD, pPara, pParaSD, num_ti, NUM)
+                // fit all pixels of the image, the loop below only fills in the map
+                if (batched)
+                {
+                    solver.solve(&ti_[0], num_ti, pData, RO*E1, RO*E1, pPara, RO*E1, pMaskCurr);
+                }
+
+#pragma omp parallel private(e1, ro, n) shared(RO, E1, pMask, pMaskCurr, pData, pMap, pMapSD, pPara, pParaSD, num_ti, NUM, batched)
                 {
                     std::vector<T> yi(num_ti, 0);
                     std::vector<T> guess(NUM + 1, 0);
@@ -305,21 +322,45 @@ void CmrParametricMapping<T>::perform_parametric_mapping()
                             }
 
                             // get data vector
-                            for (n = 0; n < num_ti; n++)
+                            if (!batched || this->compute_SD_maps_)
                             {
-                                yi[n] = pData[offset + n*RO*E1];
+                                for (n = 0; n < num_ti; n++)
+                                {
+                                    yi[n] = pData[offset + n*RO*E1];
+                                }
                             }
 
-                            // estimate initial para
-                            this->get_initial_guess(ti_, yi, guess);
+                            if (batched)
+                            {
+                                bi.resize(NUM);
+                                for (n = 0; n < NUM; n++)
+                                {
+                                    bi[n] = pPara[offset + n*RO*E1];
+                                }
 
-                            // perform mapping
-                            this->compute_map(ti_, yi, guess, bi, map_v);
+                                map_v = 0;
+                                if (bi[0] > 0 && bi[NUM - 1] > 0)
+                                {
+                                    map_v = bi[NUM - 1];
+                                    if (map_v >= max_map_value_) map_v = hole_marking_value_;
+                                    if (map_v <= min_map_value_) map_v = hole_marking_value_;
+                                }
 
-                            pMap[offset] = map_v;
-                            for (n = 0; n < NUM; n++)
+                                pMap[offset] = map_v;
+                            }
+                            else
                             {
-                                pPara[offset + n*RO*E1] = bi[n];
+                                // estimate initial para
+                                this->get_initial_guess(ti_, yi, guess);
+
+                                // perform mapping
+                                this->compute_map(ti_, yi, guess, bi, map_v);
+
+                                pMap[offset] = map_v;
+                                for (n = 0; n < NUM; n++)
+                                {
+                                    pPara[offset + n*RO*E1] = bi[n];
+                                }
                             }
 
                             // compute SD if needed
@@ -519,6 +560,12 @@ size_t CmrParametricMapping<T>::get_num_of_paras() const
     return 1;
 }
 
+template <typename T>
+bool CmrParametricMapping<T>::get_batched_fitting_model(batchedExpFittingModel& model) const
+{
+    return false;
+}
+
 // ------------------------------------------------------------
 // Instantiation
 // ------------------------------------------------------------
@@ -17,6 +17,7 @@
 #include "mri_core_utility.h"
 #include "hoNDImageContainer2D.h"
 #include "hoMRImage.h"
+#include "batchedExpFittingSolver.h"
 
 namespace Gadgetron { 
 
@@ -70,6 +71,11 @@ namespace Gadgetron {
         /// if empty, every pixel is inputted for mapping
         hoNDArray<T> mask_for_mapping_;
 
+        /// whether to fit the pixels in batches with batchedExpFittingSolver, if get_batched_fitting_model provides the signal model
+        /// the batched fitting estimates its own initial guess instead of calling get_initial_guess and compute_map
+        /// the map is the last parameter, and is valid if it and the first parameter are positive
+        bool batched_fitting_;
+
         // ======================================================================================
         /// parameter for mapping
         // ======================================================================================
@@ -142,5 +148,8 @@ namespace Gadgetron {
 
         /// return number of parameters, including the map itself
         virtual size_t get_num_of_paras() const;
+
+        /// signal model for batched fitting; return false if the mapping has no batched implementation
+        virtual bool get_batched_fitting_model(batchedExpFittingModel& model) const;
     };
 }
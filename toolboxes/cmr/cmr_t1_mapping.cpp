@@ -155,6 +155,13 @@ size_t CmrT1SRMapping<T>::get_num_of_paras() const
     return 2; // A and T1
 }
 
+template <typename T>
+bool CmrT1SRMapping<T>::get_batched_fitting_model(batchedExpFittingModel& model) const
+{
+    model = EXP_RECOVERY_TWO_PARA;
+    return true;
+}
+
 // ------------------------------------------------------------
 // Instantiation
 // ------------------------------------------------------------
@@ -52,6 +52,9 @@ public:
     /// two parameters, A, T1
     virtual size_t get_num_of_paras() const;
 
+    /// batched fitting uses the same signal model
+    virtual bool get_batched_fitting_model(batchedExpFittingModel& model) const;
+
     // ======================================================================================
     /// parameter from BaseClass
     // ======================================================================================
@@ -61,6 +64,7 @@ public:
     using BaseClass::hole_marking_value_;
     using BaseClass::compute_SD_maps_;
     using BaseClass::mask_for_mapping_;
+    using BaseClass::batched_fitting_;
     using BaseClass::ti_;
     using BaseClass::data_;
     using BaseClass::map_;
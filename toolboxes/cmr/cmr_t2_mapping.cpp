@@ -192,6 +192,13 @@ size_t CmrT2Mapping<T>::get_num_of_paras() const
     return 2; // A and T2
 }
 
+template <typename T>
+bool CmrT2Mapping<T>::get_batched_fitting_model(batchedExpFittingModel& model) const
+{
+    model = EXP_DECAY_TWO_PARA;
+    return true;
+}
+
 // ------------------------------------------------------------
 // Instantiation
 // ------------------------------------------------------------
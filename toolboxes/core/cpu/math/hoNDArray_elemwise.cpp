@@ -3,6 +3,7 @@
 #include "complext.h"
 #include "hoArmadillo.h"
 #include "cpp_blas.h"
+#include "hoNDArray_elemwise_simd.h"
 
 #ifdef USE_OMP
     #include <omp.h>
@@ -366,6 +367,64 @@ namespace Gadgetron{
 
     }
 
+    // calls f(offset_x, offset_y, n) for contiguous parts of an array of sizeX elements, in which y of sizeY elements
+    // is repeated; the parts are split over the threads in the same way as the broadcasting loops above
+    template <typename F>
+    void simd_loop(size_t sizeX, size_t sizeY, F f)
+    {
+      const long long blocksize = 16*1024;
+
+      // empty arrays, nothing to do and sizeY must not be divided by
+      if (sizeX==0 || sizeY==0) return;
+
+      long long outerloopsize = sizeX/sizeY;
+      long long innerloopsize = sizeY;
+      if (sizeX<NumElementsUseThreading) {
+          // No OMP at All
+          for (long long outer=0; outer<outerloopsize; outer++) {
+              f(outer*innerloopsize, 0, innerloopsize);
+          }
+      } else if (innerloopsize>NumElementsUseThreading) {
+          // OMP over blocks of the inner loop
+          long long numblocks = (innerloopsize+blocksize-1)/blocksize;
+          for (long long outer=0; outer<outerloopsize; outer++) {
+              long long block;
+#ifdef USE_OMP
+#pragma omp parallel for private(block) shared(numblocks, innerloopsize, outer, f)
+#endif
+              for (block=0; block<numblocks; block++) {
+                  long long start = block*blocksize;
+                  f(outer*innerloopsize+start, start, std::min(blocksize, innerloopsize-start));
+              }
+          }
+      } else {
+          // OMP in the outer loop
+          long long outer;
+#ifdef USE_OMP
+#pragma omp parallel for private(outer) shared(outerloopsize, innerloopsize, f)
+#endif
+          for (outer=0; outer<outerloopsize; outer++) {
+              f(outer*innerloopsize, 0, innerloopsize);
+          }
+      }
+    }
+
+    // std::complex<float> and complext<float> use the vectorized kernels; compilers do not vectorize the complex
+    // product because of the nan and inf handling the standard requires
+    void multiply_impl(size_t sizeX, size_t sizeY, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+    {
+      if (sizeY>sizeX) {
+          throw std::runtime_error("Multiply cannot broadcast when the size of x is less than the size of y.");
+      }
+
+      simd_loop(sizeX, sizeY, [=](size_t ox, size_t oy, size_t n) { simd::multiply(n, x+ox, y+oy, r+ox); });
+    }
+
+    void multiply_impl(size_t sizeX, size_t sizeY, const complext<float>* x, const complext<float>* y, complext<float>* r)
+    {
+      multiply_impl(sizeX, sizeY, reinterpret_cast<const std::complex<float>*>(x), reinterpret_cast<const std::complex<float>*>(y), reinterpret_cast<std::complex<float>*>(r));
+    }
+
     template <class T, class S>
     void multiply(const hoNDArray<T>& x, const hoNDArray<S>& y, hoNDArray<typename mathReturnType<T,S>::type >& r)
     {
@@ -621,6 +680,20 @@ namespace Gadgetron{
 
     }
 
+    void multiplyConj_impl(size_t sizeX, size_t sizeY, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+    {
+      if (sizeY>sizeX) {
+          throw std::runtime_error("MultiplyConj cannot broadcast when the size of x is less than the size of y.");
+      }
+
+      simd_loop(sizeX, sizeY, [=](size_t ox, size_t oy, size_t n) { simd::multiplyConj(n, x+ox, y+oy, r+ox); });
+    }
+
+    void multiplyConj_impl(size_t sizeX, size_t sizeY, const complext<float>* x, const complext<float>* y, complext<float>* r)
+    {
+      multiplyConj_impl(sizeX, sizeY, reinterpret_cast<const std::complex<float>*>(x), reinterpret_cast<const std::complex<float>*>(y), reinterpret_cast<std::complex<float>*>(r));
+    }
+
     template <class T, class S>
     void multiplyConj(const hoNDArray<T>& x, const hoNDArray<S>& y, hoNDArray<typename mathReturnType<T,S>::type >& r)
     {
@@ -660,6 +733,105 @@ namespace Gadgetron{
     template EXPORTCPUCOREMATH void multiplyConj(const hoNDArray< double >& x, const hoNDArray< std::complex<double> >& y, hoNDArray< std::complex<double> >& r);
     template EXPORTCPUCOREMATH void multiplyConj(const hoNDArray< std::complex<double> >& x, const hoNDArray< std::complex<double> >& y, hoNDArray< std::complex<double> >& r);
 
+    // --------------------------------------------------------------------------------
+
+    // internal low level function for r += x * conj(y)
+    template <class T>
+    void multiplyConjAccumulate_impl(size_t N, const T* x, const T* y, T* r)
+    {
+      // cast to internal types
+      const typename mathInternalType<T>::type * a = reinterpret_cast<const typename mathInternalType<T>::type *>(x);
+      const typename mathInternalType<T>::type * b = reinterpret_cast<const typename mathInternalType<T>::type *>(y);
+      typename mathInternalType<T>::type * c = reinterpret_cast<typename mathInternalType<T>::type *>(r);
+
+      long long n;
+#ifdef USE_OMP
+#pragma omp parallel for default(none) private(n) shared(N, c, a, b) if (N>NumElementsUseThreading)
+#endif
+      for (n=0; n<(long long)N; n++)
+        {
+          c[n] += a[n]*conj(b[n]);
+        }
+    }
+
+    void multiplyConjAccumulate_impl(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+    {
+      simd_loop(N, N, [=](size_t o, size_t, size_t n) { simd::multiplyConjAccumulate(n, x+o, y+o, r+o); });
+    }
+
+    void multiplyConjAccumulate_impl(size_t N, const complext<float>* x, const complext<float>* y, complext<float>* r)
+    {
+      multiplyConjAccumulate_impl(N, reinterpret_cast<const std::complex<float>*>(x), reinterpret_cast<const std::complex<float>*>(y), reinterpret_cast<std::complex<float>*>(r));
+    }
+
+    template <class T>
+    void multiplyConjAccumulate(const hoNDArray<T>& x, const hoNDArray<T>& y, hoNDArray<T>& r)
+    {
+      if (x.get_number_of_elements()!=y.get_number_of_elements() || x.get_number_of_elements()!=r.get_number_of_elements()) {
+          throw std::runtime_error("multiplyConjAccumulate: x, y and r must have the same number of elements.");
+      }
+
+      multiplyConjAccumulate_impl(x.get_number_of_elements(), x.begin(), y.begin(), r.begin());
+    }
+
+    template EXPORTCPUCOREMATH void multiplyConjAccumulate(const hoNDArray< complext<float> >& x, const hoNDArray< complext<float> >& y, hoNDArray< complext<float> >& r);
+    template EXPORTCPUCOREMATH void multiplyConjAccumulate(const hoNDArray< complext<double> >& x, const hoNDArray< complext<double> >& y, hoNDArray< complext<double> >& r);
+    template EXPORTCPUCOREMATH void multiplyConjAccumulate(const hoNDArray< std::complex<float> >& x, const hoNDArray< std::complex<float> >& y, hoNDArray< std::complex<float> >& r);
+    template EXPORTCPUCOREMATH void multiplyConjAccumulate(const hoNDArray< std::complex<double> >& x, const hoNDArray< std::complex<double> >& y, hoNDArray< std::complex<double> >& r);
+
+    // --------------------------------------------------------------------------------
+
+    // internal low level function for r = a*x + y
+    template <class T>
+    void axpy_impl(size_t N, T a, const T* x, const T* y, T* r)
+    {
+      // cast to internal types
+      const typename mathInternalType<T>::type s = *reinterpret_cast<const typename mathInternalType<T>::type *>(&a);
+      const typename mathInternalType<T>::type * xi = reinterpret_cast<const typename mathInternalType<T>::type *>(x);
+      const typename mathInternalType<T>::type * yi = reinterpret_cast<const typename mathInternalType<T>::type *>(y);
+      typename mathInternalType<T>::type * c = reinterpret_cast<typename mathInternalType<T>::type *>(r);
+
+      long long n;
+#ifdef USE_OMP
+#pragma omp parallel for default(none) private(n) shared(N, c, s, xi, yi) if (N>NumElementsUseThreading)
+#endif
+      for (n=0; n<(long long)N; n++)
+        {
+          c[n] = s*xi[n] + yi[n];
+        }
+    }
+
+    void axpy_impl(size_t N, std::complex<float> a, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+    {
+      simd_loop(N, N, [=](size_t o, size_t, size_t n) { simd::axpy(n, a, x+o, y+o, r+o); });
+    }
+
+    void axpy_impl(size_t N, complext<float> a, const complext<float>* x, const complext<float>* y, complext<float>* r)
+    {
+      axpy_impl(N, std::complex<float>(a.real(), a.imag()), reinterpret_cast<const std::complex<float>*>(x), reinterpret_cast<const std::complex<float>*>(y), reinterpret_cast<std::complex<float>*>(r));
+    }
+
+    template <typename T>
+    void axpy(T a, const hoNDArray<T>& x, const hoNDArray<T>& y, hoNDArray<T>& r)
+    {
+      if (x.get_number_of_elements()!=y.get_number_of_elements()) {
+          throw std::runtime_error("axpy: x and y have different number of elements.");
+      }
+
+      if (r.get_number_of_elements()!=x.get_number_of_elements()) {
+          r.create(x.get_dimensions());
+      }
+
+      axpy_impl(x.get_number_of_elements(), a, x.begin(), y.begin(), r.begin());
+    }
+
+    template EXPORTCPUCOREMATH void axpy(float a, const hoNDArray<float>& x, const hoNDArray<float>& y, hoNDArray<float>& r);
+    template EXPORTCPUCOREMATH void axpy(double a, const hoNDArray<double>& x, const hoNDArray<double>& y, hoNDArray<double>& r);
+    template EXPORTCPUCOREMATH void axpy(complext<float> a, const hoNDArray< complext<float> >& x, const hoNDArray< complext<float> >& y, hoNDArray< complext<float> >& r);
+    template EXPORTCPUCOREMATH void axpy(complext<double> a, const hoNDArray< complext<double> >& x, const hoNDArray< complext<double> >& y, hoNDArray< complext<double> >& r);
+    template EXPORTCPUCOREMATH void axpy(std::complex<float> a, const hoNDArray< std::complex<float> >& x, const hoNDArray< std::complex<float> >& y, hoNDArray< std::complex<float> >& r);
+    template EXPORTCPUCOREMATH void axpy(std::complex<double> a, const hoNDArray< std::complex<double> >& x, const hoNDArray< std::complex<double> >& y, hoNDArray< std::complex<double> >& r);
+
 
     // --------------------------------------------------------------------------------
 
@@ -675,6 +847,14 @@ namespace {
             reinterpret_cast<REAL (&)[2]>(r[n])[1] = -(reinterpret_cast<const REAL (&)[2]>(x[n])[1]);
         }
     }
+
+    inline void conjugate(size_t N, const std::complex<float> *x, std::complex<float> *r) {
+        simd_loop(N, N, [=](size_t o, size_t, size_t n) { simd::conjugate(n, x+o, r+o); });
+    }
+
+    inline void conjugate(size_t N, const complext<float> *x, complext<float> *r) {
+        conjugate(N, reinterpret_cast<const std::complex<float>*>(x), reinterpret_cast<std::complex<float>*>(r));
+    }
 }
 
     template <typename T> 
@@ -862,16 +1042,7 @@ namespace {
 
     inline void abs(size_t N, const  std::complex<float> * x, float* r)
     {
-        long long n;
-
-        #pragma omp parallel for default(none) private(n) shared(N, x, r) if (N>NumElementsUseThreading)
-        for ( n=0; n<(long long)N; n++ )
-        {
-            const  std::complex<float> & c = x[n];
-            const float re = c.real();
-            const float im = c.imag();
-            r[n]= std::sqrt( (re*re) + (im * im) );
-        }
+        simd_loop(N, N, [=](size_t o, size_t, size_t n) { simd::abs(n, x+o, r+o); });
     }
 
     inline void abs(size_t N, const  std::complex<double> * x, double* r)
@@ -890,16 +1061,7 @@ namespace {
 
     void abs(size_t N, const complext<float> * x, float* r)
     {
-        long long n;
-
-        #pragma omp parallel for private(n) shared(N, x, r) if (N>NumElementsUseThreading)
-        for ( n=0; n<(long long)N; n++ )
-        {
-            const  complext<float> & c = x[n];
-            const float re = c.real();
-            const float im = c.imag();
-            r[n]= std::sqrt( (re*re) + (im * im) );
-        }
+        abs(N, reinterpret_cast<const std::complex<float>*>(x), r);
     }
 
     void abs(size_t N, const complext<double> * x, double* r)
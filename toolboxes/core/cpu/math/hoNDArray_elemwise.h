@@ -84,6 +84,8 @@ namespace Gadgetron{
   //
   template<class T,class S> bool compatible_dimensions( const hoNDArray<T> &x, const hoNDArray<S> &y )
   {
+      // an empty y is only compatible with an empty x
+      if (y.get_number_of_elements()==0) return (x.get_number_of_elements()==0);
       return ((x.get_number_of_elements()%y.get_number_of_elements())==0);
   }
 
@@ -102,6 +104,9 @@ namespace Gadgetron{
       if (nx == ny) {
           return (nx==nr);
       }
+      if (nx==0 || ny==0) {
+          return false;
+      }
       if ((nx%ny)==0) {
           return (nx==nr);
       }
@@ -193,6 +198,13 @@ void multiplyConj(const hoNDArray<T>* x, const hoNDArray<S>* y, hoNDArray<typena
 }
 
 
+/**
+* @brief r += x * conj(y)
+  x, y and r have the same number of elements
+*/
+template <class T> EXPORTCPUCOREMATH
+void multiplyConjAccumulate(const hoNDArray<T>& x, const hoNDArray<T>& y, hoNDArray<T>& r);
+
 /**
 * @brief r = conj(x)
 */
@@ -664,6 +676,12 @@ template<class T> void axpy(T a, const hoNDArray<T> *x, hoNDArray<T> *y ){ BLAS:
 */
 template <typename T> void axpy(T a, const hoNDArray<T>& x, hoNDArray<T>& y){ axpy(a,&x,&y);}
 
+/**
+* @brief compute r = a*x + y
+  support in-place computation, e.g. y==r
+*/
+template <typename T> EXPORTCPUCOREMATH void axpy(T a, const hoNDArray<T>& x, const hoNDArray<T>& y, hoNDArray<T>& r);
+
 /**
 * @brief compute x *= a
 */
@@ -0,0 +1,500 @@
+#include "hoNDArray_elemwise_simd.h"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define ELEMWISE_SIMD_X86
+    #include <immintrin.h>
+#endif
+
+namespace Gadgetron
+{
+namespace simd
+{
+
+// ------------------------------------------------------------------------
+// The complex arrays are accessed as interleaved real and imaginary parts, N is the number of complex elements.
+//
+// With x = (xr, xi) and y = (yr, yi), x*y = (xr*yr - xi*yi, xi*yr + xr*yi). In a register, x is multiplied by the
+// duplicated real parts of y, and x with real and imaginary parts swapped by the duplicated imaginary parts of y;
+// an addsub of the two products gives x*y, a subadd gives x*conj(y).
+// ------------------------------------------------------------------------
+
+static void multiply_scalar(size_t N, const float* x, const float* y, float* r)
+{
+    for (size_t n = 0; n < N; n++)
+    {
+        float xr = x[2 * n], xi = x[2 * n + 1];
+        float yr = y[2 * n], yi = y[2 * n + 1];
+        r[2 * n] = xr*yr - xi*yi;
+        r[2 * n + 1] = xi*yr + xr*yi;
+    }
+}
+
+static void multiplyConj_scalar(size_t N, const float* x, const float* y, float* r)
+{
+    for (size_t n = 0; n < N; n++)
+    {
+        float xr = x[2 * n], xi = x[2 * n + 1];
+        float yr = y[2 * n], yi = y[2 * n + 1];
+        r[2 * n] = xr*yr + xi*yi;
+        r[2 * n + 1] = xi*yr - xr*yi;
+    }
+}
+
+static void multiplyConjAccumulate_scalar(size_t N, const float* x, const float* y, float* r)
+{
+    for (size_t n = 0; n < N; n++)
+    {
+        float xr = x[2 * n], xi = x[2 * n + 1];
+        float yr = y[2 * n], yi = y[2 * n + 1];
+        r[2 * n] += xr*yr + xi*yi;
+        r[2 * n + 1] += xi*yr - xr*yi;
+    }
+}
+
+static void axpy_scalar(size_t N, float ar, float ai, const float* x, const float* y, float* r)
+{
+    for (size_t n = 0; n < N; n++)
+    {
+        float xr = x[2 * n], xi = x[2 * n + 1];
+        r[2 * n] = ar*xr - ai*xi + y[2 * n];
+        r[2 * n + 1] = ar*xi + ai*xr + y[2 * n + 1];
+    }
+}
+
+static void conjugate_scalar(size_t N, const float* x, float* r)
+{
+    for (size_t n = 0; n < N; n++)
+    {
+        r[2 * n] = x[2 * n];
+        r[2 * n + 1] = -x[2 * n + 1];
+    }
+}
+
+static void abs_scalar(size_t N, const float* x, float* r)
+{
+    for (size_t n = 0; n < N; n++)
+    {
+        float xr = x[2 * n], xi = x[2 * n + 1];
+        r[n] = std::sqrt(xr*xr + xi*xi);
+    }
+}
+
+#ifdef ELEMWISE_SIMD_X86
+
+// ------------------------------------------------------------------------
+// SSE3, 2 complex values per register
+// ------------------------------------------------------------------------
+
+__attribute__((target("sse3")))
+static void multiply_sse3(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 2 <= N; n += 2)
+    {
+        __m128 a = _mm_loadu_ps(x + 2 * n);
+        __m128 b = _mm_loadu_ps(y + 2 * n);
+        __m128 as = _mm_shuffle_ps(a, a, 0xB1);
+        _mm_storeu_ps(r + 2 * n, _mm_addsub_ps(_mm_mul_ps(a, _mm_moveldup_ps(b)), _mm_mul_ps(as, _mm_movehdup_ps(b))));
+    }
+
+    multiply_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+// there is no subadd, so the imaginary parts of y are negated before the addsub
+__attribute__((target("sse3")))
+static inline __m128 multiplyConj_sse3(__m128 a, __m128 b)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 as = _mm_shuffle_ps(a, a, 0xB1);
+    return _mm_addsub_ps(_mm_mul_ps(a, _mm_moveldup_ps(b)), _mm_mul_ps(as, _mm_xor_ps(_mm_movehdup_ps(b), sign)));
+}
+
+__attribute__((target("sse3")))
+static void multiplyConj_sse3(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 2 <= N; n += 2)
+    {
+        _mm_storeu_ps(r + 2 * n, multiplyConj_sse3(_mm_loadu_ps(x + 2 * n), _mm_loadu_ps(y + 2 * n)));
+    }
+
+    multiplyConj_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("sse3")))
+static void multiplyConjAccumulate_sse3(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 2 <= N; n += 2)
+    {
+        __m128 p = multiplyConj_sse3(_mm_loadu_ps(x + 2 * n), _mm_loadu_ps(y + 2 * n));
+        _mm_storeu_ps(r + 2 * n, _mm_add_ps(_mm_loadu_ps(r + 2 * n), p));
+    }
+
+    multiplyConjAccumulate_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("sse3")))
+static void axpy_sse3(size_t N, float ar, float ai, const float* x, const float* y, float* r)
+{
+    const __m128 vr = _mm_set1_ps(ar);
+    const __m128 vi = _mm_set1_ps(ai);
+
+    size_t n = 0;
+    for (; n + 2 <= N; n += 2)
+    {
+        __m128 a = _mm_loadu_ps(x + 2 * n);
+        __m128 as = _mm_shuffle_ps(a, a, 0xB1);
+        __m128 p = _mm_addsub_ps(_mm_mul_ps(a, vr), _mm_mul_ps(as, vi));
+        _mm_storeu_ps(r + 2 * n, _mm_add_ps(p, _mm_loadu_ps(y + 2 * n)));
+    }
+
+    axpy_scalar(N - n, ar, ai, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("sse3")))
+static void conjugate_sse3(size_t N, const float* x, float* r)
+{
+    const __m128 sign = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+
+    size_t n = 0;
+    for (; n + 2 <= N; n += 2)
+    {
+        _mm_storeu_ps(r + 2 * n, _mm_xor_ps(_mm_loadu_ps(x + 2 * n), sign));
+    }
+
+    conjugate_scalar(N - n, x + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("sse3")))
+static void abs_sse3(size_t N, const float* x, float* r)
+{
+    size_t n = 0;
+    for (; n + 4 <= N; n += 4)
+    {
+        __m128 a = _mm_loadu_ps(x + 2 * n);
+        __m128 b = _mm_loadu_ps(x + 2 * n + 4);
+        __m128 s = _mm_hadd_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b));
+        _mm_storeu_ps(r + n, _mm_sqrt_ps(s));
+    }
+
+    abs_scalar(N - n, x + 2 * n, r + n);
+}
+
+// ------------------------------------------------------------------------
+// AVX2 and FMA, 4 complex values per register
+// ------------------------------------------------------------------------
+
+__attribute__((target("avx2,fma")))
+static void multiply_avx2(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 4 <= N; n += 4)
+    {
+        __m256 a = _mm256_loadu_ps(x + 2 * n);
+        __m256 b = _mm256_loadu_ps(y + 2 * n);
+        __m256 as = _mm256_permute_ps(a, 0xB1);
+        _mm256_storeu_ps(r + 2 * n, _mm256_fmaddsub_ps(a, _mm256_moveldup_ps(b), _mm256_mul_ps(as, _mm256_movehdup_ps(b))));
+    }
+
+    multiply_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx2,fma")))
+static void multiplyConj_avx2(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 4 <= N; n += 4)
+    {
+        __m256 a = _mm256_loadu_ps(x + 2 * n);
+        __m256 b = _mm256_loadu_ps(y + 2 * n);
+        __m256 as = _mm256_permute_ps(a, 0xB1);
+        _mm256_storeu_ps(r + 2 * n, _mm256_fmsubadd_ps(a, _mm256_moveldup_ps(b), _mm256_mul_ps(as, _mm256_movehdup_ps(b))));
+    }
+
+    multiplyConj_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx2,fma")))
+static void multiplyConjAccumulate_avx2(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 4 <= N; n += 4)
+    {
+        __m256 a = _mm256_loadu_ps(x + 2 * n);
+        __m256 b = _mm256_loadu_ps(y + 2 * n);
+        __m256 as = _mm256_permute_ps(a, 0xB1);
+        __m256 p = _mm256_fmsubadd_ps(a, _mm256_moveldup_ps(b), _mm256_mul_ps(as, _mm256_movehdup_ps(b)));
+        _mm256_storeu_ps(r + 2 * n, _mm256_add_ps(_mm256_loadu_ps(r + 2 * n), p));
+    }
+
+    multiplyConjAccumulate_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(size_t N, float ar, float ai, const float* x, const float* y, float* r)
+{
+    const __m256 vr = _mm256_set1_ps(ar);
+    const __m256 vi = _mm256_set1_ps(ai);
+
+    size_t n = 0;
+    for (; n + 4 <= N; n += 4)
+    {
+        __m256 a = _mm256_loadu_ps(x + 2 * n);
+        __m256 as = _mm256_permute_ps(a, 0xB1);
+        __m256 p = _mm256_fmaddsub_ps(a, vr, _mm256_mul_ps(as, vi));
+        _mm256_storeu_ps(r + 2 * n, _mm256_add_ps(p, _mm256_loadu_ps(y + 2 * n)));
+    }
+
+    axpy_scalar(N - n, ar, ai, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx2,fma")))
+static void conjugate_avx2(size_t N, const float* x, float* r)
+{
+    const __m256 sign = _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+
+    size_t n = 0;
+    for (; n + 4 <= N; n += 4)
+    {
+        _mm256_storeu_ps(r + 2 * n, _mm256_xor_ps(_mm256_loadu_ps(x + 2 * n), sign));
+    }
+
+    conjugate_scalar(N - n, x + 2 * n, r + 2 * n);
+}
+
+// hadd works within the 128 bit lanes, the permute puts the 64 bit pairs of results back in order
+__attribute__((target("avx2,fma")))
+static void abs_avx2(size_t N, const float* x, float* r)
+{
+    size_t n = 0;
+    for (; n + 8 <= N; n += 8)
+    {
+        __m256 a = _mm256_loadu_ps(x + 2 * n);
+        __m256 b = _mm256_loadu_ps(x + 2 * n + 8);
+        __m256 s = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+        s = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(s), 0xD8));
+        _mm256_storeu_ps(r + n, _mm256_sqrt_ps(s));
+    }
+
+    abs_scalar(N - n, x + 2 * n, r + n);
+}
+
+// ------------------------------------------------------------------------
+// AVX-512F, 8 complex values per register
+// ------------------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static void multiply_avx512(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 8 <= N; n += 8)
+    {
+        __m512 a = _mm512_loadu_ps(x + 2 * n);
+        __m512 b = _mm512_loadu_ps(y + 2 * n);
+        __m512 as = _mm512_shuffle_ps(a, a, 0xB1);
+        _mm512_storeu_ps(r + 2 * n, _mm512_fmaddsub_ps(a, _mm512_moveldup_ps(b), _mm512_mul_ps(as, _mm512_movehdup_ps(b))));
+    }
+
+    multiply_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx512f")))
+static void multiplyConj_avx512(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 8 <= N; n += 8)
+    {
+        __m512 a = _mm512_loadu_ps(x + 2 * n);
+        __m512 b = _mm512_loadu_ps(y + 2 * n);
+        __m512 as = _mm512_shuffle_ps(a, a, 0xB1);
+        _mm512_storeu_ps(r + 2 * n, _mm512_fmsubadd_ps(a, _mm512_moveldup_ps(b), _mm512_mul_ps(as, _mm512_movehdup_ps(b))));
+    }
+
+    multiplyConj_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx512f")))
+static void multiplyConjAccumulate_avx512(size_t N, const float* x, const float* y, float* r)
+{
+    size_t n = 0;
+    for (; n + 8 <= N; n += 8)
+    {
+        __m512 a = _mm512_loadu_ps(x + 2 * n);
+        __m512 b = _mm512_loadu_ps(y + 2 * n);
+        __m512 as = _mm512_shuffle_ps(a, a, 0xB1);
+        __m512 p = _mm512_fmsubadd_ps(a, _mm512_moveldup_ps(b), _mm512_mul_ps(as, _mm512_movehdup_ps(b)));
+        _mm512_storeu_ps(r + 2 * n, _mm512_add_ps(_mm512_loadu_ps(r + 2 * n), p));
+    }
+
+    multiplyConjAccumulate_scalar(N - n, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(size_t N, float ar, float ai, const float* x, const float* y, float* r)
+{
+    const __m512 vr = _mm512_set1_ps(ar);
+    const __m512 vi = _mm512_set1_ps(ai);
+
+    size_t n = 0;
+    for (; n + 8 <= N; n += 8)
+    {
+        __m512 a = _mm512_loadu_ps(x + 2 * n);
+        __m512 as = _mm512_shuffle_ps(a, a, 0xB1);
+        __m512 p = _mm512_fmaddsub_ps(a, vr, _mm512_mul_ps(as, vi));
+        _mm512_storeu_ps(r + 2 * n, _mm512_add_ps(p, _mm512_loadu_ps(y + 2 * n)));
+    }
+
+    axpy_scalar(N - n, ar, ai, x + 2 * n, y + 2 * n, r + 2 * n);
+}
+
+// the floating point xor needs AVX512DQ, the integer xor does the same on the bits
+__attribute__((target("avx512f")))
+static void conjugate_avx512(size_t N, const float* x, float* r)
+{
+    const __m512i sign = _mm512_set1_epi64(0x8000000000000000LL);
+
+    size_t n = 0;
+    for (; n + 8 <= N; n += 8)
+    {
+        __m512i a = _mm512_castps_si512(_mm512_loadu_ps(x + 2 * n));
+        _mm512_storeu_ps(r + 2 * n, _mm512_castsi512_ps(_mm512_xor_si512(a, sign)));
+    }
+
+    conjugate_scalar(N - n, x + 2 * n, r + 2 * n);
+}
+
+// there is no hadd for 512 bit registers, the squared magnitude is summed into the real parts and those are gathered from both registers
+__attribute__((target("avx512f")))
+static void abs_avx512(size_t N, const float* x, float* r)
+{
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+
+    size_t n = 0;
+    for (; n + 16 <= N; n += 16)
+    {
+        __m512 a = _mm512_loadu_ps(x + 2 * n);
+        __m512 b = _mm512_loadu_ps(x + 2 * n + 16);
+        a = _mm512_mul_ps(a, a);
+        b = _mm512_mul_ps(b, b);
+        a = _mm512_add_ps(a, _mm512_shuffle_ps(a, a, 0xB1));
+        b = _mm512_add_ps(b, _mm512_shuffle_ps(b, b, 0xB1));
+        _mm512_storeu_ps(r + n, _mm512_sqrt_ps(_mm512_permutex2var_ps(a, even, b)));
+    }
+
+    abs_scalar(N - n, x + 2 * n, r + n);
+}
+
+#endif // ELEMWISE_SIMD_X86
+
+// ------------------------------------------------------------------------
+// run time dispatch
+// ------------------------------------------------------------------------
+
+struct kernel_table
+{
+    void (*multiply)(size_t, const float*, const float*, float*);
+    void (*multiplyConj)(size_t, const float*, const float*, float*);
+    void (*multiplyConjAccumulate)(size_t, const float*, const float*, float*);
+    void (*axpy)(size_t, float, float, const float*, const float*, float*);
+    void (*conjugate)(size_t, const float*, float*);
+    void (*abs)(size_t, const float*, float*);
+};
+
+static const kernel_table kernels[] =
+{
+    { multiply_scalar, multiplyConj_scalar, multiplyConjAccumulate_scalar, axpy_scalar, conjugate_scalar, abs_scalar },
+#ifdef ELEMWISE_SIMD_X86
+    { multiply_sse3, multiplyConj_sse3, multiplyConjAccumulate_sse3, axpy_sse3, conjugate_sse3, abs_sse3 },
+    { multiply_avx2, multiplyConj_avx2, multiplyConjAccumulate_avx2, axpy_avx2, conjugate_avx2, abs_avx2 },
+    { multiply_avx512, multiplyConj_avx512, multiplyConjAccumulate_avx512, axpy_avx512, conjugate_avx512, abs_avx512 },
+#endif // ELEMWISE_SIMD_X86
+};
+
+static ISA detect_isa()
+{
+#ifdef ELEMWISE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return ISA::avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ISA::avx2;
+    if (__builtin_cpu_supports("sse3")) return ISA::sse3;
+#endif // ELEMWISE_SIMD_X86
+    return ISA::scalar;
+}
+
+static std::atomic<int>& current_isa()
+{
+    static std::atomic<int> isa((int)supported_isa());
+    return isa;
+}
+
+static const kernel_table& current_kernels()
+{
+    return kernels[current_isa().load(std::memory_order_relaxed)];
+}
+
+ISA supported_isa()
+{
+    static const ISA isa = detect_isa();
+    return isa;
+}
+
+ISA get_isa()
+{
+    return (ISA)current_isa().load();
+}
+
+void set_isa(ISA isa)
+{
+    if ((int)isa > (int)supported_isa()) isa = supported_isa();
+    current_isa().store((int)isa);
+}
+
+const char* isa_name(ISA isa)
+{
+    switch (isa)
+    {
+    case ISA::sse3: return "SSE3";
+    case ISA::avx2: return "AVX2";
+    case ISA::avx512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+// ------------------------------------------------------------------------
+
+void multiply(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+{
+    current_kernels().multiply(N, reinterpret_cast<const float*>(x), reinterpret_cast<const float*>(y), reinterpret_cast<float*>(r));
+}
+
+void multiplyConj(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+{
+    current_kernels().multiplyConj(N, reinterpret_cast<const float*>(x), reinterpret_cast<const float*>(y), reinterpret_cast<float*>(r));
+}
+
+void multiplyConjAccumulate(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+{
+    current_kernels().multiplyConjAccumulate(N, reinterpret_cast<const float*>(x), reinterpret_cast<const float*>(y), reinterpret_cast<float*>(r));
+}
+
+void axpy(size_t N, std::complex<float> a, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r)
+{
+    current_kernels().axpy(N, a.real(), a.imag(), reinterpret_cast<const float*>(x), reinterpret_cast<const float*>(y), reinterpret_cast<float*>(r));
+}
+
+void conjugate(size_t N, const std::complex<float>* x, std::complex<float>* r)
+{
+    current_kernels().conjugate(N, reinterpret_cast<const float*>(x), reinterpret_cast<float*>(r));
+}
+
+void abs(size_t N, const std::complex<float>* x, float* r)
+{
+    current_kernels().abs(N, reinterpret_cast<const float*>(x), r);
+}
+
+}
+}
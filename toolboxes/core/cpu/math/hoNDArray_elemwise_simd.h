@@ -0,0 +1,59 @@
+/** \file   hoNDArray_elemwise_simd.h
+    \brief  Vectorized element-wise kernels for interleaved complex<float> arrays
+
+            The kernels are written for SSE3, AVX2/FMA and AVX-512F. The instruction set is selected at run time
+            from the CPU, so one binary runs on all x86-64 machines; other platforms use the scalar kernels.
+
+            The kernels are single threaded and work on contiguous arrays; the hoNDArray functions in
+            hoNDArray_elemwise.h split large arrays over the OpenMP threads and call these kernels on each part.
+            In-place use (r==x or r==y) is supported.
+*/
+
+#pragma once
+
+#include "cpucore_math_export.h"
+#include <complex>
+#include <cstddef>
+
+namespace Gadgetron
+{
+namespace simd
+{
+    enum class ISA
+    {
+        scalar,
+        sse3,
+        avx2,
+        avx512
+    };
+
+    /// best instruction set supported by this CPU
+    EXPORTCPUCOREMATH ISA supported_isa();
+
+    /// instruction set used by the kernels, supported_isa() unless changed with set_isa
+    EXPORTCPUCOREMATH ISA get_isa();
+
+    /// select the instruction set, e.g. for benchmarking; an instruction set the CPU does not support falls back to supported_isa()
+    EXPORTCPUCOREMATH void set_isa(ISA isa);
+
+    EXPORTCPUCOREMATH const char* isa_name(ISA isa);
+
+    /// r = x * y
+    EXPORTCPUCOREMATH void multiply(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r);
+
+    /// r = x * conj(y)
+    EXPORTCPUCOREMATH void multiplyConj(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r);
+
+    /// r += x * conj(y)
+    EXPORTCPUCOREMATH void multiplyConjAccumulate(size_t N, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r);
+
+    /// r = a * x + y
+    EXPORTCPUCOREMATH void axpy(size_t N, std::complex<float> a, const std::complex<float>* x, const std::complex<float>* y, std::complex<float>* r);
+
+    /// r = conj(x)
+    EXPORTCPUCOREMATH void conjugate(size_t N, const std::complex<float>* x, std::complex<float>* r);
+
+    /// r = abs(x)
+    EXPORTCPUCOREMATH void abs(size_t N, const std::complex<float>* x, float* r);
+}
+}
@@ -17,6 +17,8 @@ namespace Gadgetron{
   //
   template<class T,class S> static bool compatible_dimensions( const cuNDArray<T> &x, const cuNDArray<S> &y )
   {
+    // an empty y is only compatible with an empty x
+    if (y.get_number_of_elements()==0) return (x.get_number_of_elements()==0);
     return ((x.get_number_of_elements()%y.get_number_of_elements())==0);
   }
 
@@ -10,6 +10,10 @@
 #include "hoArmadillo.h"
 #include <numeric>
 
+#ifdef USE_OMP
+#include <omp.h>
+#endif // USE_OMP
+
 namespace Gadgetron {
     namespace Denoise {
 
@@ -48,7 +52,7 @@ namespace Gadgetron {
                            const vector_td<int, 2> &image_dims) {
 
                 std::vector<ImagePatch<T>> result;
-                result.reserve(search_window);
+                result.reserve(search_window * search_window);
 
                 for (int dy = std::max(ky - search_window / 2, 0);
                      dy < std::min(search_window / 2 + ky, image_dims[1]); dy++) {
@@ -92,32 +96,19 @@ namespace Gadgetron {
                 return result;
             };
 
+            /**
+             * The patches as the columns of one matrix, so the statistics of the group are matrix products
+             */
             template<class T>
-            arma::Col<T> get_mean_patch(const std::vector<ImagePatch<T>> &patches) {
-
-                auto mean_patch = arma::Col<T>(patches.front().patch.size(), arma::fill::zeros);
-
-                for (auto &patch : patches) {
-                    mean_patch += patch.patch;
-                }
-
-                mean_patch /= patches.size();
-
-                return mean_patch;
-            }
-
-            template<class T>
-            arma::Mat<T>
-            get_covariance_matrix(const std::vector<ImagePatch<T>> &patches, const arma::Col<T> &mean_patch) {
+            arma::Mat<T> get_patch_matrix(const std::vector<ImagePatch<T>> &patches) {
 
-                auto covariance_matrix = arma::Mat<T>(mean_patch.size(), mean_patch.size(), arma::fill::zeros);
+                auto patch_matrix = arma::Mat<T>(patches.front().patch.size(), patches.size());
 
-                for (auto &patch : patches) {
-                    covariance_matrix += (patch.patch - mean_patch) * (patch.patch - mean_patch).t();
+                for (size_t i = 0; i < patches.size(); i++) {
+                    patch_matrix.col(i) = patches[i].patch;
                 }
-                covariance_matrix /= patches.size() - 1;
 
-                return covariance_matrix;
+                return patch_matrix;
             }
 
 
@@ -127,7 +118,9 @@ namespace Gadgetron {
 
                 auto distances = std::vector<float>(patches.size());
                 transform(patches.begin(), patches.end(), distances.begin(),
-                          [&](auto patch) { return distance(patch.patch, reference_patch); });
+                          [&](const auto &patch) { return distance(patch.patch, reference_patch); });
+
+                n_patches = std::min<int>(n_patches, patches.size());
 
                 std::vector<size_t> patch_indices(patches.size());
                 std::iota(patch_indices.begin(), patch_indices.end(), 0);
@@ -149,7 +142,7 @@ namespace Gadgetron {
             bool is_homogenous_area(std::vector<ImagePatch<T>> &patches, float noise_std) {
 
                 float std2 = std::accumulate(patches.begin(), patches.end(), 0.0f,
-                                             [](auto cur, auto patch) {
+                                             [](auto cur, const auto &patch) {
                                                  float std = arma::stddev(patch.patch);
                                                  return cur + std * std;
                                              }
@@ -159,9 +152,14 @@ namespace Gadgetron {
             }
 
 
+            /**
+             * The covariance of the group and the Bayes filter of all its patches are each a single matrix product,
+             * and the filter is a linear solve rather than an explicit inverse.
+             */
             template<class T>
             void denoise_patches(std::vector<ImagePatch<T>> &patches, float noise_std) {
-                auto mean_patch = get_mean_patch(patches);
+                arma::Mat<T> patch_matrix = get_patch_matrix(patches);
+                arma::Col<T> mean_patch = arma::mean(patch_matrix, 1);
 
                 if (is_homogenous_area(patches, noise_std)) {
                     auto mean_value = arma::mean(mean_patch);
@@ -169,22 +167,28 @@ namespace Gadgetron {
                     return;
                 }
 
+                patch_matrix.each_col() -= mean_patch;
+
+                arma::Mat<T> covariance_matrix = patch_matrix * patch_matrix.t();
+                covariance_matrix /= T(patches.size() - 1);
 
-                auto covariance_matrix = get_covariance_matrix(patches, mean_patch);
                 arma::Mat<T> noise_covariance = covariance_matrix + noise_std * noise_std * arma::eye<arma::Mat<T>>(
                         arma::size(covariance_matrix));
 
-                auto inv_cov = arma::Mat<T>(arma::size(covariance_matrix));
-                if (inv(inv_cov, noise_covariance)) {
-                    for (auto &patch : patches) {
-                        patch.patch = mean_patch + inv_cov * covariance_matrix * (patch.patch - mean_patch);
+                // inv(noise_covariance) * covariance_matrix
+                arma::Mat<T> filter;
+                if (arma::solve(filter, noise_covariance, covariance_matrix)) {
+                    patch_matrix = filter * patch_matrix;
+                    patch_matrix.each_col() += mean_patch;
+                    for (size_t i = 0; i < patches.size(); i++) {
+                        patches[i].patch = patch_matrix.col(i);
                     }
                 }
 
             }
 
             template<class T>
-            hoNDArray<T> non_local_bayes_single_image(const hoNDArray<T> &image, float noise_std, int search_window) {
+            hoNDArray<T> non_local_bayes_single_image(const hoNDArray<T> &image, float noise_std, int search_window, bool parallel) {
 
 
                 if (image.get_number_of_dimensions() != 2)
@@ -207,7 +211,7 @@ namespace Gadgetron {
                 const vector_td<int, 2> image_dims = vector_td<int, 2>(
                         from_std_vector<size_t, 2>(*image.get_dimensions()));
 
-#pragma omp parallel for num_threads(4)
+#pragma omp parallel for num_threads(4) if(parallel)
                 for (int ky = 0; ky < image.get_size(1); ky++) {
                     for (int kx = 0; kx < image.get_size(0); kx++) {
 
@@ -252,12 +256,19 @@ namespace Gadgetron {
 
                 auto result = hoNDArray<T>(image.get_dimensions());
 
-                hoNDArray<T> result_view;
-                result_view.create(image_dims);
-                for (int i = 0; i < n_images; i++) {
+                // A series is spread over the threads one image each, a single image is split over its rows
+                int n_threads = 1;
+#ifdef USE_OMP
+                n_threads = omp_get_max_threads();
+#endif // USE_OMP
+                const bool parallel_images = n_images > 1 && n_images >= n_threads;
+
+                long long i;
+#pragma omp parallel for private(i) if(parallel_images) schedule(dynamic)
+                for (i = 0; i < (long long)n_images; i++) {
 
                     auto image_view = hoNDArray<T>(image_dims, const_cast<T*>(image.get_data_ptr() + i * image_elements));
-                    result_view = non_local_bayes_single_image(image_view, noise_std, search_window);
+                    auto result_view = non_local_bayes_single_image(image_view, noise_std, search_window, !parallel_images);
 
                     memcpy(result.begin() + i * image_elements, result_view.begin(), result_view.get_number_of_bytes());
                 }
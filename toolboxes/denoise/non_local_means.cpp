@@ -6,89 +6,166 @@
 #include <GadgetronTimer.h>
 #include "non_local_means.h"
 
+#ifdef USE_OMP
+#include <omp.h>
+#endif // USE_OMP
 
 namespace Gadgetron {
     namespace Denoise {
 
         namespace {
 
+            float squared_difference(float a, float b) {
+                float d = a - b;
+                return d * d;
+            }
 
-            template<class T, int D>
-            vector_td<T, D * D> get_patch(const hoNDArray<T> &image, int x, int y,
-                                          const vector_td<int, 2> &image_dims) {
+            float squared_difference(const std::complex<float> &a, const std::complex<float> &b) {
+                return std::norm(a - b);
+            }
 
-                constexpr int N = D * D;
-                vector_td<T, N> window;
-                for (int ky = 0; ky < D; ky++) {
-                    for (int kx = 0; kx < D; kx++) {
-                        window[kx + ky * D] = image(((kx - D / 2) + x + image_dims[0]) % image_dims[0],
-                                                    ((ky - D / 2) + y + image_dims[1]) % image_dims[1]);
+            /**
+             * out[x] = in[(x + dx) mod nx], as two contiguous copies
+             */
+            template<class T>
+            void shift_row(const T *in, T *out, int nx, int dx) {
+                int s = ((dx % nx) + nx) % nx;
+                std::copy(in + s, in + nx, out);
+                std::copy(in, in + s, out + nx - s);
+            }
 
+            /**
+             * Circular box sum of width D along x, for the rows [y0, y1)
+             */
+            template<int D>
+            void box_sum_x(const float *in, float *out, int nx, int y0, int y1) {
+                for (int y = y0; y < y1; y++) {
+                    const float *row = in + y * nx;
+                    float *out_row = out + y * nx;
+
+                    float sum = 0;
+                    for (int k = -D / 2; k <= D / 2; k++) sum += row[(k + nx) % nx];
+
+                    for (int x = 0; x < nx; x++) {
+                        out_row[x] = sum;
+                        sum += row[(x + D / 2 + 1) % nx] - row[(x - D / 2 + nx) % nx];
                     }
                 }
-                return window;
-            };
+            }
 
+            /**
+             * Circular box sum of width D along y, for the rows [y0, y1). Adds whole rows, so the inner loop vectorizes.
+             */
+            template<int D>
+            void box_sum_y(const float *in, float *out, int nx, int ny, int y0, int y1) {
+                for (int y = y0; y < y1; y++) {
+                    float *out_row = out + y * nx;
+                    const float *first_row = in + ((y - D / 2 + ny) % ny) * nx;
+                    for (int x = 0; x < nx; x++) out_row[x] = first_row[x];
+
+                    for (int k = -D / 2 + 1; k <= D / 2; k++) {
+                        const float *row = in + ((y + k + ny) % ny) * nx;
+                        for (int x = 0; x < nx; x++) out_row[x] += row[x];
+                    }
+                }
+            }
 
+            /**
+             * The patch distance of every pixel to the pixel shifted by (dx,dy) is the box sum of the squared
+             * differences of the image and the shifted image. The box sums are computed separably with running sums,
+             * which costs O(1) per pixel instead of O(D*D).
+             */
             template<class T>
-            hoNDArray<T> non_local_means_single_image(const hoNDArray<T> &image, float noise_std, int search_radius) {
+            void non_local_means_single_image(const T *image, T *result, int nx, int ny, float noise_std,
+                                              int search_radius, bool parallel) {
 
                 constexpr int D = 5;
 
-                hoNDArray<T> result(image.get_dimensions());
-                const float noise_std2 = noise_std * noise_std;
-                const vector_td<int, 2> image_dims = vector_td<int, 2>(
-                        from_std_vector<size_t, 2>(*image.get_dimensions()));
-
-#pragma omp parallel for
-                for (int ky = 0; ky < image.get_size(1); ky++) {
-                    for (int kx = 0; kx < image.get_size(0); kx++) {
-                        float sum_weight = 0;
-                        T sum_value = 0;
-                        auto window = get_patch<T, D>(image, kx, ky, image_dims);
-
-                        for (int dy = -int(search_radius); dy < search_radius; dy++) {
-                            for (int dx = -int(search_radius); dx < search_radius; dx++) {
-
-                                auto window2 = get_patch<T, D>(image, kx + dx, ky + dy, image_dims);
-                                auto diff = window - window2;
-                                auto weight = std::exp(-norm_squared(diff) / (noise_std2 * D * D));
-
-                                sum_weight += weight;
-                                sum_value += weight * window2[D / 2 + D * (D / 2)];
+                const float scale = -1.0f / (noise_std * noise_std * D * D);
+
+                std::vector<float> diff(nx * ny);
+                std::vector<float> diff_x(nx * ny);
+                std::vector<float> distance(nx * ny);
+                std::vector<float> sum_weight(nx * ny, 0.0f);
+                std::vector<T> sum_value(nx * ny, T(0));
+
+                for (int dy = -search_radius; dy < search_radius; dy++) {
+                    for (int dx = -search_radius; dx < search_radius; dx++) {
+
+#pragma omp parallel if(parallel)
+                        {
+#ifdef USE_OMP
+                            int n_threads = omp_get_num_threads();
+                            int thread = omp_get_thread_num();
+#else
+                            int n_threads = 1;
+                            int thread = 0;
+#endif // USE_OMP
+                            // Every thread works on its own tile of rows
+                            int y0 = (ny * thread) / n_threads;
+                            int y1 = (ny * (thread + 1)) / n_threads;
+
+                            std::vector<T> shifted_row(nx);
+
+                            for (int y = y0; y < y1; y++) {
+                                const T *row = image + y * nx;
+                                shift_row(image + ((y + dy + ny) % ny) * nx, shifted_row.data(), nx, dx);
+                                float *diff_row = diff.data() + y * nx;
+                                for (int x = 0; x < nx; x++) {
+                                    diff_row[x] = squared_difference(row[x], shifted_row[x]);
+                                }
+                            }
 
+                            box_sum_x<D>(diff.data(), diff_x.data(), nx, y0, y1);
+#pragma omp barrier
+                            box_sum_y<D>(diff_x.data(), distance.data(), nx, ny, y0, y1);
+
+                            for (int y = y0; y < y1; y++) {
+                                shift_row(image + ((y + dy + ny) % ny) * nx, shifted_row.data(), nx, dx);
+                                const float *distance_row = distance.data() + y * nx;
+                                float *weight_row = sum_weight.data() + y * nx;
+                                T *value_row = sum_value.data() + y * nx;
+                                for (int x = 0; x < nx; x++) {
+                                    float weight = std::exp(distance_row[x] * scale);
+                                    weight_row[x] += weight;
+                                    value_row[x] += weight * shifted_row[x];
+                                }
                             }
                         }
-
-                        result(kx, ky) = sum_value / sum_weight;
-
                     }
                 }
 
-                return result;
-
+                for (int i = 0; i < nx * ny; i++) {
+                    result[i] = sum_value[i] / sum_weight[i];
+                }
             }
 
             template<class T>
             hoNDArray<T> non_local_means_T(const hoNDArray<T> &image, float noise_std, unsigned int search_radius) {
 
-
                 GadgetronTimer("Non local means");
-                size_t n_images = image.get_number_of_elements() / (image.get_size(0) * image.get_size(1));
 
-                std::vector<size_t> image_dims = {image.get_size(0), image.get_size(1)};
-                size_t image_elements = image_dims[0] * image_dims[1];
+                const int nx = image.get_size(0);
+                const int ny = image.get_size(1);
+                const long long n_images = image.get_number_of_elements() / (nx * ny);
+                const size_t image_elements = nx * ny;
 
                 auto result = hoNDArray<T>(image.get_dimensions());
-                for (int i = 0; i < n_images; i++) {
-
-                    auto image_view = hoNDArray<T>(image_dims, const_cast<T*>(image.get_data_ptr() + i * image_elements));
-
-                    auto result_view = hoNDArray<T>(image_dims, result.get_data_ptr() + i * image_elements);
-
-                    result_view = non_local_means_single_image(image_view, noise_std, search_radius);
-
 
+                // The images of a series are independent, so they are spread over the threads when there are enough
+                // of them. A single image is split into tiles of rows instead.
+                int n_threads = 1;
+#ifdef USE_OMP
+                n_threads = omp_get_max_threads();
+#endif // USE_OMP
+                const bool parallel_images = n_images >= n_threads;
+
+                long long i;
+#pragma omp parallel for private(i) if(parallel_images) schedule(dynamic)
+                for (i = 0; i < n_images; i++) {
+                    non_local_means_single_image(image.get_data_ptr() + i * image_elements,
+                                                 result.get_data_ptr() + i * image_elements, nx, ny, noise_std,
+                                                 search_radius, !parallel_images);
                 }
                 return result;
             }
@@ -0,0 +1,280 @@
+//
+// Parallel minimum cut on a regular image grid
+//
+
+#pragma once
+
+#include "vector_td_utilities.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif // USE_OMP
+
+namespace Gadgetron {
+
+    /**
+     * Minimum s-t cut of a graph whose vertices are the pixels of a D dimensional image, connected to their 2*D
+     * nearest neighbours (no wrap around) and to the source and sink.
+     *
+     * The graph is stored implicitly. Every pixel holds the residual capacities of its 2*D neighbour edges, its excess
+     * and its height, so there are no edge lists, descriptors or reverse edge maps.
+     *
+     * The maximum flow is found with push-relabel. The pixels are coloured as a checkerboard, so that every edge joins
+     * two pixels of different colour. All active pixels of one colour are discharged in parallel; they only read the
+     * heights of pixels of the other colour, and every edge is touched by only one of its end points, so the only
+     * shared write is the excess of the neighbours. The heights are recomputed with a breadth first search after every
+     * sweep which relabelled any pixel.
+     *
+     * The flow is pushed from the sink towards the source along the transposed edges. When no pixel is active, the
+     * pixels which can still reach the source in the residual graph form the smallest source set of any minimum cut,
+     * which is the source tree of the Boykov-Kolmogorov algorithm.
+     */
+    template<unsigned int D>
+    class GridGraphCut {
+    public:
+
+        constexpr static unsigned int edges_per_vertex = 2 * D;
+
+        GridGraphCut(const vector_td<int, D> &dims) : dims_(dims) {
+            num_vertices_ = std::accumulate(std::begin(dims_), std::end(dims_), size_t(1), std::multiplies<size_t>());
+
+            strides_[0] = 1;
+            for (unsigned int d = 1; d < D; d++) strides_[d] = strides_[d - 1] * dims_[d - 1];
+
+            residual_ = std::vector<float>(num_vertices_ * edges_per_vertex, 0);
+            excess_ = std::vector<float>(num_vertices_, 0);
+            to_source_ = std::vector<float>(num_vertices_, 0);
+            height_ = std::vector<int>(num_vertices_, 0);
+        }
+
+        size_t num_vertices() const {
+            return num_vertices_;
+        }
+
+        /**
+         * Adds an edge from idx to its neighbour idx + stride along dimension dim, and optionally the opposite edge.
+         * Calls for different (idx, dim) are thread safe.
+         */
+        void add_edge(size_t idx, unsigned int dim, float capacity, float reverse_capacity = 0) {
+            assert(coordinate(idx, dim) < dims_[dim] - 1);
+            size_t idx2 = idx + strides_[dim];
+            residual_[idx2 * edges_per_vertex + 2 * dim] += capacity;
+            residual_[idx * edges_per_vertex + 2 * dim + 1] += reverse_capacity;
+        }
+
+        /**
+         * Adds capacity to the edges from the source to idx and from idx to the sink. Calls for different idx are
+         * thread safe.
+         */
+        void add_terminal_capacity(size_t idx, float source_capacity, float sink_capacity) {
+            to_source_[idx] += source_capacity;
+            excess_[idx] += sink_capacity;
+        }
+
+        /**
+         * Computes the minimum cut. Returns 1 for the pixels on the source side, 0 for the pixels on the sink side.
+         */
+        std::vector<char> solve() {
+
+            // Flow along source -> idx -> sink needs no search
+            for (size_t idx = 0; idx < num_vertices_; idx++) {
+                float direct_flow = std::min(excess_[idx], to_source_[idx]);
+                excess_[idx] -= direct_flow;
+                to_source_[idx] -= direct_flow;
+            }
+
+            global_relabel();
+
+            // Local relabels only raise a pixel by one level at a time, so without frequent global relabels the
+            // excess which cannot reach the source is passed back and forth for a very long time
+            bool active = true;
+            while (active) {
+                active = false;
+                size_t relabels = 0;
+                for (int colour = 0; colour < 2; colour++) {
+                    size_t colour_relabels = 0;
+                    if (discharge_colour(colour, colour_relabels)) active = true;
+                    relabels += colour_relabels;
+                }
+
+                if (active && relabels > 0) global_relabel();
+            }
+
+            global_relabel();
+
+            std::vector<char> source_side(num_vertices_);
+            for (size_t idx = 0; idx < num_vertices_; idx++) source_side[idx] = height_[idx] < max_height();
+            return source_side;
+        }
+
+    private:
+
+        int max_height() const {
+            return int(num_vertices_) + 1;
+        }
+
+        size_t coordinate(size_t idx, unsigned int dim) const {
+            return (idx / strides_[dim]) % dims_[dim];
+        }
+
+        bool has_neighbour(size_t idx, unsigned int edge) const {
+            unsigned int dim = edge / 2;
+            size_t co = coordinate(idx, dim);
+            return (edge % 2) ? co + 1 < size_t(dims_[dim]) : co > 0;
+        }
+
+        size_t neighbour(size_t idx, unsigned int edge) const {
+            return (edge % 2) ? idx + strides_[edge / 2] : idx - strides_[edge / 2];
+        }
+
+        /**
+         * Sets the heights to the distance to the source in the residual graph, or to max_height() for the pixels
+         * which cannot reach it. The breadth first search expands each level in parallel. A pixel can be claimed by
+         * two threads at once, which only puts it twice in the next level.
+         */
+        void global_relabel() {
+            const int unreachable = max_height();
+            std::fill(height_.begin(), height_.end(), unreachable);
+
+            std::vector<size_t> frontier;
+            for (size_t idx = 0; idx < num_vertices_; idx++) {
+                if (to_source_[idx] > 0) {
+                    height_[idx] = 1;
+                    frontier.push_back(idx);
+                }
+            }
+
+            int level = 1;
+            while (!frontier.empty()) {
+                std::vector<size_t> next_frontier;
+                const long long frontier_size = frontier.size();
+
+#pragma omp parallel shared(frontier, next_frontier) if(frontier_size > 1024)
+                {
+                    std::vector<size_t> local_frontier;
+
+                    long long n;
+#pragma omp for private(n) schedule(static) nowait
+                    for (n = 0; n < frontier_size; n++) {
+                        size_t idx = frontier[n];
+                        for (unsigned int edge = 0; edge < edges_per_vertex; edge++) {
+                            if (!has_neighbour(idx, edge)) continue;
+                            size_t idx2 = neighbour(idx, edge);
+                            // The edge from idx2 back to idx
+                            if (residual_[idx2 * edges_per_vertex + (edge ^ 1)] <= 0) continue;
+
+                            int height;
+#pragma omp atomic read
+                            height = height_[idx2];
+                            if (height == unreachable) {
+#pragma omp atomic write
+                                height_[idx2] = level + 1;
+                                local_frontier.push_back(idx2);
+                            }
+                        }
+                    }
+
+#pragma omp critical
+                    next_frontier.insert(next_frontier.end(), local_frontier.begin(), local_frontier.end());
+                }
+
+                frontier.swap(next_frontier);
+                level++;
+            }
+        }
+
+        /**
+         * Discharges all active pixels of one colour. Returns true if any pixel was active.
+         */
+        bool discharge_colour(int colour, size_t &relabels) {
+            const long long rows = num_vertices_ / dims_[0];
+            const int nx = dims_[0];
+
+            size_t local_relabels = 0;
+            int active = 0;
+
+            long long row;
+#pragma omp parallel for private(row) reduction(+:local_relabels) reduction(|:active) schedule(dynamic, 16)
+            for (row = 0; row < rows; row++) {
+                size_t row_start = row * nx;
+                int parity = colour;
+                for (unsigned int d = 1; d < D; d++) parity += coordinate(row_start, d);
+
+                for (int x = parity % 2; x < nx; x += 2) {
+                    size_t idx = row_start + x;
+                    if (excess_[idx] > 0 && height_[idx] < max_height()) {
+                        active = 1;
+                        local_relabels += discharge(idx);
+                    }
+                }
+            }
+
+            relabels = local_relabels;
+            return active != 0;
+        }
+
+        /**
+         * Pushes the excess of idx to its lower neighbours, relabelling it until the excess is gone or the source
+         * cannot be reached. Returns the number of relabels.
+         */
+        size_t discharge(size_t idx) {
+            const int unreachable = max_height();
+            float excess = excess_[idx];
+            int height = height_[idx];
+            float *residual = residual_.data() + idx * edges_per_vertex;
+            size_t relabels = 0;
+
+            while (excess > 0) {
+                if (height == 1 && to_source_[idx] > 0) {
+                    float delta = std::min(excess, to_source_[idx]);
+                    to_source_[idx] -= delta;
+                    excess -= delta;
+                }
+
+                for (unsigned int edge = 0; edge < edges_per_vertex && excess > 0; edge++) {
+                    if (residual[edge] <= 0) continue;
+                    size_t idx2 = neighbour(idx, edge);
+                    if (height_[idx2] != height - 1) continue;
+
+                    float delta = std::min(excess, residual[edge]);
+                    residual[edge] -= delta;
+                    residual_[idx2 * edges_per_vertex + (edge ^ 1)] += delta;
+                    excess -= delta;
+#pragma omp atomic
+                    excess_[idx2] += delta;
+                }
+
+                if (excess <= 0) break;
+
+                int new_height = unreachable;
+                if (to_source_[idx] > 0) new_height = 1;
+                for (unsigned int edge = 0; edge < edges_per_vertex; edge++) {
+                    if (residual[edge] > 0)
+                        new_height = std::min(new_height, height_[neighbour(idx, edge)] + 1);
+                }
+                height = new_height;
+                relabels++;
+                if (height >= unreachable) break;
+            }
+
+            excess_[idx] = excess;
+            height_[idx] = height;
+            return relabels;
+        }
+
+        vector_td<int, D> dims_;
+        size_t strides_[D];
+        size_t num_vertices_;
+
+        // Residual capacities of the transposed neighbour edges, edges_per_vertex per pixel, ordered -x,+x,-y,+y,...
+        std::vector<float> residual_;
+        std::vector<float> excess_;
+        // Residual capacity of the transposed edge from the pixel to the source
+        std::vector<float> to_source_;
+        std::vector<int> height_;
+    };
+}
@@ -3,8 +3,7 @@
 //
 
 #include <random>
-#include "ImageGraph.h"
-#include <boost/graph/boykov_kolmogorov_max_flow.hpp>
+#include "GridGraphCut.h"
 #include "graph_cut.h"
 
 
@@ -13,11 +12,20 @@ namespace {
     static std::mt19937 rng_state(4242);
 
 
-    template<unsigned int D>
-    void update_regularization_edge(ImageGraph<D> &graph, const hoNDArray<uint16_t> &field_map,
-                                    const hoNDArray<uint16_t> &proposed_field_map,
-                                    const hoNDArray<float> &second_deriv, const size_t idx, const size_t idx2,
-                                    const size_t edge_idx, float scaling) {
+    struct regularization_edge {
+        float capacity;
+        float first_terminal;
+        float second_terminal;
+    };
+
+    /**
+     * The pairwise term between idx and idx2, as an edge from idx to idx2 and a terminal term for each of the two
+     * pixels (positive for a source capacity, negative for a sink capacity).
+     */
+    regularization_edge make_regularization_edge(const hoNDArray<uint16_t> &field_map,
+                                                 const hoNDArray<uint16_t> &proposed_field_map,
+                                                 const hoNDArray<float> &second_deriv, const size_t idx,
+                                                 const size_t idx2, float scaling) {
 
         int f_value1 = field_map[idx];
         int pf_value1 = proposed_field_map[idx];
@@ -36,82 +44,77 @@ namespace {
 
         assert(lambda >= 0);
 
-        auto &capacity_map = graph.edge_capacity_map;
-
-        capacity_map[edge_idx] += weight;
-        {
-            float aq = lambda * (c - a);
-
-            if (aq > 0) {
-                capacity_map[graph.edge_from_source(idx)] += aq;
-
-            } else {
-                capacity_map[graph.edge_to_sink(idx)] -= aq;
-            }
-        }
+        return regularization_edge{weight, lambda * (c - a), lambda * (d - c)};
+    }
 
-        {
-            float aj = lambda * (d - c);
-            if (aj > 0) {
-                capacity_map[graph.edge_from_source(idx2)] += aj;
+    struct terminal_capacity {
+        float source = 0;
+        float sink = 0;
 
+        void add(float terminal) {
+            if (terminal > 0) {
+                source += terminal;
             } else {
-                capacity_map[graph.edge_to_sink(idx2)] -= aj;
+                sink -= terminal;
             }
         }
-
-
-    }
-
+    };
+
+    /**
+     * Every pixel gathers the terms of the edges to its neighbours, so the pixels can be set up in parallel.
+     * The terms are summed in the order a raster scan over the edges would add them (edges from the z, y and x
+     * neighbours before the pixel, then the x, y and z edges after it, then the residual), with separate source
+     * and sink sums, so the float capacities are bit for bit those of the sequential boost graph.
+     */
     template<unsigned int D>
-    ImageGraph<D> make_graph(const hoNDArray<uint16_t> &field_map, const hoNDArray<uint16_t> &proposed_field_map,
-                             const hoNDArray<float> &residual_diff_map, const hoNDArray<float> &second_deriv) {
+    GridGraphCut<D> make_graph(const hoNDArray<uint16_t> &field_map, const hoNDArray<uint16_t> &proposed_field_map,
+                               const hoNDArray<float> &residual_diff_map, const hoNDArray<float> &second_deriv) {
 
         const auto dims = vector_td<int,3>(field_map.get_size(0),field_map.get_size(1),field_map.get_size(2));
 
         vector_td<int,D> graph_dims;
         for (int i = 0; i < D; i++) graph_dims[i] = dims[i];
 
-        ImageGraph<D> graph = ImageGraph<D>(graph_dims);
+        GridGraphCut<D> graph(graph_dims);
 
-        auto &capacity_map = graph.edge_capacity_map;
-        //Add regularization edges
+        const size_t strides[3] = {1, size_t(dims[0]), size_t(dims[0]) * dims[1]};
 
-        for (size_t kz = 0; kz < dims[2]; kz++) {
-            for (size_t ky = 0; ky < dims[1]; ky++) {
+        long long kz;
+#pragma omp parallel for private(kz) collapse(2)
+        for (kz = 0; kz < dims[2]; kz++) {
+            for (long long ky = 0; ky < dims[1]; ky++) {
                 for (size_t kx = 0; kx < dims[0]; kx++) {
                     size_t idx = kz*dims[1]*dims[0]+ky * dims[0] + kx;
+                    const size_t co[3] = {kx, size_t(ky), size_t(kz)};
 
+                    terminal_capacity terminal;
 
-                    if (kx < (dims[0] - 1)) {
-                        size_t idx2 = idx + 1;
-
-                        update_regularization_edge(graph, field_map, proposed_field_map, second_deriv, idx, idx2,
-                                                   graph.edge(idx, idx2).first, 1);
-                    }
-
-
-                    if (ky < (dims[1] - 1)) {
-                        size_t idx2 = idx + dims[0];
-                        update_regularization_edge(graph, field_map, proposed_field_map, second_deriv, idx, idx2,
-                                                   graph.edge(idx, idx2).first, 1);
+                    for (int dim = D - 1; dim >= 0; dim--) {
+                        if (co[dim] > 0) {
+                            auto edge = make_regularization_edge(field_map, proposed_field_map, second_deriv,
+                                                                 idx - strides[dim], idx, 1);
+                            terminal.add(edge.second_terminal);
+                        }
                     }
 
-                    if (kz < (dims[2] - 1)) {
-                        size_t idx2 = idx + dims[0]*dims[1];
-                        update_regularization_edge(graph, field_map, proposed_field_map, second_deriv, idx, idx2,
-                                                   graph.edge(idx, idx2).first, 1);
+                    for (unsigned int dim = 0; dim < D; dim++) {
+                        if (co[dim] < (dims[dim] - 1)) {
+                            auto edge = make_regularization_edge(field_map, proposed_field_map, second_deriv, idx,
+                                                                 idx + strides[dim], 1);
+                            graph.add_edge(idx, dim, edge.capacity);
+                            terminal.add(edge.first_terminal);
+                        }
                     }
 
                     float residual_diff = residual_diff_map[idx];
 
                     if (residual_diff > 0) {
-                        capacity_map[graph.edge_to_sink(idx)] += int(residual_diff);
-
+                        terminal.sink += int(residual_diff);
                     } else {
-                        capacity_map[graph.edge_from_source(idx)] -= int(residual_diff);
+                        terminal.source -= int(residual_diff);
                     }
 
+                    graph.add_terminal_capacity(idx, terminal.source, terminal.sink);
                 }
             }
         }
@@ -120,16 +123,14 @@ namespace {
     }
 
     template<unsigned int DIMS>
-    std::vector<boost::default_color_type>
+    std::vector<char>
     graph_cut(const hoNDArray<uint16_t> &field_map_index, const hoNDArray<uint16_t> &proposed_field_map_index,
               const hoNDArray<float> &lambda_map, const hoNDArray<float> &residual_diff_map) {
 
-        ImageGraph<DIMS> graph = make_graph<DIMS>(field_map_index, proposed_field_map_index, residual_diff_map,
-                                                  lambda_map);
+        GridGraphCut<DIMS> graph = make_graph<DIMS>(field_map_index, proposed_field_map_index, residual_diff_map,
+                                                    lambda_map);
 
-        float flow = boost::boykov_kolmogorov_max_flow(graph, graph.source_vertex, graph.sink_vertex);
-
-        return std::move(graph.color_map);
+        return graph.solve();
     }
 
 }
@@ -146,7 +147,9 @@ namespace Gadgetron {
         const auto Y = field_map_index.get_size(1);
         const auto Z = field_map_index.get_size(2);
 
-        for (size_t kz = 0; kz < Z; kz++) {
+        long long kz;
+#pragma omp parallel for private(kz) if(Z>1)
+        for (kz = 0; kz < Z; kz++) {
             for (size_t ky = 0; ky < Y; ky++) {
                 for (size_t kx = 0; kx < X; kx++) {
                     residual_diff_map(kx, ky,kz) = residuals_map(field_map_index(kx, ky,kz), kx, ky,kz) -
@@ -158,12 +161,12 @@ namespace Gadgetron {
         }
 
 
-        std::vector<boost::default_color_type> color_map;
+        std::vector<char> source_side;
         if (Z == 1) {
-            color_map = graph_cut<2>(field_map_index, proposed_field_map_index, lambda_map,
-                                     residual_diff_map);
+            source_side = graph_cut<2>(field_map_index, proposed_field_map_index, lambda_map,
+                                       residual_diff_map);
         } else {
-            color_map = graph_cut<3>(field_map_index, proposed_field_map_index, lambda_map, residual_diff_map);
+            source_side = graph_cut<3>(field_map_index, proposed_field_map_index, lambda_map, residual_diff_map);
         }
 
 
@@ -171,7 +174,7 @@ namespace Gadgetron {
         auto result = field_map_index;
         size_t updated_voxels = 0;
         for (size_t i = 0; i < field_map_index.get_number_of_elements(); i++) {
-            if (color_map[i] != boost::default_color_type::black_color) {
+            if (!source_side[i]) {
                 updated_voxels++;
                 result[i] = proposed_field_map_index[i];
             }
@@ -181,4 +184,4 @@ namespace Gadgetron {
 
     }
 
-}
\ No newline at end of file
+}
@@ -8,11 +8,16 @@
 #include "hoNDArray_elemwise.h"
 #include "hoNDArray_math.h"
 
+#include <algorithm>
+#include <cstdio>
+
 namespace Gadgetron{
 
 template<typename T> hoNDFFT<T>* hoNDFFT<T>::instance()
     																{
-	if (!instance_) instance_ = new hoNDFFT<T>();
+	//Thread safe initialization
+	static hoNDFFT<T>* fft = new hoNDFFT<T>();
+	if (!instance_) instance_ = fft;
 	return instance_;
     																}
 
@@ -76,17 +81,9 @@ template<class T> void hoNDFFT<T>::fft_int(hoNDArray< ComplexType >* input, size
 //Grab address of data
 	ComplexType* data_ptr = input->get_data_ptr();
 
-	//Allocate storage and make plan
-	{
-            std::lock_guard<std::mutex> guard(mutex_);
-            unsigned planner_flags = FFTW_ESTIMATE;
-            fft_plan = fftw_plan_many_dft_(1,&length,trafos,data_ptr,&length,stride,dist,data_ptr,&length,stride,dist,sign,planner_flags);
-            //fftw_print_plan_(fft_plan);
-            if (fft_plan == NULL)
-	    {
-                throw std::runtime_error("hoNDFFT: failed to create fft plan");
-            }
-	}
+	//Get plan
+	bool cached_plan;
+	fft_plan = get_plan(1,&length,trafos,data_ptr,stride,dist,data_ptr,stride,dist,sign,cached_plan,chunk_size*sizeof(ComplexType));
 
 #pragma omp parallel for
 	for (int k = 0; k < chunks; k++)
@@ -96,14 +93,7 @@ template<class T> void hoNDFFT<T>::fft_int(hoNDArray< ComplexType >* input, size
     timeswitch(input,dim_to_transform);
 
 
-	//clean up
-	{
-            std::lock_guard<std::mutex> guard(mutex_);
-            if (fft_plan != 0)
-	    {
-                fftw_destroy_plan_(fft_plan);
-            }
-	}
+	release_plan(fft_plan, cached_plan);
 
 
 	*input *= scale;
@@ -617,50 +607,39 @@ inline void hoNDFFT<T>::ifft1(const hoNDArray< ComplexType >& a, hoNDArray< Comp
 template<typename T>
 inline void hoNDFFT<T>::fft1c(hoNDArray< ComplexType >& a)
 {
-	ifftshift1D(a);
-	fft1(a);
-	fftshift1D(a);
+	fftc(a, a, 1, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft1c(hoNDArray< ComplexType >& a)
 {
-	ifftshift1D(a);
-	ifft1(a);
-	fftshift1D(a);
+	fftc(a, a, 1, false);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::fft1c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r)
 {
-	ifftshift1D(a, r);
-	fft1(r);
-	fftshift1D(r);
-
+	fftc(a, r, 1, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft1c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r)
 {
-	ifftshift1D(a, r);
-	ifft1(r);
-	fftshift1D(r);
+	fftc(a, r, 1, false);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::fft1c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf)
 {
-	ifftshift1D(a, r);
-	fft1(r, buf);
-	fftshift1D(buf, r);
+	//buf is not needed by the batched transform
+	fftc(a, r, 1, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft1c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf)
 {
-	ifftshift1D(a, r);
-	ifft1(r, buf);
-	fftshift1D(buf, r);
+	//buf is not needed by the batched transform
+	fftc(a, r, 1, false);
 }
 
 // -----------------------------------------------------------------------------------------
@@ -707,50 +686,39 @@ inline void hoNDFFT<T>::ifft2(const hoNDArray< ComplexType >& a, hoNDArray< Comp
 template<typename T>
 inline void hoNDFFT<T>::fft2c(hoNDArray< ComplexType >& a)
 {
-	ifftshift2D(a);
-	fft2(a);
-	fftshift2D(a);
-
+	fftc(a, a, 2, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft2c(hoNDArray< ComplexType >& a)
 {
-	ifftshift2D(a);
-	ifft2(a);
-	fftshift2D(a);
+	fftc(a, a, 2, false);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::fft2c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r)
 {
-	ifftshift2D(a, r);
-	fft2(r);
-	fftshift2D(r);
+	fftc(a, r, 2, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft2c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r)
 {
-	ifftshift2D(a, r);
-	ifft2(r);
-	fftshift2D(r);
+	fftc(a, r, 2, false);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::fft2c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf)
 {
-	ifftshift2D(a, r);
-	fft2(r, buf);
-	fftshift2D(buf, r);
+	//buf is not needed by the batched transform
+	fftc(a, r, 2, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft2c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf)
 {
-	ifftshift2D(a, r);
-	ifft2(r, buf);
-	fftshift2D(buf, r);
+	//buf is not needed by the batched transform
+	fftc(a, r, 2, false);
 }
 
 // -----------------------------------------------------------------------------------------
@@ -796,49 +764,39 @@ inline void hoNDFFT<T>::ifft3(const hoNDArray< ComplexType >& a, hoNDArray< Comp
 template<typename T>
 inline void hoNDFFT<T>::fft3c(hoNDArray< ComplexType >& a)
 {
-	ifftshift3D(a);
-	fft3(a);
-	fftshift3D(a);
+	fftc(a, a, 3, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft3c(hoNDArray< ComplexType >& a)
 {
-	ifftshift3D(a);
-	ifft3(a);
-	fftshift3D(a);
+	fftc(a, a, 3, false);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::fft3c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r)
 {
-	ifftshift3D(a, r);
-	fft3(r);
-	fftshift3D(r);
+	fftc(a, r, 3, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft3c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r)
 {
-	ifftshift3D(a, r);
-	ifft3(r);
-	fftshift3D(r);
+	fftc(a, r, 3, false);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::fft3c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf)
 {
-	ifftshift3D(a, r);
-	fft3(r, buf);
-	fftshift3D(buf, r);
+	//buf is not needed by the batched transform
+	fftc(a, r, 3, true);
 }
 
 template<typename T>
 inline void hoNDFFT<T>::ifft3c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf)
 {
-	ifftshift3D(a, r);
-	ifft3(r, buf);
-	fftshift3D(buf, r);
+	//buf is not needed by the batched transform
+	fftc(a, r, 3, false);
 }
 
 template<typename T>
@@ -878,20 +836,14 @@ void hoNDFFT<T>::fft1(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r,
 
 
 	typename fftw_types<T>::plan * p;
+	bool cached;
 
 	if( num_thr > 1 )
 	{
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			if ( forward )
-			{
-				p = fftw_plan_dft_1d_(n0,a.get_data_ptr(),r.get_data_ptr(),FFTW_FORWARD,FFTW_ESTIMATE);
-			}
-			else
-			{
-				p = fftw_plan_dft_1d_(n0,a.get_data_ptr(),r.get_data_ptr(),FFTW_BACKWARD,FFTW_ESTIMATE);
-			}
-		}
+		p = get_plan(1, &n0, 1,
+				a.get_data_ptr(), 1, n0,
+				r.get_data_ptr(), 1, n0,
+				forward ? FFTW_FORWARD : FFTW_BACKWARD, cached, n0*sizeof(ComplexType));
 
 #pragma omp parallel for private(n) shared(num, p, a, n0, r) num_threads(num_thr)
 		for ( n=0; n<num; n++ )
@@ -899,45 +851,20 @@ void hoNDFFT<T>::fft1(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r,
 			fftw_execute_dft_(p, a.get_data_ptr()+n*n0,
 					r.get_data_ptr()+n*n0);
 		}
-
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			fftw_destroy_plan_(p);
-		}
 	}
 	else
 	{
 		// multiple fft interface
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			if ( forward )
-			{
-				p = fftw_plan_many_dft_(1, &n0, num,
-						a.get_data_ptr(), NULL,
-						1, n0,
-						r.get_data_ptr(), NULL,
-						1, n0,
-						FFTW_FORWARD, FFTW_ESTIMATE);
-			}
-			else
-			{
-				p = fftw_plan_many_dft_(1, &n0, num,
-						a.get_data_ptr(),NULL,
-						1, n0,
-						r.get_data_ptr(), NULL,
-						1, n0,
-						FFTW_BACKWARD, FFTW_ESTIMATE);
-			}
-		}
-
-		fftw_execute_(p);
+		p = get_plan(1, &n0, num,
+				a.get_data_ptr(), 1, n0,
+				r.get_data_ptr(), 1, n0,
+				forward ? FFTW_FORWARD : FFTW_BACKWARD, cached);
 
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			fftw_destroy_plan_(p);
-		}
+		fftw_execute_dft_(p, a.get_data_ptr(), r.get_data_ptr());
 	}
 
+	release_plan(p, cached);
+
 	r *= fftRatio;
 }
 
@@ -958,16 +885,18 @@ void hoNDFFT<T>::fft2(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r,
 
 
 	typename fftw_types<T>::plan * p;
+	bool cached;
+
+	int dims[] = {n0, n1};
+	int idist = n0*n1;
+	int odist = n0*n1;
 
 	if ( num_thr > 1 )
 	{
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			p = fftw_plan_dft_2d_(n0, n1,
-					a.begin(),
-					r.begin(),
-					forward ? FFTW_FORWARD : FFTW_BACKWARD, FFTW_ESTIMATE);
-		}
+		p = get_plan(2, dims, 1,
+				a.begin(), 1, idist,
+				r.begin(), 1, odist,
+				forward ? FFTW_FORWARD : FFTW_BACKWARD, cached, idist*sizeof(ComplexType));
 
 #pragma omp parallel for private(n) shared(num, p, a, n0, n1, r) num_threads(num_thr)
 		for ( n=0; n<num; n++ )
@@ -975,39 +904,20 @@ void hoNDFFT<T>::fft2(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r,
 			fftw_execute_dft_(p, a.begin()+n*n0*n1,
 					r.begin()+n*n0*n1);
 		}
-
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			fftw_destroy_plan_(p);
-		}
 	}
 	else
 	{
 		// multiple fft interface
+		p = get_plan(2, dims, num,
+				a.begin(), 1, idist,
+				r.begin(), 1, odist,
+				forward ? FFTW_FORWARD : FFTW_BACKWARD, cached);
 
-		int n[] = {n0, n1};
-		int idist = n0*n1;
-		int odist = n0*n1;
-
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			p = fftw_plan_many_dft_(2, n, num,
-					a.begin(), NULL,
-					1, idist,
-					r.begin(), NULL,
-					1, odist,
-					forward ? FFTW_FORWARD : FFTW_BACKWARD, FFTW_ESTIMATE);
-
-		}
-
-		fftw_execute_(p);
-
-		{
-                        std::lock_guard<std::mutex> guard(mutex_);
-			fftw_destroy_plan_(p);
-		}
+		fftw_execute_dft_(p, a.begin(), r.begin());
 	}
 
+	release_plan(p, cached);
+
 	r *= fftRatio;
 
 }
@@ -1029,15 +939,13 @@ void hoNDFFT<T>::fft3(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r,
 	long long n;
 
 	typename fftw_types<T>::plan * p;
+	bool cached;
 
-	{
-                std::lock_guard<std::mutex> guard(mutex_);
-		p = fftw_plan_dft_3d_(n0, n1, n2,
-				a.get_data_ptr(),
-				r.get_data_ptr(),
-				forward ? FFTW_FORWARD : FFTW_BACKWARD, FFTW_ESTIMATE);
-
-	}
+	int dims[] = {n0, n1, n2};
+	p = get_plan(3, dims, 1,
+			a.get_data_ptr(), 1, n0*n1*n2,
+			r.get_data_ptr(), 1, n0*n1*n2,
+			forward ? FFTW_FORWARD : FFTW_BACKWARD, cached, (size_t)n0*n1*n2*sizeof(ComplexType));
 
 #pragma omp parallel for private(n) shared(num, p, a, n0, n1, n2, r) if (num_thr > 1) num_threads(num_thr)
 	for ( n=0; n<num; n++ )
@@ -1046,14 +954,164 @@ void hoNDFFT<T>::fft3(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r,
 				r.begin()+n*n0*n1*n2);
 	}
 
+	release_plan(p, cached);
+
+	r *= fftRatio;
+
+}
+template<typename T>
+void hoNDFFT<T>::fftc(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, size_t rank, bool forward)
+{
+	if (rank < 1 || rank > 3)
+	{
+		throw std::runtime_error("hoNDFFT::fftc: only 1D, 2D and 3D transforms are supported");
+	}
+
+	size_t n[3] = {a.get_size(0), (rank > 1) ? a.get_size(1) : 1, (rank > 2) ? a.get_size(2) : 1};
+
+	bool even = true;
+	for (size_t i = 0; i < rank; i++) even = even && (n[i] % 2 == 0);
+
+	if (!even || a.get_number_of_elements() == 0)
+	{
+		fftc_shift(a, r, rank, forward);
+		return;
+	}
+
+	if ( &r != &a && !r.dimensions_equal(&a) )
 	{
-                std::lock_guard<std::mutex> guard(mutex_);
-		fftw_destroy_plan_(p);
+		r.create(a.get_dimensions());
 	}
 
-	r *= fftRatio;
+	size_t N = n[0]*n[1]*n[2];
+	size_t batch = a.get_number_of_elements()/N;
+
+	// For even sizes fftshift(fft(ifftshift(x)))[k] = (-1)^(N/2) (-1)^k fft(x (-1)^m)[k], per dimension
+	T scale = T(1.0/std::sqrt( T(N) ));
+	for (size_t i = 0; i < rank; i++)
+	{
+		if ( (n[i]/2) % 2 ) scale = -scale;
+	}
+
+	ComplexType* pr = r.begin();
+	modulate(a.begin(), pr, n, batch, T(1));
+
+	int num_thr;
+	if (rank == 1)
+		num_thr = get_num_threads_fft1(n[0], batch);
+	else if (rank == 2)
+		num_thr = get_num_threads_fft2(n[1], n[0], batch);
+	else
+		num_thr = get_num_threads_fft3(n[2], n[1], n[0], batch);
+	if (num_thr < 1) num_thr = 1;
+	if ((size_t)num_thr > batch) num_thr = (int)batch;
+
+	// One strided plan_many call per thread over a contiguous part of the batch
+	size_t chunk = (batch + num_thr - 1)/num_thr;
+	long long num_chunks = (long long)((batch + chunk - 1)/chunk);
+	size_t last = batch - (num_chunks-1)*chunk;
+
+	int dims[3];
+	for (size_t i = 0; i < rank; i++) dims[i] = (int)n[rank-1-i];
+	int sign = forward ? FFTW_FORWARD : FFTW_BACKWARD;
+
+	bool cached, cached_last;
+	typename fftw_types<T>::plan * p = get_plan((int)rank, dims, (int)chunk,
+			pr, 1, (int)N, pr, 1, (int)N, sign, cached, chunk*N*sizeof(ComplexType));
+	typename fftw_types<T>::plan * p_last = p;
+	cached_last = true;
+	if (last != chunk)
+	{
+		ComplexType* pl = pr + (num_chunks-1)*chunk*N;
+		p_last = get_plan((int)rank, dims, (int)last, pl, 1, (int)N, pl, 1, (int)N, sign, cached_last);
+	}
+
+	long long c;
+#pragma omp parallel for private(c) shared(num_chunks, p, p_last, pr, chunk, N) if (num_chunks > 1) num_threads(num_thr)
+	for ( c=0; c<num_chunks; c++ )
+	{
+		ComplexType* pc = pr + c*chunk*N;
+		fftw_execute_dft_((c == num_chunks-1) ? p_last : p, pc, pc);
+	}
+
+	if (p_last != p) release_plan(p_last, cached_last);
+	release_plan(p, cached);
+
+	modulate(pr, pr, n, batch, scale);
+}
+
+template<typename T>
+void hoNDFFT<T>::fftc_shift(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, size_t rank, bool forward)
+{
+	if ( &r == &a )
+	{
+		if (rank == 1)
+		{
+			ifftshift1D(r);
+			fft1(r, forward);
+			fftshift1D(r);
+		}
+		else if (rank == 2)
+		{
+			ifftshift2D(r);
+			fft2(r, forward);
+			fftshift2D(r);
+		}
+		else
+		{
+			ifftshift3D(r);
+			fft3(r, forward);
+			fftshift3D(r);
+		}
+		return;
+	}
+
+	if (rank == 1)
+	{
+		ifftshift1D(a, r);
+		fft1(r, forward);
+		fftshift1D(r);
+	}
+	else if (rank == 2)
+	{
+		ifftshift2D(a, r);
+		fft2(r, forward);
+		fftshift2D(r);
+	}
+	else
+	{
+		ifftshift3D(a, r);
+		fft3(r, forward);
+		fftshift3D(r);
+	}
+}
+
+template<typename T>
+void hoNDFFT<T>::modulate(const ComplexType* in, ComplexType* out, const size_t* n, size_t batch, T scale)
+{
+	long long rows = (long long)(n[1]*n[2]*batch);
+	size_t n0 = n[0];
+	size_t n1 = n[1];
+	size_t n2 = n[2];
+
+	long long row;
+#pragma omp parallel for private(row) shared(rows, in, out, n0, n1, n2, scale) if ( rows*n0 > 64*1024 )
+	for ( row=0; row<rows; row++ )
+	{
+		size_t y = row % n1;
+		size_t z = (row / n1) % n2;
+		T s = ((y + z) % 2) ? -scale : scale;
 
+		const ComplexType* pi = in + row*n0;
+		ComplexType* po = out + row*n0;
+		for (size_t x = 0; x < n0; x += 2)
+		{
+			po[x] = pi[x] * s;
+			po[x+1] = pi[x+1] * (-s);
+		}
+	}
 }
+
 // TODO: implement more optimized threading strategy
 template<typename T>
 inline int hoNDFFT<T>::get_num_threads_fft1(size_t n0, size_t num)
@@ -1156,6 +1214,215 @@ void hoNDFFT<T>::phaseshift(hoNDArray<ComplexType>* inout, T phase, int dim_to_t
 
 	}
 }
+template<typename T>
+bool hoNDFFT<T>::PlanKey::operator<(const PlanKey& k) const
+{
+	const int a[] = {rank, n[0], n[1], n[2], howmany, istride, idist, ostride, odist, sign, inplace, ialign, oalign, (int)flags};
+	const int b[] = {k.rank, k.n[0], k.n[1], k.n[2], k.howmany, k.istride, k.idist, k.ostride, k.odist, k.sign, k.inplace, k.ialign, k.oalign, (int)k.flags};
+	return std::lexicographical_compare(a, a+14, b, b+14);
+}
+
+template<typename T>
+typename fftw_types<T>::plan * hoNDFFT<T>::get_plan(int rank, const int* n, int howmany,
+		ComplexType* in, int istride, int idist,
+		ComplexType* out, int ostride, int odist,
+		int sign, bool& cached, size_t slice_bytes)
+{
+	PlanKey key;
+	key.rank = rank;
+	for (int i = 0; i < 3; i++) key.n[i] = (i < rank) ? n[i] : 0;
+	key.howmany = howmany;
+	key.istride = istride;
+	key.idist = idist;
+	key.ostride = ostride;
+	key.odist = odist;
+	key.sign = sign;
+	key.inplace = (in == out);
+	key.ialign = fftw_alignment_of_(in);
+	key.oalign = fftw_alignment_of_(out);
+	key.flags = FFTW_ESTIMATE;
+
+	//Plans executed on slices with a different SIMD alignment than the planning arrays must not assume alignment
+	if (slice_bytes && fftw_alignment_of_(reinterpret_cast<ComplexType*>(reinterpret_cast<char*>(in) + slice_bytes)) != key.ialign)
+	{
+		key.flags |= FFTW_UNALIGNED;
+	}
+
+	//Lock free lookup in the plans this thread has seen
+	struct ThreadCache
+	{
+		size_t generation;
+		PlanCache plans;
+	};
+	static thread_local ThreadCache local = { 0, PlanCache() };
+
+	size_t generation = plan_generation_.load(std::memory_order_acquire);
+	if (local.generation != generation)
+	{
+		local.plans.clear();
+		local.generation = generation;
+	}
+
+	typename PlanCache::iterator it = local.plans.find(key);
+	if (it != local.plans.end())
+	{
+		cached = true;
+		return it->second;
+	}
+
+	std::lock_guard<std::mutex> guard(mutex_);
+
+	it = plans_.find(key);
+	if (it != plans_.end())
+	{
+		local.plans[key] = it->second;
+		cached = true;
+		return it->second;
+	}
+
+	typename fftw_types<T>::plan * p = fftw_plan_many_dft_(rank, n, howmany,
+			in, NULL, istride, idist,
+			out, NULL, ostride, odist,
+			sign, key.flags);
+	if (p == NULL)
+	{
+		throw std::runtime_error("hoNDFFT: failed to create fft plan");
+	}
+
+	cached = plans_.size() < max_cached_plans;
+	if (cached)
+	{
+		plans_[key] = p;
+		local.plans[key] = p;
+	}
+
+	return p;
+}
+
+template<typename T>
+void hoNDFFT<T>::release_plan(typename fftw_types<T>::plan * p, bool cached)
+{
+	if (cached || p == NULL) return;
+
+	std::lock_guard<std::mutex> guard(mutex_);
+	fftw_destroy_plan_(p);
+}
+
+template<typename T>
+size_t hoNDFFT<T>::plan_cache_size()
+{
+	std::lock_guard<std::mutex> guard(mutex_);
+	return plans_.size();
+}
+
+template<typename T>
+void hoNDFFT<T>::clear_plan_cache()
+{
+	std::lock_guard<std::mutex> guard(mutex_);
+	for (typename PlanCache::iterator it = plans_.begin(); it != plans_.end(); ++it)
+	{
+		fftw_destroy_plan_(it->second);
+	}
+	plans_.clear();
+	plan_generation_++;
+}
+
+template<typename T>
+bool hoNDFFT<T>::import_wisdom(const std::string& filename)
+{
+	FILE* file = fopen(filename.c_str(), "r");
+	if (!file) return false;
+
+	int res;
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		res = fftw_import_wisdom_from_file_(file);
+	}
+
+	fclose(file);
+	return res != 0;
+}
+
+template<typename T>
+bool hoNDFFT<T>::export_wisdom(const std::string& filename)
+{
+	//Write next to the target and rename, so concurrent readers never see a partial file
+	std::string tmp = filename + ".tmp";
+	FILE* file = fopen(tmp.c_str(), "w");
+	if (!file) return false;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		fftw_export_wisdom_to_file_(file);
+	}
+
+	if (fclose(file) != 0)
+	{
+		std::remove(tmp.c_str());
+		return false;
+	}
+
+	return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+template<typename T>
+void hoNDFFT<T>::prewarm(const std::vector<size_t>& dims, size_t howmany)
+{
+	if (dims.empty() || dims.size() > 3)
+	{
+		throw std::runtime_error("hoNDFFT::prewarm: only 1D, 2D and 3D transforms are supported");
+	}
+
+	int rank = (int)dims.size();
+	int n[3];
+	size_t N = 1;
+	for (int i = 0; i < rank; i++)
+	{
+		//FFTW expects the slowest varying dimension first
+		n[i] = (int)dims[rank-1-i];
+		N *= dims[i];
+	}
+	if (howmany < 1) howmany = 1;
+
+	ComplexType* in = (ComplexType*)fftw_malloc_(sizeof(ComplexType)*N*howmany);
+	ComplexType* out = (ComplexType*)fftw_malloc_(sizeof(ComplexType)*N*howmany);
+	if (!in || !out)
+	{
+		if (in) fftw_free_(in);
+		if (out) fftw_free_(out);
+		throw std::runtime_error("hoNDFFT::prewarm: failed to allocate planning buffers");
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+
+		int signs[] = {FFTW_FORWARD, FFTW_BACKWARD};
+		for (int s = 0; s < 2; s++)
+		{
+			for (int inplace = 0; inplace < 2; inplace++)
+			{
+				//FFTW_MEASURE overwrites the arrays, the resulting wisdom is reused when planning on real data
+				typename fftw_types<T>::plan * p = fftw_plan_many_dft_(rank, n, (int)howmany,
+						in, NULL, 1, (int)N,
+						inplace ? in : out, NULL, 1, (int)N,
+						signs[s], FFTW_MEASURE);
+				if (p) fftw_destroy_plan_(p);
+			}
+		}
+	}
+
+	fftw_free_(in);
+	fftw_free_(out);
+}
+
+template<> int hoNDFFT<float>::fftw_alignment_of_(ComplexType* p){
+	return fftwf_alignment_of(reinterpret_cast<float*>(p));
+}
+
+template<> int hoNDFFT<double>::fftw_alignment_of_(ComplexType* p){
+	return fftw_alignment_of(reinterpret_cast<double*>(p));
+}
+
 template<> int hoNDFFT<float>::fftw_import_wisdom_from_file_(FILE* file){
 	return fftwf_import_wisdom_from_file(file);
 }
@@ -9,6 +9,10 @@
 #include "cpufft_export.h"
 
 #include <mutex>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
 #include <iostream>
 #include <fftw3.h>
 #include <complex>
@@ -37,6 +41,12 @@ template<> struct fftw_types<double>{
     This class is a singleton because the planning and memory allocation routines of FFTW are NOT threadsafe.
     The class' template type is a REAL, ie. float or double.
 
+    Plans are cached by problem (rank, sizes, batch count, strides, direction, in-place and alignment)
+    and never destroyed, so repeated transforms of the same size skip planning. Each thread keeps its
+    own view of the cache, and cached plans are executed concurrently through the new-array interface,
+    so only a cache miss takes the planner lock. FFTW wisdom can be imported at startup, exported at
+    shutdown and grown ahead of time with prewarm().
+
 		Note that scaling is 1/sqrt(N) fir both FFT and IFFT, where N is the number of elements along the FFT dimensions
     Access using e.g.
     FFT<float>::instance()
@@ -175,12 +185,46 @@ template<> struct fftw_types<double>{
         void ifft3c(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, hoNDArray< ComplexType >& buf);
 
 
+        /**
+         * Centered transform of the first rank (1 to 3) dimensions, batched over all remaining dimensions.
+         * a and r may be the same array. For even sizes the fftshifts are folded into the transform as
+         * a (-1)^k modulation before and after it, and the batch is transformed with strided plan_many
+         * calls, one per thread. Odd sizes fall back to explicit shifts.
+         * The fft1c/fft2c/fft3c functions and their inverses use this.
+         */
+        void fftc(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, size_t rank, bool forward);
+
         void timeswitch(hoNDArray<ComplexType>* a, int transform_dim);
+
+        /**
+         * Loads FFTW wisdom for this precision, returns false if the file cannot be read.
+         */
+        bool import_wisdom(const std::string& filename);
+
+        /**
+         * Saves the accumulated FFTW wisdom for this precision.
+         */
+        bool export_wisdom(const std::string& filename);
+
+        /**
+         * Plans transforms of the given sizes with FFTW_MEASURE to build wisdom before the first data arrives.
+         * dims are the transformed dimensions in hoNDArray order (1 to 3 of them), howmany is the number
+         * of transforms in a batch. Both directions, in-place and out-of-place, are planned.
+         */
+        void prewarm(const std::vector<size_t>& dims, size_t howmany = 1);
+
+        size_t plan_cache_size();
+
+        /**
+         * Destroys all cached plans. Must not be called while transforms are running.
+         */
+        void clear_plan_cache();
+
     protected:
 
         //We are making these protected since this class is a singleton
 
-        hoNDFFT() {
+        hoNDFFT() : plan_generation_(0) {
 
 
 #ifdef USE_OMP
@@ -190,7 +234,7 @@ template<> struct fftw_types<double>{
 #endif // USE_OMP
         }
 
-        virtual ~hoNDFFT() { fftw_cleanup_(); }
+        virtual ~hoNDFFT() { clear_plan_cache(); fftw_cleanup_(); }
 
         void fft_int(hoNDArray< ComplexType >* input, size_t dim_to_transform, int sign);
 
@@ -217,6 +261,42 @@ template<> struct fftw_types<double>{
         typename fftw_types<T>::plan * fftw_plan_dft_(int rank, ComplexType*, ComplexType*, int, unsigned);
 
         void  fftw_destroy_plan_(typename fftw_types<T>::plan *);
+        int   fftw_alignment_of_(ComplexType*);
+
+        struct PlanKey
+        {
+            int rank;
+            int n[3];
+            int howmany;
+            int istride, idist, ostride, odist;
+            int sign;
+            bool inplace;
+            int ialign, oalign;
+            unsigned flags;
+
+            bool operator<(const PlanKey& k) const;
+        };
+
+        typedef std::map<PlanKey, typename fftw_types<T>::plan *> PlanCache;
+
+        /**
+         * Returns a plan for the problem, creating it with FFTW_ESTIMATE (using any wisdom) if it is not cached.
+         * in and out are only used for planning, execute with fftw_execute_dft_. slice_bytes is the offset
+         * between the arrays the plan will be executed on, 0 if only in/out are used.
+         * Cached plans are owned by the cache; if cached is false the caller must release the plan with release_plan.
+         */
+        typename fftw_types<T>::plan * get_plan(int rank, const int* n, int howmany,
+                                                ComplexType* in, int istride, int idist,
+                                                ComplexType* out, int ostride, int odist,
+                                                int sign, bool& cached, size_t slice_bytes = 0);
+
+        void release_plan(typename fftw_types<T>::plan * p, bool cached);
+
+        PlanCache plans_;
+        std::atomic<size_t> plan_generation_;
+
+        //Bounds the cache for callers with many different batch sizes, further problems are planned per call
+        static const size_t max_cached_plans = 4096;
 
 
 
@@ -266,6 +346,12 @@ template<> struct fftw_types<double>{
         void fft2(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, bool forward);
         void fft3(hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, bool forward);
 
+        // centered transform with explicit shifts, for odd sizes
+        void fftc_shift(const hoNDArray< ComplexType >& a, hoNDArray< ComplexType >& r, size_t rank, bool forward);
+
+        // out[x,y,z,b] = in[x,y,z,b] * scale * (-1)^(x+y+z), x fastest and n[0] even
+        void modulate(const ComplexType* in, ComplexType* out, const size_t* n, size_t batch, T scale);
+
         // get the number of threads used for fft
         int get_num_threads_fft1(size_t n0, size_t num);
         int get_num_threads_fft2(size_t n0, size_t n1, size_t num);
@@ -10,6 +10,7 @@
 #include <ace/SOCK_Stream.h>
 #include <ace/Reactor_Notification_Strategy.h>
 #include <string>
+#include <vector>
 
 #define MAXHOSTNAMELENGTH 1024
 
@@ -24,14 +25,29 @@ namespace Gadgetron{
   WriterTask(ACE_SOCK_Stream* socket)
     : inherited()
       , socket_(socket)
+      , output_(socket)
+      , coalesce_bytes_(0)
+      , coalesce_latency_(ACE_Time_Value::zero)
     {
     }
 
     virtual ~WriterTask()
       {
+	this->release_held();
 	writers_.clear();
       }
 
+    /**
+       Enables coalescing of outgoing messages. Messages are collected until max_bytes are pending,
+       or until max_latency_us has passed since the first pending message, and then sent together.
+       A max_bytes of zero disables coalescing, every message is then sent as soon as it is written.
+     */
+    void set_coalescing(size_t max_bytes, unsigned long max_latency_us)
+    {
+      coalesce_bytes_ = max_bytes;
+      coalesce_latency_ = ACE_Time_Value(max_latency_us / 1000000, max_latency_us % 1000000);
+    }
+
     virtual int init(void)
     {
       return 0;
@@ -65,11 +81,25 @@ namespace Gadgetron{
     virtual int svc(void)
     {
       ACE_Message_Block *mb = 0;
-      ACE_Time_Value nowait (ACE_OS::gettimeofday ());
-
 
       //Send a package if we have one
-      while (this->getq (mb) != -1) {
+      while (true) {
+	ACE_Time_Value deadline;
+	ACE_Time_Value* timeout = 0;
+	if (!held_.empty()) {
+	  deadline = first_held_ + coalesce_latency_;
+	  timeout = &deadline;
+	}
+
+	if (this->getq (mb, timeout) == -1) {
+	  if (timeout && ACE_OS::last_error () == EWOULDBLOCK) {
+	    //Latency cap reached, send what we have
+	    if (this->flush_held() < 0) return -1;
+	    continue;
+	  }
+	  break;
+	}
+
 	GadgetContainerMessage<GadgetMessageIdentifier>* mid =
 	  AsContainerMessage<GadgetMessageIdentifier>(mb);
 
@@ -82,6 +112,7 @@ namespace Gadgetron{
 
 	//Is this a shutdown message?
 	if (mid->getObjectPtr()->id == GADGET_MESSAGE_CLOSE) {
+	  this->flush_held();
 	  socket_->send_n(mid->getObjectPtr(),sizeof(GadgetMessageIdentifier));
 	  mid->release();
 	  return 0;
@@ -95,22 +126,59 @@ namespace Gadgetron{
 	  return -1;
 	}
 
-	if (w->write(socket_,mb->cont()) < 0) {
+	if (held_.empty()) {
+	  first_held_ = ACE_OS::gettimeofday();
+	}
+	held_.push_back(mb);
+
+	if (w->write_gather(&output_,mb->cont()) < 0) {
 	  GERROR("Failed to write message to Gadgetron\n");
-	  mb->release ();
+	  this->release_held();
 	  return -1;
 	}
 
-	mb->release();
+	if (!coalesce_bytes_ || output_.pending_bytes() >= coalesce_bytes_) {
+	  if (this->flush_held() < 0) return -1;
+	}
       }
 
+      this->flush_held();
       return 0;
 
     }
 
   protected:
+    int flush_held()
+    {
+      ssize_t res = 0;
+      if (output_.pending_bytes()) {
+	res = output_.flush();
+	if (res < 0) {
+	  GERROR("Failed to send messages to Gadgetron\n");
+	}
+      }
+      this->release_held();
+      return res < 0 ? -1 : 0;
+    }
+
+    void release_held()
+    {
+      output_.clear();
+      for (size_t i = 0; i < held_.size(); i++) {
+	held_[i]->release();
+      }
+      held_.clear();
+    }
+
     ACE_SOCK_Stream* socket_;
     GadgetronSlotContainer<GadgetMessageWriter> writers_;
+
+    //Messages written to output_ but not yet sent
+    GadgetOutputStream output_;
+    std::vector<ACE_Message_Block*> held_;
+    ACE_Time_Value first_held_;
+    size_t coalesce_bytes_;
+    ACE_Time_Value coalesce_latency_;
   };
 
   class EXPORTGADGETTOOLS GadgetronConnector: public ACE_Svc_Handler<ACE_SOCK_STREAM, ACE_MT_SYNCH> {
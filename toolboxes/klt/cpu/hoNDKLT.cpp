@@ -5,27 +5,29 @@
 #include "hoNDArray_linalg.h"
 #include "hoNDArray_utils.h"
 
+#include <algorithm>
+
 namespace Gadgetron{
 
 template<typename T> 
-hoNDKLT<T>::hoNDKLT()
+hoNDKLT<T>::hoNDKLT() : count_(0), accumulate_remove_mean_(true)
 {
 }
 
 template<typename T>
-hoNDKLT<T>::hoNDKLT(const hoNDArray<T>& data, size_t dim, size_t output_length)
+hoNDKLT<T>::hoNDKLT(const hoNDArray<T>& data, size_t dim, size_t output_length) : count_(0), accumulate_remove_mean_(true)
 {
     this->prepare(data, dim, output_length);
 }
 
 template<typename T>
-hoNDKLT<T>::hoNDKLT(const hoNDArray<T>& data, size_t dim, value_type thres)
+hoNDKLT<T>::hoNDKLT(const hoNDArray<T>& data, size_t dim, value_type thres) : count_(0), accumulate_remove_mean_(true)
 {
     this->prepare(data, dim, thres);
 }
 
 template<typename T>
-hoNDKLT<T>::hoNDKLT(const Self& v)
+hoNDKLT<T>::hoNDKLT(const Self& v) : count_(0), accumulate_remove_mean_(true)
 {
     *this = v;
 }
@@ -47,6 +49,11 @@ hoNDKLT<T>& hoNDKLT<T>::operator=(const Self& v)
     size_t N = this->V_.get_size(0);
     this->M_.create(N, this->output_length_, V_.begin());
 
+    this->C_ = v.C_;
+    this->mean_ = v.mean_;
+    this->count_ = v.count_;
+    this->accumulate_remove_mean_ = v.accumulate_remove_mean_;
+
     return *this;
 }
 
@@ -489,6 +496,298 @@ void hoNDKLT<T>::prepare(const hoNDArray<T>& data, size_t dim, std::vector<size_
     }
 }
 
+template<typename T>
+void hoNDKLT<T>::accumulate_2D(const hoNDArray<T>& data2D, bool remove_mean)
+{
+    try
+    {
+        size_t M = data2D.get_size(0);
+        size_t N = data2D.get_size(1);
+
+        if (count_ == 0)
+        {
+            C_.create(N, N);
+            Gadgetron::clear(C_);
+
+            mean_.create(N, 1);
+            Gadgetron::clear(mean_);
+
+            accumulate_remove_mean_ = remove_mean;
+        }
+        else
+        {
+            GADGET_CHECK_THROW(C_.get_size(0) == N);
+            GADGET_CHECK_THROW(accumulate_remove_mean_ == remove_mean);
+        }
+
+        if (M == 0) return;
+
+        size_t m, n;
+
+        if (remove_mean)
+        {
+            // Chan's update of the mean and covariance with a batch
+            // the batch with its own mean removed, plus one row for the change of the mean
+            // C = C + Cb + count*M/(count+M) * delta'*delta, delta = mean_batch - mean
+            size_t total = count_ + M;
+            value_type w = (value_type)std::sqrt((double)count_*M / total);
+
+            batch_.create(M + 1, N);
+
+            for (n = 0; n < N; n++)
+            {
+                T mean_batch = 0;
+                for (m = 0; m < M; m++)
+                {
+                    mean_batch += data2D(m, n);
+                }
+                mean_batch /= (value_type)M;
+
+                for (m = 0; m < M; m++)
+                {
+                    batch_(m, n) = data2D(m, n) - mean_batch;
+                }
+
+                T delta = mean_batch - mean_(n);
+                batch_(M, n) = w*delta;
+
+                mean_(n) += delta * (value_type)((double)M / total);
+            }
+
+            Gadgetron::herk(batch_cov_, batch_, 'L', true);
+        }
+        else
+        {
+            Gadgetron::herk(batch_cov_, data2D, 'L', true);
+        }
+
+        for (n = 0; n < N; n++)
+        {
+            for (m = n; m < N; m++)
+            {
+                C_(m, n) += batch_cov_(m, n);
+            }
+        }
+
+        count_ += M;
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::accumulate_2D(...) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::accumulate(const hoNDArray<T>& data, size_t dim, bool remove_mean)
+{
+    try
+    {
+        size_t NDim = data.get_number_of_dimensions();
+        GADGET_CHECK_THROW(dim<NDim);
+
+        std::vector<size_t> dimD;
+        data.get_dimensions(dimD);
+
+        size_t N = dimD[dim];
+        size_t M = data.get_number_of_elements() / N;
+
+        size_t K = 1;
+        for (size_t n = dim + 1; n < NDim; n++) K *= dimD[n];
+
+        if ((dim == NDim - 1) || (K == 1))
+        {
+            hoNDArray<T> data2D;
+            data2D.create(M, N, const_cast<T*>(data.begin()));
+
+            this->accumulate_2D(data2D, remove_mean);
+        }
+        else
+        {
+            std::vector<size_t> dimOrder(NDim), dimPermuted(dimD);
+
+            size_t l;
+            for (l = 0; l<NDim; l++)
+            {
+                dimOrder[l] = l;
+                dimPermuted[l] = dimD[l];
+            }
+
+            dimOrder[dim] = NDim - 1;
+            dimOrder[NDim - 1] = dim;
+
+            dimPermuted[dim] = dimD[NDim - 1];
+            dimPermuted[NDim - 1] = dimD[dim];
+
+            hoNDArray<T> dataP;
+            dataP.create(dimPermuted);
+            Gadgetron::permute(data, dataP, dimOrder);
+
+            hoNDArray<T> dataP2D;
+            dataP2D.create(M, N, dataP.begin());
+
+            this->accumulate_2D(dataP2D, remove_mean);
+        }
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::accumulate(...) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::compute_eigen_vector_accumulated(std::vector<size_t>& untransformed)
+{
+    try
+    {
+        GADGET_CHECK_THROW(count_ > 0);
+
+        size_t N = C_.get_size(0);
+        size_t unN = untransformed.size();
+
+        size_t NT = N - unN;
+
+        // the covariance of the transformed slots
+        hoNDArray<T> V(NT, NT);
+
+        size_t r, c, rT, cT;
+        for (c = 0, cT = 0; c < N; c++)
+        {
+            if (std::find(untransformed.begin(), untransformed.end(), c) != untransformed.end()) continue;
+
+            for (r = 0, rT = 0; r < N; r++)
+            {
+                if (std::find(untransformed.begin(), untransformed.end(), r) != untransformed.end()) continue;
+
+                V(rT, cT) = C_(r, c);
+                rT++;
+            }
+
+            cT++;
+        }
+
+        // eigen values in the ascending order, only the lower triangle is used
+        hoNDArray<T> E;
+        Gadgetron::heev(V, E);
+
+        // make the first eigen channel with the largest eigen value
+        V_.create(NT, NT);
+        E_.create(NT, 1);
+        for (c = 0; c < NT; c++)
+        {
+            memcpy(&V_(0, c), &V(0, NT - 1 - c), sizeof(T)*NT);
+            E_(c) = E(NT - 1 - c);
+        }
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::compute_eigen_vector_accumulated(...) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::prepare_accumulated(size_t output_length)
+{
+    try
+    {
+        std::vector<size_t> untransformed;
+        this->prepare_accumulated(untransformed, output_length);
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::prepare_accumulated(output_length) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::prepare_accumulated(value_type thres)
+{
+    try
+    {
+        this->prepare_accumulated((size_t)0);
+        this->compute_num_kept(thres);
+        M_.create(E_.get_size(0), output_length_, V_.begin());
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::prepare_accumulated(thres) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::prepare_accumulated(std::vector<size_t>& untransformed, size_t output_length)
+{
+    try
+    {
+        GADGET_CHECK_THROW(count_ > 0);
+
+        size_t N = C_.get_size(0);
+
+        size_t unN = untransformed.size();
+        GADGET_CHECK_THROW(unN<N);
+        if (output_length > 0)
+        {
+            GADGET_CHECK_THROW(output_length >= unN);
+        }
+
+        size_t d;
+        for (d = 0; d < unN; d++)
+        {
+            GADGET_CHECK_THROW(untransformed[d] < N);
+        }
+
+        this->compute_eigen_vector_accumulated(untransformed);
+
+        if (unN > 0)
+        {
+            this->copy_and_reset_transform(N, untransformed);
+        }
+
+        if (output_length > 0 && output_length <= N)
+        {
+            output_length_ = output_length;
+        }
+        else
+        {
+            output_length_ = N;
+        }
+
+        M_.create(N, output_length_, V_.begin());
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::prepare_accumulated(untransformed, output_length) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::prepare_accumulated(std::vector<size_t>& untransformed, value_type thres)
+{
+    try
+    {
+        this->prepare_accumulated(untransformed, (size_t)0);
+        this->compute_num_kept(thres);
+        M_.create(E_.get_size(0), output_length_, V_.begin());
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoNDKLT<T>::prepare_accumulated(untransformed, thres) ... ");
+    }
+}
+
+template<typename T>
+void hoNDKLT<T>::reset_accumulation()
+{
+    C_.clear();
+    mean_.clear();
+    count_ = 0;
+}
+
+template<typename T>
+size_t hoNDKLT<T>::accumulated_samples() const
+{
+    return count_;
+}
+
 template<typename T>
 void hoNDKLT<T>::transform(const hoNDArray<T>& in, hoNDArray<T>& out, size_t dim) const
 {
@@ -20,6 +20,11 @@ namespace Gadgetron{
         The eigen values are in the descending order, 
         which means the first eigen channel has the LARGEST eigen value
         and the last eigen channel has the SMALLEST eigen value
+
+        The transformation can also be computed from data arriving in batches, e.g. readout by readout
+        Every call of accumulate adds the batch to the covariance matrix, with the mean tracked incrementally,
+        and prepare_accumulated computes the transformation from the covariance accumulated so far
+        Only the covariance matrix is kept, so the memory does not grow with the amount of data
     */
 
     template <typename T> class EXPORTCPUKLT hoNDKLT
@@ -53,6 +58,20 @@ namespace Gadgetron{
         void prepare(const hoNDArray<T>& data, size_t dim, std::vector<size_t>& untransformed, size_t output_length = 0, bool remove_mean = true);
         void prepare(const hoNDArray<T>& data, size_t dim, std::vector<size_t>& untransformed, value_type thres = (value_type)0.001, bool remove_mean = true);
 
+        /// add a batch of data to the accumulated covariance along dimension dim
+        /// data.get_size(dim) must be the same for all batches, and so must remove_mean
+        void accumulate(const hoNDArray<T>& data, size_t dim, bool remove_mean = true);
+        /// compute the KLT from the accumulated covariance, the same as prepare(...) on all accumulated data
+        /// the accumulation continues, so the KLT can be computed again after more data has been added
+        void prepare_accumulated(size_t output_length = 0);
+        void prepare_accumulated(value_type thres);
+        void prepare_accumulated(std::vector<size_t>& untransformed, size_t output_length = 0);
+        void prepare_accumulated(std::vector<size_t>& untransformed, value_type thres);
+        /// discard the accumulated covariance
+        void reset_accumulation();
+        /// number of samples accumulated
+        size_t accumulated_samples() const;
+
         /// apply the transform
         /// The input array size must meet in.get_size(dim) == M.get_size(0)
         /// out array will have out.get_size(dim)==out_length
@@ -88,9 +107,26 @@ namespace Gadgetron{
         /// length of output dimension
         size_t output_length_;
 
+        /// accumulated covariance, only the lower triangle is filled
+        hoNDArray<T> C_;
+        /// mean of the accumulated samples
+        hoNDArray<T> mean_;
+        /// number of accumulated samples
+        size_t count_;
+        /// whether the accumulated covariance has the mean removed
+        bool accumulate_remove_mean_;
+        /// buffers for a batch
+        hoNDArray<T> batch_, batch_cov_;
+
         /// compute eigen vector and values
         void compute_eigen_vector(const hoNDArray<T>& data, bool remove_mean);
 
+        /// add a batch of data, [M N], to the accumulated covariance
+        void accumulate_2D(const hoNDArray<T>& data2D, bool remove_mean);
+
+        /// compute eigen vector and values from the accumulated covariance, without the untransformed slots
+        void compute_eigen_vector_accumulated(std::vector<size_t>& untransformed);
+
         /// exclude untransformed data
         void exclude_untransformed(const hoNDArray<T>& data, size_t dim, std::vector<size_t>& untransformed, hoNDArray<T>& dataCropped);
 
@@ -18,201 +18,299 @@
 namespace Gadgetron
 {
 
-template<typename T> 
-void coil_map_2d_Inati(const hoNDArray<T>& data, hoNDArray<T>& coilMap, size_t ks, size_t power)
+namespace
 {
-    try
+    inline long long coil_map_wrap(long long ind, long long len)
     {
-        typedef typename realType<T>::Type value_type;
-        using std::abs;
+        ind %= len;
+        return (ind < 0) ? ind + len : ind;
+    }
 
-        long long RO = data.get_size(0);
-        long long E1 = data.get_size(1);
-        long long CHA = data.get_size(2);
+    // complex arrays are given as interleaved real and imaginary parts, n is the number of complex values
+    // c += conj(a) .* b
+    template<typename value_type>
+    inline void coil_map_conj_multiply_add(const value_type* a, const value_type* b, value_type* c, long long n)
+    {
+        for (long long k = 0; k < n; k++)
+        {
+            const value_type ar = a[2 * k], ai = a[2 * k + 1];
+            const value_type br = b[2 * k], bi = b[2 * k + 1];
 
-        long long N = data.get_number_of_elements() / (RO*E1*CHA);
-        GADGET_CHECK_THROW(N == 1);
+            c[2 * k] += ar*br + ai*bi;
+            c[2 * k + 1] += ar*bi - ai*br;
+        }
+    }
 
-        const T* pData = data.begin();
+    // c += a .* b
+    template<typename value_type>
+    inline void coil_map_multiply_add(const value_type* a, const value_type* b, value_type* c, long long n)
+    {
+        for (long long k = 0; k < n; k++)
+        {
+            const value_type ar = a[2 * k], ai = a[2 * k + 1];
+            const value_type br = b[2 * k], bi = b[2 * k + 1];
 
-        if (!data.dimensions_equal(&coilMap))
+            c[2 * k] += ar*br - ai*bi;
+            c[2 * k + 1] += ar*bi + ai*br;
+        }
+    }
+
+    // y(ro) = sum of x(ro-halfKs ... ro+halfKs), the window wraps around at the borders
+    template<typename value_type>
+    inline void coil_map_box_filter_ro(const value_type* x, value_type* y, long long RO, long long halfKs)
+    {
+        memset(y, 0, sizeof(value_type) * 2 * RO);
+
+        for (long long kro = -halfKs; kro <= halfKs; kro++)
         {
-            coilMap = data;
+            long long s = 2 * coil_map_wrap(kro, RO);
+
+            for (long long k = 0; k < 2 * RO - s; k++) y[k] += x[k + s];
+            for (long long k = 2 * RO - s; k < 2 * RO; k++) y[k] += x[k + s - 2 * RO];
         }
-        T* pSen = coilMap.begin();
+    }
 
-        if (ks % 2 != 1)
+    // normalize the CHA vectors of a line of RO pixels, stored as [RO CHA]
+    template<typename value_type>
+    inline void coil_map_normalize(value_type* v, value_type* norm, long long RO, long long CHA)
+    {
+        long long ro, cha;
+
+        memset(norm, 0, sizeof(value_type) * RO);
+        for (cha = 0; cha < CHA; cha++)
         {
-            ks++;
+            const value_type* pV = v + cha * 2 * RO;
+            for (ro = 0; ro < RO; ro++)
+            {
+                norm[ro] += pV[2 * ro] * pV[2 * ro] + pV[2 * ro + 1] * pV[2 * ro + 1];
+            }
         }
 
-        size_t kss = ks*ks;
-        long long halfKs = (long long)ks / 2;
+        for (ro = 0; ro < RO; ro++)
+        {
+            norm[ro] = (value_type)1.0 / std::sqrt(norm[ro]);
+        }
 
-        long long e1;
+        for (cha = 0; cha < CHA; cha++)
+        {
+            value_type* pV = v + cha * 2 * RO;
+            for (ro = 0; ro < RO; ro++)
+            {
+                pV[2 * ro] *= norm[ro];
+                pV[2 * ro + 1] *= norm[ro];
+            }
+        }
+    }
 
-        #pragma omp parallel private(e1) shared(ks, RO, E1, CHA, pSen, pData, halfKs, power, kss)
+    // add the channel products and the channels of the line (e1, e2) to the sums of the window
+    // the lower triangle of the channel products is stored as [RO CHA*(CHA+1)/2]
+    template<typename value_type>
+    inline void coil_map_add_line(const value_type* pData, long long RO, long long E1, long long E2, long long CHA, long long e1, long long e2, value_type* pCov, value_type* pSum)
+    {
+        long long i, j, k, p = 0;
+        for (j = 0; j < CHA; j++)
         {
-            hoNDArray<T> D(ks*ks, CHA);
-            T* pD = D.begin();
+            const value_type* pJ = pData + 2 * ((j*E2 + e2)*E1 + e1)*RO;
 
-            hoNDArray<T> DC(ks*ks, CHA);
-            T* pDC = DC.begin();
+            for (i = j; i < CHA; i++)
+            {
+                const value_type* pI = pData + 2 * ((i*E2 + e2)*E1 + e1)*RO;
+                coil_map_conj_multiply_add(pI, pJ, pCov + 2 * p*RO, RO);
+                p++;
+            }
 
-            hoNDArray<T> DH_D(CHA, CHA);
-            Gadgetron::clear(DH_D);
+            value_type* pS = pSum + 2 * j*RO;
+            for (k = 0; k < 2 * RO; k++) pS[k] += pJ[k];
+        }
+    }
+}
 
-            hoNDArray<T> U1(ks*ks, 1);
-            T* pU1 = U1.begin();
+// the local covariance of a pixel is the sum of the channel products over its ks*ks*kz window; it is computed as
+// a separable box filter, one line of RO pixels at a time:
+//  - the sums over E2 of the ks lines in the E1 window are kept in a ring buffer, moving to the next E1 only
+//    computes the sum of the line entering the window
+//  - the sums over E1 and then over RO are computed from these by additions only; subtracting the line leaving the
+//    window instead loses the weak signal next to strong signal in float
+//  - the power iterations of all pixels of the line are computed together, with the loops over RO innermost
+// for 2D data, E2 == 1 and kz == 1
+// the window wraps around at the borders
+template<typename T>
+void coil_map_Inati_box_filter(const T* data, T* coilMap, long long RO, long long E1, long long E2, long long CHA, long long ks, long long kz, size_t power)
+{
+    typedef typename realType<T>::Type value_type;
 
-            hoNDArray<T> V1(CHA, 1);
-            T* pV1 = V1.begin();
+    const value_type* pData = reinterpret_cast<const value_type*>(data);
+    value_type* pSen = reinterpret_cast<value_type*>(coilMap);
 
-            hoNDArray<T> V(CHA, 1);
+    long long halfKs = ks / 2;
+    long long halfKz = kz / 2;
 
-            Gadgetron::clear(D);
-            Gadgetron::clear(DC);
-            Gadgetron::clear(DH_D);
-            Gadgetron::clear(U1);
-            Gadgetron::clear(V1);
-            Gadgetron::clear(V);
+    // number of channel pairs in the lower triangle of the covariance matrix
+    long long numOfPairs = CHA*(CHA + 1) / 2;
+    long long numOfLines = E1*E2;
 
-            T phaseU1;
+    long long line;
 
-            value_type v1Norm(1), u1Norm(1);
+    #pragma omp parallel default(none) private(line) shared(pData, pSen, RO, E1, E2, CHA, ks, halfKs, halfKz, numOfPairs, numOfLines, power)
+    {
+        // sums over the E2 window of the lines in the E1 window, a line is kept in the slot of its index, before
+        // wrapping around E1, modulo ks
+        hoNDArray<value_type> ringCov(2 * RO, numOfPairs, ks);
+        hoNDArray<value_type> ringSum(2 * RO, CHA, ks);
+
+        // sums over the E1/E2 window
+        hoNDArray<value_type> lineCov(2 * RO, numOfPairs);
+        hoNDArray<value_type> lineSum(2 * RO, CHA);
+
+        // sums over the whole window
+        hoNDArray<value_type> cov(2 * RO, numOfPairs);
+        hoNDArray<value_type> sum(2 * RO, CHA);
+
+        hoNDArray<value_type> V1(2 * RO, CHA);
+        hoNDArray<value_type> V(2 * RO, CHA);
+        hoNDArray<value_type> phaseU1(2 * RO);
+        hoNDArray<value_type> norm(RO);
+
+        value_type* pLineCov = lineCov.begin();
+        value_type* pLineSum = lineSum.begin();
+        value_type* pCov = cov.begin();
+        value_type* pSum = sum.begin();
+        value_type* pV1 = V1.begin();
+        value_type* pV = V.begin();
+        value_type* pPhase = phaseU1.begin();
+
+        long long i, j, k, p, ro, cha, ke1, ke2, e1, e2;
+        size_t po;
+
+        long long sizeCov = 2 * RO*numOfPairs;
+        long long sizeSum = 2 * RO*CHA;
+
+        // the last line of this thread, the ring buffer is reused if it is the previous line
+        long long prevLine = -2;
+
+        #pragma omp for schedule(static)
+        for (line = 0; line < numOfLines; line++)
+        {
+            e1 = line % E1;
+            e2 = line / E1;
 
-            long long cha, ro, kro, ke1, de1, dro;
-            size_t po;
+            // only the line entering the E1 window is summed over E2, unless this thread starts a new run of lines
+            long long startE1 = (e1 > 0 && line == prevLine + 1) ? e1 + halfKs : e1 - halfKs;
 
-            #pragma omp for
-            for (e1 = 0; e1<(int)E1; e1++)
+            for (ke1 = startE1; ke1 <= e1 + halfKs; ke1++)
             {
-                for (ro = 0; ro<(long long)RO; ro++)
+                long long slot = coil_map_wrap(ke1, ks);
+                value_type* pSlotCov = ringCov.begin() + slot*sizeCov;
+                value_type* pSlotSum = ringSum.begin() + slot*sizeSum;
+
+                memset(pSlotCov, 0, sizeof(value_type)*sizeCov);
+                memset(pSlotSum, 0, sizeof(value_type)*sizeSum);
+
+                for (ke2 = -halfKz; ke2 <= halfKz; ke2++)
                 {
-                    // fill the data matrix D
-                    if (e1 >= halfKs && e1<E1 - halfKs && ro >= halfKs && ro<RO - halfKs)
-                    {
-                        for (cha = 0; cha<CHA; cha++)
-                        {
-                            const T* pDataCurr = pData + cha*RO*E1;
-                            int ind = 0;
-                            for (ke1 = -halfKs; ke1 <= halfKs; ke1++)
-                            {
-                                de1 = e1 + ke1;
-                                for (kro = -halfKs; kro <= halfKs; kro++)
-                                {
-                                    pD[ind + cha*kss] = pDataCurr[de1*RO + ro + kro];
-                                    ind++;
-                                }
-                            }
-                        }
-                    }
-                    else
-                    {
-                        for (cha = 0; cha<CHA; cha++)
-                        {
-                            const T* pDataCurr = pData + cha*RO*E1;
-                            int ind = 0;
-                            for (ke1 = -halfKs; ke1 <= halfKs; ke1++)
-                            {
-                                de1 = e1 + ke1;
-                                if (de1 < 0) de1 += E1;
-                                if (de1 >= E1) de1 -= E1;
-
-                                for (kro = -halfKs; kro <= halfKs; kro++)
-                                {
-                                    dro = ro + kro;
-                                    if (dro < 0) dro += RO;
-                                    if (dro >= RO) dro -= RO;
-
-                                    pD[ind + cha*kss] = pDataCurr[de1*RO + dro];
-                                    ind++;
-                                }
-                            }
-                        }
-                    }
+                    coil_map_add_line(pData, RO, E1, E2, CHA, coil_map_wrap(ke1, E1), coil_map_wrap(e2 + ke2, E2), pSlotCov, pSlotSum);
+                }
+            }
 
-                    T* pTmp;
-                    for (cha = 0; cha<CHA; cha++)
-                    {
-                        pTmp = pD + cha*kss;
-                        pV1[cha] = pTmp[0];
-                        for (po = 1; po<kss; po++)
-                        {
-                            pV1[cha] += pTmp[po];
-                        }
-                    }
+            memcpy(pLineCov, ringCov.begin(), sizeof(value_type)*sizeCov);
+            memcpy(pLineSum, ringSum.begin(), sizeof(value_type)*sizeSum);
+            for (ke1 = 1; ke1 < ks; ke1++)
+            {
+                const value_type* pSlotCov = ringCov.begin() + ke1*sizeCov;
+                const value_type* pSlotSum = ringSum.begin() + ke1*sizeSum;
 
-                    value_type sum(0);
-                    for (cha = 0; cha<CHA; cha++)
-                    {
-                        const T& c = pV1[cha];
-                        const value_type re = c.real();
-                        const value_type im = c.imag();
-                        sum += ((re*re) + (im * im));
-                    }
-                    v1Norm = std::sqrt(sum);
+                for (k = 0; k < sizeCov; k++) pLineCov[k] += pSlotCov[k];
+                for (k = 0; k < sizeSum; k++) pLineSum[k] += pSlotSum[k];
+            }
 
-                    value_type v1NormInv = (value_type)1.0 / v1Norm;
-                    for (cha = 0; cha<CHA; cha++)
-                    {
-                        pV1[cha] *= v1NormInv;
-                    }
+            prevLine = line;
+
+            for (p = 0; p < numOfPairs; p++)
+            {
+                coil_map_box_filter_ro(pLineCov + 2 * p*RO, pCov + 2 * p*RO, RO, halfKs);
+            }
 
-                    memcpy(pDC, pD, sizeof(T)*ks*ks*CHA);
-                    gemm(DH_D, DC, true, D, false);
+            for (cha = 0; cha < CHA; cha++)
+            {
+                coil_map_box_filter_ro(pLineSum + 2 * cha*RO, pSum + 2 * cha*RO, RO, halfKs);
+            }
 
-                    for (po = 0; po<power; po++)
-                    {
-                        gemm(V, DH_D, false, V1, false);
-                        memcpy(V1.begin(), V.begin(), V.get_number_of_bytes());
+            // V1 starts from the sum of the channels over the window
+            memcpy(pV1, pSum, sizeof(value_type) * 2 * RO*CHA);
+            coil_map_normalize(pV1, norm.begin(), RO, CHA);
 
-                        sum = 0;
-                        for (cha = 0; cha<CHA; cha++)
-                        {
-                            const T& c = pV1[cha];
-                            const value_type re = c.real();
-                            const value_type im = c.imag();
-                            sum += ((re*re) + (im * im));
-                        }
-                        v1Norm = std::sqrt(sum);
+            // V = DH_D * V1, DH_D(i, j) = conj(DH_D(j, i))
+            for (po = 0; po < power; po++)
+            {
+                memset(pV, 0, sizeof(value_type) * 2 * RO*CHA);
 
-                        value_type v1NormInv = (value_type)1.0 / v1Norm;
-                        for (cha = 0; cha<CHA; cha++)
+                p = 0;
+                for (j = 0; j < CHA; j++)
+                {
+                    for (i = j; i < CHA; i++)
+                    {
+                        const value_type* pA = pCov + 2 * p*RO;
+                        coil_map_multiply_add(pA, pV1 + 2 * j*RO, pV + 2 * i*RO, RO);
+                        if (i != j)
                         {
-                            pV1[cha] *= v1NormInv;
+                            coil_map_conj_multiply_add(pA, pV1 + 2 * i*RO, pV + 2 * j*RO, RO);
                         }
+                        p++;
                     }
+                }
 
-                    gemm(U1, D, false, V1, false);
+                std::swap(pV1, pV);
+                coil_map_normalize(pV1, norm.begin(), RO, CHA);
+            }
 
-                    phaseU1 = pU1[0];
-                    for (po = 1; po<kss; po++)
-                    {
-                        phaseU1 += pU1[po];
-                    }
-                    phaseU1 /= abs(phaseU1);
+            // the sum of U1 = D*V1 is the sum of the channels over the window times V1
+            Gadgetron::clear(phaseU1);
+            for (cha = 0; cha < CHA; cha++)
+            {
+                coil_map_multiply_add(pSum + 2 * cha*RO, pV1 + 2 * cha*RO, pPhase, RO);
+            }
 
-                    const value_type c = phaseU1.real();
-                    const value_type d = phaseU1.imag();
+            for (ro = 0; ro < RO; ro++)
+            {
+                value_type mag = std::sqrt(pPhase[2 * ro] * pPhase[2 * ro] + pPhase[2 * ro + 1] * pPhase[2 * ro + 1]);
+                pPhase[2 * ro] /= mag;
+                pPhase[2 * ro + 1] /= mag;
+            }
 
-                    for (cha = 0; cha<CHA; cha++)
-                    {
-                        const T& v = pV1[cha];
-                        const value_type a = v.real();
-                        const value_type b = v.imag();
+            // put the mean object phase to coil map
+            for (cha = 0; cha < CHA; cha++)
+            {
+                value_type* pSenCurr = pSen + 2 * ((cha*E2 + e2)*E1 + e1)*RO;
+                memset(pSenCurr, 0, sizeof(value_type) * 2 * RO);
+                coil_map_conj_multiply_add(pV1 + 2 * cha*RO, pPhase, pSenCurr, RO);
+            }
+        }
+    }
+}
 
-                        reinterpret_cast< value_type(&)[2] >(pV1[cha])[0] = a*c + b*d;
-                        reinterpret_cast< value_type(&)[2] >(pV1[cha])[1] = a*d - b*c;
-                    }
+template<typename T> 
+void coil_map_2d_Inati(const hoNDArray<T>& data, hoNDArray<T>& coilMap, size_t ks, size_t power)
+{
+    try
+    {
+        long long RO = data.get_size(0);
+        long long E1 = data.get_size(1);
+        long long CHA = data.get_size(2);
 
-                    for (cha = 0; cha<CHA; cha++)
-                    {
-                        pSen[cha*RO*E1 + e1*RO + ro] = V1(cha, 0);
-                    }
-                }
-            }
+        long long N = data.get_number_of_elements() / (RO*E1*CHA);
+        GADGET_CHECK_THROW(N == 1);
+
+        if (!data.dimensions_equal(&coilMap))
+        {
+            coilMap = data;
+        }
+
+        if (ks % 2 != 1)
+        {
+            ks++;
         }
+
+        coil_map_Inati_box_filter(data.begin(), coilMap.begin(), RO, E1, 1, CHA, (long long)ks, 1, power);
     }
     catch (...)
     {
@@ -233,9 +331,6 @@ void coil_map_3d_Inati(const hoNDArray<T>& data, hoNDArray<T>& coilMap, size_t k
 {
     try
     {
-        typedef typename realType<T>::Type value_type;
-        using std::abs;
-
         long long RO = data.get_size(0);
         long long E1 = data.get_size(1);
         long long E2 = data.get_size(2);
@@ -244,13 +339,10 @@ void coil_map_3d_Inati(const hoNDArray<T>& data, hoNDArray<T>& coilMap, size_t k
         long long N = data.get_number_of_elements() / (RO*E1*E2*CHA);
         GADGET_CHECK_THROW(N == 1);
 
-        const T* pData = data.begin();
-
         if (!data.dimensions_equal(&coilMap))
         {
             coilMap = data;
         }
-        T* pSen = coilMap.begin();
 
         if (ks % 2 != 1)
         {
@@ -262,134 +354,7 @@ void coil_map_3d_Inati(const hoNDArray<T>& data, hoNDArray<T>& coilMap, size_t k
             kz++;
         }
 
-        size_t kss = ks*ks*kz;
-        long long halfKs = (long long)ks / 2;
-        long long halfKz = (long long)kz / 2;
-
-        long long e2;
-
-        #pragma omp parallel default(none) private(e2) shared(ks, kz, RO, E1, E2, CHA, pSen, pData, halfKs, halfKz, power, kss)
-        {
-            hoMatrix<T> D(kss, CHA);
-            hoMatrix<T> DC(kss, CHA);
-            hoMatrix<T> DH_D(CHA, CHA);
-
-            hoMatrix<T> U1(kss, 1);
-            hoMatrix<T> V1(CHA, 1);
-            hoMatrix<T> V(CHA, 1);
-
-            Gadgetron::clear(D);
-            Gadgetron::clear(DC);
-            Gadgetron::clear(DH_D);
-            Gadgetron::clear(U1);
-            Gadgetron::clear(V1);
-            Gadgetron::clear(V);
-
-            T phaseU1;
-
-            value_type v1Norm(1);
-
-            long long cha, ro, e1, kro, dro, ke1, de1, ke2, de2;
-            size_t po;
-
-            #pragma omp for
-            for (e2 = 0; e2<(long long)E2; e2++)
-            {
-                for (e1 = 0; e1<(long long)E1; e1++)
-                {
-                    for (ro = 0; ro<(long long)RO; ro++)
-                    {
-                        // fill the data matrix D
-                        if (e2 >= halfKz && e2<E2 - halfKz && e1 >= halfKs && e1<E1 - halfKs && ro >= halfKs && ro<RO - halfKs)
-                        {
-                            for (cha = 0; cha<CHA; cha++)
-                            {
-                                const T* pDataCurr = pData + cha*RO*E1*E2;
-                                long long ind = 0;
-                                for (ke2 = -halfKz; ke2 <= halfKz; ke2++)
-                                {
-                                    de2 = e2 + ke2;
-                                    for (ke1 = -halfKs; ke1 <= halfKs; ke1++)
-                                    {
-                                        de1 = e1 + ke1;
-                                        for (kro = -halfKs; kro <= halfKs; kro++)
-                                        {
-                                            D(ind++, cha) = pDataCurr[de2*RO*E1 + de1*RO + ro + kro];
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        else
-                        {
-                            for (cha = 0; cha<CHA; cha++)
-                            {
-                                const T* pDataCurr = pData + cha*RO*E1*E2;
-                                long long ind = 0;
-                                for (ke2 = -halfKz; ke2 <= halfKz; ke2++)
-                                {
-                                    de2 = e2 + ke2;
-                                    if (de2 < 0) de2 += E2;
-                                    if (de2 >= E2) de2 -= E2;
-
-                                    for (ke1 = -halfKs; ke1 <= halfKs; ke1++)
-                                    {
-                                        de1 = e1 + ke1;
-                                        if (de1 < 0) de1 += E1;
-                                        if (de1 >= E1) de1 -= E1;
-
-                                        for (kro = -halfKs; kro <= halfKs; kro++)
-                                        {
-                                            dro = ro + kro;
-                                            if (dro < 0) dro += RO;
-                                            if (dro >= RO) dro -= RO;
-
-                                            D(ind++, cha) = pDataCurr[de2*RO*E1 + de1*RO + dro];
-                                        }
-                                    }
-                                }
-                            }
-                        }
-
-                        // compute V1
-                        D.sumOverCol(V1);
-                        v1Norm = nrm2(V1);
-                        scal((value_type)1.0 / v1Norm, V1);
-
-                        memcpy(DC.begin(), D.begin(), sizeof(T)*kss*CHA);
-                        gemm(DH_D, DC, true, D, false);
-                        // gemm(DH_D, D, true, D, false);
-
-                        for (po = 0; po<power; po++)
-                        {
-                            gemm(V, DH_D, false, V1, false);
-                            V1 = V;
-                            v1Norm = nrm2(V1);
-                            scal((value_type)1.0 / v1Norm, V1);
-                        }
-
-                        // compute U1
-                        gemm(U1, D, false, V1, false);
-
-                        phaseU1 = U1(0, 0);
-                        for (po = 1; po<kss; po++)
-                        {
-                            phaseU1 += U1(po, 0);
-                        }
-                        phaseU1 /= abs(phaseU1);
-
-                        // put the mean object phase to coil map
-                        conjugate(V1, V1);
-                        scal(phaseU1, V1);
-
-                        for (cha = 0; cha<CHA; cha++)
-                        {
-                            pSen[cha*RO*E1*E2 + e2*RO*E1 + e1*RO + ro] = V1(cha, 0);
-                        }
-                    }
-                }
-            }
-        }
+        coil_map_Inati_box_filter(data.begin(), coilMap.begin(), RO, E1, E2, CHA, (long long)ks, (long long)kz, power);
     }
     catch (...)
     {
@@ -642,11 +607,18 @@ template<typename T> void coil_map_Inati(const hoNDArray<T>& data, hoNDArray<T>&
 
         long long n;
 
+#ifdef USE_OMP
+        int num_procs = omp_get_num_procs();
+#endif // USE_OMP
+
+        // with few N/S, the lines of every coil map are computed in parallel instead
         if (E2 > 1)
         {
+#ifdef USE_OMP
+#pragma omp parallel for default(none) private(n) shared(num, RO, E1, E2, CHA, data, coilMap, ks, kz, power) if(num>num_procs/2)
+#endif // USE_OMP
             for (n = 0; n < (long long)num; n++)
             {
-
                 hoNDArray<T> im(RO, E1, E2, CHA, const_cast<T*>(data.begin() + n*RO*E1*E2*CHA));
                 hoNDArray<T> cmap(RO, E1, E2, CHA, coilMap.begin() + n*RO*E1*E2*CHA);
 
@@ -656,7 +628,6 @@ template<typename T> void coil_map_Inati(const hoNDArray<T>& data, hoNDArray<T>&
         else
         {
 #ifdef USE_OMP
-            int num_procs = omp_get_num_procs();
 #pragma omp parallel for default(none) private(n) shared(num, RO, E1, CHA, data, coilMap, ks, power) if(num>num_procs/2)
 #endif // USE_OMP
             for (n = 0; n < (long long)num; n++)
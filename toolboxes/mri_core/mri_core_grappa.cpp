@@ -35,6 +35,11 @@
     #include "omp.h"
 #endif // USE_OMP
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define GRAPPA_UNMIX_X86
+    #include <immintrin.h>
+#endif
+
 namespace Gadgetron
 {
 
@@ -579,6 +584,261 @@ template EXPORTMRICORE void grappa2d_image_domain_unwrapping_aliased_image(const
 
 // ------------------------------------------------------------------------
 
+// pixels per tile, the coefficients of a tile stay in cache while all blocks of images are unmixed
+static const size_t unmix_tile_pixels = 256;
+// images unmixed together, bounded by the number of vector registers
+static const size_t unmix_image_block = 4;
+
+template <typename R, size_t F>
+static void unmix_tile(const R* im, size_t imStride, const R* coeff, size_t pixels, size_t srcCHA, size_t start, size_t end, R* res, size_t resStride)
+{
+    // complex values are accessed as interleaved real and imaginary parts, strides are in complex elements
+    for (size_t p = start; p < end; p++)
+    {
+        R re[F] = { 0 };
+        R imag[F] = { 0 };
+
+        for (size_t cha = 0; cha < srcCHA; cha++)
+        {
+            const R* c = coeff + 2 * (cha*pixels + p);
+            R cr = c[0];
+            R ci = c[1];
+
+            for (size_t f = 0; f < F; f++)
+            {
+                const R* x = im + 2 * (f*imStride + cha*pixels + p);
+                re[f] += x[0] * cr - x[1] * ci;
+                imag[f] += x[0] * ci + x[1] * cr;
+            }
+        }
+
+        for (size_t f = 0; f < F; f++)
+        {
+            res[2 * (f*resStride + p)] = re[f];
+            res[2 * (f*resStride + p) + 1] = imag[f];
+        }
+    }
+}
+
+#ifdef GRAPPA_UNMIX_X86
+
+// With c = (cr, ci) and x = (xr, xi), a accumulates (xr*cr, xi*cr) and b accumulates (xi*ci, xr*ci);
+// the product x*c is (a0 - b0, a1 + b1), i.e. an addsub of the two accumulators.
+
+template <size_t F>
+__attribute__((target("avx2,fma")))
+static void unmix_tile_avx2(const float* im, size_t imStride, const float* coeff, size_t pixels, size_t srcCHA, size_t start, size_t end, float* res, size_t resStride)
+{
+    size_t p = start;
+    for (; p + 4 <= end; p += 4)
+    {
+        __m256 a[F], b[F];
+        for (size_t f = 0; f < F; f++)
+        {
+            a[f] = _mm256_setzero_ps();
+            b[f] = _mm256_setzero_ps();
+        }
+
+        for (size_t cha = 0; cha < srcCHA; cha++)
+        {
+            __m256 c = _mm256_loadu_ps(coeff + 2 * (cha*pixels + p));
+            __m256 cr = _mm256_moveldup_ps(c);
+            __m256 ci = _mm256_movehdup_ps(c);
+
+            for (size_t f = 0; f < F; f++)
+            {
+                __m256 x = _mm256_loadu_ps(im + 2 * (f*imStride + cha*pixels + p));
+                a[f] = _mm256_fmadd_ps(x, cr, a[f]);
+                b[f] = _mm256_fmadd_ps(_mm256_permute_ps(x, 0xB1), ci, b[f]);
+            }
+        }
+
+        for (size_t f = 0; f < F; f++)
+        {
+            _mm256_storeu_ps(res + 2 * (f*resStride + p), _mm256_addsub_ps(a[f], b[f]));
+        }
+    }
+
+    unmix_tile<float, F>(im, imStride, coeff, pixels, srcCHA, p, end, res, resStride);
+}
+
+template <size_t F>
+__attribute__((target("avx512f")))
+static void unmix_tile_avx512(const float* im, size_t imStride, const float* coeff, size_t pixels, size_t srcCHA, size_t start, size_t end, float* res, size_t resStride)
+{
+    const __m512 one = _mm512_set1_ps(1.0f);
+
+    size_t p = start;
+    for (; p + 8 <= end; p += 8)
+    {
+        __m512 a[F], b[F];
+        for (size_t f = 0; f < F; f++)
+        {
+            a[f] = _mm512_setzero_ps();
+            b[f] = _mm512_setzero_ps();
+        }
+
+        for (size_t cha = 0; cha < srcCHA; cha++)
+        {
+            __m512 c = _mm512_loadu_ps(coeff + 2 * (cha*pixels + p));
+            __m512 cr = _mm512_shuffle_ps(c, c, 0xA0);
+            __m512 ci = _mm512_shuffle_ps(c, c, 0xF5);
+
+            for (size_t f = 0; f < F; f++)
+            {
+                __m512 x = _mm512_loadu_ps(im + 2 * (f*imStride + cha*pixels + p));
+                a[f] = _mm512_fmadd_ps(x, cr, a[f]);
+                b[f] = _mm512_fmadd_ps(_mm512_shuffle_ps(x, x, 0xB1), ci, b[f]);
+            }
+        }
+
+        // there is no addsub for 512 bit registers, a*1 -/+ b does the same
+        for (size_t f = 0; f < F; f++)
+        {
+            _mm512_storeu_ps(res + 2 * (f*resStride + p), _mm512_fmaddsub_ps(a[f], one, b[f]));
+        }
+    }
+
+    unmix_tile<float, F>(im, imStride, coeff, pixels, srcCHA, p, end, res, resStride);
+}
+
+enum unmix_isa
+{
+    UNMIX_SCALAR,
+    UNMIX_AVX2,
+    UNMIX_AVX512
+};
+
+static unmix_isa detect_unmix_isa()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return UNMIX_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return UNMIX_AVX2;
+    return UNMIX_SCALAR;
+}
+
+#endif // GRAPPA_UNMIX_X86
+
+template <typename R, size_t F>
+struct unmix_kernel
+{
+    static void run(const std::complex<R>* im, size_t imStride, const std::complex<R>* coeff, size_t pixels, size_t srcCHA, size_t start, size_t end, std::complex<R>* res, size_t resStride)
+    {
+        unmix_tile<R, F>(reinterpret_cast<const R*>(im), imStride, reinterpret_cast<const R*>(coeff), pixels, srcCHA, start, end, reinterpret_cast<R*>(res), resStride);
+    }
+};
+
+template <size_t F>
+struct unmix_kernel<float, F>
+{
+    static void run(const std::complex<float>* im, size_t imStride, const std::complex<float>* coeff, size_t pixels, size_t srcCHA, size_t start, size_t end, std::complex<float>* res, size_t resStride)
+    {
+        const float* pIm = reinterpret_cast<const float*>(im);
+        const float* pCoeff = reinterpret_cast<const float*>(coeff);
+        float* pRes = reinterpret_cast<float*>(res);
+
+#ifdef GRAPPA_UNMIX_X86
+        static const unmix_isa isa = detect_unmix_isa();
+        if (isa == UNMIX_AVX512)
+        {
+            unmix_tile_avx512<F>(pIm, imStride, pCoeff, pixels, srcCHA, start, end, pRes, resStride);
+            return;
+        }
+        if (isa == UNMIX_AVX2)
+        {
+            unmix_tile_avx2<F>(pIm, imStride, pCoeff, pixels, srcCHA, start, end, pRes, resStride);
+            return;
+        }
+#endif // GRAPPA_UNMIX_X86
+
+        unmix_tile<float, F>(pIm, imStride, pCoeff, pixels, srcCHA, start, end, pRes, resStride);
+    }
+};
+
+template <typename R>
+static void unmix_images(const std::complex<R>* im, size_t imStride, const std::complex<R>* coeff, size_t pixels, size_t srcCHA, size_t numIm, size_t start, size_t end, std::complex<R>* res, size_t resStride)
+{
+    switch (numIm)
+    {
+    case 1:
+        unmix_kernel<R, 1>::run(im, imStride, coeff, pixels, srcCHA, start, end, res, resStride);
+        break;
+    case 2:
+        unmix_kernel<R, 2>::run(im, imStride, coeff, pixels, srcCHA, start, end, res, resStride);
+        break;
+    case 3:
+        unmix_kernel<R, 3>::run(im, imStride, coeff, pixels, srcCHA, start, end, res, resStride);
+        break;
+    default:
+        unmix_kernel<R, unmix_image_block>::run(im, imStride, coeff, pixels, srcCHA, start, end, res, resStride);
+        break;
+    }
+}
+
+template <typename T>
+void apply_unmix_coeff_multiple_groups(const std::vector<const T*>& aliasedIm, size_t imStride, const std::vector<const T*>& unmixCoeff, size_t pixels, size_t srcCHA, const std::vector<size_t>& num, const std::vector<T*>& complexIm, size_t resStride)
+{
+    typedef typename realType<T>::Type R;
+
+    size_t numGroups = num.size();
+    GADGET_CHECK_THROW(aliasedIm.size() == numGroups);
+    GADGET_CHECK_THROW(unmixCoeff.size() == numGroups);
+    GADGET_CHECK_THROW(complexIm.size() == numGroups);
+
+    // blocks of images of all groups, every block is unmixed with the coefficients of its group
+    std::vector<size_t> blockGroup, blockStart;
+    size_t totalIm = 0;
+    for (size_t g = 0; g < numGroups; g++)
+    {
+        for (size_t n = 0; n < num[g]; n += unmix_image_block)
+        {
+            blockGroup.push_back(g);
+            blockStart.push_back(n);
+        }
+        totalIm += num[g];
+    }
+
+    long long numBlocks = (long long)blockGroup.size();
+    long long numTiles = (long long)((pixels + unmix_tile_pixels - 1) / unmix_tile_pixels);
+    long long numItems = numBlocks*numTiles;
+    size_t work = pixels*srcCHA*totalIm;
+
+    // one flat loop over tiles and blocks, consecutive items share the coefficient tile of a group
+    long long ii;
+
+#pragma omp parallel for private(ii) shared(aliasedIm, imStride, unmixCoeff, pixels, srcCHA, num, complexIm, resStride, numBlocks, numItems, blockGroup, blockStart) if(numItems>1 && work>=65536)
+    for (ii = 0; ii < numItems; ii++)
+    {
+        size_t t = ii / numBlocks;
+        size_t b = ii - t*numBlocks;
+
+        size_t start = t*unmix_tile_pixels;
+        size_t end = std::min(start + unmix_tile_pixels, pixels);
+
+        size_t g = blockGroup[b];
+        size_t n = blockStart[b];
+        size_t numIm = std::min(unmix_image_block, num[g] - n);
+
+        unmix_images<R>(aliasedIm[g] + n*imStride, imStride, unmixCoeff[g], pixels, srcCHA, numIm, start, end, complexIm[g] + n*resStride, resStride);
+    }
+}
+
+template EXPORTMRICORE void apply_unmix_coeff_multiple_groups(const std::vector<const std::complex<float>*>& aliasedIm, size_t imStride, const std::vector<const std::complex<float>*>& unmixCoeff, size_t pixels, size_t srcCHA, const std::vector<size_t>& num, const std::vector<std::complex<float>*>& complexIm, size_t resStride);
+template EXPORTMRICORE void apply_unmix_coeff_multiple_groups(const std::vector<const std::complex<double>*>& aliasedIm, size_t imStride, const std::vector<const std::complex<double>*>& unmixCoeff, size_t pixels, size_t srcCHA, const std::vector<size_t>& num, const std::vector<std::complex<double>*>& complexIm, size_t resStride);
+
+// ------------------------------------------------------------------------
+
+template <typename T>
+void apply_unmix_coeff_multiple_images(const T* aliasedIm, size_t imStride, const T* unmixCoeff, size_t pixels, size_t srcCHA, size_t num, T* complexIm, size_t resStride)
+{
+    Gadgetron::apply_unmix_coeff_multiple_groups(std::vector<const T*>(1, aliasedIm), imStride, std::vector<const T*>(1, unmixCoeff), pixels, srcCHA, std::vector<size_t>(1, num), std::vector<T*>(1, complexIm), resStride);
+}
+
+template EXPORTMRICORE void apply_unmix_coeff_multiple_images(const std::complex<float>* aliasedIm, size_t imStride, const std::complex<float>* unmixCoeff, size_t pixels, size_t srcCHA, size_t num, std::complex<float>* complexIm, size_t resStride);
+template EXPORTMRICORE void apply_unmix_coeff_multiple_images(const std::complex<double>* aliasedIm, size_t imStride, const std::complex<double>* unmixCoeff, size_t pixels, size_t srcCHA, size_t num, std::complex<double>* complexIm, size_t resStride);
+
+// ------------------------------------------------------------------------
+
 template <typename T>
 void apply_unmix_coeff_kspace(const hoNDArray<T>& kspace, const hoNDArray<T>& unmixCoeff, hoNDArray<T>& complexIm)
 {
@@ -600,8 +860,11 @@ void apply_unmix_coeff_kspace(const hoNDArray<T>& kspace, const hoNDArray<T>& un
             complexIm.create(&dim);
         }
 
-        Gadgetron::multiply(buffer2DT, unmixCoeff, buffer2DT);
-        Gadgetron::sum_over_dimension(buffer2DT, complexIm, 2);
+        size_t pixels = kspace.get_size(0)*kspace.get_size(1);
+        size_t srcCHA = kspace.get_size(2);
+        size_t num = kspace.get_number_of_elements() / (pixels*srcCHA);
+
+        Gadgetron::apply_unmix_coeff_multiple_images(buffer2DT.begin(), pixels*srcCHA, unmixCoeff.begin(), pixels, srcCHA, num, complexIm.begin(), pixels);
     }
     catch (...)
     {
@@ -632,10 +895,11 @@ void apply_unmix_coeff_aliased_image(const hoNDArray<T>& aliasedIm, const hoNDAr
             complexIm.create(&dim);
         }
 
-        hoNDArray<T> buffer2DT(aliasedIm);
+        size_t pixels = aliasedIm.get_size(0)*aliasedIm.get_size(1);
+        size_t srcCHA = aliasedIm.get_size(2);
+        size_t num = aliasedIm.get_number_of_elements() / (pixels*srcCHA);
 
-        Gadgetron::multiply(aliasedIm, unmixCoeff, buffer2DT);
-        Gadgetron::sum_over_dimension(buffer2DT, complexIm, 2);
+        Gadgetron::apply_unmix_coeff_multiple_images(aliasedIm.begin(), pixels*srcCHA, unmixCoeff.begin(), pixels, srcCHA, num, complexIm.begin(), pixels);
     }
     catch (...)
     {
@@ -1491,12 +1755,7 @@ void apply_unmix_coeff_kspace_3D(const hoNDArray<T>& kspace, const hoNDArray<T>&
         buffer.create(dim);
         Gadgetron::hoNDFFT<typename realType<T>::Type>::instance()->ifft3c(kspace, aliasedIm, buffer);
 
-        Gadgetron::multiply(aliasedIm, unmixCoeff, buffer);
-
-        hoNDArray<T> bufferIm;
-        bufferIm.create(RO, E1, E2, 1, N, complexIm.begin());
-
-        Gadgetron::sum_over_dimension(buffer, bufferIm, 3);
+        Gadgetron::apply_unmix_coeff_multiple_images(aliasedIm.begin(), RO*E1*E2*srcCHA, unmixCoeff.begin(), RO*E1*E2, srcCHA, N, complexIm.begin(), RO*E1*E2);
     }
     catch (...)
     {
@@ -1521,9 +1780,6 @@ void apply_unmix_coeff_aliased_image_3D(const hoNDArray<T>& aliasedIm, const hoN
 
         size_t N = aliasedIm.get_size(4);
 
-        std::vector<size_t> dim;
-        aliasedIm.get_dimensions(dim);
-
         GADGET_CHECK_THROW(unmixCoeff.get_size(0) == RO);
         GADGET_CHECK_THROW(unmixCoeff.get_size(1) == E1);
         GADGET_CHECK_THROW(unmixCoeff.get_size(2) == E2);
@@ -1537,15 +1793,7 @@ void apply_unmix_coeff_aliased_image_3D(const hoNDArray<T>& aliasedIm, const hoN
             complexIm.create(RO, E1, E2, N);
         }
 
-        hoNDArray<T> buffer;
-        buffer.create(dim);
-
-        Gadgetron::multiply(aliasedIm, unmixCoeff, buffer);
-
-        hoNDArray<T> bufferIm;
-        bufferIm.create(RO, E1, E2, 1, N, complexIm.begin());
-
-        Gadgetron::sum_over_dimension(buffer, bufferIm, 3);
+        Gadgetron::apply_unmix_coeff_multiple_images(aliasedIm.begin(), RO*E1*E2*srcCHA, unmixCoeff.begin(), RO*E1*E2, srcCHA, N, complexIm.begin(), RO*E1*E2);
     }
     catch (...)
     {
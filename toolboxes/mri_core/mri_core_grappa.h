@@ -58,6 +58,18 @@ namespace Gadgetron {
     /// aliasedIm : [RO E1 srcCHA ...]
     template <typename T> EXPORTMRICORE void apply_unmix_coeff_aliased_image(const hoNDArray<T>& aliasedIm, const hoNDArray<T>& unmixCoeff, hoNDArray<T>& complexIm);
 
+    /// apply unmixing coefficient to several aliased images sharing the same coefficient, used by the apply_unmix_coeff functions
+    /// aliasedIm : num images, image n starts at aliasedIm + n*imStride and holds srcCHA channels of pixels each
+    /// unmixCoeff : [pixels srcCHA]
+    /// complexIm : num images of [pixels], image n starts at complexIm + n*resStride
+    /// the coefficients are tiled and read once for every block of images; for std::complex<float>, AVX2 or AVX-512 is used if the cpu supports it
+    template <typename T> EXPORTMRICORE void apply_unmix_coeff_multiple_images(const T* aliasedIm, size_t imStride, const T* unmixCoeff, size_t pixels, size_t srcCHA, size_t num, T* complexIm, size_t resStride);
+
+    /// apply unmixing coefficient to groups of aliased images, the images of group g share the coefficient unmixCoeff[g]
+    /// group g has num[g] images, starting at aliasedIm[g] and complexIm[g], with the strides as above
+    /// tiles and blocks of images of all groups are unmixed in one parallel loop, so single-image groups are balanced with large ones
+    template <typename T> EXPORTMRICORE void apply_unmix_coeff_multiple_groups(const std::vector<const T*>& aliasedIm, size_t imStride, const std::vector<const T*>& unmixCoeff, size_t pixels, size_t srcCHA, const std::vector<size_t>& num, const std::vector<T*>& complexIm, size_t resStride);
+
     /// ------------------------
     /// grappa 2d low level functions
     /// ------------------------
@@ -138,6 +138,81 @@ namespace Gadgetron {
             }
             return deapodization;
         }
+
+        /**
+            out = in*filter, with in zero padded to the size of the filter as pad() does.
+            The filter is repeated over the dimensions beyond D.
+        */
+        template<class T, unsigned int D> void
+        pad_deapodize(const hoNDArray<T>& in, const hoNDArray<T>& filter, hoNDArray<T>& out) {
+
+            auto matrix_size_in = from_std_vector<size_t, D>(*in.get_dimensions());
+            auto matrix_size_out = from_std_vector<size_t, D>(*filter.get_dimensions());
+
+            if (weak_greater(matrix_size_in, matrix_size_out))
+                throw std::runtime_error("pad_deapodize: size mismatch, cannot expand");
+
+            if (matrix_size_in != matrix_size_out) clear(&out);
+
+            vector_td<size_t, D> offset;
+            for (unsigned int d = 0; d < D; d++)
+                offset[d] = matrix_size_out[d]/2 - matrix_size_in[d]/2;
+
+            size_t len = in.get_size(0);
+            size_t lines = in.get_number_of_elements()/len;
+            size_t frame = filter.get_number_of_elements();
+
+            const T* in_ptr = in.get_data_ptr();
+            const T* filter_ptr = filter.get_data_ptr();
+            T* out_ptr = out.get_data_ptr();
+
+#pragma omp parallel for
+            for (long long k = 0; k < (long long)lines; k++) {
+                auto ind = in.calculate_index(k*len);
+                for (unsigned int d = 0; d < D; d++) ind[d] += offset[d];
+
+                size_t out_offset = out.calculate_offset(ind);
+                const T* filter_line = filter_ptr + out_offset%frame;
+                const T* in_line = in_ptr + k*len;
+                T* out_line = out_ptr + out_offset;
+                for (size_t p = 0; p < len; p++) out_line[p] = in_line[p]*filter_line[p];
+            }
+        }
+
+        /**
+            out = in*filter, cropped to crop_size as crop() does.
+            The filter has the size of in and is repeated over the dimensions beyond D.
+        */
+        template<class T, unsigned int D> void
+        crop_deapodize(const vector_td<size_t, D>& crop_offset, const vector_td<size_t, D>& crop_size,
+                       const hoNDArray<T>& filter, const hoNDArray<T>& in, hoNDArray<T>& out) {
+
+            std::vector<size_t> dims = to_std_vector(crop_size);
+            for (unsigned int d = D; d < in.get_number_of_dimensions(); d++)
+                dims.push_back(in.get_size(d));
+
+            if (!out.dimensions_equal(&dims)) out.create(dims);
+
+            size_t len = out.get_size(0);
+            size_t lines = out.get_number_of_elements()/len;
+            size_t frame = filter.get_number_of_elements();
+
+            const T* in_ptr = in.get_data_ptr();
+            const T* filter_ptr = filter.get_data_ptr();
+            T* out_ptr = out.get_data_ptr();
+
+#pragma omp parallel for
+            for (long long k = 0; k < (long long)lines; k++) {
+                auto ind = out.calculate_index(k*len);
+                for (unsigned int d = 0; d < D; d++) ind[d] += crop_offset[d];
+
+                size_t in_offset = in.calculate_offset(ind);
+                const T* filter_line = filter_ptr + in_offset%frame;
+                const T* in_line = in_ptr + in_offset;
+                T* out_line = out_ptr + k*len;
+                for (size_t p = 0; p < len; p++) out_line[p] = in_line[p]*filter_line[p];
+            }
+        }
     }
 
 
@@ -190,14 +265,14 @@ namespace Gadgetron {
            return (point+REAL(0.5))*matrix_size_os_real;
         });
 
+        // The same matrix serves both directions, the adjoint convolution scatters it tile by tile
+        convolution_matrix.clear();
         convolution_matrix.reserve(this->number_of_frames);
-        convolution_matrix_T.reserve(this->number_of_frames);
+
+        auto cache = NFFT_internal::NFFT_MatrixCache<REAL,D>::instance();
 
         for (auto traj : NDArrayViewRange<hoNDArray<vector_td<REAL,D>>>(trajectories_scaled,0)){
-            convolution_matrix.push_back(NFFT_internal::make_NFFT_matrix(traj, this->matrix_size_os, this->W, beta));
-            if (mode == NFFT_prep_mode::ALL || mode == NFFT_prep_mode::NC2C) {
-                convolution_matrix_T.push_back(NFFT_internal::transpose(convolution_matrix.back()));
-            }
+            convolution_matrix.push_back(cache->get(traj, this->matrix_size_os, this->W, beta));
         }
 
 
@@ -223,7 +298,61 @@ namespace Gadgetron {
             const hoNDArray<REAL> *dcw,
             NFFT_comp_mode mode
     ) {
-       NFFT_plan<hoNDArray,REAL,D>::compute(d,m,dcw,mode);
+        const auto *pd = reinterpret_cast<const hoNDArray<ComplexType> *>(&d);
+        auto *pm = reinterpret_cast<hoNDArray<ComplexType> *>(&m);
+
+        // The fused paths apply the density compensation per frame, which needs one weight per sample
+        bool frame_dcw = !dcw || dcw->get_number_of_elements() == this->number_of_samples*this->number_of_frames;
+
+        if (mode == NFFT_comp_mode::FORWARDS_C2NC && frame_dcw && !convolution_matrix.empty()) {
+            compute_NFFT_C2NC_fused(*pd, *pm, dcw ? dcw->get_data_ptr() : nullptr);
+        } else if (mode == NFFT_comp_mode::BACKWARDS_NC2C && frame_dcw && !convolution_matrix.empty()) {
+            compute_NFFTH_NC2C_fused(*pd, *pm, dcw ? dcw->get_data_ptr() : nullptr);
+        } else {
+            NFFT_plan<hoNDArray,REAL,D>::compute(d,m,dcw,mode);
+        }
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFT_plan<REAL, D>::compute_NFFT_C2NC_fused(
+            const hoNDArray<ComplexType> &image,
+            hoNDArray<ComplexType> &samples,
+            const REAL* dcw
+    ) {
+        auto vec_dims = to_std_vector(this->matrix_size_os);
+        for (unsigned int d = D; d < image.get_number_of_dimensions(); d++)
+            vec_dims.push_back(image.get_size(d));
+
+        hoNDArray<ComplexType> working_image(vec_dims);
+        pad_deapodize<ComplexType,D>(image, deapodization_filter_IFFT, working_image);
+        this->fft(working_image, NFFT_fft_mode::FORWARDS);
+        convolve_NFFT_C2NC(working_image, samples, false, dcw);
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFT_plan<REAL, D>::compute_NFFTH_NC2C_fused(
+            const hoNDArray<ComplexType> &samples,
+            hoNDArray<ComplexType> &image,
+            const REAL* dcw
+    ) {
+        auto image_dims = from_std_vector<size_t, D>(*image.get_dimensions());
+        bool oversampled_image = (image_dims == this->matrix_size_os);
+
+        auto vec_dims = to_std_vector(this->matrix_size_os);
+        for (unsigned int d = D; d < image.get_number_of_dimensions(); d++)
+            vec_dims.push_back(image.get_size(d));
+
+        if (oversampled_image) {
+            convolve_NFFT_NC2C(samples, image, false, dcw);
+            this->fft(image, NFFT_fft_mode::BACKWARDS);
+            deapodize(image);
+        } else {
+            hoNDArray<ComplexType> working_image(vec_dims);
+            convolve_NFFT_NC2C(samples, working_image, false, dcw);
+            this->fft(working_image, NFFT_fft_mode::BACKWARDS);
+            crop_deapodize<ComplexType,D>((this->matrix_size_os - this->matrix_size) >> 1, this->matrix_size,
+                                          deapodization_filter_IFFT, working_image, image);
+        }
     }
 
 
@@ -246,13 +375,15 @@ namespace Gadgetron {
             hoNDArray<ComplexType> &out,
             const hoNDArray<REAL>* dcw
     ) {
+        // in is an image, so the forwards NFFT comes first
         std::vector<size_t> dims = {this->number_of_samples,this->number_of_frames};
-        auto batches = in.get_number_of_elements()/(prod(this->matrix_size_os)*this->number_of_frames);
+        size_t image_elements = from_std_vector<size_t,D>(*in.get_dimensions()) == this->matrix_size_os ? prod(this->matrix_size_os) : prod(this->matrix_size);
+        auto batches = in.get_number_of_elements()/(image_elements*this->number_of_frames);
         dims.push_back(batches);
 
         hoNDArray<ComplexType> tmp(dims);
-        compute(in, tmp, dcw, NFFT_comp_mode::BACKWARDS_NC2C);
-        compute(tmp, out,dcw, NFFT_comp_mode::FORWARDS_C2NC);
+        compute(in, tmp, dcw, NFFT_comp_mode::FORWARDS_C2NC);
+        compute(tmp, out,dcw, NFFT_comp_mode::BACKWARDS_NC2C);
     }
 
     template<class REAL, unsigned int D>
@@ -323,18 +454,53 @@ namespace Gadgetron {
 
 
     namespace {
+        /**
+            result += matrix*vector, optionally scaling the entries of result by out_weights.
+            Each stored column is a gather from vector, so the columns can be processed in any order.
+        */
         template<class REAL> void
-        matrix_vector_multiply(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL>& matrix, const complext<REAL>* vector, complext<REAL>* result) {
+        matrix_vector_multiply(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL>& matrix, const complext<REAL>* vector, complext<REAL>* result,
+                               const REAL* out_weights) {
 
-            for (size_t i = 0; i < matrix.n_cols; i++) {
-                auto &row_indices = matrix.indices[i];
-                auto &weights = matrix.weights[i];
+            const size_t* offsets = matrix.column_offsets.data();
+            const auto* indices = matrix.indices.data();
+            const REAL* weights = matrix.weights.data();
+
+            for (size_t j = 0; j < matrix.n_cols; j++) {
+                REAL re = 0, im = 0;
 
 #ifndef WIN32
-    #pragma omp simd
+    #pragma omp simd reduction(+:re,im)
 #endif // WIN32
-                for (size_t n = 0; n < row_indices.size(); n++) {
-                    result[i] += vector[row_indices[n]] * weights[n];
+                for (size_t n = offsets[j]; n < offsets[j+1]; n++) {
+                    re += vector[indices[n]].real() * weights[n];
+                    im += vector[indices[n]].imag() * weights[n];
+                }
+
+                complext<REAL> sum(re, im);
+                size_t i = matrix.column(j);
+                result[i] += out_weights ? sum * out_weights[i] : sum;
+            }
+        }
+
+        /**
+            result += transpose(matrix)*vector for the stored columns [range.first, range.second),
+            optionally scaling the entries of vector by in_weights.
+        */
+        template<class REAL> void
+        scatter_tile(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL>& matrix, const std::pair<size_t,size_t>& range,
+                     const complext<REAL>* vector, complext<REAL>* result, const REAL* in_weights) {
+
+            const size_t* offsets = matrix.column_offsets.data();
+            const auto* indices = matrix.indices.data();
+            const REAL* weights = matrix.weights.data();
+
+            for (size_t j = range.first; j < range.second; j++) {
+                size_t i = matrix.column(j);
+                complext<REAL> value = in_weights ? vector[i] * in_weights[i] : vector[i];
+
+                for (size_t n = offsets[j]; n < offsets[j+1]; n++) {
+                    result[indices[n]] += value * weights[n];
                 }
             }
         }
@@ -343,21 +509,23 @@ namespace Gadgetron {
     template<class REAL, unsigned int D>
     void hoNFFT_plan<REAL, D>::convolve_NFFT_C2NC(
             const hoNDArray<ComplexType> &cartesian,
-            hoNDArray<ComplexType> &non_cartesian, bool accumulate
+            hoNDArray<ComplexType> &non_cartesian, bool accumulate,
+            const REAL* dcw
     ) {
-
-        size_t nbatches = cartesian.get_number_of_elements()/convolution_matrix.front().n_rows;
-        assert(nbatches == non_cartesian.get_number_of_elements()/convolution_matrix.front().n_cols);
+        const auto& matrix = *convolution_matrix.front();
+        size_t nbatches = cartesian.get_number_of_elements()/matrix.n_rows;
+        assert(nbatches == non_cartesian.get_number_of_elements()/matrix.n_cols);
 
         if (!accumulate) clear(&non_cartesian);
 
 #pragma omp parallel for
         for (int b = 0; b < (int)nbatches; b++) {
 
-            const ComplexType* cartesian_view = cartesian.get_data_ptr()+b*convolution_matrix.front().n_rows;
-            ComplexType* non_cartesian_view = non_cartesian.get_data_ptr()+b*convolution_matrix.front().n_cols;
+            const ComplexType* cartesian_view = cartesian.get_data_ptr()+b*matrix.n_rows;
+            ComplexType* non_cartesian_view = non_cartesian.get_data_ptr()+b*matrix.n_cols;
             size_t matrix_index = b%convolution_matrix.size();
-            matrix_vector_multiply(convolution_matrix[matrix_index],(complext<REAL>*)cartesian_view,(complext<REAL>*)non_cartesian_view);
+            const REAL* dcw_view = dcw ? dcw+matrix_index*matrix.n_cols : nullptr;
+            matrix_vector_multiply(*convolution_matrix[matrix_index],(complext<REAL>*)cartesian_view,(complext<REAL>*)non_cartesian_view,dcw_view);
         }
 
     }
@@ -365,20 +533,38 @@ namespace Gadgetron {
     template<class REAL, unsigned int D>
     void hoNFFT_plan<REAL, D>::convolve_NFFT_NC2C(
             const hoNDArray<ComplexType> &non_cartesian,
-            hoNDArray<ComplexType> &cartesian, bool accumulate
+            hoNDArray<ComplexType> &cartesian, bool accumulate,
+            const REAL* dcw
     ) {
-                size_t nbatches = cartesian.get_number_of_elements()/convolution_matrix.front().n_rows;
-        assert(nbatches == non_cartesian.get_number_of_elements()/convolution_matrix.front().n_cols);
+        size_t n_rows = convolution_matrix.front()->n_rows;
+        size_t n_cols = convolution_matrix.front()->n_cols;
+        size_t nbatches = cartesian.get_number_of_elements()/n_rows;
+        assert(nbatches == non_cartesian.get_number_of_elements()/n_cols);
         GadgetronTimer timer("Convolution");
         if (!accumulate) clear(&cartesian);
-#pragma omp parallel for
-        for (int b = 0; b < (int)nbatches; b++) {
 
-            ComplexType *cartesian_view = cartesian.get_data_ptr() + b * convolution_matrix.front().n_rows;
-            const ComplexType *non_cartesian_view = non_cartesian.get_data_ptr() + b * convolution_matrix.front().n_cols;
-            size_t matrix_index = b%convolution_matrix.size();
-            matrix_vector_multiply(convolution_matrix_T[matrix_index], (complext<REAL>*)non_cartesian_view, (complext<REAL>*)cartesian_view);
+        // Tiles of one colour write disjoint parts of the grid, so they are scattered concurrently
+        // straight into the output, without locks or per thread copies of the grid.
+        size_t nframes = convolution_matrix.size();
+        for (size_t f = 0; f < std::min(nframes, nbatches); f++) {
+
+            const auto& matrix = *convolution_matrix[f];
+            size_t frame_batches = (nbatches - f + nframes - 1)/nframes;
+            const REAL* dcw_view = dcw ? dcw+f*n_cols : nullptr;
+
+            for (const auto& tiles : matrix.tiles) {
+                long long work = (long long)(tiles.size()*frame_batches);
 
+#pragma omp parallel for schedule(dynamic)
+                for (long long w = 0; w < work; w++) {
+                    size_t b = f + (w/tiles.size())*nframes;
+                    const auto& range = tiles[w%tiles.size()];
+
+                    ComplexType *cartesian_view = cartesian.get_data_ptr() + b * n_rows;
+                    const ComplexType *non_cartesian_view = non_cartesian.get_data_ptr() + b * n_cols;
+                    scatter_tile(matrix, range, (const complext<REAL>*)non_cartesian_view, (complext<REAL>*)cartesian_view, dcw_view);
+                }
+            }
         }
     }
 
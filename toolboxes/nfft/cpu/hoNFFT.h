@@ -186,12 +186,34 @@ namespace Gadgetron{
 
             void convolve_NFFT_C2NC(
                 const hoNDArray<ComplexType> &d,
-                hoNDArray<ComplexType> &m, bool accumulate
+                hoNDArray<ComplexType> &m, bool accumulate,
+                const REAL* dcw = nullptr
             );
 
             void convolve_NFFT_NC2C(
                 const hoNDArray<ComplexType> &d,
-                hoNDArray<ComplexType> &m, bool accumulate
+                hoNDArray<ComplexType> &m, bool accumulate,
+                const REAL* dcw = nullptr
+            );
+
+            /**
+                Fused NFFT paths for images that are not oversampled
+
+                Deapodization is done while padding or cropping the image,
+                and the density compensation while convolving, which saves
+                the copies of the image and of the samples made by the
+                generic NFFT_plan::compute.
+            */
+            void compute_NFFT_C2NC_fused(
+                const hoNDArray<ComplexType> &image,
+                hoNDArray<ComplexType> &samples,
+                const REAL* dcw
+            );
+
+            void compute_NFFTH_NC2C_fused(
+                const hoNDArray<ComplexType> &samples,
+                hoNDArray<ComplexType> &image,
+                const REAL* dcw
             );
 
 
@@ -205,8 +227,7 @@ namespace Gadgetron{
         private:
 
         vector_td<REAL,D> beta;
-        std::vector<NFFT_internal::NFFT_Matrix<REAL>> convolution_matrix;
-        std::vector<NFFT_internal::NFFT_Matrix<REAL>> convolution_matrix_T;
+        std::vector<std::shared_ptr<const NFFT_internal::NFFT_Matrix<REAL>>> convolution_matrix;
 
         hoNDArray<ComplexType> deapodization_filter_IFFT;
         hoNDArray<ComplexType> deapodization_filter_FFT;
@@ -1,9 +1,115 @@
 #include "nfft_export.h"
 #include "hoNDArray_math.h"
+#include "hoNDArray_utils.h"
 #include "hoNFFT.h"
+#include "hoNFFTOperator.h"
+#include "vector_td_utilities.h"
+#include "GadgetronTimer.h"
 #include "../NFFTOperator.hpp"
 
 namespace Gadgetron{
+
+    template<class REAL, unsigned int D>
+    hoNFFTOperator<REAL, D>::hoNFFTOperator() : NFFTOperator<hoNDArray, REAL, D>(), toeplitz_(false) {
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::set_dcw(boost::shared_ptr<hoNDArray<REAL>> dcw) {
+        NFFTOperator<hoNDArray, REAL, D>::set_dcw(dcw);
+        toeplitz_kernel_.clear();
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::preprocess(const hoNDArray<typename reald<REAL, D>::Type>& trajectory) {
+        NFFTOperator<hoNDArray, REAL, D>::preprocess(trajectory);
+        trajectory_ = trajectory;
+        toeplitz_kernel_.clear();
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::compute_toeplitz_kernel() {
+
+        GadgetronTimer timer("Toeplitz kernel");
+
+        if (!this->plan_ || trajectory_.get_number_of_elements() == 0)
+            throw std::runtime_error("hoNFFTOperator::compute_toeplitz_kernel : operator not preprocessed");
+
+        size_t number_of_samples = trajectory_.get_size(0);
+        size_t number_of_frames = trajectory_.get_number_of_elements()/number_of_samples;
+
+        // mult_M and mult_MH both apply the density compensation, so E^H E weighs the samples by its square
+        hoNDArray<complext<REAL>> weights(number_of_samples, number_of_frames);
+        if (this->dcw_) {
+            if (this->dcw_->get_number_of_elements() != weights.get_number_of_elements())
+                throw std::runtime_error("hoNFFTOperator::compute_toeplitz_kernel : density compensation weights do not match the trajectory");
+
+            for (size_t i = 0; i < weights.get_number_of_elements(); i++)
+                weights[i] = complext<REAL>((*this->dcw_)[i]*(*this->dcw_)[i], REAL(0));
+        } else {
+            fill(&weights, complext<REAL>(REAL(1), REAL(0)));
+        }
+
+        // The point spread function for all differences of pixel positions, |n-m| < matrix_size, is the adjoint NFFT of the weights on the doubled grid
+        auto matrix_size = this->plan_->get_matrix_size();
+        auto matrix_size_os = this->plan_->get_matrix_size_os();
+
+        hoNFFT_plan<REAL, D> psf_plan(matrix_size*size_t(2), matrix_size_os*size_t(2), this->plan_->get_W());
+        psf_plan.preprocess(trajectory_, NFFT_prep_mode::NC2C);
+
+        auto kernel_dims = to_std_vector(matrix_size*size_t(2));
+        kernel_dims.push_back(number_of_frames);
+        toeplitz_kernel_.create(kernel_dims);
+
+        psf_plan.compute(weights, toeplitz_kernel_, nullptr, NFFT_comp_mode::BACKWARDS_NC2C);
+
+        // With unitary FFTs, a circular convolution is sqrt(N) times the product of the transforms
+        psf_plan.fft(toeplitz_kernel_, NFFT_fft_mode::FORWARDS);
+        toeplitz_kernel_ *= std::sqrt(REAL(prod(matrix_size*size_t(2))));
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::toeplitz_mult_MH_M(const hoNDArray<complext<REAL>>& in, hoNDArray<complext<REAL>>& out) {
+
+        if (toeplitz_kernel_.get_number_of_elements() == 0) compute_toeplitz_kernel();
+
+        auto matrix_size = this->plan_->get_matrix_size();
+        auto padded_size = matrix_size*size_t(2);
+
+        // Batches cycle through the frames, as in the NFFT
+        if (in.get_number_of_elements() % (prod(matrix_size)*toeplitz_kernel_.get_size(D)) != 0)
+            throw std::runtime_error("hoNFFTOperator::mult_MH_M : input does not match the number of frames of the trajectory");
+
+        hoNDArray<complext<REAL>> padded;
+        pad<complext<REAL>, D>(padded_size, in, padded);
+
+        this->plan_->fft(padded, NFFT_fft_mode::FORWARDS);
+        padded *= toeplitz_kernel_;
+        this->plan_->fft(padded, NFFT_fft_mode::BACKWARDS);
+
+        crop<complext<REAL>, D>((padded_size - matrix_size) >> 1, matrix_size, padded, out);
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::mult_MH_M(hoNDArray<complext<REAL>>* in, hoNDArray<complext<REAL>>* out, bool accumulate) {
+
+        if (!toeplitz_) {
+            NFFTOperator<hoNDArray, REAL, D>::mult_MH_M(in, out, accumulate);
+            return;
+        }
+
+        if (!in || !out) {
+            throw std::runtime_error("hoNFFTOperator::mult_MH_M : 0x0 input/output not accepted");
+        }
+
+        if (accumulate) {
+            hoNDArray<complext<REAL>> tmp_out;
+            toeplitz_mult_MH_M(*in, tmp_out);
+            *out += tmp_out;
+        } else {
+            toeplitz_mult_MH_M(*in, *out);
+        }
+    }
+
     template EXPORTNFFT class NFFTOperator<hoNDArray,float,1>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,float,2>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,float,3>;
@@ -11,5 +117,12 @@ namespace Gadgetron{
     template EXPORTNFFT class NFFTOperator<hoNDArray,double,1>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,double,2>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,double,3>;
-}
 
+    template EXPORTNFFT class hoNFFTOperator<float,1>;
+    template EXPORTNFFT class hoNFFTOperator<float,2>;
+    template EXPORTNFFT class hoNFFTOperator<float,3>;
+
+    template EXPORTNFFT class hoNFFTOperator<double,1>;
+    template EXPORTNFFT class hoNFFTOperator<double,2>;
+    template EXPORTNFFT class hoNFFTOperator<double,3>;
+}
@@ -0,0 +1,50 @@
+/** \file hoNFFTOperator.h
+    \brief NFFT encoding operator for the CPU, with an optional Toeplitz normal operator
+*/
+
+#pragma once
+
+#include "hoNDArray_math.h"
+#include "hoNFFT.h"
+#include "../NFFTOperator.h"
+
+namespace Gadgetron{
+
+    /**
+        In Toeplitz mode mult_MH_M does not grid. E^H E is a convolution of the image with the
+        point spread function of the trajectory, which is computed once per trajectory on a grid of
+        twice the matrix size. mult_MH_M then zero pads the image to that grid, and takes an FFT, a
+        pointwise multiplication with the Fourier transform of the point spread function, and an
+        inverse FFT. mult_M and mult_MH are not affected.
+
+        The point spread function includes the density compensation weights, and is recomputed if
+        they are changed after preprocessing.
+    */
+    template<class REAL, unsigned int D>
+    class EXPORTNFFT hoNFFTOperator : public NFFTOperator<hoNDArray,REAL,D>
+    {
+    public:
+
+        hoNFFTOperator();
+        virtual ~hoNFFTOperator() {}
+
+        void set_toeplitz(bool toeplitz) { toeplitz_ = toeplitz; }
+        bool get_toeplitz() const { return toeplitz_; }
+
+        virtual void set_dcw( boost::shared_ptr< hoNDArray<REAL> > dcw ) override;
+        virtual void preprocess(const hoNDArray<typename reald<REAL,D>::Type>& trajectory ) override;
+
+        virtual void mult_MH_M( hoNDArray< complext<REAL> > *in, hoNDArray< complext<REAL> > *out, bool accumulate = false ) override;
+
+    protected:
+
+        void compute_toeplitz_kernel();
+        void toeplitz_mult_MH_M( const hoNDArray< complext<REAL> >& in, hoNDArray< complext<REAL> >& out );
+
+        bool toeplitz_;
+        hoNDArray<vector_td<REAL,D>> trajectory_;
+
+        // Fourier transform of the point spread function on the doubled grid, one per frame
+        hoNDArray< complext<REAL> > toeplitz_kernel_;
+    };
+}
@@ -7,40 +7,55 @@
 #include "hoNFFT_sparseMatrix.h"
 #include "KaiserBessel_kernel.h"
 #include "vector_td_utilities.h"
-#include <boost/range/irange.hpp>
+#include <algorithm>
+#include <limits>
+#include <tuple>
 
 namespace {
     using namespace Gadgetron;
-
-
-
-
+    using Gadgetron::NFFT_internal::NFFT_Matrix;
 
     template<int N>
     struct iteration_counter {
     };
 
+    // First and last grid point covered by the kernel along one dimension
+    template<class REAL>
+    std::pair<int, int> kernel_extent(REAL point, REAL W) {
+        return std::make_pair(int(std::ceil(point - W * 0.5)), int(std::floor(point + W * 0.5)));
+    }
+
+    template<class REAL, unsigned int D>
+    size_t number_of_entries(const vector_td<REAL, D> &point, REAL W) {
+        size_t count = 1;
+        for (unsigned int d = 0; d < D; d++) {
+            auto extent = kernel_extent(point[d], W);
+            count *= size_t(std::max(extent.second - extent.first + 1, 0));
+        }
+        return count;
+    }
 
     template<class REAL, unsigned int D>
     void iterate_body(const vector_td<REAL, D> &point,
                       const vector_td<size_t, D> &matrix_size, REAL W, const vector_td<REAL, D> &beta,
-                      std::vector<size_t> &indices,
-                      std::vector<REAL> &weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<-1>) {
+                      typename NFFT_Matrix<REAL>::index_type *&indices,
+                      REAL *&weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<-1>) {
 
-        indices.push_back(index);
-        weights.push_back(KaiserBessel(abs(image_point - point), vector_td<REAL,D>(matrix_size), REAL(1) / W, beta));
+        *indices++ = typename NFFT_Matrix<REAL>::index_type(index);
+        *weights++ = KaiserBessel(abs(image_point - point), vector_td<REAL,D>(matrix_size), REAL(1) / W, beta);
 
     }
 
     template<class REAL, unsigned int D, int N>
     void iterate_body(const vector_td<REAL, D> &point,
                       const vector_td<size_t, D> &matrix_size, REAL W, const vector_td<REAL, D> &beta,
-                      std::vector<size_t> &indices,
-                      std::vector<REAL> &weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<N>) {
+                      typename NFFT_Matrix<REAL>::index_type *&indices,
+                      REAL *&weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<N>) {
 
         size_t frame_offset = std::accumulate(&matrix_size[0], &matrix_size[N], 1, std::multiplies<size_t>());
 
-        for (int i = std::ceil(point[N] - W * 0.5); i <= std::floor(point[N] + W * 0.5); i++) {
+        auto extent = kernel_extent(point[N], W);
+        for (int i = extent.first; i <= extent.second; i++) {
             auto wrapped_i = (i + matrix_size[N]) % matrix_size[N];
             size_t index2 = index + frame_offset * wrapped_i;
             image_point[N] = i;
@@ -49,25 +64,97 @@ namespace {
         }
     }
 
+    // Spreads the lowest bits of x so that D of them interleave into a Morton code
+    inline uint64_t spread_bits(uint64_t x, unsigned int D) {
+        uint64_t result = 0;
+        unsigned int bits = 64 / D;
+        for (unsigned int b = 0; b < bits; b++) {
+            result |= ((x >> b) & 1) << (b * D);
+        }
+        return result;
+    }
+
+    /**
+        Orders the samples by grid tile, and along a Z-order curve through the grid within a tile.
+
+        Tiles are at least the kernel width plus a margin wide, the last tile along a dimension takes
+        the remainder of the grid. Tiles are coloured so that two tiles of the same colour are separated by a
+        whole tile along some dimension, also across the periodic boundary. The kernel footprints of samples
+        in different tiles of one colour therefore never overlap, and those tiles can be gridded concurrently.
+     */
     template<class REAL, unsigned int D>
-    std::tuple<std::vector<size_t>, std::vector<REAL>>
-    get_indices(const vector_td<REAL, D> &point, const vector_td<size_t, D> &matrix_size,
-                REAL W, const vector_td<REAL, D> &beta) {
+    void tiled_order(const hoNDArray<vector_td<REAL, D>> &trajectories, const vector_td<size_t, D> &matrix_size,
+                     REAL W, NFFT_Matrix<REAL> &matrix) {
 
-        std::vector<size_t> indices;
-        indices.reserve(size_t(std::pow(std::ceil(W), D)));
+        typedef typename NFFT_Matrix<REAL>::index_type index_type;
 
-        std::vector<REAL> weights;
-        weights.reserve(size_t(std::pow(std::ceil(W), D)));
+        size_t tile_size = std::max<size_t>(16, size_t(std::ceil(W)) + 2);
 
-        vector_td<REAL, D> image_point;
-        size_t index = 0;
-        iterate_body(point, matrix_size, W, beta, indices, weights, image_point, index, iteration_counter<D - 1>());
+        vector_td<size_t, D> number_of_tiles;
+        size_t number_of_colours = 1;
+        for (unsigned int d = 0; d < D; d++) {
+            number_of_tiles[d] = std::max<size_t>(1, matrix_size[d] / tile_size);
+            number_of_colours *= 3;
+        }
 
-        return std::make_tuple(std::move(indices), std::move(weights));
-    }
+        size_t n = trajectories.get_number_of_elements();
+        std::vector<std::tuple<uint64_t, uint64_t, index_type>> codes(n);
+
+#pragma omp parallel for
+        for (long long i = 0; i < (long long)n; i++) {
+            uint64_t tile_code = 0;
+            uint64_t cell_code = 0;
+            for (unsigned int d = 0; d < D; d++) {
+                long long cell = (long long)std::floor(trajectories[i][d]);
+                cell = std::min(std::max(cell, 0LL), (long long)matrix_size[d] - 1);
+                size_t tile = std::min(size_t(cell) / tile_size, number_of_tiles[d] - 1);
+                tile_code |= spread_bits(uint64_t(tile), D) << d;
+                cell_code |= spread_bits(uint64_t(cell), D) << d;
+            }
+            codes[i] = std::make_tuple(tile_code, cell_code, index_type(i));
+        }
+
+        std::sort(codes.begin(), codes.end());
+
+        matrix.order.resize(n);
+        for (size_t i = 0; i < n; i++) matrix.order[i] = std::get<2>(codes[i]);
+
+        matrix.tiles.assign(number_of_colours, std::vector<std::pair<size_t, size_t>>());
+
+        for (size_t begin = 0; begin < n;) {
+            size_t end = begin + 1;
+            while (end < n && std::get<0>(codes[end]) == std::get<0>(codes[begin])) end++;
+
+            size_t colour = 0;
+            size_t stride = 1;
+            for (unsigned int d = 0; d < D; d++) {
+                long long cell = (long long)std::floor(trajectories[matrix.order[begin]][d]);
+                cell = std::min(std::max(cell, 0LL), (long long)matrix_size[d] - 1);
+                size_t tile = std::min(size_t(cell) / tile_size, number_of_tiles[d] - 1);
 
+                // With an odd number of tiles the first and last tile are neighbours across the boundary
+                bool last_of_odd = (number_of_tiles[d] % 2 == 1) && (number_of_tiles[d] > 1) && (tile == number_of_tiles[d] - 1);
+                colour += stride * (last_of_odd ? 2 : tile % 2);
+                stride *= 3;
+            }
 
+            matrix.tiles[colour].push_back(std::make_pair(begin, end));
+            begin = end;
+        }
+    }
+
+    template<class REAL, unsigned int D>
+    uint64_t trajectory_hash(const hoNDArray<vector_td<REAL, D>> &trajectory) {
+        // FNV-1a
+        uint64_t h = 14695981039346656037ULL;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(trajectory.get_data_ptr());
+        size_t len = trajectory.get_number_of_elements() * sizeof(vector_td<REAL, D>);
+        for (size_t i = 0; i < len; i++) {
+            h ^= p[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
 }
 
 
@@ -77,60 +164,120 @@ Gadgetron::NFFT_internal::make_NFFT_matrix(const Gadgetron::hoNDArray<Gadgetron:
                                   const Gadgetron::vector_td<size_t, D> &image_dims, REAL W,
                                   const Gadgetron::vector_td<REAL, D> &beta) {
     GadgetronTimer timer("Make NFFT");
-//    std::vector<std::vector<size_t>> rowind;
-//    rowind.reserve(trajectories.get_number_of_elements() * std::ceil(std::pow(W, 3)));
-
-//    std::vector<size_t> colptr;
-//    colptr.reserve(trajectories.get_number_of_elements() + 1);
 
-//    std::vector<std::vector<REAL>> weights;
-//    weights.reserve(trajectories.get_number_of_elements() * std::ceil(std::pow(W, 3)));
+    typedef typename NFFT_Matrix<REAL>::index_type index_type;
+    if (trajectories.get_number_of_elements() > std::numeric_limits<index_type>::max() ||
+        prod(image_dims) > std::numeric_limits<index_type>::max())
+        throw std::runtime_error("make_NFFT_matrix: trajectory or oversampled matrix too large");
 
     NFFT_Matrix<REAL> matrix(trajectories.get_number_of_elements(),prod(image_dims));
-#pragma omp parallel for 
-    for (int i = 0; i < (int)trajectories.get_number_of_elements(); i++) {
-        std::tie(matrix.indices[i], matrix.weights[i]) = get_indices(trajectories[i], image_dims, W, beta);
+    tiled_order(trajectories, image_dims, W, matrix);
+
+    const long long n_cols = (long long)matrix.n_cols;
+
+#pragma omp parallel for
+    for (long long j = 0; j < n_cols; j++) {
+        matrix.column_offsets[j + 1] = number_of_entries(trajectories[matrix.order[j]], W);
     }
-    return matrix;
-}
+    std::partial_sum(matrix.column_offsets.begin(), matrix.column_offsets.end(), matrix.column_offsets.begin());
 
+    matrix.indices.resize(matrix.column_offsets.back());
+    matrix.weights.resize(matrix.column_offsets.back());
 
+#pragma omp parallel for
+    for (long long j = 0; j < n_cols; j++) {
+        index_type *indices = matrix.indices.data() + matrix.column_offsets[j];
+        REAL *weights = matrix.weights.data() + matrix.column_offsets[j];
+        vector_td<REAL, D> image_point;
+        iterate_body(trajectories[matrix.order[j]], image_dims, W, beta, indices, weights, image_point, 0,
+                     iteration_counter<D - 1>());
+    }
 
-template<class REAL>
-Gadgetron::NFFT_internal::NFFT_Matrix<REAL>
-Gadgetron::NFFT_internal::transpose(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL> &matrix) {
-    GadgetronTimer timer("Transpose");
+    return matrix;
+}
 
-    auto work_index = boost::irange(size_t(0),matrix.n_cols);
 
-    NFFT_Matrix<REAL> transposed(matrix.n_rows, matrix.n_cols);
 
-    std::vector<int> counts(matrix.n_rows, 0);
+template<class REAL, unsigned int D>
+Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>* Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::instance() {
+    static NFFT_MatrixCache<REAL, D> cache;
+    return &cache;
+}
 
+template<class REAL, unsigned int D>
+Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::NFFT_MatrixCache() : capacity_(8) {
+}
 
-    for (size_t i : work_index) {
-        auto &rows = matrix.indices[i];
-        for (auto &row : rows) {
-            counts[row]++;
+template<class REAL, unsigned int D>
+typename Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::MatrixPtr
+Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::get(const Gadgetron::hoNDArray<Gadgetron::vector_td<REAL, D>> &trajectory,
+                                                         const Gadgetron::vector_td<size_t, D> &image_dims, REAL W,
+                                                         const Gadgetron::vector_td<REAL, D> &beta) {
+
+    uint64_t hash = trajectory_hash(trajectory);
+    size_t n = trajectory.get_number_of_elements();
+
+    auto matches = [&](const Entry &entry) {
+        return entry.hash == hash && entry.W == W && entry.image_dims == image_dims && entry.beta == beta &&
+               entry.trajectory.size() == n &&
+               std::equal(entry.trajectory.begin(), entry.trajectory.end(), trajectory.get_data_ptr());
+    };
+
+    MatrixPtr matrix;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (matches(*it)) {
+                entries_.splice(entries_.begin(), entries_, it);
+                return entries_.front().matrix;
+            }
         }
     }
 
-    for (size_t i = 0; i < counts.size(); i++) {
-        transposed.indices[i].reserve(counts[i]);
-        transposed.weights[i].reserve(counts[i]);
-    }
+    // Computed without holding the lock, a concurrent request for the same trajectory may duplicate the work
+    matrix = std::make_shared<const NFFT_Matrix<REAL>>(make_NFFT_matrix(trajectory, image_dims, W, beta));
 
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) return matrix;
 
-    for (size_t i : work_index ) {
-        auto &rows = matrix.indices[i];
-        auto &weights = matrix.weights[i];
-        for (size_t n = 0; n < rows.size(); n++) {
-            transposed.indices[rows[n]].push_back(i);
-            transposed.weights[rows[n]].push_back(weights[n]);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (matches(*it)) {
+            entries_.splice(entries_.begin(), entries_, it);
+            return entries_.front().matrix;
         }
     }
 
-    return transposed;
+    Entry entry;
+    entry.hash = hash;
+    entry.trajectory.assign(trajectory.get_data_ptr(), trajectory.get_data_ptr() + n);
+    entry.image_dims = image_dims;
+    entry.W = W;
+    entry.beta = beta;
+    entry.matrix = matrix;
+    entries_.push_front(std::move(entry));
+
+    while (entries_.size() > capacity_) entries_.pop_back();
+
+    return matrix;
+}
+
+template<class REAL, unsigned int D>
+void Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::set_capacity(size_t entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = entries;
+    while (entries_.size() > capacity_) entries_.pop_back();
+}
+
+template<class REAL, unsigned int D>
+size_t Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+template<class REAL, unsigned int D>
+void Gadgetron::NFFT_internal::NFFT_MatrixCache<REAL, D>::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
 }
 
 
@@ -160,7 +307,9 @@ template Gadgetron::NFFT_internal::NFFT_Matrix<double> Gadgetron::NFFT_internal:
         const Gadgetron::hoNDArray<Gadgetron::vector_td<double, 3>> trajectories,
         const Gadgetron::vector_td<size_t, 3> &image_dims, double W, const Gadgetron::vector_td<double, 3> &beta);
 
-template Gadgetron::NFFT_internal::NFFT_Matrix<float> Gadgetron::NFFT_internal::transpose(
-        const Gadgetron::NFFT_internal::NFFT_Matrix<float> &matrix);
-template Gadgetron::NFFT_internal::NFFT_Matrix<double> Gadgetron::NFFT_internal::transpose(
-        const Gadgetron::NFFT_internal::NFFT_Matrix<double> &matrix);
\ No newline at end of file
+template class EXPORTNFFT Gadgetron::NFFT_internal::NFFT_MatrixCache<float, 1>;
+template class EXPORTNFFT Gadgetron::NFFT_internal::NFFT_MatrixCache<float, 2>;
+template class EXPORTNFFT Gadgetron::NFFT_internal::NFFT_MatrixCache<float, 3>;
+template class EXPORTNFFT Gadgetron::NFFT_internal::NFFT_MatrixCache<double, 1>;
+template class EXPORTNFFT Gadgetron::NFFT_internal::NFFT_MatrixCache<double, 2>;
+template class EXPORTNFFT Gadgetron::NFFT_internal::NFFT_MatrixCache<double, 3>;
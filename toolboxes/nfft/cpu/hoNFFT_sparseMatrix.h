@@ -3,30 +3,91 @@
 #include "hoArmadillo.h"
 #include "hoNDArray.h"
 #include "vector_td.h"
+#include "../nfft_export.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
 
 namespace Gadgetron {
     namespace NFFT_internal {
 
+        /**
+            Sparse convolution matrix in compressed column form.
+
+            The entries of stored column j are indices[column_offsets[j]] ... indices[column_offsets[j+1]-1],
+            with the matching weights. When order is not empty, stored column j is column order[j] of the matrix,
+            which lets make_NFFT_matrix keep the columns sorted along a space-filling curve.
+
+            make_NFFT_matrix also groups the stored columns by grid tile. tiles[c] holds the ranges [first, second)
+            of stored columns of the tiles of colour c, and the rows touched by two tiles of the same colour are
+            disjoint, so the transposed product can scatter the tiles of one colour in parallel without locking.
+         */
         template<class REAL> struct NFFT_Matrix {
 
-            NFFT_Matrix(size_t cols, size_t rows) : n_cols(cols),n_rows(rows) {
-                weights = std::vector<std::vector<REAL>>(n_cols);
-                indices = std::vector<std::vector<size_t>>(n_cols);
+            typedef uint32_t index_type;
+
+            NFFT_Matrix(size_t cols, size_t rows) : column_offsets(cols+1,0), n_cols(cols),n_rows(rows) {
             }
-            NFFT_Matrix(){}
-            std::vector<std::vector<REAL>> weights;
-            std::vector<std::vector<size_t>> indices;
+            NFFT_Matrix() : n_cols(0), n_rows(0) {}
+
+            size_t column(size_t j) const { return order.empty() ? j : order[j]; }
+            size_t number_of_entries() const { return indices.size(); }
+
+            std::vector<size_t> column_offsets;
+            std::vector<index_type> indices;
+            std::vector<REAL> weights;
+            std::vector<index_type> order;
+            std::vector<std::vector<std::pair<size_t,size_t>>> tiles;
             size_t n_cols, n_rows;
         };
 
 
-        template<class REAL> NFFT_Matrix<REAL> transpose(const NFFT_Matrix<REAL>& matrix);
-
         template<class REAL, unsigned int D>
         NFFT_Matrix<REAL>
         make_NFFT_matrix(const hoNDArray<vector_td<REAL, D>> trajectories, const vector_td<size_t, D> &image_dims,
                          REAL W, const vector_td<REAL, D> &beta);
-    }
-}
 
+        /**
+            Process-wide cache of convolution matrices.
 
+            Matrices are keyed by the trajectory of a frame and the kernel parameters, so plans created for
+            repetitions, coils or pseudo replicas sharing a trajectory reuse the matrices instead of computing them
+            again.
+         */
+        template<class REAL, unsigned int D>
+        class EXPORTNFFT NFFT_MatrixCache {
+        public:
+            typedef std::shared_ptr<const NFFT_Matrix<REAL>> MatrixPtr;
+
+            static NFFT_MatrixCache* instance();
+
+            /// Returns the convolution matrix for the (scaled) trajectory
+            MatrixPtr get(const hoNDArray<vector_td<REAL, D>>& trajectory, const vector_td<size_t, D>& image_dims,
+                          REAL W, const vector_td<REAL, D>& beta);
+
+            /// Number of trajectories kept. Zero disables the cache.
+            void set_capacity(size_t entries);
+            size_t size();
+            void clear();
+
+        protected:
+            NFFT_MatrixCache();
+
+            struct Entry {
+                uint64_t hash;
+                std::vector<vector_td<REAL,D>> trajectory;
+                vector_td<size_t,D> image_dims;
+                REAL W;
+                vector_td<REAL,D> beta;
+                MatrixPtr matrix;
+            };
+
+            std::mutex mutex_;
+            std::list<Entry> entries_; //Most recently used first
+            size_t capacity_;
+        };
+    }
+}
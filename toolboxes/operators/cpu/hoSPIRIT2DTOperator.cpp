@@ -54,9 +54,6 @@ void hoSPIRIT2DTOperator<T>::set_forward_kernel(ARRAY_TYPE& forward_kernel, bool
         }
 
         // allocate the helper memory
-        res_after_apply_kernel_.create(RO, E1, srcCHA, dstCHA);
-        res_after_apply_kernel_dst_.create(RO, E1, dstCHA, srcCHA);
-
         if(kspace_.get_size(4)>N)
         {
             res_after_apply_kernel_sum_over_.create(RO, E1, dstCHA, kspace_.get_size(4));
@@ -79,7 +76,7 @@ void hoSPIRIT2DTOperator<T>::set_forward_kernel(ARRAY_TYPE& forward_kernel, bool
 }
 
 template <typename T>
-void hoSPIRIT2DTOperator<T>::apply_forward_kernel(ARRAY_TYPE& x)
+void hoSPIRIT2DTOperator<T>::apply_kernel(const ARRAY_TYPE& kernel, const ARRAY_TYPE& x, ARRAY_TYPE& y)
 {
     try
     {
@@ -88,33 +85,72 @@ void hoSPIRIT2DTOperator<T>::apply_forward_kernel(ARRAY_TYPE& x)
         size_t srcCHA = x.get_size(2);
         size_t N = x.get_size(3);
 
-        size_t dstCHA = this->forward_kernel_.get_size(3);
-        size_t kernelN = this->forward_kernel_.get_size(4);
+        GADGET_CHECK_THROW(kernel.get_size(2) == srcCHA);
+
+        size_t dstCHA = kernel.get_size(3);
+        size_t kernelN = kernel.get_size(4);
+
+        y.create(RO, E1, dstCHA, N);
 
-        this->res_after_apply_kernel_sum_over_.create(RO, E1, dstCHA, N);
+        // every dst channel of every 2D kspace is one block, the src channels are multiplied and summed in one pass
+        // without the [RO E1 srcCHA dstCHA] buffer of the product
+        size_t num = RO*E1;
+        size_t numBlocks = dstCHA*N;
 
-        long long n;
-        for (n = 0; n < (long long)N; n++)
+        const T* pKernel = kernel.begin();
+        const T* pX = x.begin();
+        T* pY = y.begin();
+
+        long long b;
+#pragma omp parallel for default(none) private(b) shared(num, numBlocks, srcCHA, dstCHA, kernelN, pKernel, pX, pY)
+        for (b = 0; b < (long long)numBlocks; b++)
         {
-            hoNDArray<T> currComplexIm(RO, E1, srcCHA, x.begin() + n*RO*E1*srcCHA);
+            size_t dst = b % dstCHA;
+            size_t n = b / dstCHA;
+            size_t kn = (n < kernelN) ? n : kernelN - 1;
 
-            hoNDArray<T> curr_forward_kernel;
+            const T* pK = pKernel + kn*num*srcCHA*dstCHA + dst*num*srcCHA;
+            const T* pXn = pX + n*num*srcCHA;
+            REAL* r = reinterpret_cast<REAL*>(pY + n*num*dstCHA + dst*num);
 
-            if (n < (long long)kernelN)
-            {
-                curr_forward_kernel.create(RO, E1, srcCHA, dstCHA, this->forward_kernel_.begin() + n*RO*E1*srcCHA*dstCHA);
-            }
-            else
+            size_t src, ii;
+            for (src = 0; src < srcCHA; src++)
             {
-                curr_forward_kernel.create(RO, E1, srcCHA, dstCHA, this->forward_kernel_.begin() + (kernelN - 1)*RO*E1*srcCHA*dstCHA);
+                const REAL* k = reinterpret_cast<const REAL*>(pK + src*num);
+                const REAL* v = reinterpret_cast<const REAL*>(pXn + src*num);
+
+                if (src == 0)
+                {
+                    for (ii = 0; ii < num; ii++)
+                    {
+                        r[2 * ii] = k[2 * ii] * v[2 * ii] - k[2 * ii + 1] * v[2 * ii + 1];
+                        r[2 * ii + 1] = k[2 * ii] * v[2 * ii + 1] + k[2 * ii + 1] * v[2 * ii];
+                    }
+                }
+                else
+                {
+                    for (ii = 0; ii < num; ii++)
+                    {
+                        r[2 * ii] += k[2 * ii] * v[2 * ii] - k[2 * ii + 1] * v[2 * ii + 1];
+                        r[2 * ii + 1] += k[2 * ii] * v[2 * ii + 1] + k[2 * ii + 1] * v[2 * ii];
+                    }
+                }
             }
-
-            Gadgetron::multiply(curr_forward_kernel, currComplexIm, res_after_apply_kernel_);
-
-            hoNDArray<T> sumResCurr(RO, E1, 1, dstCHA, this->res_after_apply_kernel_sum_over_.begin() + n*RO*E1*dstCHA);
-            Gadgetron::sum_over_dimension(this->res_after_apply_kernel_, sumResCurr, 2);
         }
     }
+    catch (...)
+    {
+        GADGET_THROW("Errors in hoSPIRIT2DTOperator<T>::apply_kernel(...) ... ");
+    }
+}
+
+template <typename T>
+void hoSPIRIT2DTOperator<T>::apply_forward_kernel(ARRAY_TYPE& x)
+{
+    try
+    {
+        this->apply_kernel(this->forward_kernel_, x, this->res_after_apply_kernel_sum_over_);
+    }
     catch(...)
     {
         GADGET_THROW("Errors in hoSPIRIT2DTOperator<T>::apply_forward_kernel(x) ... ");
@@ -166,37 +202,7 @@ void hoSPIRIT2DTOperator<T>::apply_adjoint_kernel(ARRAY_TYPE& x)
 {
     try
     {
-        size_t RO = x.get_size(0);
-        size_t E1 = x.get_size(1);
-        size_t dstCHA = x.get_size(2);
-        size_t N = x.get_size(3);
-
-        size_t srcCHA = this->adjoint_kernel_.get_size(3);
-        size_t kernelN = this->adjoint_kernel_.get_size(4);
-
-        this->res_after_apply_kernel_sum_over_dst_.create(RO, E1, srcCHA, N);
-
-        long long n;
-        for (n = 0; n < (long long)N; n++)
-        {
-            hoNDArray<T> currComplexIm(RO, E1, dstCHA, x.begin() + n*RO*E1*dstCHA);
-
-            hoNDArray<T> curr_adjoint_kernel;
-
-            if (n < (long long)kernelN)
-            {
-                curr_adjoint_kernel.create(RO, E1, dstCHA, srcCHA, this->adjoint_kernel_.begin() + n*RO*E1*dstCHA*srcCHA);
-            }
-            else
-            {
-                curr_adjoint_kernel.create(RO, E1, dstCHA, srcCHA, this->adjoint_kernel_.begin() + (kernelN - 1)*RO*E1*dstCHA*srcCHA);
-            }
-
-            Gadgetron::multiply(curr_adjoint_kernel, currComplexIm, res_after_apply_kernel_dst_);
-
-            hoNDArray<T> sumResCurr(RO, E1, 1, srcCHA, this->res_after_apply_kernel_sum_over_dst_.begin() + n*RO*E1*srcCHA);
-            Gadgetron::sum_over_dimension(this->res_after_apply_kernel_dst_, sumResCurr, 2);
-        }
+        this->apply_kernel(this->adjoint_kernel_, x, this->res_after_apply_kernel_sum_over_dst_);
     }
     catch (...)
     {
@@ -282,35 +288,8 @@ void hoSPIRIT2DTOperator<T>::apply_adjoint_forward_kernel(ARRAY_TYPE& x)
 {
     try
     {
-        size_t RO = x.get_size(0);
-        size_t E1 = x.get_size(1);
-        size_t srcCHA = x.get_size(2);
-        size_t N = x.get_size(3);
-
-        GADGET_CHECK_THROW(this->adjoint_forward_kernel_.get_size(3)==srcCHA);
-        size_t kernelN = this->adjoint_forward_kernel_.get_size(4);
-
-        long long n;
-        for (n = 0; n < (long long)N; N++)
-        {
-            hoNDArray<T> currComplexIm(RO, E1, srcCHA, this->complexIm_.begin() + n*RO*E1*srcCHA);
-
-            hoNDArray<T> curr_adjoint_forward_kernel;
-
-            if (n < (long long)kernelN)
-            {
-                curr_adjoint_forward_kernel.create(RO, E1, srcCHA, srcCHA, this->adjoint_forward_kernel_.begin() + n*RO*E1*srcCHA*srcCHA);
-            }
-            else
-            {
-                curr_adjoint_forward_kernel.create(RO, E1, srcCHA, srcCHA, this->adjoint_forward_kernel_.begin() + (kernelN - 1)*RO*E1*srcCHA*srcCHA);
-            }
-
-            Gadgetron::multiply(curr_adjoint_forward_kernel, currComplexIm, res_after_apply_kernel_dst_);
-
-            hoNDArray<T> sumResCurr(RO, E1, 1, srcCHA, this->res_after_apply_kernel_sum_over_dst_.begin() + n*RO*E1*srcCHA);
-            Gadgetron::sum_over_dimension(this->res_after_apply_kernel_dst_, sumResCurr, 2);
-        }
+        GADGET_CHECK_THROW(this->adjoint_forward_kernel_.get_size(3)==x.get_size(2));
+        this->apply_kernel(this->adjoint_forward_kernel_, x, this->res_after_apply_kernel_sum_over_dst_);
     }
     catch (...)
     {
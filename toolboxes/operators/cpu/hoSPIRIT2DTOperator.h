@@ -67,8 +67,6 @@ protected:
     using BaseClass::kspace_dst_;
     using BaseClass::complexIm_;
     ARRAY_TYPE complexIm_dst_;
-    using BaseClass::res_after_apply_kernel_;
-    ARRAY_TYPE res_after_apply_kernel_dst_;
     using BaseClass::res_after_apply_kernel_sum_over_;
     ARRAY_TYPE res_after_apply_kernel_sum_over_dst_;
 
@@ -83,6 +81,9 @@ protected:
     //using BaseClass::gt_timer3_;
     //using BaseClass::gt_exporter_;
 
+    /// y[RO E1 dstCHA N] = sum over srcCHA of kernel[RO E1 srcCHA dstCHA Nor1] .* x[RO E1 srcCHA N]
+    void apply_kernel(const ARRAY_TYPE& kernel, const ARRAY_TYPE& x, ARRAY_TYPE& y);
+
     void apply_forward_kernel(ARRAY_TYPE& x);
     void apply_adjoint_kernel(ARRAY_TYPE& x);
     void apply_adjoint_forward_kernel(ARRAY_TYPE& x);
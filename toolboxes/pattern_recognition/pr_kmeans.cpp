@@ -14,6 +14,7 @@
 #include <boost/math/special_functions/sign.hpp>
 
 #include <random>
+#include <numeric>
 
 namespace Gadgetron { 
 
@@ -23,6 +24,8 @@ kmeans<T>::kmeans()
     max_iter_ = 100;
     replicates_ = 10;
     perform_online_update_ = true;
+    mini_batch_size_ = 0;
+    random_seed_ = 42;
 
     verbose_ = false;
     perform_timing_ = false;
@@ -48,8 +51,7 @@ void kmeans<T>::get_initial_guess_sample(const ArrayType& X, size_t K, ArrayType
 
         GADGET_CHECK_THROW(N>K);
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
+        std::mt19937 gen(this->random_seed_);
         std::uniform_real_distribution<> dis(0, 1);
 
         C_for_initial.create(P, K, this->replicates_);
@@ -86,8 +88,7 @@ void kmeans<T>::get_initial_guess_uniform(const ArrayType& X, size_t K, ArrayTyp
 
         GADGET_CHECK_THROW(N>K);
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
+        std::mt19937 gen(this->random_seed_);
         std::uniform_real_distribution<> dis(0, 1);
 
         C_for_initial.create(P, K, this->replicates_);
@@ -143,8 +144,7 @@ void kmeans<T>::get_initial_guess_cluster(const ArrayType& X, size_t K, ArrayTyp
 
         GADGET_CHECK_THROW(N>K);
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
+        std::mt19937 gen(this->random_seed_);
         std::uniform_real_distribution<> dis(0, 1);
 
         C_for_initial.create(P, K, this->replicates_);
@@ -212,8 +212,7 @@ void kmeans<T>::get_initial_guess_kmeansplusplus(const ArrayType& X, size_t K, A
 
         GADGET_CHECK_THROW(N>K);
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
+        std::mt19937 gen(this->random_seed_);
         std::uniform_real_distribution<> dis(0, 1);
 
         C_for_initial.create(P, K, this->replicates_);
@@ -400,6 +399,12 @@ void kmeans<T>::run(const ArrayType& X, size_t K, const ArrayType& C_for_initial
 
         this->replicates_ = C_for_initial.get_size(2);
 
+        if (this->mini_batch_size_ > 0 && N > this->mini_batch_size_)
+        {
+            this->run_mini_batch(X, K, C_for_initial, IDX, C, sumD);
+            return;
+        }
+
         IDX.resize(N, 0);
         C.create(P, K);
         Gadgetron::clear(C);
@@ -520,6 +525,99 @@ void kmeans<T>::run(const ArrayType& X, size_t K, const ArrayType& C_for_initial
     }
 }
 
+template <typename T>
+void kmeans<T>::run_mini_batch(const ArrayType& X, size_t K, const ArrayType& C_for_initial, ClusterType& IDX, ArrayType& C, T& sumD)
+{
+    try
+    {
+        size_t P = X.get_size(0);
+        size_t N = X.get_size(1);
+
+        GADGET_CHECK_THROW(N>K);
+        GADGET_CHECK_THROW(C_for_initial.get_size(0) == P);
+        GADGET_CHECK_THROW(C_for_initial.get_size(1) == K);
+        GADGET_CHECK_THROW(this->mini_batch_size_>0);
+
+        size_t B = this->mini_batch_size_;
+
+        C.create(P, K);
+        memcpy(C.begin(), C_for_initial.begin(), sizeof(T)*P*K);
+
+        VectorType norm_C(K, 0);
+
+        // number of samples assigned to each centroid so far, the learning rate of a centroid is 1/count
+        std::vector<size_t> num_in_C(K, 0);
+
+        std::mt19937 gen(this->random_seed_);
+        std::uniform_int_distribution<size_t> dis(0, N - 1);
+
+        ArrayType X_batch;
+        X_batch.create(P, B);
+
+        ClusterType IDX_batch;
+
+        size_t iter, m, k, p;
+        for (iter = 0; iter < this->max_iter_; iter++)
+        {
+            for (m = 0; m < B; m++)
+            {
+                size_t ind = dis(gen);
+                memcpy(&X_batch(0, m), &X(0, ind), sizeof(T)*P);
+            }
+
+            for (k = 0; k < K; k++)
+            {
+                T v = 0;
+                for (p = 0; p < P; p++) v += C(p, k)*C(p, k);
+                norm_C[k] = v;
+            }
+
+            this->update_IDX(X_batch, C, norm_C, IDX_batch);
+
+            for (m = 0; m < B; m++)
+            {
+                k = IDX_batch[m];
+                num_in_C[k]++;
+
+                T eta = (T)1 / (T)num_in_C[k];
+                for (p = 0; p < P; p++)
+                {
+                    C(p, k) = ((T)1 - eta) * C(p, k) + eta * X_batch(p, m);
+                }
+            }
+        }
+
+        // assign all samples to the final centroids
+        for (k = 0; k < K; k++)
+        {
+            T v = 0;
+            for (p = 0; p < P; p++) v += C(p, k)*C(p, k);
+            norm_C[k] = v;
+        }
+
+        this->update_IDX(X, C, norm_C, IDX);
+
+        ArrayType D, D_norm;
+        this->compute_dist(X, IDX, C, D);
+        this->compute_norm_dist(D, D_norm);
+
+        sumD = 0;
+        for (size_t n = 0; n < N; n++)
+        {
+            sumD += D_norm(n)*D_norm(n);
+        }
+
+        if (this->verbose_)
+        {
+            GDEBUG_STREAM("Mini-batch kmeans stopped : iter " << iter << " - " << sumD);
+        }
+    }
+    catch (...)
+    {
+        GERROR_STREAM("Exceptions happened in kmeans<T>::run_mini_batch(...) ... ");
+    }
+}
+
 template <typename T>
 void kmeans<T>::compute_dist(const ArrayType& X, const ClusterType& IDX, const ArrayType& C, ArrayType& D)
 {
@@ -609,27 +707,40 @@ void kmeans<T>::update_IDX(const ArrayType& X, const ArrayType& C, const VectorT
 
         IDX.resize(N);
 
-        ArrayType CX;
-        Gadgetron::gemm(CX, C, true, X, false);
+        // the samples are processed in blocks, so CX stays small for large N
+        const size_t block_size = 16384;
 
-        size_t t, s;
+        ArrayType CX;
 
-        for (t = 0; t < N; t++)
+        size_t start;
+        for (start = 0; start < N; start += block_size)
         {
-            for (s = 0; s < K; s++)
-            {
-                CX(s, t) = 2* CX(s, t) - norm_C[s];
-            }
+            size_t num = std::min(block_size, N - start);
 
-            T maxCX = CX(0, t);
-            IDX[t] = 0;
-            for (s = 1; s < K; s++)
+            ArrayType X_block;
+            X_block.create(P, num, const_cast<T*>(&X(0, start)));
+
+            Gadgetron::gemm(CX, C, true, X_block, false);
+
+            long long t;
+            size_t s;
+
+#pragma omp parallel for default(none) private(t, s) shared(num, K, CX, norm_C, IDX, start)
+            for (t = 0; t < (long long)num; t++)
             {
-                if (CX(s, t) > maxCX)
+                T maxCX = 2 * CX(0, t) - norm_C[0];
+                size_t ind = 0;
+                for (s = 1; s < K; s++)
                 {
-                    maxCX = CX(s, t);
-                    IDX[t] = s;
+                    T v = 2 * CX(s, t) - norm_C[s];
+                    if (v > maxCX)
+                    {
+                        maxCX = v;
+                        ind = s;
+                    }
                 }
+
+                IDX[start + t] = ind;
             }
         }
     }
@@ -652,31 +763,68 @@ void kmeans<T>::update_centroid(const ArrayType& X, const ClusterType& IDX, Arra
 
         norm_C.resize(K);
 
-        std::vector<size_t> num_in_C(K, 0);
+        // the samples are summed in a fixed number of chunks, which are added in order,
+        // so the centroids do not depend on the number of threads
+        long long num_chunks = (long long)std::min(N, (size_t)64);
 
-        Gadgetron::clear(C);
-        T* pC = C.begin();
+        ArrayType sum_chunks;
+        sum_chunks.create(P, K, num_chunks);
+        Gadgetron::clear(sum_chunks);
 
-        size_t n, p;
-        for (n=0; n<N; n++)
+        std::vector< std::vector<size_t> > num_in_chunks(num_chunks, std::vector<size_t>(K, 0));
+
+        long long c;
+
+#pragma omp parallel for default(none) private(c) shared(num_chunks, N, P, K, pX, IDX, sum_chunks, num_in_chunks)
+        for (c = 0; c < num_chunks; c++)
         {
-            size_t currK = IDX[n];
+            size_t n_start = (N * c) / num_chunks;
+            size_t n_end = (N * (c + 1)) / num_chunks;
 
-            if(currK<K)
+            T* pSum = &sum_chunks(0, 0, c);
+
+            for (size_t n = n_start; n < n_end; n++)
             {
-                for (p=0; p<P; p++)
+                size_t currK = IDX[n];
+
+                if (currK < K)
                 {
-                    pC[p+currK*P] += pX[p+n*P];
+                    for (size_t p = 0; p < P; p++)
+                    {
+                        pSum[p + currK*P] += pX[p + n*P];
+                    }
+
+                    num_in_chunks[c][currK]++;
                 }
+            }
+        }
+
+        std::vector<size_t> num_in_C(K, 0);
+
+        Gadgetron::clear(C);
+        T* pC = C.begin();
 
-                num_in_C[currK]++;
+        size_t n, p;
+        for (c = 0; c < num_chunks; c++)
+        {
+            const T* pSum = &sum_chunks(0, 0, c);
+            for (n = 0; n < P*K; n++)
+            {
+                pC[n] += pSum[n];
             }
-            else
+
+            for (n = 0; n < K; n++)
             {
-                GERROR_STREAM("kmeans, currC>=K, in update_centroid : " << n);
+                num_in_C[n] += num_in_chunks[c][n];
             }
         }
 
+        size_t num_assigned = std::accumulate(num_in_C.begin(), num_in_C.end(), size_t(0));
+        if (num_assigned < N)
+        {
+            GERROR_STREAM("kmeans, currC>=K, in update_centroid : " << N - num_assigned << " samples");
+        }
+
         for (n = 0; n < K; n++)
         {
             T v = 0;
@@ -847,49 +995,30 @@ void kmeans<T>::perform_online_update(const ArrayType& X, ClusterType& IDX, Arra
         size_t nummoved = 0;
         ClusterType prevIDX, newIDX(IDX);
 
-        while (iter < this->max_iter_)
+        // for every cluster K and every point N
+        // compute change of delta sum cost
+        for (k = 0; k < K; k++)
         {
-            // for every cluster K and every point N
-            // compute change of delta sum cost
-            for (k = 0; k < K; k++)
-            {
-                for (n = 0; n < N; n++)
-                {
-                    T v;
-                    if (IDX[n] == k)
-                    {
-                        if (num_pt_clusters[k] > 1)
-                            v = (T)num_pt_clusters[k] / (T)(num_pt_clusters[k] - 1);
-                        else
-                            v = 1;
-                    }
-                    else
-                        v = (T)num_pt_clusters[k] / (T)(num_pt_clusters[k] + 1);
-
-                    T t(0), d = 0;
-                    for (p = 0; p < P; p++)
-                    {
-                        t = X(p, n) - C(p, k);
-                        d += t*t;
-                    }
-
-                    del_cost(n, k) = v * d;
-                }
-            }
+            this->compute_del_cost(X, IDX, C, num_pt_clusters, k, del_cost);
+        }
 
+        while (iter < this->max_iter_)
+        {
             prevIDX = IDX;
 
             // get the new IDX
-            for (n = 0; n < N; n++)
+            long long nn;
+#pragma omp parallel for default(none) private(nn, k) shared(N, K, del_cost, newIDX)
+            for (nn = 0; nn < (long long)N; nn++)
             {
-                newIDX[n] = 0;
-                T min_del_cost = del_cost(n, 0);
+                newIDX[nn] = 0;
+                T min_del_cost = del_cost(nn, 0);
                 for (k = 1; k < K; k++)
                 {
-                    if(del_cost(n, k) < min_del_cost)
+                    if(del_cost(nn, k) < min_del_cost)
                     {
-                        newIDX[n] = k;
-                        min_del_cost = del_cost(n, k);
+                        newIDX[nn] = k;
+                        min_del_cost = del_cost(nn, k);
                     }
                 }
             }
@@ -954,6 +1083,10 @@ void kmeans<T>::perform_online_update(const ArrayType& X, ClusterType& IDX, Arra
                 C(p, nidx) = C(p, nidx) + (X(p, moved_ind) - C(p, nidx)) / num_pt_clusters[nidx];
                 C(p, oidx) = C(p, oidx) - (X(p, moved_ind) - C(p, oidx)) / num_pt_clusters[oidx];
             }
+
+            // only the two clusters involved in the move have changed
+            this->compute_del_cost(X, IDX, C, num_pt_clusters, oidx, del_cost);
+            this->compute_del_cost(X, IDX, C, num_pt_clusters, nidx, del_cost);
         }
     }
     catch (...)
@@ -962,6 +1095,43 @@ void kmeans<T>::perform_online_update(const ArrayType& X, ClusterType& IDX, Arra
     }
 }
 
+template <typename T>
+void kmeans<T>::compute_del_cost(const ArrayType& X, const ClusterType& IDX, const ArrayType& C, const std::vector<size_t>& num_pt_clusters, size_t k, ArrayType& del_cost)
+{
+    size_t P = X.get_size(0);
+    size_t N = X.get_size(1);
+
+    const T* pX = X.begin();
+    const T* pC = &C(0, k);
+
+    long long n;
+    size_t p;
+
+#pragma omp parallel for default(none) private(n, p) shared(N, P, k, pX, pC, IDX, num_pt_clusters, del_cost)
+    for (n = 0; n < (long long)N; n++)
+    {
+        T v;
+        if (IDX[n] == k)
+        {
+            if (num_pt_clusters[k] > 1)
+                v = (T)num_pt_clusters[k] / (T)(num_pt_clusters[k] - 1);
+            else
+                v = 1;
+        }
+        else
+            v = (T)num_pt_clusters[k] / (T)(num_pt_clusters[k] + 1);
+
+        T t(0), d = 0;
+        for (p = 0; p < P; p++)
+        {
+            t = pX[p + n*P] - pC[p];
+            d += t*t;
+        }
+
+        del_cost(n, k) = v * d;
+    }
+}
+
 // ------------------------------------------------------------
 // Instantiation
 // ------------------------------------------------------------
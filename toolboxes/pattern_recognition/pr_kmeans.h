@@ -29,6 +29,13 @@ namespace Gadgetron {
 // online update: the kmeans can optionally use the so-called "online" update. In this process, every data point is reallocated to all clusters and the
 // delta change of adding or removing this point is computed; those moves which will reduce the total sum cost will be performed.
 //
+// mini-batch: for very large N, e.g. pixel-wise clustering over a whole series, the centroids can be updated from small random batches of samples
+// instead of all samples, http://www.eecs.tufts.edu/~dsculley/papers/fastkmeans.pdf
+// all samples are assigned to the final centroids once at the end; the online update is not performed in this mode
+//
+// the distances of all samples to all centroids are computed as ||x||^2 - 2*C'*X + ||c||^2 with gemm; the assignment and centroid updates are
+// parallelized over samples. All random numbers come from random_seed_, so the clustering is reproducible.
+//
 // output
 // IDX : [N 1] array, indicating to which clusters every data sample belongs (first cluster has index 0)
 // C : [P K], K centroids
@@ -65,6 +72,12 @@ public:
     // whether to perform on-line update
     bool perform_online_update_;
 
+    // if > 0 and the number of samples is larger than this, the centroids are updated from random batches of this size
+    size_t mini_batch_size_;
+
+    // seed of the random number generator used for the initial guess and the mini-batch sampling
+    unsigned int random_seed_;
+
     // ======================================================================================
     /// parameter for debugging
     // ======================================================================================
@@ -98,6 +111,9 @@ public:
     virtual void run_replicates(const ArrayType& X, size_t K, const ArrayType& C_for_initial, ClusterType& IDX, ArrayType& C, VectorType& sumD_rep, T& sumD);
     virtual void run(const ArrayType& X, size_t K, const ArrayType& C_for_initial, ClusterType& IDX, ArrayType& C, T& sumD);
 
+    /// mini-batch kmeans, max_iter_ batches of mini_batch_size_ samples
+    virtual void run_mini_batch(const ArrayType& X, size_t K, const ArrayType& C_for_initial, ClusterType& IDX, ArrayType& C, T& sumD);
+
     /// compute distance vector
     /// D: [P N] distance from a point to its closest centroid
     void compute_dist(const ArrayType& X, const ClusterType& IDX, const ArrayType& C, ArrayType& D);
@@ -127,6 +143,11 @@ public:
     /// On return, IDX and C may be updated
     /// max_iter_ is used for online update
     void perform_online_update(const ArrayType& X, ClusterType& IDX, ArrayType& C, T& sumD);
+
+protected:
+
+    /// cost change of moving every point to cluster k, given the current cluster sizes, del_cost: [N K]
+    void compute_del_cost(const ArrayType& X, const ClusterType& IDX, const ArrayType& C, const std::vector<size_t>& num_pt_clusters, size_t k, ArrayType& del_cost);
 };
 
 }
@@ -47,11 +47,7 @@ namespace Gadgetron {
             auto pyWav = arrayData.waveform_ ? boost::python::object(*arrayData.waveform_) : boost::python::object();
             auto pyAcqHeaders = arrayData.acq_headers_ ? boost::python::object(*arrayData.acq_headers_) : boost::python::object();
 
-            bp::incref(data.ptr());
-            bp::incref(pyHeaders.ptr());
-            bp::incref(pyMeta.ptr());
-            bp::incref(pyWav.ptr());
-            bp::incref(pyAcqHeaders.ptr());
+            // The buffer holds its own references, extra ones would leak the arrays and, for views, the message owning them
             auto buffer = pygadgetron.attr("IsmrmrdImageArray")(data, pyHeaders, pyMeta, pyWav, pyAcqHeaders);
 
             // increment the reference count so it exists after `return`
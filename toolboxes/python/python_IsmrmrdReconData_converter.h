@@ -38,13 +38,9 @@ private:
     auto headers = boost::python::object(dataBuffer.headers_);
     auto trajectory = dataBuffer.trajectory_ ? bp::object(*dataBuffer.trajectory_) : bp::object();
     auto sampling = SamplingDescriptionToPython(dataBuffer.sampling_);
+    // The buffer holds its own references, extra ones would leak the arrays and, for views, the message owning them
     auto buffer = pygadgetron.attr("IsmrmrdDataBuffered")(data,headers,sampling,trajectory);
 
-    bp::incref(data.ptr());
-    bp::incref(headers.ptr());
-    bp::incref(trajectory.ptr());
-    bp::incref(sampling.ptr());
-
     return buffer;
   }
 
@@ -18,6 +18,7 @@ namespace Gadgetron {
 
 // -------------------------------------------------------------------------------
 /// Used for making a NumPy array from and hoNDArray
+/// Inside a NumPyViewScope the NumPy array is a view of the hoNDArray storage, otherwise the data is copied
 template <typename T>
 struct hoNDArray_to_numpy_array {
     static PyObject* convert(const hoNDArray<T>& arr) {
@@ -26,6 +27,21 @@ struct hoNDArray_to_numpy_array {
         for (size_t i = 0; i < ndim; i++) {
             dims2[i] = static_cast<npy_intp>(arr.get_size(i));
         }
+
+        PyObject* base = NumPyViewScope::make_base();
+        if (base) {
+            PyObject *obj = NumPyArray_FromData(dims2.size(), dims2.data(), get_numpy_type<T>(),
+                    const_cast<T*>(arr.get_data_ptr()), base);
+            if (!obj) bp::throw_error_already_set();
+            if (sizeof(T) != NumPyArray_ITEMSIZE(obj)) {
+                GERROR("sizeof(T): %d, ITEMSIZE: %d\n", sizeof(T), NumPyArray_ITEMSIZE(obj));
+                bp::decref(obj);
+                throw std::runtime_error("hondarray_to_numpy_array: "
+                        "python object and array data type sizes do not match");
+            }
+            return obj;
+        }
+
         PyObject *obj = NumPyArray_EMPTY(dims2.size(), dims2.data(), get_numpy_type<T>(),true);
         if (sizeof(T) != NumPyArray_ITEMSIZE(obj)) {
             GERROR("sizeof(T): %d, ITEMSIZE: %d\n", sizeof(T), NumPyArray_ITEMSIZE(obj));
@@ -126,17 +142,25 @@ struct hoNDArray_from_numpy_array {
         void* storage = ((bp::converter::rvalue_from_python_storage<hoNDArray<T> >*)data)->storage.bytes;
         data->convertible = storage;
 
-        PyObject* obj =  NumPyArray_FromAny(obj_orig, nullptr, 1, 36,  NPY_ARRAY_IN_FARRAY, nullptr);
+        // Any memory order is accepted, the copy into the hoNDArray reorders the data
+        PyObject* obj =  NumPyArray_FromAny(obj_orig, nullptr, 1, 36, 0, nullptr);
+        if (!obj) bp::throw_error_already_set();
         size_t ndim = NumPyArray_NDIM(obj);
         std::vector<size_t> dims(ndim);
+        std::vector<npy_intp> dims2(ndim);
         for (size_t i = 0; i < ndim; i++) {
             dims[i] = NumPyArray_DIM(obj, i);
+            dims2[i] = NumPyArray_DIM(obj, i);
         }
         // Placement-new of hoNDArray in memory provided by Boost
         hoNDArray<T>* arr = new (storage) hoNDArray<T>(dims);
-        memcpy(arr->get_data_ptr(), NumPyArray_DATA(obj),
-                sizeof(T) * arr->get_number_of_elements());
+
+        // Copy once, straight from the NumPy buffer into the hoNDArray storage
+        PyObject* dst = NumPyArray_FromData(dims2.size(), dims2.data(), get_numpy_type<T>(), arr->get_data_ptr(), nullptr);
+        int res = dst ? NumPyArray_CopyInto(dst, obj) : -1;
+        bp::xdecref(dst);
         bp::decref(obj);
+        if (res < 0) bp::throw_error_already_set();
     }
 };
 
@@ -20,6 +20,9 @@ EXPORTPYTHON npy_intp NumPyArray_SIZE(PyObject* obj);
 EXPORTPYTHON PyObject *NumPyArray_SimpleNew(int nd, npy_intp* dims, int typenum);
 EXPORTPYTHON PyObject *NumPyArray_EMPTY(int nd, npy_intp* dims, int typenum, int fortran);
 EXPORTPYTHON PyObject* NumPyArray_FromAny(PyObject* op, PyArray_Descr* dtype, int min_depth, int max_depth, int requirements, PyObject* context);
+/// Wraps existing Fortran ordered data without copying. The array steals the reference to base, which must keep data alive.
+EXPORTPYTHON PyObject* NumPyArray_FromData(int nd, npy_intp* dims, int typenum, void* data, PyObject* base);
+EXPORTPYTHON int NumPyArray_CopyInto(PyObject* dst, PyObject* src);
 /// return the enumerated numpy type for a given C++ type
 template <typename T> int get_numpy_type() { return NPY_VOID; }
 template <> inline int get_numpy_type< bool >() { return NPY_BOOL; }
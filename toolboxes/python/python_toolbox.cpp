@@ -113,6 +113,36 @@ std::string pyerr_to_string(void)
     return bp::extract<std::string>(formatted);
 }
 
+static const char* numpy_view_owner_name = "gadgetron.numpy_view_owner";
+static thread_local boost::shared_ptr<void>* numpy_view_owner = nullptr;
+
+static void release_numpy_view_owner(PyObject* capsule)
+{
+    delete static_cast<boost::shared_ptr<void>*>(PyCapsule_GetPointer(capsule, numpy_view_owner_name));
+}
+
+NumPyViewScope::NumPyViewScope(boost::shared_ptr<void> owner)
+    : owner_(owner)
+    , previous_(numpy_view_owner)
+{
+    numpy_view_owner = &owner_;
+}
+
+NumPyViewScope::~NumPyViewScope()
+{
+    numpy_view_owner = previous_;
+}
+
+PyObject* NumPyViewScope::make_base()
+{
+    if (!numpy_view_owner || !*numpy_view_owner) return NULL;
+
+    boost::shared_ptr<void>* owner = new boost::shared_ptr<void>(*numpy_view_owner);
+    PyObject* capsule = PyCapsule_New(owner, numpy_view_owner_name, &release_numpy_view_owner);
+    if (!capsule) delete owner;
+    return capsule;
+}
+
 /// Wraps PyArray_NDIM
 int NumPyArray_NDIM(PyObject* obj)
 {
@@ -139,6 +169,26 @@ npy_intp* NumPyArray_STRIDES(PyObject* obj)
 PyObject* NumPyArray_FromAny(PyObject* op, PyArray_Descr* dtype, int min_depth, int max_depth, int requirements, PyObject* context){
   return PyArray_FromAny(op, dtype, min_depth, max_depth, requirements, context);
 }
+PyObject* NumPyArray_FromData(int nd, npy_intp* dims, int typenum, void* data, PyObject* base)
+{
+    PyObject* obj = PyArray_New(&PyArray_Type, nd, dims, typenum, NULL, data, 0, NPY_ARRAY_FARRAY, NULL);
+    if (!obj) {
+        Py_XDECREF(base);
+        return NULL;
+    }
+
+    if (base && PyArray_SetBaseObject((PyArrayObject*)obj, base) < 0) {
+        Py_DECREF(obj);
+        return NULL;
+    }
+    return obj;
+}
+
+int NumPyArray_CopyInto(PyObject* dst, PyObject* src)
+{
+    return PyArray_CopyInto((PyArrayObject*)dst, (PyArrayObject*)src);
+}
+
 /// Wraps PyArray_ITEMSIZE
 int NumPyArray_ITEMSIZE(PyObject* obj)
 {
@@ -3,6 +3,7 @@
 #include "python_export.h"
 #include "log.h"
 #include <boost/python.hpp>
+#include <boost/shared_ptr.hpp>
 namespace bp = boost::python;
 
 namespace Gadgetron
@@ -44,6 +45,42 @@ namespace Gadgetron {
 
     };
 
+/// While an instance is alive, hoNDArrays converted to NumPy on this thread are not copied.
+/// The NumPy arrays are views of the hoNDArray storage and keep owner alive until Python drops them,
+/// so owner must keep the converted hoNDArrays unchanged. Python must hold the GIL.
+///
+///    NumPyViewScope views(owner);
+///    bp::object pydata(data);
+///
+    class EXPORTPYTHON NumPyViewScope {
+    public:
+        explicit NumPyViewScope(boost::shared_ptr<void> owner);
+
+        ~NumPyViewScope();
+
+        /// New reference to an object keeping the owner of the current scope alive, NULL outside of a scope
+        static PyObject* make_base();
+
+    private:
+        // noncopyable
+        NumPyViewScope(const NumPyViewScope &);
+
+        NumPyViewScope &operator=(const NumPyViewScope &);
+
+        boost::shared_ptr<void> owner_;
+        boost::shared_ptr<void>* previous_;
+    };
+
+/// Converts the content of a GadgetContainerMessage to Python, the arrays are NumPy views of the message data.
+/// A duplicate of the message is released when Python drops the last view, so the data is not copied and
+/// the message itself may be released right away. Python must hold the GIL.
+    template <typename M> bp::object to_python_views(M* m)
+    {
+        boost::shared_ptr<void> owner(m->duplicate(), [](M* d) { d->release(); });
+        NumPyViewScope views(owner);
+        return bp::object(*m->getObjectPtr());
+    }
+
 }
 
 #include "python_converters.h"
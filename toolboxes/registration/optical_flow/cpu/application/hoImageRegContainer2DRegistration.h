@@ -402,6 +402,10 @@ namespace Gadgetron {
         /// verbose mode
         bool verbose_;
 
+        /// number of threads shared by all registrations over the container, 0 means all processors
+        /// the registrations run in parallel first; threads left over go to the pixel loops inside every registration
+        unsigned int max_num_of_threads_;
+
         // ----------------------------------
         // debug and timing
         // ----------------------------------
@@ -436,6 +440,13 @@ namespace Gadgetron {
 
         bool initialize(const TargetContinerType& targetContainer, bool warped);
 
+        /// split the thread budget over numOfTasks registrations
+        /// returns the number of registrations to run in parallel and sets num_of_threads_per_task_
+        int splitThreads(long long numOfTasks);
+
+        /// number of threads for the pixel loops of one registration
+        unsigned int num_of_threads_per_task_;
+
     };
 
     template<typename TargetType, typename SourceType, typename CoordType> 
@@ -531,9 +542,32 @@ namespace Gadgetron {
 
         verbose_ = false;
 
+        max_num_of_threads_ = 0;
+        num_of_threads_per_task_ = 1;
+
         return true;
     }
 
+    template<typename TargetType, typename SourceType, typename CoordType> 
+    int hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::splitThreads(long long numOfTasks)
+    {
+        num_of_threads_per_task_ = 1;
+
+        int numOfThreads = 1;
+
+#ifdef USE_OMP
+        int budget = (max_num_of_threads_>0) ? (int)max_num_of_threads_ : omp_get_num_procs();
+
+        numOfThreads = (numOfTasks>budget) ? budget : (int)numOfTasks;
+        if ( numOfThreads < 1 ) numOfThreads = 1;
+
+        num_of_threads_per_task_ = budget / numOfThreads;
+        if ( num_of_threads_per_task_ < 1 ) num_of_threads_per_task_ = 1;
+#endif // USE_OMP
+
+        return numOfThreads;
+    }
+
     template<typename TargetType, typename SourceType, typename CoordType> 
     bool hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::
     registerTwoImagesParametric(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, TransformationParametricType& transform)
@@ -578,6 +612,7 @@ namespace Gadgetron {
             reg.apply_in_FOV_constraint_ = apply_in_FOV_constraint_;
             reg.apply_divergence_free_constraint_ = apply_divergence_free_constraint_;
             reg.verbose_ = verbose_;
+            reg.num_of_threads_ = num_of_threads_per_task_;
 
             reg.dissimilarity_type_.clear();
             reg.dissimilarity_type_.resize(resolution_pyramid_levels_, dissimilarity_type_);
@@ -681,6 +716,7 @@ namespace Gadgetron {
             reg.apply_divergence_free_constraint_ = apply_divergence_free_constraint_;
 
             reg.verbose_ = verbose_;
+            reg.num_of_threads_ = num_of_threads_per_task_;
 
             reg.dissimilarity_type_.clear();
             reg.dissimilarity_type_.resize(resolution_pyramid_levels_, dissimilarity_type_);
@@ -830,24 +866,12 @@ namespace Gadgetron {
 
             GDEBUG_STREAM("registerOverContainer2DPairWise - threading ... ");
 
-            int numOfThreads = 1;
+            int numOfThreads = this->splitThreads(numOfImages);
+            GDEBUG_STREAM("registerOverContainer2DPairWise - " << numOfThreads << " registrations in parallel, " << num_of_threads_per_task_ << " threads each ... ");
 
 #ifdef USE_OMP
-            int numOfProcs = omp_get_num_procs();
-            int nested = omp_get_nested();
-            GDEBUG_STREAM("registerOverContainer2DPairWise - nested openMP is " << nested);
-            /*if (numOfImages < numOfProcs - 1)
-            {
-                omp_set_nested(1);
-                GDEBUG_STREAM("registerOverContainer2DPairWise - nested openMP on ... ");
-            }
-            else
-            {
-                omp_set_nested(0);
-                GDEBUG_STREAM("registerOverContainer2DPairWise - nested openMP off ... ");
-            }*/
-
-            numOfThreads = (numOfImages>numOfProcs) ? numOfProcs : numOfImages;
+            int max_active_levels = omp_get_max_active_levels();
+            if ( num_of_threads_per_task_ > 1 ) omp_set_max_active_levels(2);
 #endif // USE_OMP
 
             unsigned int ii;
@@ -944,9 +968,9 @@ namespace Gadgetron {
                 GDEBUG_STREAM("To be implemented ...");
             }
 
-//#ifdef USE_OMP
-//            omp_set_nested(nested);
-//#endif // USE_OMP
+#ifdef USE_OMP
+            omp_set_max_active_levels(max_active_levels);
+#endif // USE_OMP
         }
         catch(...)
         {
@@ -1003,24 +1027,12 @@ namespace Gadgetron {
 
             GADGET_CHECK_RETURN_FALSE(numOfImages==targetImages.size());
 
-            int numOfThreads = 1;
+            int numOfThreads = this->splitThreads(numOfImages);
+            GDEBUG_STREAM("registerOverContainer2DFixedReference - " << numOfThreads << " registrations in parallel, " << num_of_threads_per_task_ << " threads each ... ");
 
 #ifdef USE_OMP
-            int numOfProcs = omp_get_num_procs();
-            int nested = omp_get_nested();
-            GDEBUG_STREAM("registerOverContainer2DFixedReference - nested openMP is " << nested);
-            //if (numOfImages < numOfProcs - 1)
-            //{
-            //    omp_set_nested(1);
-            //    GDEBUG_STREAM("registerOverContainer2DFixedReference - nested openMP on ... ");
-            //}
-            //else
-            //{
-            //    omp_set_nested(0);
-            //    GDEBUG_STREAM("registerOverContainer2DFixedReference - nested openMP off ... ");
-            //}
-
-            numOfThreads = (numOfImages>numOfProcs) ? numOfProcs : numOfImages;
+            int max_active_levels = omp_get_max_active_levels();
+            if ( num_of_threads_per_task_ > 1 ) omp_set_max_active_levels(2);
 #endif // USE_OMP
 
             if ( container_reg_transformation_ == GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD )
@@ -1124,9 +1136,9 @@ namespace Gadgetron {
                 GDEBUG_STREAM("To be implemented ...");
             }
 
-//#ifdef USE_OMP
-//            omp_set_nested(nested);
-//#endif // USE_OMP
+#ifdef USE_OMP
+            omp_set_max_active_levels(max_active_levels);
+#endif // USE_OMP
         }
         catch(...)
         {
@@ -1160,6 +1172,9 @@ namespace Gadgetron {
             long long numOfTasks = (long long)(2*row);
             GDEBUG_STREAM("hoImageRegContainer2DRegistration<...>::registerOverContainer2DProgressive(...), numOfTasks : " << numOfTasks);
 
+            int numOfThreads = this->splitThreads(numOfTasks);
+            GDEBUG_STREAM("registerOverContainer2DProgressive - " << numOfThreads << " registrations in parallel, " << num_of_threads_per_task_ << " threads each ... ");
+
             std::vector< std::vector<TargetType*> > regImages(numOfTasks);
             std::vector< std::vector<TargetType*> > warpedImages(numOfTasks);
 
@@ -1269,7 +1284,12 @@ namespace Gadgetron {
             {
                 bool initial = false;
 
-                #pragma omp parallel default(none) private(n, ii) shared(numOfTasks, initial, regImages, warpedImages, deform)
+#ifdef USE_OMP
+                int max_active_levels = omp_get_max_active_levels();
+                if ( num_of_threads_per_task_ > 1 ) omp_set_max_active_levels(2);
+#endif // USE_OMP
+
+                #pragma omp parallel default(none) private(n, ii) shared(numOfTasks, initial, regImages, warpedImages, deform) num_threads(numOfThreads)
                 {
                     DeformationFieldType* deformCurr[DIn];
 
@@ -1295,12 +1315,21 @@ namespace Gadgetron {
                         }
                     }
                 }
+
+#ifdef USE_OMP
+                omp_set_max_active_levels(max_active_levels);
+#endif // USE_OMP
             }
             else if ( container_reg_transformation_ == GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD_BIDIRECTIONAL )
             {
                 bool initial = false;
 
-                #pragma omp parallel default(none) private(n, ii) shared(numOfTasks, initial, regImages, warpedImages, deform, deformInv)
+#ifdef USE_OMP
+                int max_active_levels = omp_get_max_active_levels();
+                if ( num_of_threads_per_task_ > 1 ) omp_set_max_active_levels(2);
+#endif // USE_OMP
+
+                #pragma omp parallel default(none) private(n, ii) shared(numOfTasks, initial, regImages, warpedImages, deform, deformInv) num_threads(numOfThreads)
                 {
                     DeformationFieldType* deformCurr[DIn];
                     DeformationFieldType* deformInvCurr[DIn];
@@ -1326,6 +1355,10 @@ namespace Gadgetron {
                         }
                     }
                 }
+
+#ifdef USE_OMP
+                omp_set_max_active_levels(max_active_levels);
+#endif // USE_OMP
             }
             else if ( container_reg_transformation_==GT_IMAGE_REG_TRANSFORMATION_RIGID 
                         || container_reg_transformation_==GT_IMAGE_REG_TRANSFORMATION_AFFINE )
@@ -1362,6 +1395,7 @@ namespace Gadgetron {
 
         os << "Whether to apply in_FOV constraint : " << apply_in_FOV_constraint_ << std::endl;
         os << "Whether to apply divergence free constraint : " << apply_divergence_free_constraint_ << std::endl;
+        os << "Maximal number of threads : " << max_num_of_threads_ << std::endl;
         os << "Whether to perform world coordinate registration is : " << use_world_coordinates_ << std::endl;
         os << "Number of resolution pyramid levels is : " << resolution_pyramid_levels_ << std::endl;
 
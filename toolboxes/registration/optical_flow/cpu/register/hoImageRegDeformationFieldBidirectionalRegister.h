@@ -114,6 +114,7 @@ namespace Gadgetron {
         using BaseClass::performTiming_;
         using BaseClass::gt_exporter_;
         using BaseClass::debugFolder_;
+        using BaseClass::num_of_threads_;
 
         using BaseClass::max_iter_num_pyramid_level_;
         using BaseClass::dissimilarity_thres_pyramid_level_;
@@ -231,11 +232,13 @@ namespace Gadgetron {
                 warper_pyramid_[ii].setInterpolator( *source_interp_warper_[ii] );
                 warper_pyramid_[ii].setBackgroundValue(bg_value_);
                 warper_pyramid_[ii].debugFolder_ = this->debugFolder_;
+                warper_pyramid_[ii].num_of_threads_ = num_of_threads_;
 
                 warper_pyramid_inverse_[ii].setTransformation(*transform_inverse_);
                 warper_pyramid_inverse_[ii].setInterpolator( *target_interp_warper_[ii] );
                 warper_pyramid_inverse_[ii].setBackgroundValue(bg_value_);
                 warper_pyramid_inverse_[ii].debugFolder_ = this->debugFolder_;
+                warper_pyramid_inverse_[ii].num_of_threads_ = num_of_threads_;
 
                 solver_pyramid_inverse_[ii].setTransform(*transform_);
                 solver_pyramid_inverse_[ii].setTransformInverse(*transform_inverse_);
@@ -265,6 +268,7 @@ namespace Gadgetron {
                 solver_pyramid_inverse_[ii].step_size_para_ = step_size_para_pyramid_level_[ii];
                 solver_pyramid_inverse_[ii].step_size_div_para_ = step_size_div_para_pyramid_level_[ii];
                 solver_pyramid_inverse_[ii].verbose_ = verbose_;
+                solver_pyramid_inverse_[ii].num_of_threads_ = num_of_threads_;
                 solver_pyramid_inverse_[ii].debugFolder_ = this->debugFolder_;
 
                 solver_pyramid_inverse_[ii].setTarget(target_pyramid_[ii]);
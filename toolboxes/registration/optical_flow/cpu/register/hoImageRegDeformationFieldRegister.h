@@ -123,6 +123,7 @@ namespace Gadgetron {
         using BaseClass::performTiming_;
         using BaseClass::gt_exporter_;
         using BaseClass::debugFolder_;
+        using BaseClass::num_of_threads_;
 
         /// number of iterations for every pyramid level
         std::vector<unsigned int> max_iter_num_pyramid_level_;
@@ -304,6 +305,7 @@ namespace Gadgetron {
                 warper_pyramid_[ii].setInterpolator( *source_interp_warper_[ii] );
                 warper_pyramid_[ii].setBackgroundValue(bg_value_);
                 warper_pyramid_[ii].debugFolder_ = this->debugFolder_;
+                warper_pyramid_[ii].num_of_threads_ = num_of_threads_;
 
                 solver_pyramid_[ii].setTransform(*transform_);
 
@@ -332,6 +334,7 @@ namespace Gadgetron {
                 solver_pyramid_[ii].step_size_para_ = step_size_para_pyramid_level_[ii];
                 solver_pyramid_[ii].step_size_div_para_ = step_size_div_para_pyramid_level_[ii];
                 solver_pyramid_[ii].verbose_ = verbose_;
+                solver_pyramid_[ii].num_of_threads_ = num_of_threads_;
                 solver_pyramid_[ii].debugFolder_ = this->debugFolder_;
 
                 solver_pyramid_[ii].setTarget(target_pyramid_[ii]);
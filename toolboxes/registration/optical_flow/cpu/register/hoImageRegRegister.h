@@ -171,6 +171,9 @@ namespace Gadgetron {
         /// Mutual information
         std::vector<ValueType> dissimilarity_MI_betaArg_;
 
+        /// number of threads used by the warpers and solvers of every pyramid level
+        unsigned int num_of_threads_;
+
         // ----------------------------------
         // debug and timing
         // ----------------------------------
@@ -229,7 +232,7 @@ namespace Gadgetron {
     template<typename TargetType, typename SourceType, typename CoordType> 
     hoImageRegRegister<TargetType, SourceType, CoordType>::
     hoImageRegRegister(unsigned int resolution_pyramid_levels, ValueType bg_value) 
-    : target_(NULL), source_(NULL), bg_value_(bg_value), performTiming_(false)
+    : target_(NULL), source_(NULL), bg_value_(bg_value), num_of_threads_(1), performTiming_(false)
     {
         gt_timer1_.set_timing_in_destruction(false);
         gt_timer2_.set_timing_in_destruction(false);
@@ -112,6 +112,7 @@ namespace Gadgetron {
         using BaseClass::step_size_para_;
         using BaseClass::step_size_div_para_;
         using BaseClass::verbose_;
+        using BaseClass::num_of_threads_;
         using BaseClass::gt_timer1_;
         using BaseClass::gt_timer2_;
         using BaseClass::gt_timer3_;
@@ -321,12 +322,12 @@ namespace Gadgetron {
                         long long sy = (long long)dim_inverse[1];
 
                         long long y;
-                        // #pragma omp parallel default(none) private(y) shared(sx, sy, transform, transform_inverse, deform_delta, deform, deform_inverse) if(sx*sy>64*1024) num_threads(2)
+                        #pragma omp parallel default(none) private(y) shared(sx, sy, transform, transform_inverse, deform_delta, deform, deform_inverse) num_threads(num_of_threads_) if(num_of_threads_>1)
                         {
                             CoordType ix, iy, px, py, px_inverse, py_inverse, dx, dy, dx_inverse, dy_inverse;
                             size_t offset;
 
-                            // #pragma omp for 
+                            #pragma omp for 
                             for ( y=0; y<(long long)sy; y++ )
                             {
                                 for ( size_t x=0; x<sx; x++ )
@@ -427,12 +428,12 @@ namespace Gadgetron {
                         long long sy = (long long)dim_inverse[1];
 
                         long long y;
-                        // #pragma omp parallel default(none) private(y) shared(sx, sy, transform, transform_inverse, deform_delta) if(sx*sy>64*1024) num_threads(2)
+                        #pragma omp parallel default(none) private(y) shared(sx, sy, transform, transform_inverse, deform_delta) num_threads(num_of_threads_) if(num_of_threads_>1)
                         {
                             CoordType px, py, dx, dy, dx_inverse, dy_inverse;
                             size_t offset;
 
-                            // #pragma omp for 
+                            #pragma omp for 
                             for ( y=0; y<(long long)sy; y++ )
                             {
                                 for ( size_t x=0; x<sx; x++ )
@@ -543,7 +544,7 @@ namespace Gadgetron {
                             DeformationFieldType& dyInv = transform_inverse->getDeformationField(1);
 
                             long long x, y;
-                            // #pragma omp parallel for default(none) private(y, x) shared(sx, sy, dxInv, dyInv) if(sx*sy>64*1024) num_threads(2)
+                            #pragma omp parallel for default(none) private(y, x) shared(sx, sy, dxInv, dyInv) num_threads(num_of_threads_) if(num_of_threads_>1)
                             for ( y=0; y<sy; y++ )
                             {
                                 for ( x=0; x<sx; x++ )
@@ -127,6 +127,7 @@ namespace Gadgetron {
         using BaseClass::step_size_para_;
         using BaseClass::step_size_div_para_;
         using BaseClass::verbose_;
+        using BaseClass::num_of_threads_;
         using BaseClass::gt_timer1_;
         using BaseClass::gt_timer2_;
         using BaseClass::gt_timer3_;
@@ -312,7 +313,9 @@ namespace Gadgetron {
                 ValueType* pG = gradient_warpped[ii].begin();
                 CoordType* pR = deform_delta[ii].begin();
 
-                for (size_t n = 0; n < N; n++)
+                long long n;
+                #pragma omp parallel for private(n) shared(N, pG, pR, pD) num_threads(num_of_threads_) if(num_of_threads_>1)
+                for (n = 0; n < (long long)N; n++)
                 {
                     pR[n] = pG[n] * pD[n];
                 }
@@ -347,9 +350,11 @@ namespace Gadgetron {
             }
 
             /// filter sigma is in the unit of pixel size
-            for ( ii=0; ii<D; ii++ )
+            long long dd;
+            #pragma omp parallel for private(dd) shared(deform_delta) num_threads(num_of_threads_) if(num_of_threads_>1)
+            for ( dd=0; dd<(long long)D; dd++ )
             {
-                Gadgetron::filterGaussian(deform_delta[ii], regularization_hilbert_strength_);
+                Gadgetron::filterGaussian(deform_delta[dd], regularization_hilbert_strength_);
             }
 
             if ( !debugFolder_.empty() )
@@ -404,7 +409,7 @@ namespace Gadgetron {
                     {
                         CoordType ix, iy, wx, wy, pX, pY, deltaWX, deltaWY;
 
-                        // #pragma omp parallel for default(none) private(y, x, ix, iy, wx, wy, pX, pY, deltaWX, deltaWY) shared(sx, sy, target, deform_delta, deform_updated, transform) num_threads(2)
+                        #pragma omp parallel for default(none) private(y, x, ix, iy, wx, wy, pX, pY, deltaWX, deltaWY) shared(sx, sy, target, deform_delta, deform_updated, transform) num_threads(num_of_threads_) if(num_of_threads_>1)
                         for ( y=0; y<sy; y++ )
                         {
                             for ( x=0; x<sx; x++ )
@@ -511,7 +516,7 @@ namespace Gadgetron {
                     {
                         CoordType pX, pY;
 
-                        // #pragma omp parallel for default(none) private(y, x, pX, pY) shared(sx, sy, deform_delta, deform_updated, transform) num_threads(2)
+                        #pragma omp parallel for default(none) private(y, x, pX, pY) shared(sx, sy, deform_delta, deform_updated, transform) num_threads(num_of_threads_) if(num_of_threads_>1)
                         for ( y=0; y<sy; y++ )
                         {
                             for ( x=0; x<sx; x++ )
@@ -614,7 +619,7 @@ namespace Gadgetron {
                         {
                             CoordType pX, pY;
 
-                            // #pragma omp parallel for default(none) private(y, x, pX, pY) shared(sx, sy, deform_updated) num_threads(2)
+                            #pragma omp parallel for default(none) private(y, x, pX, pY) shared(sx, sy, deform_updated) num_threads(num_of_threads_) if(num_of_threads_>1)
                             for ( y=0; y<sy; y++ )
                             {
                                 for ( x=0; x<sx; x++ )
@@ -147,6 +147,10 @@ namespace Gadgetron {
         /// if true, print out more intermediate information
         bool verbose_;
 
+        /// number of threads for the pixel loops of one iteration
+        /// the loops only write per pixel, so the result does not depend on it
+        unsigned int num_of_threads_;
+
         // ----------------------------------
         // debug and timing
         // ----------------------------------
@@ -185,7 +189,7 @@ namespace Gadgetron {
 
     template<typename TargetType, typename SourceType, typename CoordType> 
     hoImageRegSolver<TargetType, SourceType, CoordType>::hoImageRegSolver() 
-        : target_(NULL), source_(NULL), bg_value_(0), interp_(NULL), warper_(NULL), dissimilarity_(NULL), verbose_(false), use_world_coordinate_(true), performTiming_(false)
+        : target_(NULL), source_(NULL), bg_value_(0), interp_(NULL), warper_(NULL), dissimilarity_(NULL), verbose_(false), num_of_threads_(1), use_world_coordinate_(true), performTiming_(false)
     {
         gt_timer1_.set_timing_in_destruction(false);
         gt_timer2_.set_timing_in_destruction(false);
@@ -86,6 +86,9 @@ namespace Gadgetron {
 
         virtual void print(std::ostream& os) const;
 
+        /// number of threads to warp 2D images
+        unsigned int num_of_threads_;
+
         // ----------------------------------
         // debug and timing
         // ----------------------------------
@@ -112,7 +115,7 @@ namespace Gadgetron {
     };
 
     template<typename TargetType, typename SourceType, typename CoordType> 
-    hoImageRegWarper<TargetType, SourceType, CoordType>::hoImageRegWarper(ValueType bg_value) : transform_(NULL), interp_(NULL), performTiming_(false), bg_value_(bg_value)
+    hoImageRegWarper<TargetType, SourceType, CoordType>::hoImageRegWarper(ValueType bg_value) : transform_(NULL), interp_(NULL), num_of_threads_(1), performTiming_(false), bg_value_(bg_value)
     {
         gt_timer1_.set_timing_in_destruction(false);
         gt_timer2_.set_timing_in_destruction(false);
@@ -174,11 +177,11 @@ namespace Gadgetron {
 
                 if ( useWorldCoordinate )
                 {
-                    // #pragma omp parallel private(y) shared(sx, sy, target, source, warped) num_threads(2)
+                    #pragma omp parallel private(y) shared(sx, sy, target, source, warped) num_threads(num_of_threads_) if(num_of_threads_>1)
                     {
                         coord_type px, py, px_source, py_source, ix_source, iy_source;
 
-                        // #pragma omp for 
+                        #pragma omp for 
                         for ( y=0; y<(long long)sy; y++ )
                         {
                             for ( size_t x=0; x<sx; x++ )
@@ -205,11 +208,11 @@ namespace Gadgetron {
                 }
                 else
                 {
-                    // #pragma omp parallel private(y) shared(sx, sy, target, source, warped) num_threads(2)
+                    #pragma omp parallel private(y) shared(sx, sy, target, source, warped) num_threads(num_of_threads_) if(num_of_threads_>1)
                     {
                         coord_type ix_source, iy_source;
 
-                        // #pragma omp for 
+                        #pragma omp for 
                         for ( y=0; y<(long long)sy; y++ )
                         {
                             for ( size_t x=0; x<sx; x++ )
@@ -396,11 +399,11 @@ namespace Gadgetron {
 
                 long long y;
 
-                // #pragma omp parallel private(y) shared(sx, sy, target, source, warped) num_threads(2)
+                #pragma omp parallel private(y) shared(sx, sy, target, source, warped) num_threads(num_of_threads_) if(num_of_threads_>1)
                 {
                     coord_type px, py, dx, dy, ix_source, iy_source;
 
-                    // #pragma omp for 
+                    #pragma omp for 
                     for ( y=0; y<(long long)sy; y++ )
                     {
                         for ( size_t x=0; x<sx; x++ )
@@ -0,0 +1,379 @@
+/** \file       batchedExpFittingSolver.h
+    \brief      Levenberg-Marquardt fitting of exponential signal models for many curves at once
+
+                The curves are fitted in batches, one curve per lane, with the samples and parameters of a batch
+                stored as structure of arrays, so every step of the iteration is a loop over the lanes which the
+                compiler can vectorize. The Jacobians of the models are analytic. Curves are read from and the
+                parameters written to strided arrays, e.g. [RO E1 N] images and [RO E1 NUM] parameter maps, and
+                nothing is allocated per curve.
+
+                ref: Donald W. Marquardt, "An Algorithm for Least-Squares Estimation of Nonlinear Parameters", Journal of the Society for Industrial and Applied Mathematics, 11(2), 431-441, 1963.
+
+    \author     agent
+*/
+
+#pragma once
+
+#include "log.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace Gadgetron {
+
+    /// signal models of batchedExpFittingSolver, with the parameters in the order of the matching curve fitting operators
+    enum batchedExpFittingModel
+    {
+        /// y = b[0] - b[0] * exp(-x/b[1]), twoParaExpRecoveryOperator
+        EXP_RECOVERY_TWO_PARA,
+        /// y = b[0] * exp(-x/b[1]), twoParaExpDecayOperator
+        EXP_DECAY_TWO_PARA,
+        /// y = b[0] - b[1] * exp(-x/b[2]), threeParaExpRecoveryOperator
+        EXP_RECOVERY_THREE_PARA
+    };
+
+    template <typename T>
+    class batchedExpFittingSolver
+    {
+    public:
+
+        /// number of curves fitted together
+        enum { BATCH = 32 };
+
+        batchedExpFittingSolver(batchedExpFittingModel model = EXP_RECOVERY_TWO_PARA, size_t maxIter = 150, double thres_fun = 1e-4);
+        virtual ~batchedExpFittingSolver();
+
+        size_t get_num_of_paras() const;
+
+        /// fit num curves; sample n of curve p is y[p + n*stride_y], parameter k of curve p is b[p + k*stride_b]
+        /// curves with mask[p] <= 0 are skipped and their parameters are not touched; mask can be NULL
+        /// if use_guess is false, the initial guess is estimated from the samples, otherwise it is read from b
+        void solve(const T* x, size_t num_x, const T* y, size_t stride_y, size_t num, T* b, size_t stride_b, const T* mask = NULL, bool use_guess = false) const;
+
+        /// signal model
+        batchedExpFittingModel model_;
+
+        /// maximal number of iterations
+        size_t max_iter_;
+        /// a curve is converged if an accepted step reduces its cost by less than thres_fun_ (relative)
+        double thres_fun_;
+
+        /// initial damping, relative to the diagonal of J'J
+        T lambda_;
+
+    protected:
+
+        template <int MODEL, int NUM> void solve_batch(const T* x, size_t num_x, const T* yb, size_t lanes, T b[][BATCH], bool use_guess) const;
+
+        template <int MODEL> static void eval(T x, const T* b, T& f, T* J);
+    };
+
+    template <typename T>
+    batchedExpFittingSolver<T>::batchedExpFittingSolver(batchedExpFittingModel model, size_t maxIter, double thres_fun)
+        : model_(model), max_iter_(maxIter), thres_fun_(thres_fun), lambda_((T)1e-3)
+    {
+    }
+
+    template <typename T>
+    batchedExpFittingSolver<T>::~batchedExpFittingSolver()
+    {
+    }
+
+    template <typename T>
+    size_t batchedExpFittingSolver<T>::get_num_of_paras() const
+    {
+        return (model_ == EXP_RECOVERY_THREE_PARA) ? 3 : 2;
+    }
+
+    template <typename T>
+    template <int MODEL>
+    inline void batchedExpFittingSolver<T>::eval(T x, const T* b, T& f, T* J)
+    {
+        // same guard of the time constant as in the curve fitting operators
+        const int NUM = (MODEL == EXP_RECOVERY_THREE_PARA) ? 3 : 2;
+        T tau = b[NUM - 1];
+        T rb = (T)1 / ((std::abs(tau) < FLT_EPSILON) ? ((tau < 0) ? -FLT_EPSILON : FLT_EPSILON) : tau);
+
+        T val = std::exp(-x * rb);
+        T dval = x * rb * rb * val; // d val / d tau
+
+        if (MODEL == EXP_RECOVERY_TWO_PARA)
+        {
+            f = b[0] - b[0] * val;
+            J[0] = 1 - val;
+            J[1] = -b[0] * dval;
+        }
+        else if (MODEL == EXP_DECAY_TWO_PARA)
+        {
+            f = b[0] * val;
+            J[0] = val;
+            J[1] = b[0] * dval;
+        }
+        else
+        {
+            f = b[0] - b[1] * val;
+            J[0] = 1;
+            J[1] = -val;
+            J[2] = -b[1] * dval;
+        }
+    }
+
+    template <typename T>
+    void batchedExpFittingSolver<T>::solve(const T* x, size_t num_x, const T* y, size_t stride_y, size_t num, T* b, size_t stride_b, const T* mask, bool use_guess) const
+    {
+        GADGET_CHECK_THROW(num_x > 0);
+
+        size_t NUM = this->get_num_of_paras();
+        long long num_batches = (long long)((num + BATCH - 1) / BATCH);
+
+#pragma omp parallel default(shared)
+        {
+            // samples of a batch, [num_x BATCH], allocated once per thread
+            std::vector<T> yb(num_x*BATCH);
+            T bb[3][BATCH];
+            size_t ind[BATCH];
+
+            long long batch;
+#pragma omp for schedule(dynamic)
+            for (batch = 0; batch < num_batches; batch++)
+            {
+                size_t start = (size_t)batch*BATCH;
+                size_t end = std::min(start + BATCH, num);
+
+                // gather the curves inside the mask into lanes
+                size_t lanes = 0;
+                for (size_t p = start; p < end; p++)
+                {
+                    if (mask != NULL && mask[p] <= 0) continue;
+                    ind[lanes++] = p;
+                }
+                if (lanes == 0) continue;
+
+                for (size_t n = 0; n < num_x; n++)
+                {
+                    const T* pY = y + n*stride_y;
+                    for (size_t l = 0; l < lanes; l++) yb[n*BATCH + l] = pY[ind[l]];
+                }
+
+                if (use_guess)
+                {
+                    for (size_t k = 0; k < NUM; k++)
+                        for (size_t l = 0; l < lanes; l++) bb[k][l] = b[ind[l] + k*stride_b];
+                }
+
+                switch (model_)
+                {
+                case EXP_RECOVERY_TWO_PARA:
+                    this->template solve_batch<EXP_RECOVERY_TWO_PARA, 2>(x, num_x, &yb[0], lanes, bb, use_guess);
+                    break;
+                case EXP_DECAY_TWO_PARA:
+                    this->template solve_batch<EXP_DECAY_TWO_PARA, 2>(x, num_x, &yb[0], lanes, bb, use_guess);
+                    break;
+                default:
+                    this->template solve_batch<EXP_RECOVERY_THREE_PARA, 3>(x, num_x, &yb[0], lanes, bb, use_guess);
+                    break;
+                }
+
+                for (size_t k = 0; k < NUM; k++)
+                    for (size_t l = 0; l < lanes; l++) b[ind[l] + k*stride_b] = bb[k][l];
+            }
+        }
+    }
+
+    template <typename T>
+    template <int MODEL, int NUM>
+    void batchedExpFittingSolver<T>::solve_batch(const T* x, size_t num_x, const T* yb, size_t lanes, T b[][BATCH], bool use_guess) const
+    {
+        size_t l, n;
+
+        // ------------------------------------------------------------
+        // initial guess, as in the cmr mapping classes
+        // ------------------------------------------------------------
+        if (!use_guess)
+        {
+            T x_mid = x[num_x / 2];
+
+            T max_y[BATCH], min_y[BATCH];
+            for (l = 0; l < lanes; l++) { max_y[l] = yb[l]; min_y[l] = yb[l]; }
+            for (n = 1; n < num_x; n++)
+            {
+                for (l = 0; l < lanes; l++)
+                {
+                    max_y[l] = std::max(max_y[l], yb[n*BATCH + l]);
+                    min_y[l] = std::min(min_y[l], yb[n*BATCH + l]);
+                }
+            }
+
+            if (MODEL == EXP_RECOVERY_TWO_PARA)
+            {
+                for (l = 0; l < lanes; l++) { b[0][l] = max_y[l]; b[1][l] = x_mid; }
+            }
+            else if (MODEL == EXP_RECOVERY_THREE_PARA)
+            {
+                for (l = 0; l < lanes; l++) { b[0][l] = max_y[l]; b[1][l] = 2 * max_y[l]; b[2][l] = x_mid; }
+            }
+            else
+            {
+                // log linear fit, log(y) = log(b[0]) - x/b[1], if every sample is positive
+                T sx(0), sxx(0);
+                for (n = 0; n < num_x; n++) { sx += x[n]; sxx += x[n] * x[n]; }
+                T det = num_x*sxx - sx*sx;
+
+                T sy[BATCH], sxy[BATCH];
+                for (l = 0; l < lanes; l++) { sy[l] = 0; sxy[l] = 0; }
+                for (n = 0; n < num_x; n++)
+                {
+                    for (l = 0; l < lanes; l++)
+                    {
+                        T v = std::log(std::max(yb[n*BATCH + l], (T)FLT_MIN));
+                        sy[l] += v;
+                        sxy[l] += x[n] * v;
+                    }
+                }
+
+                for (l = 0; l < lanes; l++)
+                {
+                    T slope = (num_x*sxy[l] - sx*sy[l]) / det;
+                    T intercept = (sy[l] - slope*sx) / num_x;
+
+                    bool valid = (min_y[l] > 0) && (std::abs(det) > 0) && (slope < 0);
+                    b[0][l] = valid ? std::exp(intercept) : max_y[l];
+                    b[1][l] = valid ? -1 / slope : x_mid;
+                }
+            }
+        }
+
+        // ------------------------------------------------------------
+        // Levenberg-Marquardt iterations
+        // ------------------------------------------------------------
+        T lambda[BATCH], cost[BATCH], active[BATCH];
+        T JtJ[NUM][NUM][BATCH], Jtr[NUM][BATCH], bt[NUM][BATCH], cost_t[BATCH];
+
+        for (l = 0; l < lanes; l++)
+        {
+            lambda[l] = lambda_;
+            active[l] = 1;
+        }
+
+        size_t num_active = lanes;
+        for (size_t iter = 0; iter < max_iter_ && num_active > 0; iter++)
+        {
+            // normal equations at the current parameters
+            for (l = 0; l < lanes; l++)
+            {
+                cost[l] = 0;
+                for (int i = 0; i < NUM; i++)
+                {
+                    Jtr[i][l] = 0;
+                    for (int j = 0; j <= i; j++) JtJ[i][j][l] = 0;
+                }
+            }
+
+            for (n = 0; n < num_x; n++)
+            {
+                const T* pY = yb + n*BATCH;
+#pragma omp simd
+                for (l = 0; l < lanes; l++)
+                {
+                    T bl[NUM], f, J[NUM];
+                    for (int i = 0; i < NUM; i++) bl[i] = b[i][l];
+                    eval<MODEL>(x[n], bl, f, J);
+
+                    T r = f - pY[l];
+                    cost[l] += r*r;
+                    for (int i = 0; i < NUM; i++)
+                    {
+                        Jtr[i][l] += J[i] * r;
+                        for (int j = 0; j <= i; j++) JtJ[i][j][l] += J[i] * J[j];
+                    }
+                }
+            }
+
+            // damped step, (J'J + lambda*diag(J'J)) d = -J'r, solved by Cholesky
+            for (l = 0; l < lanes; l++)
+            {
+                T A[NUM][NUM], L[NUM][NUM], z[NUM], d[NUM];
+                int i, j;
+                for (i = 0; i < NUM; i++)
+                {
+                    for (j = 0; j <= i; j++) A[i][j] = JtJ[i][j][l];
+                    A[i][i] += lambda[l] * A[i][i] + FLT_MIN;
+                }
+
+                bool pd = true;
+                for (i = 0; i < NUM; i++)
+                {
+                    for (j = 0; j <= i; j++)
+                    {
+                        T s = A[i][j];
+                        for (int k = 0; k < j; k++) s -= L[i][k] * L[j][k];
+
+                        if (i == j)
+                        {
+                            if (!(s > 0)) { pd = false; s = 1; }
+                            L[i][i] = std::sqrt(s);
+                        }
+                        else
+                        {
+                            L[i][j] = s / L[j][j];
+                        }
+                    }
+                }
+
+                for (i = 0; i < NUM; i++)
+                {
+                    T s = -Jtr[i][l];
+                    for (j = 0; j < i; j++) s -= L[i][j] * z[j];
+                    z[i] = s / L[i][i];
+                }
+
+                for (i = NUM - 1; i >= 0; i--)
+                {
+                    T s = z[i];
+                    for (j = i + 1; j < NUM; j++) s -= L[j][i] * d[j];
+                    d[i] = s / L[i][i];
+                }
+
+                for (i = 0; i < NUM; i++) bt[i][l] = b[i][l] + ((pd && active[l] > 0) ? d[i] : 0);
+                if (!pd) cost[l] = 0; // rejects the step
+            }
+
+            // cost at the trial parameters
+            for (l = 0; l < lanes; l++) cost_t[l] = 0;
+
+            for (n = 0; n < num_x; n++)
+            {
+                const T* pY = yb + n*BATCH;
+#pragma omp simd
+                for (l = 0; l < lanes; l++)
+                {
+                    T bl[NUM], f, J[NUM];
+                    for (int i = 0; i < NUM; i++) bl[i] = bt[i][l];
+                    eval<MODEL>(x[n], bl, f, J);
+
+                    T r = f - pY[l];
+                    cost_t[l] += r*r;
+                }
+            }
+
+            // accept or reject per lane
+            num_active = 0;
+            for (l = 0; l < lanes; l++)
+            {
+                bool accept = (active[l] > 0) && (cost_t[l] < cost[l]);
+
+                for (int i = 0; i < NUM; i++) b[i][l] = accept ? bt[i][l] : b[i][l];
+
+                bool converged = accept && ((cost[l] - cost_t[l]) <= thres_fun_*cost[l]);
+                bool stalled = !accept && (lambda[l] > (T)1e10);
+
+                lambda[l] = accept ? lambda[l] * (T)0.1 : lambda[l] * 10;
+                if (converged || stalled || (accept && !(cost_t[l] > 0))) active[l] = 0;
+
+                num_active += (active[l] > 0);
+            }
+        }
+    }
+}
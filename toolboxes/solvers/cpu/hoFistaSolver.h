@@ -0,0 +1,269 @@
+/** \file       hoFistaSolver.h
+    \brief      Implement the accelerated proximal gradient (FISTA) solver with adaptive restart
+
+                The solver minimizes the same cost as hoGdSolver, 0.5*||Ax-b||2 + lamda*||Wx||1, with the same operators,
+                parameters and call back. The momentum is restarted when the update direction and the momentum disagree,
+                which removes the oscillation of FISTA once the iterations are close to the solution.
+
+                All arrays used by the iterations are members of the solver and only allocated by the first iteration,
+                or when the size of the problem changes.
+
+                Ref:
+                A. Beck, M. Teboulle. A Fast Iterative Shrinkage-Thresholding Algorithm for Linear Inverse Problems. SIAM J. Imaging Sciences, 2(1):183-202, 2009.
+                B. O'Donoghue, E. Candes. Adaptive Restart for Accelerated Gradient Schemes. Found. Comput. Math., 15(3):715-732, 2015.
+
+    \author     agent
+*/
+
+#pragma once
+
+#include "hoGdSolver.h"
+
+namespace Gadgetron {
+
+template <typename Array_Type, typename Proximal_Oper_Type>
+class hoFistaSolver : public hoGdSolver<Array_Type, Proximal_Oper_Type>
+{
+public:
+
+    typedef hoFistaSolver<Array_Type, Proximal_Oper_Type> Self;
+    typedef hoGdSolver<Array_Type, Proximal_Oper_Type> BaseClass;
+
+    typedef typename BaseClass::ValueType ValueType;
+    typedef typename BaseClass::value_type value_type;
+
+    hoFistaSolver();
+    virtual ~hoFistaSolver();
+
+    using BaseClass::solve;
+    virtual void solve(const Array_Type& b, Array_Type& x);
+
+    /// whether to restart the momentum when the update direction and the momentum disagree
+    bool adaptive_restart_;
+
+    /// number of times the momentum was restarted in the last solve
+    size_t restarts_;
+
+    using BaseClass::iterations_;
+    using BaseClass::grad_thres_;
+    using BaseClass::thres_;
+    using BaseClass::func_value_;
+    using BaseClass::iterations_inner_;
+    using BaseClass::oper_system_;
+    using BaseClass::oper_reg_;
+    using BaseClass::call_back_;
+
+protected:
+
+    using BaseClass::WATb_;
+    using BaseClass::proximal_WATb_;
+    using BaseClass::proximal_WTATb_;
+
+    // workspace of the iterations
+    Array_Type ATb_;
+    Array_Type x_, x_prev_, x_next_;
+    Array_Type y_, z_, grad_, diff_;
+    Array_Type Ax_, Ax_prev_, Ax_next_, Ay_, res_;
+    hoNDArray<value_type> magWATb_;
+};
+
+template <typename Array_Type, typename Proximal_Oper_Type>
+hoFistaSolver<Array_Type, Proximal_Oper_Type>::
+hoFistaSolver() : BaseClass()
+{
+    adaptive_restart_ = true;
+    restarts_ = 0;
+}
+
+template <typename Array_Type, typename Proximal_Oper_Type>
+hoFistaSolver<Array_Type, Proximal_Oper_Type>::
+~hoFistaSolver()
+{
+}
+
+template <typename Array_Type, typename Proximal_Oper_Type>
+void hoFistaSolver<Array_Type, Proximal_Oper_Type>::
+solve(const Array_Type& b, Array_Type& x)
+{
+    try
+    {
+        if (oper_system_ == NULL || oper_reg_ == NULL)
+        {
+            GADGET_THROW("hoFistaSolver solver can only handle two operators ... ");
+        }
+
+        GADGET_CHECK_THROW(this->x0_ != NULL);
+
+        func_value_.clear();
+        func_value_.reserve(iterations_);
+        restarts_ = 0;
+
+        Array_Type* pb = const_cast<Array_Type*>(&b);
+        oper_system_->mult_MH(pb, &ATb_);
+
+        value_type proximal_strength = this->compute_proximal_strength(ATb_);
+
+        if (this->output_mode_ >= Self::OUTPUT_VERBOSE)
+        {
+            GDEBUG_STREAM("---> hoFistaSolver iteration : proximal_strength - " << proximal_strength);
+        }
+
+        if (proximal_strength<FLT_EPSILON) return;
+
+        // the inner iterations of the proximity operation start from zero for every solve
+        if (proximal_WATb_.get_number_of_elements() > 0) Gadgetron::clear(proximal_WATb_);
+        if (proximal_WTATb_.get_number_of_elements() > 0) Gadgetron::clear(proximal_WTATb_);
+
+        x_ = *(this->x0_);
+        x_prev_ = x_;
+
+        oper_system_->mult_M(&x_, &Ax_);
+        Ax_prev_ = Ax_;
+
+        // estimate of the Lipschitz constant of the gradient, increased by the line search
+        value_type norm_length = 0.1;
+
+        value_type t = 1;
+
+        size_t nIter;
+        for (nIter = 0; nIter<iterations_; nIter++)
+        {
+            value_type t_next = (value_type)((1.0 + std::sqrt(1.0 + 4.0*t*t)) / 2.0);
+            value_type beta = (t - 1) / t_next;
+
+            // y = x + beta*(x - x_prev), A is linear so Ay is extrapolated the same way
+            if (beta > 0)
+            {
+                Gadgetron::subtract(x_, x_prev_, diff_);
+                Gadgetron::axpy(ValueType(beta), diff_, x_, y_);
+
+                Gadgetron::subtract(Ax_, Ax_prev_, res_);
+                Gadgetron::axpy(ValueType(beta), res_, Ax_, Ay_);
+            }
+            else
+            {
+                y_ = x_;
+                Ay_ = Ax_;
+            }
+
+            // gradient of the data term at y
+            oper_system_->mult_MH(&Ay_, &grad_);
+            Gadgetron::subtract(grad_, ATb_, grad_);
+
+            size_t iterInner;
+            for (iterInner = 0; iterInner<iterations_inner_; iterInner++)
+            {
+                Gadgetron::axpy(ValueType(-1.0 / norm_length), grad_, y_, z_);
+
+                this->proximal_step(z_, proximal_strength / norm_length, x_next_);
+
+                oper_system_->mult_M(&x_next_, &Ax_next_);
+
+                Gadgetron::subtract(x_next_, y_, diff_);
+                Gadgetron::subtract(Ax_next_, Ay_, res_);
+
+                value_type diffX_norm = Gadgetron::nrm2(diff_);
+                diffX_norm = diffX_norm*diffX_norm;
+
+                value_type diffA_norm = Gadgetron::nrm2(res_);
+                diffA_norm = diffA_norm*diffA_norm;
+
+                if (diffX_norm <= FLT_EPSILON) break;
+                if (diffA_norm <= diffX_norm * norm_length) break;
+
+                norm_length = std::max((value_type)(1.5*norm_length), diffA_norm / diffX_norm);
+            }
+
+            // gradient restart, if (y - x_next)'(x_next - x) > 0 the momentum points uphill
+            bool restarted = false;
+            if (adaptive_restart_ && beta > 0)
+            {
+                Gadgetron::subtract(x_next_, x_, z_);
+                if (std::real(Gadgetron::dot(diff_, z_)) < 0)
+                {
+                    restarted = true;
+                    restarts_++;
+                }
+            }
+
+            t = restarted ? (value_type)1 : t_next;
+
+            // x_prev <- x <- x_next, without copying
+            std::swap(x_prev_, x_);
+            std::swap(x_, x_next_);
+            std::swap(Ax_prev_, Ax_);
+            std::swap(Ax_, Ax_next_);
+
+            Gadgetron::subtract(Ax_, b, res_);
+            oper_reg_->mult_M(&x_, &WATb_);
+
+            value_type error_data_fidelity = Gadgetron::nrm2(res_);
+            error_data_fidelity = error_data_fidelity*error_data_fidelity;
+            error_data_fidelity *= 0.5;
+
+            // l1 norm of the magnitudes, asum of complex data is the sum of |re| + |im|
+            Gadgetron::abs(WATb_, magWATb_);
+            value_type error_image_reg = Gadgetron::asum(magWATb_);
+            func_value_.push_back(error_data_fidelity + proximal_strength*error_image_reg);
+
+            if (this->output_mode_ >= Self::OUTPUT_VERBOSE)
+            {
+                if (nIter > 0)
+                {
+                    GDEBUG_STREAM("---> iteration " << nIter << " - cost : " << error_data_fidelity << " - delta change : " << (func_value_[nIter] - func_value_[nIter - 1]) << " - " << (func_value_[nIter] - func_value_[nIter - 1]) / func_value_[nIter - 1] << (restarted ? " - restart" : ""));
+                }
+                else
+                {
+                    GDEBUG_STREAM("---> iteration " << nIter << " - initial cost : " << error_data_fidelity);
+                }
+            }
+
+            if (nIter >= 2)
+            {
+                if (func_value_[nIter] > func_value_[nIter - 1])
+                {
+                    if (beta <= 0)
+                    {
+                        // even the step without momentum increased the cost
+                        x_ = x_prev_;
+                        break;
+                    }
+
+                    // function restart, the next step is a proximal gradient step from x
+                    if (!restarted) restarts_++;
+                    t = 1;
+                }
+                else if (std::abs(func_value_[nIter] - func_value_[nIter - 1]) <= thres_)
+                {
+                    break;
+                }
+                else if (std::abs(func_value_[nIter] - func_value_[nIter - 1]) / func_value_[nIter - 1] <= grad_thres_)
+                {
+                    break;
+                }
+            }
+
+            if (call_back_ != NULL)
+            {
+                call_back_->solver_ = this;
+                call_back_->execute(b, x_);
+
+                // the call back can change x, keep Ax consistent for the extrapolation
+                oper_system_->mult_M(&x_, &Ax_);
+            }
+        }
+
+        x = x_;
+
+        if (this->output_mode_ >= Self::OUTPUT_VERBOSE)
+        {
+            GDEBUG_STREAM("---> hoFistaSolver : " << func_value_.size() << " iterations, momentum restarted " << restarts_ << " times");
+        }
+    }
+    catch (...)
+    {
+        GADGET_THROW("Errors happened in hoFistaSolver<Array_Type, Proximal_Oper_Type>::solve(...) ... ");
+    }
+}
+
+}
@@ -78,6 +78,20 @@ public:
 
 protected:
 
+    /// compute the strength of proximity operation from A'b
+    /// if determine_proximal_strength_from_L1_term_ is true, WATb_ is filled with W*A'b
+    value_type compute_proximal_strength(Array_Type& ATb);
+
+    /// x = W'*prox(W*z), computed by the inner iterations in the transform domain
+    /// the inner iterations are warm started from proximal_WATb_ and proximal_WTATb_
+    void proximal_step(Array_Type& z, value_type proximal_strength_normalized, Array_Type& x);
+
+    // helper memory for the proximity operation
+    Array_Type WATb_;
+    Array_Type proximal_WATb_;
+    Array_Type proximal_WTATb_;
+    Array_Type proximal_res_;
+    Array_Type r_;
 };
 
 template <typename Array_Type, typename Proximal_Oper_Type>
@@ -134,43 +148,8 @@ solve(const Array_Type& b, Array_Type& x)
         Array_Type* pb = const_cast<Array_Type*>(&b);
         oper_system_->mult_MH(pb, &ATb);
 
-        Array_Type WATb;
-        if (determine_proximal_strength_from_L1_term_)
-        {
-            oper_reg_->mult_M(&ATb, &WATb);
-        }
-
         value_type norm_length = 0.1;
-        value_type norm_max;
-        size_t indMax;
-        hoNDArray<value_type> magWv, magATy;
-
-        if (this->scale_factor_ < 0)
-        {
-            if (determine_proximal_strength_from_L1_term_)
-            {
-                Gadgetron::abs(WATb, magWv);
-                Gadgetron::maxAbsolute(magWv, norm_max, indMax);
-            }
-            else
-            {
-                Gadgetron::abs(ATb, magATy);
-                Gadgetron::maxAbsolute(magATy, norm_max, indMax);
-            }
-        }
-        else
-        {
-            norm_max = scale_factor_;
-        }
-
-        value_type proximal_strength = proximal_strength_ratio_ * std::abs(norm_max);
-        if (std::abs(proximal_strength) < FLT_EPSILON)
-        {
-            Gadgetron::abs(*(this->x0_), magATy);
-            Gadgetron::maxAbsolute(magATy, norm_max, indMax);
-
-            proximal_strength = proximal_strength_ratio_ * std::abs(norm_max);
-        }
+        value_type proximal_strength = this->compute_proximal_strength(ATb);
 
         if (this->output_mode_ >= Self::OUTPUT_VERBOSE)
         {
@@ -196,7 +175,16 @@ solve(const Array_Type& b, Array_Type& x)
 
         Array_Type x2(x), diffx(x), xprev(x);
         Array_Type diffb(ATb), diffbNorm(ATb), ATAb(ATb);
-        Array_Type proximal_WATb(WATb), proximal_WTATb(WATb), proximal_res(WATb), r(WATb);
+        if (determine_proximal_strength_from_L1_term_)
+        {
+            proximal_WATb_ = WATb_;
+            proximal_WTATb_ = WATb_;
+        }
+        else
+        {
+            proximal_WATb_.clear();
+            proximal_WTATb_.clear();
+        }
         value_type diffA_norm, diffX_norm;
 
         for (nIter = 0; nIter<iterations_; nIter++)
@@ -225,72 +213,7 @@ solve(const Array_Type& b, Array_Type& x)
 
                 value_type proximal_strength_normalized = proximal_strength / norm_length;
 
-                oper_reg_->mult_M(&diffx, &WATb);
-
-                if (!proximal_WATb.dimensions_equal(&WATb))
-                {
-                    proximal_WATb.create(WATb.get_dimensions());
-                    Gadgetron::clear(proximal_WATb);
-                }
-
-                if (!proximal_WTATb.dimensions_equal(&WATb))
-                {
-                    proximal_WTATb.create(WATb.get_dimensions());
-                    Gadgetron::clear(proximal_WTATb);
-                }
-
-                size_t N = proximal_WATb.get_number_of_elements();
-                ValueType* pProximal_WATb = proximal_WATb.begin();
-
-                long long n;
-#pragma omp parallel for default(none) private(n) shared(N, proximal_strength_normalized, pProximal_WATb)
-                for (n = 0; n<N; n++)
-                {
-                    value_type mag = std::abs(pProximal_WATb[n]);
-                    if (mag < FLT_EPSILON)
-                        pProximal_WATb[n] = 0;
-                    else
-                    {
-                        if (mag > proximal_strength_normalized)
-                            pProximal_WATb[n] *= (proximal_strength_normalized / mag);
-                    }
-                }
-
-                Gadgetron::subtract(WATb, proximal_WATb, WATb);
-                Gadgetron::subtract(WATb, proximal_WTATb, WATb);
-
-                size_t ii;
-                for (ii = 0; ii<search_steps_; ii++)
-                {
-                    Gadgetron::add(WATb, proximal_WATb, proximal_res);
-
-                    oper_reg_->proximity(proximal_res, proximal_strength_normalized);
-
-                    Gadgetron::subtract(WATb, proximal_res, WATb);
-                    Gadgetron::add(proximal_WATb, WATb, proximal_WATb);
-
-                    value_type n1 = Gadgetron::nrm2(WATb);
-
-                    if (oper_reg_->unitary())
-                    {
-                        Gadgetron::add(proximal_res, proximal_WTATb, WATb);
-                    }
-                    else
-                    {
-                        Gadgetron::add(proximal_res, proximal_WTATb, WATb);
-                        oper_reg_->mult_MH(&WATb, &r);
-                        oper_reg_->mult_M(&r, &WATb);
-                    }
-
-                    Gadgetron::subtract(proximal_res, WATb, r);
-                    Gadgetron::add(proximal_WTATb, r, proximal_WTATb);
-
-                    value_type nx = Gadgetron::nrm2(WATb);
-
-                    if (n1 < nx*1e-4) break;
-                }
-
-                oper_reg_->mult_MH(&WATb, &x);
+                this->proximal_step(diffx, proximal_strength_normalized, x);
 
                 Gadgetron::subtract(x, x2, diffx);
 
@@ -323,13 +246,13 @@ solve(const Array_Type& b, Array_Type& x)
             Gadgetron::subtract(x, bufX, bufX2);
             Gadgetron::subtract(Ax, b, bufAx2);
 
-            oper_reg_->mult_M(&x, &WATb);
+            oper_reg_->mult_M(&x, &WATb_);
 
             value_type error_data_fidelity = Gadgetron::nrm2(bufAx2);
             error_data_fidelity = error_data_fidelity*error_data_fidelity;
             error_data_fidelity *= 0.5;
 
-            value_type error_image_reg = Gadgetron::asum(WATb);
+            value_type error_image_reg = Gadgetron::asum(WATb_);
             func_value_.push_back(error_data_fidelity + proximal_strength*error_image_reg);
 
             if (this->output_mode_ >= Self::OUTPUT_VERBOSE)
@@ -378,4 +301,119 @@ solve(const Array_Type& b, Array_Type& x)
     }
 }
 
+template <typename Array_Type, typename Proximal_Oper_Type>
+typename hoGdSolver<Array_Type, Proximal_Oper_Type>::value_type hoGdSolver<Array_Type, Proximal_Oper_Type>::
+compute_proximal_strength(Array_Type& ATb)
+{
+    if (determine_proximal_strength_from_L1_term_)
+    {
+        oper_reg_->mult_M(&ATb, &WATb_);
+    }
+
+    value_type norm_max;
+    size_t indMax;
+    hoNDArray<value_type> magWv, magATy;
+
+    if (this->scale_factor_ < 0)
+    {
+        if (determine_proximal_strength_from_L1_term_)
+        {
+            Gadgetron::abs(WATb_, magWv);
+            Gadgetron::maxAbsolute(magWv, norm_max, indMax);
+        }
+        else
+        {
+            Gadgetron::abs(ATb, magATy);
+            Gadgetron::maxAbsolute(magATy, norm_max, indMax);
+        }
+    }
+    else
+    {
+        norm_max = scale_factor_;
+    }
+
+    value_type proximal_strength = proximal_strength_ratio_ * std::abs(norm_max);
+    if (std::abs(proximal_strength) < FLT_EPSILON)
+    {
+        Gadgetron::abs(*(this->x0_), magATy);
+        Gadgetron::maxAbsolute(magATy, norm_max, indMax);
+
+        proximal_strength = proximal_strength_ratio_ * std::abs(norm_max);
+    }
+
+    return proximal_strength;
+}
+
+template <typename Array_Type, typename Proximal_Oper_Type>
+void hoGdSolver<Array_Type, Proximal_Oper_Type>::
+proximal_step(Array_Type& z, value_type proximal_strength_normalized, Array_Type& x)
+{
+    oper_reg_->mult_M(&z, &WATb_);
+
+    if (!proximal_WATb_.dimensions_equal(&WATb_))
+    {
+        proximal_WATb_.create(WATb_.get_dimensions());
+        Gadgetron::clear(proximal_WATb_);
+    }
+
+    if (!proximal_WTATb_.dimensions_equal(&WATb_))
+    {
+        proximal_WTATb_.create(WATb_.get_dimensions());
+        Gadgetron::clear(proximal_WTATb_);
+    }
+
+    size_t N = proximal_WATb_.get_number_of_elements();
+    ValueType* pProximal_WATb = proximal_WATb_.begin();
+
+    long long n;
+#pragma omp parallel for default(none) private(n) shared(N, proximal_strength_normalized, pProximal_WATb)
+    for (n = 0; n<N; n++)
+    {
+        value_type mag = std::abs(pProximal_WATb[n]);
+        if (mag < FLT_EPSILON)
+            pProximal_WATb[n] = 0;
+        else
+        {
+            if (mag > proximal_strength_normalized)
+                pProximal_WATb[n] *= (proximal_strength_normalized / mag);
+        }
+    }
+
+    Gadgetron::subtract(WATb_, proximal_WATb_, WATb_);
+    Gadgetron::subtract(WATb_, proximal_WTATb_, WATb_);
+
+    size_t ii;
+    for (ii = 0; ii<search_steps_; ii++)
+    {
+        Gadgetron::add(WATb_, proximal_WATb_, proximal_res_);
+
+        oper_reg_->proximity(proximal_res_, proximal_strength_normalized);
+
+        Gadgetron::subtract(WATb_, proximal_res_, WATb_);
+        Gadgetron::add(proximal_WATb_, WATb_, proximal_WATb_);
+
+        value_type n1 = Gadgetron::nrm2(WATb_);
+
+        if (oper_reg_->unitary())
+        {
+            Gadgetron::add(proximal_res_, proximal_WTATb_, WATb_);
+        }
+        else
+        {
+            Gadgetron::add(proximal_res_, proximal_WTATb_, WATb_);
+            oper_reg_->mult_MH(&WATb_, &r_);
+            oper_reg_->mult_M(&r_, &WATb_);
+        }
+
+        Gadgetron::subtract(proximal_res_, WATb_, r_);
+        Gadgetron::add(proximal_WTATb_, r_, proximal_WTATb_);
+
+        value_type nx = Gadgetron::nrm2(WATb_);
+
+        if (n1 < nx*1e-4) break;
+    }
+
+    oper_reg_->mult_MH(&WATb_, &x);
+}
+
 }